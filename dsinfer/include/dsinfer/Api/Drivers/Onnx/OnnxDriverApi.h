@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <map>
 #include <set>
+#include <vector>
 
 #include <dsinfer/Core/Tensor.h>
 #include <dsinfer/Inference/InferenceDriver.h>
@@ -34,7 +35,56 @@ namespace ds::Api::Onnx {
         int deviceIndex = -1;
 
         /// The onnxruntime library directory. (empty means use the default)
+        ///
+        /// \note The runtime library is shared by all driver instances in a process, so every
+        /// instance must use the same directory.
         std::filesystem::path runtimePath;
+
+        /// The number of threads used to parallelize the execution within nodes. In elastic
+        /// mode, the thread budget shared by all runs of the process. (0 means use the
+        /// onnxruntime default, or the number of cores in elastic mode)
+        int intraOpNumThreads = 0;
+
+        /// The number of threads used to parallelize the execution of the graph.
+        /// (0 means use the onnxruntime default)
+        int interOpNumThreads = 0;
+
+        /// Whether to run in real-time mode, which trades throughput for bounded tail latency,
+        /// e.g. for live monitoring:
+        /// - the graph runs sequentially with preplanned memory, and the inputs are not copied;
+        /// - a run with the same input shapes as the previous one writes into the output tensors
+        ///   of the previous result, which is returned again, if the caller has released them.
+        ///   The tensor memory is then not reallocated, the run still allocates some small
+        ///   bookkeeping such as the shapes and the ORT handles of the inputs;
+        /// - the worker threads get an elevated scheduling priority where permitted, and are
+        ///   pinned to \c cpuAffinity if given;
+        /// - the run latency of each session is recorded, see \c SessionResult::latency.
+        ///
+        /// This only covers the session runs of the driver. The inference interpreters still
+        /// build new input tensors and resample the curves for every request, so a render through
+        /// them allocates per run whatever this mode is.
+        bool realtime = false;
+
+        /// Whether to lock the process memory in real-time mode, so that the models and tensor
+        /// pools are never paged out. Needs the permission to lock memory (RLIMIT_MEMLOCK); the
+        /// memory allocated later is only locked too if the limit is unlimited.
+        bool lockMemory = true;
+
+        /// The CPU cores the worker threads are pinned to in real-time mode, assigned in a round
+        /// robin. (empty means no pinning)
+        std::vector<int> cpuAffinity;
+
+        /// Whether to size the intra-op parallelism of each run from the number of runs in
+        /// flight, for servers with a varying number of concurrent requests: a run alone uses the
+        /// whole thread budget, and concurrent runs split it instead of oversubscribing the cores.
+        ///
+        /// Each CPU session then keeps up to two replicas, with a half and a quarter of the
+        /// threads, created on first use. A run uses the largest one that fits in its share, and
+        /// the smallest one if none does. Each
+        /// replica loads its own copy of the model, only the prepacked weights are shared, so a
+        /// session may take up to three times the memory of the model. Synchronous runs only;
+        /// ignored in real-time mode.
+        bool elasticThreads = false;
     };
 
     class SessionOpenArgs : public InferenceSessionOpenArgs {
@@ -58,12 +108,31 @@ namespace ds::Api::Onnx {
         std::set<std::string> outputs;
     };
 
+    /// Run latency statistics of a session, in seconds. The warm-up run is not counted.
+    struct SessionLatencyStats {
+        uint64_t count = 0;
+        double min = 0;
+        double max = 0;
+        double mean = 0;
+        double p50 = 0;
+        double p99 = 0;
+        double p999 = 0;
+
+        /// The p99.9 latency above the median.
+        inline double jitter() const {
+            return p999 - p50;
+        }
+    };
+
     class SessionResult : public InferenceSessionResult {
     public:
         inline SessionResult() : InferenceSessionResult(API_NAME, API_VERSION) {
         }
 
         std::map<std::string, srt::NO<ITensor>> outputs;
+
+        /// The latency statistics of the previous runs of the session, only in real-time mode.
+        SessionLatencyStats latency;
     };
 
 }
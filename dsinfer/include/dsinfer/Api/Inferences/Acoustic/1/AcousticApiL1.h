@@ -126,7 +126,21 @@ namespace ds::Api::Acoustic::L1 {
             : srt::InferenceRuntimeOptions(API_NAME, API_CLASS, API_LEVEL) {
         }
 
-        /// Reserved
+        /// Maximum number of frames fed to the acoustic model in a single run. Longer inputs are
+        /// split into chunks along the frame axis, so that the peak memory is bounded regardless
+        /// of the input length. (0 means no chunking)
+        int64_t chunkFrames = 0;
+
+        /// Number of extra frames before each chunk used as context. They are cropped from the
+        /// output mel.
+        int64_t chunkLeftContext = 0;
+
+        /// Number of extra frames after each chunk used as context. They are cropped from the
+        /// output mel.
+        int64_t chunkRightContext = 0;
+
+        /// Maximum number of chunks run concurrently. Each concurrent chunk uses its own session.
+        int chunkConcurrency = 1;
     };
 
     class AcousticInitArgs : public srt::InferenceInitArgs {
@@ -134,7 +148,8 @@ namespace ds::Api::Acoustic::L1 {
         inline AcousticInitArgs() : InferenceInitArgs(API_NAME) {
         }
 
-        /// Reserved
+        /// The object name of the inference driver to use. (empty means use the first driver)
+        std::string driver;
     };
 
     class AcousticStartInput : public srt::TaskStartInput {
@@ -88,7 +88,8 @@ namespace ds::Api::Duration::L1 {
         inline DurationInitArgs() : InferenceInitArgs(API_NAME) {
         }
 
-        /// Reserved
+        /// The object name of the inference driver to use. (empty means use the first driver)
+        std::string driver;
     };
 
     class DurationStartInput : public srt::TaskStartInput {
@@ -104,7 +104,8 @@ namespace ds::Api::Pitch::L1 {
         inline PitchInitArgs() : InferenceInitArgs(API_NAME) {
         }
 
-        /// Reserved
+        /// The object name of the inference driver to use. (empty means use the first driver)
+        std::string driver;
     };
 
     class PitchStartInput : public srt::TaskStartInput {
@@ -105,7 +105,8 @@ namespace ds::Api::Variance::L1 {
         inline VarianceInitArgs() : InferenceInitArgs(API_NAME) {
         }
 
-        /// Reserved
+        /// The object name of the inference driver to use. (empty means use the first driver)
+        std::string driver;
     };
 
     class VarianceStartInput : public srt::TaskStartInput {
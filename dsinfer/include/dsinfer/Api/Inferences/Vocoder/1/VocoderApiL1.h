@@ -90,7 +90,17 @@ namespace ds::Api::Vocoder::L1 {
         inline VocoderInitArgs() : InferenceInitArgs(API_NAME) {
         }
 
-        /// Reserved
+        /// The object name of the inference driver to use. (empty means use the first driver)
+        std::string driver;
+    };
+
+    /// Waveform overview at one zoom level, with one value per bin of \c binSize samples. The
+    /// last bin covers the remaining samples and may be shorter.
+    struct WaveformPeaks {
+        int binSize = 0;
+        std::vector<float> min;
+        std::vector<float> max;
+        std::vector<float> rms;
     };
 
     class VocoderStartInput : public srt::TaskStartInput {
@@ -100,6 +110,10 @@ namespace ds::Api::Vocoder::L1 {
 
         srt::NO<ITensor> mel;
         srt::NO<ITensor> f0;
+
+        /// Bin sizes of the peak pyramid computed along with the waveform, e.g.
+        /// {64, 256, 1024, 4096}. (empty means no peaks)
+        std::vector<int> peakBinSizes;
     };
 
     class VocoderResult : public srt::TaskResult {
@@ -108,6 +122,9 @@ namespace ds::Api::Vocoder::L1 {
         }
 
         std::vector<uint8_t> audioData;
+
+        /// One level per requested bin size, in the same order.
+        std::vector<WaveformPeaks> peaks;
     };
 
 }
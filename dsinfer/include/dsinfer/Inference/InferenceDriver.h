@@ -30,6 +30,20 @@ namespace ds {
     ///         ic.addObject("dsdriver", driver);
     ///     }
     /// \endcode
+    ///
+    /// Multiple drivers with different configurations can be added with the same ID. Each of them
+    /// should be given a distinct object name, which the inference init args refer to in order to
+    /// route an inference to a specific driver. An inference that does not specify a driver uses
+    /// the first one added.
+    /// \code
+    ///     interactiveDriver->setObjectName("interactive");
+    ///     batchDriver->setObjectName("batch");
+    ///     ic.addObject("dsdriver", interactiveDriver);
+    ///     ic.addObject("dsdriver", batchDriver);
+    ///
+    ///     auto initArgs = srt::NO<Api::Acoustic::L1::AcousticInitArgs>::create();
+    ///     initArgs->driver = "batch";
+    /// \endcode
     class InferenceDriver : public srt::NamedObject {
     public:
         virtual ~InferenceDriver() = default;
@@ -0,0 +1,53 @@
+#ifndef DSINFER_CURVEENCODING_H
+#define DSINFER_CURVEENCODING_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <stdcorelib/adt/array_view.h>
+
+#include <synthrt/Support/Expected.h>
+
+#include <dsinfer/dsinfer_global.h>
+
+namespace ds {
+
+    /// Name of the float32 curve encoding in JSON documents.
+    ///
+    /// The encoded curve is still text: the little-endian float32 bytes are base64 encoded into a
+    /// JSON string, about 5.3 characters per value against up to 24 for a number in the shortest
+    /// round-trip form. There is no raw binary output.
+    inline constexpr char Float32CurveEncoding[] = "f32le";
+
+    /// Appends \a values as little-endian IEEE-754 float32, 4 bytes per value.
+    DSINFER_EXPORT void appendFloat32LE(std::string &out, stdc::array_view<double> values);
+
+    /// Decodes a little-endian float32 array.
+    DSINFER_EXPORT srt::Expected<std::vector<double>> decodeFloat32LE(std::string_view bytes);
+
+    /// Appends \a bytes encoded in standard base64 with padding.
+    DSINFER_EXPORT void appendBase64(std::string &out, std::string_view bytes);
+
+    /// Decodes standard base64, padding is optional.
+    DSINFER_EXPORT srt::Expected<std::string> decodeBase64(std::string_view str);
+
+    /// Appends \a values as float32 encoded in base64, the compact form of a curve in JSON.
+    inline void appendFloat32Base64(std::string &out, stdc::array_view<double> values) {
+        std::string bytes;
+        appendFloat32LE(bytes, values);
+        appendBase64(out, bytes);
+    }
+
+    inline srt::Expected<std::vector<double>> decodeFloat32Base64(std::string_view str) {
+        auto exp = decodeBase64(str);
+        if (!exp) {
+            return exp.takeError();
+        }
+        return decodeFloat32LE(exp.value());
+    }
+
+}
+
+#endif // DSINFER_CURVEENCODING_H
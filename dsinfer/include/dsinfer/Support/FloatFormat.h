@@ -0,0 +1,38 @@
+#ifndef DSINFER_FLOATFORMAT_H
+#define DSINFER_FLOATFORMAT_H
+
+#include <cstddef>
+#include <string>
+
+#include <stdcorelib/adt/array_view.h>
+
+#include <dsinfer/dsinfer_global.h>
+
+namespace ds {
+
+    /// Buffer size large enough for any value written by \c formatShortest().
+    inline constexpr size_t FloatFormatBufferSize = 32;
+
+    /// Writes the shortest decimal representation of \a value that parses back to the same
+    /// value, e.g. 0.1 is written as "0.1" rather than "0.10000000000000001".
+    ///
+    /// Non-finite values are written as "nan", "inf" or "-inf". Returns the end of the written
+    /// characters, the buffer is not null-terminated.
+    DSINFER_EXPORT char *formatShortest(double value, char *buf);
+
+    /// Same as above, but the result only needs to round-trip as a float, which gives at most 9
+    /// significant digits instead of 17.
+    DSINFER_EXPORT char *formatShortest(float value, char *buf);
+
+    /// Appends \a value as a JSON number. Non-finite values are written as null.
+    DSINFER_EXPORT void appendJsonNumber(std::string &out, double value);
+    DSINFER_EXPORT void appendJsonNumber(std::string &out, float value);
+
+    /// Appends \a values as a JSON array of numbers. If \a asFloat32 is true, the values are
+    /// rounded to float first, which is enough for curves predicted by float32 models.
+    DSINFER_EXPORT void appendJsonArray(std::string &out, stdc::array_view<double> values,
+                                        bool asFloat32 = false);
+
+}
+
+#endif // DSINFER_FLOATFORMAT_H
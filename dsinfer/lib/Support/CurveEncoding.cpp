@@ -0,0 +1,109 @@
+#include "CurveEncoding.h"
+
+#include <array>
+#include <cstring>
+
+namespace ds {
+
+    static constexpr char base64Alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    static constexpr std::array<int8_t, 256> makeBase64Table() {
+        std::array<int8_t, 256> table{};
+        for (auto &item : table) {
+            item = -1;
+        }
+        for (int i = 0; i < 64; ++i) {
+            table[static_cast<uint8_t>(base64Alphabet[i])] = static_cast<int8_t>(i);
+        }
+        return table;
+    }
+
+    static constexpr auto base64Table = makeBase64Table();
+
+    void appendFloat32LE(std::string &out, stdc::array_view<double> values) {
+        const auto offset = out.size();
+        out.resize(offset + values.size() * sizeof(float));
+        auto dst = out.data() + offset;
+        for (size_t i = 0; i < values.size(); ++i) {
+            const auto value = static_cast<float>(values[i]);
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            dst[4 * i] = static_cast<char>(bits & 0xff);
+            dst[4 * i + 1] = static_cast<char>((bits >> 8) & 0xff);
+            dst[4 * i + 2] = static_cast<char>((bits >> 16) & 0xff);
+            dst[4 * i + 3] = static_cast<char>((bits >> 24) & 0xff);
+        }
+    }
+
+    srt::Expected<std::vector<double>> decodeFloat32LE(std::string_view bytes) {
+        if (bytes.size() % sizeof(float) != 0) {
+            return srt::Error(srt::Error::InvalidFormat,
+                              "float32 data size is not a multiple of 4 bytes");
+        }
+        std::vector<double> values(bytes.size() / sizeof(float));
+        const auto src = reinterpret_cast<const uint8_t *>(bytes.data());
+        for (size_t i = 0; i < values.size(); ++i) {
+            const uint32_t bits = uint32_t(src[4 * i]) | (uint32_t(src[4 * i + 1]) << 8) |
+                                  (uint32_t(src[4 * i + 2]) << 16) |
+                                  (uint32_t(src[4 * i + 3]) << 24);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            values[i] = value;
+        }
+        return values;
+    }
+
+    void appendBase64(std::string &out, std::string_view bytes) {
+        const auto src = reinterpret_cast<const uint8_t *>(bytes.data());
+        const auto size = bytes.size();
+        out.reserve(out.size() + (size + 2) / 3 * 4);
+
+        size_t i = 0;
+        for (; i + 3 <= size; i += 3) {
+            const uint32_t n = (uint32_t(src[i]) << 16) | (uint32_t(src[i + 1]) << 8) | src[i + 2];
+            out.push_back(base64Alphabet[(n >> 18) & 0x3f]);
+            out.push_back(base64Alphabet[(n >> 12) & 0x3f]);
+            out.push_back(base64Alphabet[(n >> 6) & 0x3f]);
+            out.push_back(base64Alphabet[n & 0x3f]);
+        }
+        if (const auto rest = size - i; rest > 0) {
+            uint32_t n = uint32_t(src[i]) << 16;
+            if (rest == 2) {
+                n |= uint32_t(src[i + 1]) << 8;
+            }
+            out.push_back(base64Alphabet[(n >> 18) & 0x3f]);
+            out.push_back(base64Alphabet[(n >> 12) & 0x3f]);
+            out.push_back(rest == 2 ? base64Alphabet[(n >> 6) & 0x3f] : '=');
+            out.push_back('=');
+        }
+    }
+
+    srt::Expected<std::string> decodeBase64(std::string_view str) {
+        while (!str.empty() && str.back() == '=') {
+            str.remove_suffix(1);
+        }
+        if (str.size() % 4 == 1) {
+            return srt::Error(srt::Error::InvalidFormat, "invalid base64 length");
+        }
+
+        std::string result;
+        result.reserve(str.size() * 3 / 4);
+        uint32_t n = 0;
+        int bits = 0;
+        for (const auto ch : str) {
+            const auto value = base64Table[static_cast<uint8_t>(ch)];
+            if (value < 0) {
+                return srt::Error(srt::Error::InvalidFormat, "invalid base64 character");
+            }
+            n = (n << 6) | static_cast<uint32_t>(value);
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                result.push_back(static_cast<char>((n >> bits) & 0xff));
+            }
+        }
+        return result;
+    }
+
+}
@@ -0,0 +1,99 @@
+#include "FloatFormat.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace ds {
+
+    template <class T>
+    static inline char *formatNonFinite(T value, char *buf) {
+        const char *str = std::isnan(value) ? "nan" : (value < 0 ? "-inf" : "inf");
+        const auto len = std::strlen(str);
+        std::memcpy(buf, str, len);
+        return buf + len;
+    }
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    template <class T>
+    static inline char *formatShortestImpl(T value, char *buf) {
+        if (!std::isfinite(value)) {
+            return formatNonFinite(value, buf);
+        }
+        // The plain overload gives the shortest round-trip representation
+        return std::to_chars(buf, buf + FloatFormatBufferSize, value).ptr;
+    }
+#else
+    // Fallback for standard libraries without floating-point to_chars: increase the precision
+    // until the value round-trips
+    template <class T>
+    static inline char *formatShortestImpl(T value, char *buf) {
+        if (!std::isfinite(value)) {
+            return formatNonFinite(value, buf);
+        }
+        constexpr int minPrecision = sizeof(T) == sizeof(float) ? 6 : 15;
+        constexpr int maxPrecision = sizeof(T) == sizeof(float) ? 9 : 17;
+        int len = 0;
+        for (int precision = minPrecision; precision <= maxPrecision; ++precision) {
+            len = std::snprintf(buf, FloatFormatBufferSize, "%.*g", precision,
+                                static_cast<double>(value));
+            // The decimal point depends on the C locale
+            for (int i = 0; i < len; ++i) {
+                if (buf[i] == ',') {
+                    buf[i] = '.';
+                }
+            }
+            if (static_cast<T>(std::strtod(buf, nullptr)) == value) {
+                break;
+            }
+        }
+        return buf + len;
+    }
+#endif
+
+    char *formatShortest(double value, char *buf) {
+        return formatShortestImpl(value, buf);
+    }
+
+    char *formatShortest(float value, char *buf) {
+        return formatShortestImpl(value, buf);
+    }
+
+    void appendJsonNumber(std::string &out, double value) {
+        if (!std::isfinite(value)) {
+            out.append("null");
+            return;
+        }
+        char buf[FloatFormatBufferSize];
+        out.append(buf, formatShortest(value, buf));
+    }
+
+    void appendJsonNumber(std::string &out, float value) {
+        if (!std::isfinite(value)) {
+            out.append("null");
+            return;
+        }
+        char buf[FloatFormatBufferSize];
+        out.append(buf, formatShortest(value, buf));
+    }
+
+    void appendJsonArray(std::string &out, stdc::array_view<double> values, bool asFloat32) {
+        // Reserve for the typical length of a curve value, e.g. "-12.345678,"
+        out.reserve(out.size() + values.size() * 12 + 2);
+        out.push_back('[');
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            if (asFloat32) {
+                appendJsonNumber(out, static_cast<float>(values[i]));
+            } else {
+                appendJsonNumber(out, values[i]);
+            }
+        }
+        out.push_back(']');
+    }
+
+}
@@ -1,5 +1,7 @@
 #include "OnnxDriver.h"
 
+#include <mutex>
+
 #include <stdcorelib/pimpl.h>
 #include <stdcorelib/str.h>
 #include <stdcorelib/support/sharedlibrary.h>
@@ -10,6 +12,7 @@
 #include "OnnxSession.h"
 #include "OnnxDriver_Logger.h"
 #include "internal/Env.h"
+#include "internal/Realtime.h"
 
 #ifndef ORT_API_MANUAL_INIT
 #  error "dsinfer requires ort to be manually initialized, but ORT_API_MANUAL_INIT is not set!"
@@ -39,15 +42,29 @@ namespace ds {
 
     using onnxdriver::Log;
 
-    class OnnxDriver::Impl {
+    // The ORT API table is process-global (see Ort::InitApi), so the runtime library is loaded
+    // once and shared by all driver instances. It stays loaded until the process exits because
+    // sessions created by any driver may outlive the driver itself.
+    class OrtRuntime {
     public:
-        Impl() {
-        }
-
-        ~Impl() {
+        static OrtRuntime &global() {
+            static OrtRuntime instance;
+            return instance;
         }
 
         srt::Expected<void> load(const fs::path &path) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (ortDSO) {
+                if (ortPath != path) {
+                    std::string msg = stdc::formatN(
+                        "onnx runtime has been loaded from a different path: %1", ortPath);
+                    Log.srtCritical("Init - %1", msg);
+                    return srt::Error(srt::Error::FileDuplicated, std::move(msg));
+                }
+                Log.srtDebug("Init - Reusing loaded onnx environment");
+                return srt::Expected<void>();
+            }
+
             Log.srtInfo("Init - Loading onnx environment");
 
             auto dylib = std::make_unique<stdc::SharedLibrary>();
@@ -89,7 +106,7 @@ namespace ds {
             auto apiBase = handle();
             auto api = apiBase->GetApi(ORT_API_VERSION);
             if (!api) {
-                std::string msg = stdc::formatN("%1: failed to get API instance");
+                std::string msg = stdc::formatN("%1: failed to get API instance", path);
                 Log.srtCritical("Init - %1", msg);
                 return srt::Error(srt::Error::SessionError, std::move(msg));
             }
@@ -102,7 +119,6 @@ namespace ds {
 
             ortDSO.swap(dylib);
 
-            loaded = true;
             ortPath = path;
             ortApiBase = apiBase;
             ortApi = api;
@@ -111,18 +127,23 @@ namespace ds {
             return srt::Expected<void>();
         }
 
+        std::mutex mtx;
         std::unique_ptr<stdc::SharedLibrary> ortDSO;
 
         // Metadata
-        bool loaded = false;
         fs::path ortPath;
 
         // Library data
-        void *hLibrary = nullptr;
         const OrtApi *ortApi = nullptr;
         const OrtApiBase *ortApiBase = nullptr;
     };
 
+    class OnnxDriver::Impl {
+    public:
+        bool initialized = false;
+        onnxdriver::Env::DeviceConfig config;
+    };
+
     OnnxDriver::OnnxDriver() : _impl(std::make_unique<Impl>()) {
     }
 
@@ -156,31 +177,51 @@ namespace ds {
         // Example logging
         Log.srtDebug("initialize: driver name: %1", args->objectName());
 
-        if (impl.loaded) {
+        if (impl.initialized) {
             return srt::Error{
                 srt::Error::FileDuplicated,
-                "onnx runtime has been initialized by another instance",
+                "onnx driver has already been initialized",
             };
         }
 
         auto dllPath = onnxArgs->runtimePath / ONNXRUNTIME_DYLIB_FILENAME;
 
-        if (!impl.load(dllPath)) {
-            return srt::Error{
-                srt::Error::SessionError,
-                "failed to load onnx runtime library",
-            };
+        if (auto res = OrtRuntime::global().load(dllPath); !res) {
+            return res;
         }
 
         onnxdriver::Env::DeviceConfig devConfig;
         devConfig.ep = onnxArgs->ep;
         devConfig.deviceIndex = onnxArgs->deviceIndex;
-        onnxdriver::Env::setDeviceConfig(devConfig);
+        devConfig.intraOpNumThreads = onnxArgs->intraOpNumThreads;
+        devConfig.interOpNumThreads = onnxArgs->interOpNumThreads;
+        devConfig.realtime = onnxArgs->realtime;
+        devConfig.cpuAffinity = onnxArgs->cpuAffinity;
+        devConfig.elasticThreads = onnxArgs->elasticThreads && !onnxArgs->realtime;
+
+        if (onnxArgs->realtime) {
+            Log.srtInfo("Init - Real-time mode enabled");
+            if (std::string msg; onnxArgs->lockMemory && !onnxdriver::lockProcessMemory(&msg)) {
+                // Keep running, only the tail latency suffers from paging
+                Log.srtWarning("Init - Could not lock memory: %1", msg);
+            }
+        }
+        if (onnxArgs->elasticThreads) {
+            if (onnxArgs->realtime) {
+                // The real-time workers are pinned and sized up front
+                Log.srtWarning("Init - Elastic threads are ignored in real-time mode");
+            } else {
+                Log.srtInfo("Init - Elastic threads enabled");
+            }
+        }
+        impl.config = devConfig;
+        impl.initialized = true;
         return srt::Expected<void>();
     }
 
     srt::NO<InferenceSession> OnnxDriver::createSession() {
-        auto session = srt::NO<OnnxSession>::create();
+        __stdc_impl_t;
+        auto session = srt::NO<OnnxSession>::create(impl.config);
         return session;
     }
 
@@ -2,23 +2,25 @@
 
 #include <stdcorelib/pimpl.h>
 
-#include "internal/Env.h"
 #include "internal/Session.h"
 
 namespace ds {
 
     class OnnxSession::Impl {
     public:
-        Impl() : sessionId(onnxdriver::Env::nextId()) {
+        explicit Impl(const onnxdriver::Env::DeviceConfig &config)
+            : sessionId(onnxdriver::Env::nextId()), config(config) {
         }
         ~Impl() {
         }
 
         int64_t sessionId;
+        onnxdriver::Env::DeviceConfig config;
         onnxdriver::Session session;
     };
 
-    OnnxSession::OnnxSession() : _impl(std::make_unique<Impl>()) {
+    OnnxSession::OnnxSession(const onnxdriver::Env::DeviceConfig &config)
+        : _impl(std::make_unique<Impl>(config)) {
     }
 
     OnnxSession::~OnnxSession() {
@@ -35,7 +37,7 @@ namespace ds {
                 "session open args is null pointer",
             };
         }
-        return impl.session.open(path, openArgs);
+        return impl.session.open(path, openArgs, impl.config);
     }
 
     bool OnnxSession::isOpen() const {
@@ -3,11 +3,13 @@
 
 #include <dsinfer/Inference/InferenceSession.h>
 
+#include "internal/Env.h"
+
 namespace ds {
 
     class OnnxSession : public InferenceSession {
     public:
-        OnnxSession();
+        explicit OnnxSession(const onnxdriver::Env::DeviceConfig &config);
         ~OnnxSession();
 
     public:
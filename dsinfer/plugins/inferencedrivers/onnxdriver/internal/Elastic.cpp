@@ -0,0 +1,51 @@
+#include "Elastic.h"
+
+#include <algorithm>
+
+namespace ds::onnxdriver {
+
+    ThreadCoordinator &ThreadCoordinator::global() {
+        static ThreadCoordinator instance;
+        return instance;
+    }
+
+    int ThreadCoordinator::threadsFor(int budget) const {
+        const int runs = _inFlight.load(std::memory_order_relaxed) + 1;
+        return levelFor(budget, budget / runs);
+    }
+
+    void ThreadCoordinator::acquire() {
+        _inFlight.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void ThreadCoordinator::release() {
+        _inFlight.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    int ThreadCoordinator::inFlight() const {
+        return _inFlight.load(std::memory_order_relaxed);
+    }
+
+    std::vector<int> ThreadCoordinator::levels(int budget) {
+        budget = (std::max) (1, budget);
+        std::vector<int> res;
+        for (int level : {budget, budget / 2, budget / 4}) {
+            level = (std::max) (1, level);
+            if (res.empty() || res.back() != level) {
+                res.push_back(level);
+            }
+        }
+        return res;
+    }
+
+    int ThreadCoordinator::levelFor(int budget, int share) {
+        const auto all = levels(budget);
+        for (const int level : all) {
+            if (level <= share) {
+                return level;
+            }
+        }
+        return all.back();
+    }
+
+}
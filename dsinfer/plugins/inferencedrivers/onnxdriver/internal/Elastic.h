@@ -0,0 +1,60 @@
+#ifndef DSINFER_ONNXDRIVER_ELASTIC_H
+#define DSINFER_ONNXDRIVER_ELASTIC_H
+
+#include <atomic>
+#include <vector>
+
+namespace ds::onnxdriver {
+
+    /// Shares a budget of intra-op threads between the runs in flight of the elastic sessions of
+    /// the process.
+    ///
+    /// onnxruntime cannot resize the thread pool of a session per run, so an elastic session
+    /// keeps replicas with fewer threads, see \c levels(). Each run gets the budget divided by the
+    /// number of runs in flight, and uses the largest replica that fits in its share.
+    class ThreadCoordinator {
+    public:
+        static ThreadCoordinator &global();
+
+        /// Returns the thread count of a new run, one of \c levels(budget), from the runs in
+        /// flight. The run is registered by \c acquire() only once its replica is ready, so that
+        /// creating a replica does not hold a share of the budget.
+        int threadsFor(int budget) const;
+
+        /// Registers a run in flight.
+        void acquire();
+        void release();
+
+        int inFlight() const;
+
+        /// Returns the thread counts of the replicas of a session: the budget, a half and a quarter
+        /// of it (at least 1, without duplicates), in decreasing order. Each replica holds its
+        /// own copy of the model, so there are at most these three.
+        static std::vector<int> levels(int budget);
+
+        /// Returns the largest level of \a budget not above \a share, or the smallest level if
+        /// none fits, so that many concurrent runs oversubscribe a little instead of dropping
+        /// to a single thread each.
+        static int levelFor(int budget, int share);
+
+    protected:
+        std::atomic<int> _inFlight = 0;
+    };
+
+    /// Holds a share of the thread budget for the duration of a run.
+    class ThreadLease {
+    public:
+        ThreadLease() {
+            ThreadCoordinator::global().acquire();
+        }
+        ~ThreadLease() {
+            ThreadCoordinator::global().release();
+        }
+
+        ThreadLease(const ThreadLease &) = delete;
+        ThreadLease &operator=(const ThreadLease &) = delete;
+    };
+
+}
+
+#endif // DSINFER_ONNXDRIVER_ELASTIC_H
@@ -2,13 +2,16 @@
 #define DSINFER_ONNXDRIVER_ENV_H
 
 #include <atomic>
-#include <shared_mutex>
+#include <tuple>
+#include <vector>
 #include <dsinfer/Api/Drivers/Onnx/OnnxDriverApi.h>
 
 namespace ds::onnxdriver {
 
     class Env {
     public:
+        /// Per-driver session configuration. Each \c OnnxDriver instance owns one, so that
+        /// several drivers (e.g. an interactive one and a batch one) can coexist in a process.
         struct DeviceConfig {
             DeviceConfig() : ep(Api::Onnx::CPUExecutionProvider), deviceIndex(-1) {
             }
@@ -18,19 +21,27 @@ namespace ds::onnxdriver {
 
             Api::Onnx::ExecutionProvider ep;
             int deviceIndex;
+            int intraOpNumThreads = 0;
+            int interOpNumThreads = 0;
+            bool realtime = false;
+            std::vector<int> cpuAffinity;
+            bool elasticThreads = false;
+
+            bool operator<(const DeviceConfig &other) const {
+                return std::tie(ep, deviceIndex, intraOpNumThreads, interOpNumThreads, realtime,
+                                cpuAffinity, elasticThreads) <
+                       std::tie(other.ep, other.deviceIndex, other.intraOpNumThreads,
+                                other.interOpNumThreads, other.realtime, other.cpuAffinity,
+                                other.elasticThreads);
+            }
         };
 
-        // Set/Get the entire device config atomically
-        static void setDeviceConfig(const DeviceConfig& config);
-        static DeviceConfig getDeviceConfig();
         static int64_t nextId();
 
     private:
-        static inline DeviceConfig s_deviceConfig;
-        static inline std::shared_mutex s_mutex;
         static inline std::atomic<int64_t> s_idCounter = 0;
     };
 
 } // namespace ds::onnxdriver
 
-#endif // DSINFER_ONNXDRIVER_ENV_H
\ No newline at end of file
+#endif // DSINFER_ONNXDRIVER_ENV_H
@@ -0,0 +1,207 @@
+#include "Realtime.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#  include <sched.h>
+#  include <sys/mman.h>
+#  include <sys/resource.h>
+#endif
+
+#include <stdcorelib/str.h>
+
+namespace ds::onnxdriver {
+
+    bool lockProcessMemory(std::string *errorMessage) {
+        static std::mutex mutex;
+        static bool locked = false;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (locked) {
+            return true;
+        }
+#ifdef _WIN32
+        if (errorMessage) {
+            *errorMessage = "memory locking is not supported on this platform";
+        }
+        return false;
+#else
+        // Under a finite limit, locking the future pages would make the allocations fail once
+        // the limit is reached, so only the current pages are locked
+        int flags = MCL_CURRENT;
+        rlimit limit{};
+        if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY) {
+            flags |= MCL_FUTURE;
+        }
+        if (mlockall(flags) != 0) {
+            if (errorMessage) {
+                *errorMessage = stdc::formatN("mlockall failed: %1", std::strerror(errno));
+            }
+            return false;
+        }
+        locked = true;
+        return true;
+#endif
+    }
+
+    bool promoteCurrentThread(int cpu, std::string *errorMessage) {
+        std::string error;
+#if defined(_WIN32)
+        if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST)) {
+            error = stdc::formatN("SetThreadPriority failed: %1", GetLastError());
+        }
+        if (cpu >= 0 && cpu < 64 &&
+            !SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu)) {
+            error = stdc::formatN("SetThreadAffinityMask failed: %1", GetLastError());
+        }
+#else
+        // A low real-time priority is enough to preempt the normal threads, while staying below
+        // the audio threads of the host
+        sched_param param{};
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+        if (int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param); ret != 0) {
+            error = stdc::formatN("pthread_setschedparam failed: %1", std::strerror(ret));
+        }
+#  if defined(__linux__)
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            if (int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); ret != 0) {
+                error = stdc::formatN("pthread_setaffinity_np failed: %1", std::strerror(ret));
+            }
+        }
+#  else
+        // Threads cannot be pinned on macOS, the affinity is ignored
+        (void) cpu;
+#  endif
+#endif
+        if (error.empty()) {
+            return true;
+        }
+        if (errorMessage) {
+            *errorMessage = std::move(error);
+        }
+        return false;
+    }
+
+    OrtCustomThreadHandle RealtimeThreadOptions::createThread(void *options,
+                                                              OrtThreadWorkerFn worker,
+                                                              void *param) {
+        auto &self = *static_cast<RealtimeThreadOptions *>(options);
+        int cpu = -1;
+        if (!self.cpuAffinity.empty()) {
+            cpu = self.cpuAffinity[self.nextCpu++ % self.cpuAffinity.size()];
+        }
+        auto thread = new std::thread([worker, param, cpu]() {
+            // Failing to promote is not fatal, the thread then runs with the default priority
+            (void) promoteCurrentThread(cpu);
+            worker(param);
+        });
+        return reinterpret_cast<OrtCustomThreadHandle>(thread);
+    }
+
+    void RealtimeThreadOptions::joinThread(OrtCustomThreadHandle handle) {
+        auto thread = reinterpret_cast<std::thread *>(const_cast<OrtCustomHandleType *>(handle));
+        thread->join();
+        delete thread;
+    }
+
+    int LatencyRecorder::bucketIndex(uint64_t micros) {
+        constexpr uint64_t subBucketCount = uint64_t(1) << SubBucketBits;
+        const uint64_t v = micros + 1;
+        if (v < subBucketCount) {
+            return static_cast<int>(v);
+        }
+        int msb = 0;
+        while ((v >> (msb + 1)) != 0) {
+            ++msb;
+        }
+        const auto index = ((msb - SubBucketBits + 1) << SubBucketBits) +
+                           static_cast<int>((v >> (msb - SubBucketBits)) & (subBucketCount - 1));
+        return std::min(index, BucketCount - 1);
+    }
+
+    double LatencyRecorder::bucketValue(int index) {
+        constexpr int subBucketCount = 1 << SubBucketBits;
+        double v;
+        if (index < subBucketCount) {
+            v = index;
+        } else {
+            const int shift = (index >> SubBucketBits) - 1;
+            const double low = std::ldexp(subBucketCount + (index & (subBucketCount - 1)), shift);
+            v = low + std::ldexp(0.5, shift);
+        }
+        return (v - 1) * 1e-6;
+    }
+
+    void LatencyRecorder::record(double seconds) {
+        const auto micros = static_cast<uint64_t>(std::max(0.0, seconds) * 1e6 + 0.5);
+        _buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sumMicros.fetch_add(micros, std::memory_order_relaxed);
+
+        auto min = _minMicros.load(std::memory_order_relaxed);
+        while (micros < min && !_minMicros.compare_exchange_weak(min, micros)) {
+        }
+        auto max = _maxMicros.load(std::memory_order_relaxed);
+        while (micros > max && !_maxMicros.compare_exchange_weak(max, micros)) {
+        }
+    }
+
+    void LatencyRecorder::reset() {
+        for (auto &bucket : _buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        _count = 0;
+        _sumMicros = 0;
+        _minMicros = UINT64_MAX;
+        _maxMicros = 0;
+    }
+
+    Api::Onnx::SessionLatencyStats LatencyRecorder::stats() const {
+        Api::Onnx::SessionLatencyStats res;
+        std::array<uint64_t, BucketCount> counts;
+        uint64_t total = 0;
+        for (int i = 0; i < BucketCount; ++i) {
+            counts[i] = _buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        if (total == 0) {
+            return res;
+        }
+
+        res.count = total;
+        res.min = _minMicros.load(std::memory_order_relaxed) * 1e-6;
+        res.max = _maxMicros.load(std::memory_order_relaxed) * 1e-6;
+        res.mean = _sumMicros.load(std::memory_order_relaxed) * 1e-6 / total;
+
+        const auto percentile = [&](double q) {
+            const auto rank = static_cast<uint64_t>(std::ceil(q * total));
+            uint64_t sum = 0;
+            for (int i = 0; i < BucketCount; ++i) {
+                sum += counts[i];
+                if (sum >= rank) {
+                    return std::clamp(bucketValue(i), res.min, res.max);
+                }
+            }
+            return res.max;
+        };
+        res.p50 = percentile(0.5);
+        res.p99 = percentile(0.99);
+        res.p999 = percentile(0.999);
+        return res;
+    }
+
+}
@@ -0,0 +1,61 @@
+#ifndef DSINFER_ONNXDRIVER_REALTIME_H
+#define DSINFER_ONNXDRIVER_REALTIME_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <onnxruntime_cxx_api.h>
+
+#include <dsinfer/Api/Drivers/Onnx/OnnxDriverApi.h>
+
+namespace ds::onnxdriver {
+
+    /// Locks the current pages of the process in memory, and the future ones if the memory lock
+    /// limit (RLIMIT_MEMLOCK) is unlimited. Process-wide; only the first successful call does
+    /// anything.
+    bool lockProcessMemory(std::string *errorMessage = nullptr);
+
+    /// Raises the scheduling priority of the calling thread and pins it to \a cpu if it is not
+    /// negative. Returns false if the system refused, the thread keeps running as before.
+    bool promoteCurrentThread(int cpu, std::string *errorMessage = nullptr);
+
+    /// Creates the onnxruntime worker threads of real-time sessions, see
+    /// \c Ort::SessionOptions::SetCustomCreateThreadFn().
+    struct RealtimeThreadOptions {
+        std::vector<int> cpuAffinity;
+        std::atomic<size_t> nextCpu = 0;
+
+        static OrtCustomThreadHandle createThread(void *options, OrtThreadWorkerFn worker,
+                                                  void *param);
+        static void joinThread(OrtCustomThreadHandle handle);
+    };
+
+    /// Run latency histogram. Recording is lock-free and never allocates.
+    class LatencyRecorder {
+    public:
+        void record(double seconds);
+        void reset();
+
+        Api::Onnx::SessionLatencyStats stats() const;
+
+    protected:
+        // 16 buckets per power of two of microseconds, i.e. a relative error below 4.5%
+        static constexpr int SubBucketBits = 4;
+        static constexpr int BucketCount = 40 << SubBucketBits;
+
+        static int bucketIndex(uint64_t micros);
+        static double bucketValue(int index);
+
+        std::array<std::atomic<uint64_t>, BucketCount> _buckets{};
+        std::atomic<uint64_t> _count = 0;
+        std::atomic<uint64_t> _sumMicros = 0;
+        std::atomic<uint64_t> _minMicros = UINT64_MAX;
+        std::atomic<uint64_t> _maxMicros = 0;
+    };
+
+}
+
+#endif // DSINFER_ONNXDRIVER_REALTIME_H
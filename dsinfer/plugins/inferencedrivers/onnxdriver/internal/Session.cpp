@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <list>
 #include <numeric>
+#include <optional>
 
 #include <stdcorelib/path.h>
 #include <stdcorelib/pimpl.h>
@@ -22,6 +23,8 @@
 #include "OnnxDriver_Logger.h"
 #include "SessionImage.h"
 #include "ScopedTimer.h"
+#include "Realtime.h"
+#include "Elastic.h"
 
 #include "OnnxTensor.h"
 
@@ -36,11 +39,25 @@ namespace ds::onnxdriver {
             int count;
         };
 
+        // Images of the same model are shared only if both the hints and the owning driver's
+        // device config are equal.
+        struct ImageKey {
+            int hints;
+            Env::DeviceConfig config;
+
+            bool operator<(const ImageKey &other) const {
+                if (hints == other.hints) {
+                    return config < other.config;
+                }
+                return hints < other.hints;
+            }
+        };
+
         struct ImageGroup {
             std::filesystem::path path;
             std::streamsize size = 0;
             std::vector<uint8_t> hash;
-            std::map<int, ImageData> images; // hint -> [ image, count ]
+            std::map<ImageKey, ImageData> images; // [ hint, config ] -> [ image, count ]
         };
 
         struct HashSizeKey {
@@ -86,6 +103,9 @@ namespace ds::onnxdriver {
         // The vector does not own the values, so they need manually memory management.
         std::vector<OrtValue *> outputValuePtrs;
 
+        // Input shapes of a real-time run, in the order of the inputs.
+        std::vector<std::vector<int64_t>> inputShapes;
+
         SessionRunContext() = default;
 
         explicit SessionRunContext(size_t inputSize, size_t outputSize)
@@ -117,6 +137,8 @@ namespace ds::onnxdriver {
             inputValuePtrs.clear();
             inputValuePtrs.reserve(inputSize);
 
+            inputShapes.resize(inputSize);
+
             releaseOutputValues();
             outputValuePtrs.resize(outputSize, nullptr);
         }
@@ -142,6 +164,7 @@ namespace ds::onnxdriver {
         SessionSystem::ImageGroup *group = nullptr;
         SessionImage *image = nullptr;
         int hints = 0;
+        Env::DeviceConfig config;
 
         std::filesystem::path realPath;
 
@@ -149,6 +172,18 @@ namespace ds::onnxdriver {
         std::unique_ptr<SessionAsyncRunContext> asyncContext;
         srt::NO<Api::Onnx::SessionResult> sessionResult;
 
+        // Real-time mode
+        LatencyRecorder latency;
+        bool warmedUp = false;
+        Ort::MemoryInfo memoryInfo{nullptr};
+
+        // Input shapes of the run that produced the outputs of sessionResult
+        std::vector<std::vector<int64_t>> resultInputShapes;
+
+        // Cleared once a run into the previous output buffers fails, e.g. for a model whose
+        // output shapes depend on the input values
+        bool reuseOutputs = true;
+
         Impl() : sessionResult(srt::NO<Api::Onnx::SessionResult>::create()) {
         }
 
@@ -224,6 +259,43 @@ namespace ds::onnxdriver {
             }
         }
 
+        // Wraps the tensor buffer without copying it, the tensor must outlive the value. Used in
+        // real-time mode to keep the input copies off the run path.
+        static inline Ort::Value wrapTensorAsOrtValue(const srt::NO<ITensor> &tensor,
+                                                      const std::vector<int64_t> &shape,
+                                                      const Ort::MemoryInfo &memoryInfo,
+                                                      srt::Error *error = nullptr) {
+            auto dataLength = tensor->elementCount();
+            auto dataLengthFromShape =
+                std::accumulate(shape.begin(), shape.end(), int64_t{1}, std::multiplies<>());
+            if (static_cast<int64_t>(dataLength) != dataLengthFromShape) {
+                if (error) {
+                    *error = {srt::Error::InvalidArgument, "Shape does not match data length"};
+                }
+                return Ort::Value(nullptr);
+            }
+            auto data = const_cast<std::byte *>(tensor->rawData());
+            switch (tensor->dataType()) {
+                case ITensor::Float:
+                    return Ort::Value::CreateTensor<float>(
+                        memoryInfo, reinterpret_cast<float *>(data), dataLength,
+                        shape.data(), shape.size());
+                case ITensor::Int64:
+                    return Ort::Value::CreateTensor<int64_t>(
+                        memoryInfo, reinterpret_cast<int64_t *>(data), dataLength,
+                        shape.data(), shape.size());
+                case ITensor::Bool:
+                    return Ort::Value::CreateTensor<bool>(
+                        memoryInfo, reinterpret_cast<bool *>(data), dataLength,
+                        shape.data(), shape.size());
+                default:
+                    if (error) {
+                        *error = {srt::Error::InvalidArgument, "Unsupported data type"};
+                    }
+                    return Ort::Value(nullptr);
+            }
+        }
+
         static inline srt::NO<ITensor> createTensorFromOrtValue(const Ort::Value &ortValue,
                                                                 srt::Error *error = nullptr) {
             if (!ortValue.IsTensor()) {
@@ -276,6 +348,29 @@ namespace ds::onnxdriver {
             }
         }
 
+        inline const Ort::MemoryInfo &cpuMemoryInfo() {
+            if (!memoryInfo) {
+                memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+            }
+            return memoryInfo;
+        }
+
+        // Whether the previous result can be run into again: the caller has released it and its
+        // tensors, and it has the requested outputs
+        inline bool canReuseOutputs(const std::set<std::string> &outputNames) const {
+            if (!reuseOutputs || sessionResult.use_count() != 1 ||
+                sessionResult->outputs.size() != outputNames.size()) {
+                return false;
+            }
+            auto nameIt = outputNames.begin();
+            for (const auto &[name, tensor] : sessionResult->outputs) {
+                if (name != *nameIt++ || !tensor || tensor.use_count() != 1) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
         inline srt::Error
             validateInputValueMap(const srt::NO<Api::Onnx::SessionStartInput> &input) {
             const auto &inputValueMap = input->inputs;
@@ -339,6 +434,7 @@ namespace ds::onnxdriver {
             auto &impl = *static_cast<Impl *>(user_data);
             auto &ctx = *impl.context;
             impl.sessionResult->outputs.clear();
+            impl.resultInputShapes.clear();
             Ort::Status runStatus(status);
             if (!runStatus.IsOK()) {
                 impl.sessionResult->error = {srt::Error::SessionError, runStatus.GetErrorMessage()};
@@ -372,9 +468,21 @@ namespace ds::onnxdriver {
         inline srt::NO<Api::Onnx::SessionResult> sessionRun(const srt::NO<Api::Onnx::SessionStartInput> &sessionStartInput,
                                srt::Error *error = nullptr) {
             const auto &filename = realPath.filename();
-            Log.srtInfo("Session [%1] - Running inference", filename);
+            const bool realtime = config.realtime;
+            if (!realtime) {
+                Log.srtInfo("Session [%1] - Running inference", filename);
+            }
 
             ScopedTimer timer([&](const ScopedTimer::duration_t &elapsed) {
+                // In real-time mode, record the latency instead of logging, which allocates
+                if (realtime) {
+                    if (warmedUp) {
+                        latency.record(elapsed.count());
+                    }
+                    warmedUp = true;
+                    return;
+                }
+
                 // When finished, print time elapsed
                 auto elapsedStr = static_cast<const std::ostringstream &>(
                                       std::ostringstream()
@@ -404,17 +512,29 @@ namespace ds::onnxdriver {
             auto inputCount = inputValueMap.size();
             auto outputCount = sessionStartInput->outputs.size();
 
-            context = std::make_unique<SessionRunContext>(inputCount, outputCount);
+            // Reuse the buffers of the previous run
+            if (context) {
+                context->initialize(inputCount, outputCount);
+            } else {
+                context = std::make_unique<SessionRunContext>(inputCount, outputCount);
+            }
             auto &ctx = *context;
 
-            auto result = srt::NO<Api::Onnx::SessionResult>::create();
             try {
-                auto memInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+                const auto &memInfo = cpuMemoryInfo();
 
+                size_t inputIndex = 0;
                 for (auto &[name, value] : inputValueMap) {
                     ctx.inputNames.push_back(name.c_str());
+                    if (realtime) {
+                        ctx.inputShapes[inputIndex] = value->shape();
+                    }
                     if (value->backend() == "tensor") {
-                        auto ortValue = createOrtValueFromTensor(value, memInfo, error);
+                        auto ortValue =
+                            realtime
+                                ? wrapTensorAsOrtValue(value, ctx.inputShapes[inputIndex], memInfo,
+                                                       error)
+                                : createOrtValueFromTensor(value, memInfo, error);
                         if (!ortValue) {
                             if (error) {
                                 *error = {srt::Error::InvalidArgument,
@@ -435,6 +555,7 @@ namespace ds::onnxdriver {
                         }
                         return {};
                     }
+                    ++inputIndex;
                 }
 
                 for (auto &name : sessionStartInput->outputs) {
@@ -442,9 +563,60 @@ namespace ds::onnxdriver {
                 }
                 runOptions.UnsetTerminate();
 
-                Ort::Status statusRun(Ort::GetApi().Run(
-                    image->session, runOptions, ctx.inputNames.data(), ctx.inputValuePtrs.data(),
-                    inputCount, ctx.outputNames.data(), outputCount, ctx.outputValuePtrs.data()));
+                // In elastic mode, run on the replica sized for the runs in flight
+                Ort::Session *ortSession = &image->session;
+                std::optional<ThreadLease> lease;
+                if (image->threadBudget > 0) {
+                    // The replica may be created here, so the run is only counted from the Run
+                    // call on
+                    const int threads =
+                        ThreadCoordinator::global().threadsFor(image->threadBudget);
+                    ortSession = &image->sessionFor(threads);
+                    lease.emplace();
+                    Log.srtDebug("Session [%1] - %2 runs in flight, running on %3 threads",
+                                 filename, ThreadCoordinator::global().inFlight(), threads);
+                }
+
+                const auto runSession = [&]() {
+                    return Ort::Status(Ort::GetApi().Run(
+                        *ortSession, runOptions, ctx.inputNames.data(), ctx.inputValuePtrs.data(),
+                        inputCount, ctx.outputNames.data(), outputCount,
+                        ctx.outputValuePtrs.data()));
+                };
+
+                // In real-time mode, run into the output buffers of the previous result if the
+                // input shapes are unchanged, so that the result and its tensors are reused
+                if (realtime && ctx.inputShapes == resultInputShapes &&
+                    canReuseOutputs(sessionStartInput->outputs)) {
+                    size_t outputIndex = 0;
+                    for (auto &[name, tensor] : sessionResult->outputs) {
+                        ctx.outputValuePtrs[outputIndex++] =
+                            *static_cast<OnnxTensor *>(tensor.get())->valuePtr();
+                    }
+
+                    Ort::Status statusRun = runSession();
+
+                    // The values stay owned by the output tensors
+                    std::fill(ctx.outputValuePtrs.begin(), ctx.outputValuePtrs.end(), nullptr);
+                    if (statusRun.IsOK()) {
+                        lease.reset();
+                        sessionResult->error = {};
+                        // This run is only recorded by the timer on return
+                        sessionResult->latency = latency.stats();
+                        return sessionResult;
+                    }
+
+                    // Their contents are lost, run again into new buffers
+                    Log.srtWarning("Session [%1] - Could not run into the previous output "
+                                   "buffers, no longer reusing them: %2",
+                                   filename, statusRun.GetErrorMessage());
+                    reuseOutputs = false;
+                    resultInputShapes.clear();
+                    sessionResult->outputs.clear();
+                }
+
+                Ort::Status statusRun = runSession();
+                lease.reset();
 
                 if (!statusRun.IsOK()) {
                     ctx.releaseOutputValues();
@@ -454,6 +626,7 @@ namespace ds::onnxdriver {
                     return {};
                 }
 
+                auto result = srt::NO<Api::Onnx::SessionResult>::create();
                 for (size_t i = 0; i < ctx.outputValuePtrs.size(); ++i) {
                     // Transfer ownership of the raw OrtValue* to an Ort::Value wrapper,
                     // which will subsequently be managed by OnnxTensor. No manual release is
@@ -475,6 +648,11 @@ namespace ds::onnxdriver {
                         ctx.outputNames[i],
                         exp.take());
                 }
+                if (realtime) {
+                    // This run is only recorded by the timer on return
+                    result->latency = latency.stats();
+                    resultInputShapes.swap(ctx.inputShapes);
+                }
                 sessionResult = result;
                 return result;
             } catch (const Ort::Exception &err) {
@@ -527,7 +705,7 @@ namespace ds::onnxdriver {
 
             asyncContext = std::make_unique<SessionAsyncRunContext>();
             try {
-                auto memInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+                const auto &memInfo = cpuMemoryInfo();
 
                 for (auto &[name, value] : inputValueMap) {
                     ctx.inputNames.push_back(name.c_str());
@@ -642,7 +820,8 @@ namespace ds::onnxdriver {
     }
 
     srt::Expected<void> Session::open(const fs::path &path,
-                                      const srt::NO<Api::Onnx::SessionOpenArgs> &args) {
+                                      const srt::NO<Api::Onnx::SessionOpenArgs> &args,
+                                      const Env::DeviceConfig &config) {
         __stdc_impl_t;
 
         if (isOpen()) {
@@ -670,13 +849,14 @@ namespace ds::onnxdriver {
         if (args->useCpu) {
             hints |= SH_PreferCPUHint;
         }
+        const SessionSystem::ImageKey key{hints, config};
         // Search path
         SessionSystem::ImageGroup *image_group = nullptr;
         if (auto it = session_system.path_map.find(canonical_path);
             it != session_system.path_map.end()) {
             image_group = &(*it->second);
             auto &image_map = image_group->images;
-            if (auto it2 = image_map.find(hints); it2 != image_map.end()) {
+            if (auto it2 = image_map.find(key); it2 != image_map.end()) {
                 auto &data = it2->second;
                 image = data.image;
                 data.count++;
@@ -685,7 +865,7 @@ namespace ds::onnxdriver {
             hash = it->second->hash;
             size = it->second->size;
 
-            Log.srtDebug("Session - No same hint in opened sessions");
+            Log.srtDebug("Session - No same hint and config in opened sessions");
             goto out_search_hash;
         }
 
@@ -703,7 +883,7 @@ namespace ds::onnxdriver {
             it != session_system.hash_size_map.end()) {
             image_group = &(*it->second);
             auto &image_map = image_group->images;
-            if (auto it2 = image_map.find(hints); it2 != image_map.end()) {
+            if (auto it2 = image_map.find(key); it2 != image_map.end()) {
                 auto &data = it2->second;
                 image = data.image;
                 data.count++;
@@ -717,7 +897,7 @@ namespace ds::onnxdriver {
 
         // Create new one
         image = new SessionImage();
-        if (std::string error1; !image->open(canonical_path, hints, &error1)) {
+        if (std::string error1; !image->open(canonical_path, hints, config, &error1)) {
             delete image;
             return srt::Error{
                 srt::Error::FileNotOpen,
@@ -740,7 +920,7 @@ namespace ds::onnxdriver {
             session_system.hash_size_map[{size, it->hash}] = it;
             image_group = &(*it);
         }
-        image_group->images[hints] = {image, 1};
+        image_group->images[key] = {image, 1};
         goto out_success;
 
     out_exists:
@@ -751,6 +931,7 @@ namespace ds::onnxdriver {
         impl.group = image_group;
         impl.image = image;
         impl.hints = hints;
+        impl.config = config;
         impl.realPath = canonical_path;
         return srt::Expected<void>();
     }
@@ -765,13 +946,24 @@ namespace ds::onnxdriver {
         const auto &filename = path.filename();
         Log.srtDebug("Session [%1] - close", filename);
 
+        if (impl.config.realtime) {
+            if (const auto stats = impl.latency.stats(); stats.count > 0) {
+                Log.srtInfo("Session [%1] - %2 runs, latency p50 %3 ms, p99.9 %4 ms, max %5 ms, "
+                            "jitter %6 ms",
+                            filename, stats.count, stats.p50 * 1e3, stats.p999 * 1e3,
+                            stats.max * 1e3, stats.jitter() * 1e3);
+            }
+            impl.latency.reset();
+            impl.warmedUp = false;
+        }
+
         auto &session_system = SessionSystem::global();
         std::unique_lock<std::shared_mutex> lock(session_system.mtx);
 
         auto &group = *impl.group;
         auto &images = group.images;
         {
-            auto it = images.find(impl.hints);
+            auto it = images.find({impl.hints, impl.config});
             assert(it != images.end());
             auto &data = it->second;
             if (--data.count != 0) {
@@ -798,6 +990,7 @@ namespace ds::onnxdriver {
         impl.group = nullptr;
         impl.image = nullptr;
         impl.hints = 0;
+        impl.config = {};
         impl.realPath.clear();
         return srt::Expected<void>();
     }
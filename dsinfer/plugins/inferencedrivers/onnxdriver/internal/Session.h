@@ -10,6 +10,8 @@
 #include <dsinfer/Api/Drivers/Onnx/OnnxDriverApi.h>
 #include <synthrt/Task/ITask.h>
 
+#include "Env.h"
+
 
 namespace ds::onnxdriver {
 
@@ -30,7 +32,9 @@ namespace ds::onnxdriver {
         Session &operator=(Session &&other) noexcept;
 
     public:
-        srt::Expected<void> open(const std::filesystem::path &path, const srt::NO<Api::Onnx::SessionOpenArgs> &args);
+        srt::Expected<void> open(const std::filesystem::path &path,
+                                 const srt::NO<Api::Onnx::SessionOpenArgs> &args,
+                                 const Env::DeviceConfig &config = {});
         srt::Expected<void> close();
 
         const std::vector<std::string> &inputNames() const;
@@ -1,5 +1,8 @@
 #include "SessionImage.h"
 
+#include <algorithm>
+#include <thread>
+
 #include <onnxruntime_cxx_api.h>
 
 #include <dsinfer/Api/Drivers/Onnx/OnnxDriverApi.h>
@@ -8,20 +11,49 @@
 #include "ExecutionProvider.h"
 #include "Env.h"
 #include "Session.h"
+#include "Elastic.h"
 
 namespace ds::onnxdriver {
     using Api::Onnx::ExecutionProvider;
 
     static Ort::Session createOrtSession(const Ort::Env &ortEnv,
                                          const std::filesystem::path &modelPath,
-                                         bool preferCpu,
+                                         bool preferCpu, const Env::DeviceConfig &devConfig,
+                                         RealtimeThreadOptions *threadOptions,
+                                         OrtPrepackedWeightsContainer *prepackedWeights,
                                          std::string *errorMessage) {
-        auto devConfig = Env::getDeviceConfig();
         auto ep = devConfig.ep;
         auto deviceIndex = devConfig.deviceIndex;
         try {
             Ort::SessionOptions sessOpt;
 
+            // Thread pool sizes (0 means let onnxruntime decide)
+            if (devConfig.intraOpNumThreads > 0) {
+                sessOpt.SetIntraOpNumThreads(devConfig.intraOpNumThreads);
+            }
+            if (devConfig.interOpNumThreads > 0) {
+                sessOpt.SetInterOpNumThreads(devConfig.interOpNumThreads);
+            }
+
+            if (devConfig.realtime) {
+                // Run sequentially with a preplanned memory pattern: once the arena has grown in
+                // the first run, later runs of the same shapes reuse the same blocks
+                sessOpt.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+                sessOpt.EnableCpuMemArena();
+                sessOpt.EnableMemPattern();
+
+                // Spinning workers wake up faster, but only spin on dedicated cores, elsewhere
+                // they would take the time of the other threads
+                sessOpt.AddConfigEntry("session.intra_op.allow_spinning",
+                                       devConfig.cpuAffinity.empty() ? "0" : "1");
+
+                if (threadOptions) {
+                    sessOpt.SetCustomCreateThreadFn(RealtimeThreadOptions::createThread);
+                    sessOpt.SetCustomThreadCreationOptions(threadOptions);
+                    sessOpt.SetCustomJoinThreadFn(RealtimeThreadOptions::joinThread);
+                }
+            }
+
             std::string initEPErrorMsg;
             if (!preferCpu) {
                 switch (ep) {
@@ -58,8 +90,11 @@ namespace ds::onnxdriver {
             } else {
                 Log.srtInfo("The model prefers to use CPU. [%1]", modelPath.filename());
             }
-            return Ort::Session{ortEnv, std::filesystem::path::string_type(modelPath).c_str(),
-                                sessOpt};
+            const auto pathString = std::filesystem::path::string_type(modelPath);
+            if (prepackedWeights) {
+                return Ort::Session{ortEnv, pathString.c_str(), sessOpt, prepackedWeights};
+            }
+            return Ort::Session{ortEnv, pathString.c_str(), sessOpt};
         } catch (const Ort::Exception &e) {
             if (errorMessage) {
                 *errorMessage = e.what();
@@ -95,12 +130,50 @@ namespace ds::onnxdriver {
 
     SessionImage::~SessionImage() = default;
 
+    void SessionImage::PrepackedWeightsDeleter::operator()(
+        OrtPrepackedWeightsContainer *container) const {
+        Ort::GetApi().ReleasePrepackedWeightsContainer(container);
+    }
+
     bool SessionImage::open(const std::filesystem::path &onnxPath, int hints,
-                            std::string *errorMessage) {
+                            const Env::DeviceConfig &config, std::string *errorMessage) {
         auto filename = onnxPath.filename();
         Log.srtDebug("SessionImage [%1] - creating", filename);
 
-        session = createOrtSession(env, onnxPath, hints & Session::SH_PreferCPUHint, errorMessage);
+        if (config.realtime) {
+            threadOptions = std::make_unique<RealtimeThreadOptions>();
+            threadOptions->cpuAffinity = config.cpuAffinity;
+        }
+
+        // Only the CPU provider runs the nodes on the intra-op threads
+        auto mainConfig = config;
+        const bool preferCpu = hints & Session::SH_PreferCPUHint;
+        if (config.elasticThreads &&
+            (preferCpu || config.ep == Api::Onnx::CPUExecutionProvider)) {
+            threadBudget = config.intraOpNumThreads;
+            if (threadBudget <= 0) {
+                threadBudget =
+                    static_cast<int>((std::max) (1u, std::thread::hardware_concurrency()));
+            }
+            mainConfig.intraOpNumThreads = threadBudget;
+
+            OrtPrepackedWeightsContainer *container = nullptr;
+            if (Ort::Status status(Ort::GetApi().CreatePrepackedWeightsContainer(&container));
+                status.IsOK()) {
+                prepackedWeights.reset(container);
+            } else {
+                // The replicas then prepack their own copy of the weights
+                Log.srtWarning("SessionImage [%1] - failed to create prepacked weights "
+                               "container: %2",
+                               filename, status.GetErrorMessage());
+            }
+        }
+        this->modelPath = onnxPath;
+        this->hints = hints;
+        this->config = mainConfig;
+
+        session = createOrtSession(env, onnxPath, preferCpu, mainConfig, threadOptions.get(),
+                                   prepackedWeights.get(), errorMessage);
         if (!session) {
             Log.srtCritical("SessionImage [%1] - create failed", filename);
             return false;
@@ -122,4 +195,38 @@ namespace ds::onnxdriver {
         return true;
     }
 
-}
\ No newline at end of file
+    Ort::Session &SessionImage::sessionFor(int threads) {
+        if (threadBudget <= 0 || threads >= threadBudget) {
+            return session;
+        }
+
+        Replica *replica;
+        {
+            std::lock_guard<std::mutex> lock(replicaMutex);
+            auto &slot = replicas[threads];
+            if (!slot) {
+                slot = std::make_unique<Replica>();
+            }
+            replica = slot.get();
+        }
+
+        // The other runs only wait for the replicas they use
+        std::call_once(replica->once, [&]() {
+            const auto filename = modelPath.filename();
+            Log.srtDebug("SessionImage [%1] - creating replica with %2 threads", filename,
+                         threads);
+            auto replicaConfig = config;
+            replicaConfig.intraOpNumThreads = threads;
+            std::string error;
+            replica->session =
+                createOrtSession(env, modelPath, hints & Session::SH_PreferCPUHint, replicaConfig,
+                                 nullptr, prepackedWeights.get(), &error);
+            if (!replica->session) {
+                Log.srtWarning("SessionImage [%1] - failed to create replica with %2 threads: %3",
+                               filename, threads, error);
+            }
+        });
+        return replica->session ? replica->session : session;
+    }
+
+}
@@ -2,11 +2,17 @@
 #define DSINFER_ONNXDRIVER_SESSIONIMAGE_P_H
 
 #include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #include <synthrt/Support/Expected.h>
 
 #include <onnxruntime_cxx_api.h>
 
+#include "Env.h"
+#include "Realtime.h"
+
 namespace ds::onnxdriver {
 
     class SessionImage {
@@ -15,14 +21,48 @@ namespace ds::onnxdriver {
         ~SessionImage();
 
         bool open(const std::filesystem::path &onnxPath, int hints,
-                  std::string *errorMessage = nullptr);
+                  const Env::DeviceConfig &config, std::string *errorMessage = nullptr);
+
+        /// Returns the replica with \a threads intra-op threads in elastic mode, see
+        /// \c ThreadCoordinator. The replica is created on first use; the main session is
+        /// returned if it cannot be.
+        Ort::Session &sessionFor(int threads);
 
     public:
         std::vector<std::string> inputNames;
         std::vector<std::string> outputNames;
 
+        // Must outlive the session, whose worker threads are created with it in real-time mode
+        std::unique_ptr<RealtimeThreadOptions> threadOptions;
+
+        // Elastic mode: the intra-op threads of the main session, 0 if not elastic
+        int threadBudget = 0;
+
+    protected:
+        struct PrepackedWeightsDeleter {
+            void operator()(OrtPrepackedWeightsContainer *container) const;
+        };
+
+        // Shared by the replicas, so that the weights prepacked by the CPU kernels are stored
+        // once. Must outlive the sessions.
+        std::unique_ptr<OrtPrepackedWeightsContainer, PrepackedWeightsDeleter> prepackedWeights;
+
+    public:
         Ort::Env env;
         Ort::Session session;
+
+    protected:
+        struct Replica {
+            std::once_flag once;
+            Ort::Session session{nullptr};
+        };
+
+        std::filesystem::path modelPath;
+        int hints = 0;
+        Env::DeviceConfig config;
+
+        std::mutex replicaMutex;
+        std::map<int, std::unique_ptr<Replica>> replicas;
     };
 
 }
@@ -1,7 +1,12 @@
 #include "AcousticInference.h"
 
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <shared_mutex>
+#include <thread>
 #include <utility>
 
 #include <stdcorelib/pimpl.h>
@@ -19,10 +24,12 @@
 
 #include <inferutil/Driver.h>
 #include <inferutil/Algorithm.h>
-#include <inferutil/TensorHelper.h>
 #include <inferutil/InputWord.h>
+#include <inferutil/Parallel.h>
 #include <inferutil/SpeakerEmbedding.h>
 #include <inferutil/Speedup.h>
+#include <inferutil/FrameChunk.h>
+#include <inferutil/SessionSkeleton.h>
 
 namespace ds {
 
@@ -45,16 +52,246 @@ namespace ds {
         return genericConfig.as<Ac::AcousticConfiguration>();
     }
 
+    // A variance parameter the acoustic model may take, the input is named after the tag
+    struct AcousticParamSlot {
+        const ParamTag *tag;
+        // The request must supply the parameter if the model takes it
+        bool required;
+        // A parameter supplied without values is filled with a constant
+        bool fillIfEmpty;
+        float fillValue;
+    };
+
+    static const AcousticParamSlot acousticParamSlots[] = {
+        {&Co::Tags::Gender, false, true, 0.0f},
+        {&Co::Tags::Velocity, false, true, 1.0f},
+        {&Co::Tags::Energy, true, false, 0.0f},
+        {&Co::Tags::Breathiness, true, false, 0.0f},
+        {&Co::Tags::Voicing, true, false, 0.0f},
+        {&Co::Tags::Tension, true, false, 0.0f},
+        {&Co::Tags::MouthOpening, false, false, 0.0f},
+    };
+
+    // The singer data derived from the configuration, which every request would otherwise
+    // recompute. Built in initialize() and shared read-only by the requests.
+    struct AcousticPrepared {
+        srt::NO<Ac::AcousticConfiguration> config;
+        double frameWidth = 0;
+        const char *accelerationInput = nullptr;
+
+        // The variance parameters taken by the model, besides f0
+        std::vector<const AcousticParamSlot *> params;
+
+        inferutil::SessionSkeleton skeleton;
+
+        static srt::Expected<std::shared_ptr<const AcousticPrepared>>
+            create(const srt::NO<Ac::AcousticConfiguration> &config) {
+            auto prepared = std::make_shared<AcousticPrepared>();
+            prepared->config = config;
+
+            if (config->hopSize <= 0 || config->sampleRate <= 0) {
+                return srt::Error(srt::Error::InvalidArgument,
+                                  "hop size and sample rate must be positive");
+            }
+            prepared->frameWidth = 1.0 * config->hopSize / config->sampleRate;
+
+            if (config->phonemes.empty()) {
+                return srt::Error(srt::Error::InvalidArgument, "acoustic phoneme list is empty");
+            }
+            if (config->useLanguageId && config->languages.empty()) {
+                return srt::Error(srt::Error::InvalidArgument, "acoustic language list is empty");
+            }
+            if (config->useSpeakerEmbedding) {
+                if (auto res = inferutil::validateSpeakerEmbeddings(config->speakers,
+                                                                    config->hiddenSize);
+                    !res) {
+                    return res.takeError();
+                }
+            }
+
+            prepared->accelerationInput = config->useContinuousAcceleration ? "steps" : "speedup";
+
+            auto &skeleton = prepared->skeleton;
+            skeleton.addInput("tokens");
+            if (config->useLanguageId) {
+                skeleton.addInput("languages");
+            }
+            skeleton.addInput("durations");
+            skeleton.addInput(prepared->accelerationInput);
+            skeleton.addInput("depth");
+            skeleton.addInput("f0");
+            for (const auto &slot : acousticParamSlots) {
+                if (config->parameters.find(*slot.tag) == config->parameters.end()) {
+                    continue;
+                }
+                prepared->params.push_back(&slot);
+                if (slot.required) {
+                    skeleton.addInput(std::string(slot.tag->name()));
+                }
+            }
+            if (config->useSpeakerEmbedding) {
+                skeleton.addInput("spk_embed");
+            }
+            skeleton.addOutput("mel");
+            return std::shared_ptr<const AcousticPrepared>(std::move(prepared));
+        }
+    };
+
     class AcousticInference::Impl {
     public:
+        srt::NO<Ac::AcousticRuntimeOptions> options;
+        std::shared_ptr<const AcousticPrepared> prepared;
         srt::NO<Ac::AcousticResult> result;
         srt::NO<InferenceDriver> driver;
         srt::NO<InferenceSession> session;
+
+        // Extra sessions of the same model for running chunks concurrently
+        std::vector<srt::NO<InferenceSession>> chunkSessions;
+
         mutable std::shared_mutex mutex;
+
+        inline bool isChunked(int64_t targetLength) const {
+            return options->chunkFrames > 0 && targetLength > options->chunkFrames;
+        }
+
+        // Runs the acoustic model chunk by chunk along the frame axis, and stitches the mel by
+        // cropping the context regions. The speaker embedding, the largest frame-axis input, is
+        // mixed for each chunk from \a speakerFrames instead of being sliced out of a full-length
+        // tensor. Must be called with the mutex locked.
+        srt::Expected<srt::NO<ITensor>>
+            runChunked(const AcousticPrepared &prepared,
+                       const srt::NO<Onnx::SessionStartInput> &sessionInput,
+                       const inferutil::SpeakerFrames *speakerFrames, int64_t targetLength,
+                       const char *outParamMel) const {
+            const auto chunks =
+                inferutil::splitFrameChunks(targetLength, options->chunkFrames,
+                                            options->chunkLeftContext, options->chunkRightContext);
+
+            auto expMel =
+                Tensor::create(ITensor::Float, std::vector<int64_t>{
+                                                   1, targetLength, prepared.config->melChannels});
+            if (!expMel) {
+                return expMel.takeError();
+            }
+            srt::NO<ITensor> mel = expMel.take();
+
+            const auto it_durations = sessionInput->inputs.find("durations");
+            if (it_durations == sessionInput->inputs.end()) {
+                return srt::Error(srt::Error::SessionError, "durations missing in acoustic input");
+            }
+
+            const auto runChunk = [&](const srt::NO<InferenceSession> &chunkSession,
+                                      const inferutil::FrameChunk &chunk) -> srt::Expected<void> {
+                auto expRange = inferutil::slicePhonemeDurations(
+                    it_durations->second, chunk.contextBegin, chunk.contextEnd);
+                if (!expRange) {
+                    return expRange.takeError();
+                }
+                const auto &range = expRange.value();
+
+                auto chunkInput = srt::NO<Onnx::SessionStartInput>::create();
+                chunkInput->outputs = sessionInput->outputs;
+                for (const auto &[name, value] : sessionInput->inputs) {
+                    if (name == "durations") {
+                        chunkInput->inputs[name] = range.durations;
+                        continue;
+                    }
+                    srt::Expected<srt::NO<ITensor>> expSlice = value;
+                    if (name == "tokens" || name == "languages") {
+                        // phoneme axis
+                        expSlice = inferutil::sliceTensorAxis1(value, range.first, range.last);
+                    } else if (const auto shape = value->shape();
+                               shape.size() >= 2 && shape[1] == targetLength) {
+                        // frame axis
+                        expSlice = inferutil::sliceTensorAxis1(value, chunk.contextBegin,
+                                                               chunk.contextEnd);
+                    }
+                    if (!expSlice) {
+                        return expSlice.takeError();
+                    }
+                    chunkInput->inputs[name] = expSlice.take();
+                }
+                if (speakerFrames) {
+                    auto expEmbedding = inferutil::mixSpeakerEmbeddingFrames(
+                        *speakerFrames, chunk.contextBegin, chunk.contextEnd);
+                    if (!expEmbedding) {
+                        return expEmbedding.takeError();
+                    }
+                    chunkInput->inputs["spk_embed"] = expEmbedding.take();
+                }
+                if (auto res = prepared.skeleton.checkInputs(*chunkInput); !res) {
+                    return res.takeError();
+                }
+
+                auto sessionExp = chunkSession->start(chunkInput);
+                if (!sessionExp) {
+                    return sessionExp.takeError();
+                }
+                const auto sessionTaskResult = sessionExp.take();
+                if (!sessionTaskResult || sessionTaskResult->objectName() != Onnx::API_NAME) {
+                    return srt::Error(srt::Error::SessionError, "invalid acoustic session result");
+                }
+                const auto sessionResult = sessionTaskResult.as<Onnx::SessionResult>();
+                const auto it_mel = sessionResult->outputs.find(outParamMel);
+                if (it_mel == sessionResult->outputs.end()) {
+                    return srt::Error(srt::Error::SessionError, "invalid result output");
+                }
+                return inferutil::stitchFrames(it_mel->second, chunk, mel);
+            };
+
+            const auto workerCount = (std::min) (chunks.size(), chunkSessions.size() + 1);
+            if (workerCount <= 1) {
+                for (const auto &chunk : chunks) {
+                    if (auto res = runChunk(session, chunk); !res) {
+                        return res.takeError();
+                    }
+                }
+                return mel;
+            }
+
+            // Each worker owns a session and takes the next pending chunk until all are done
+            std::atomic<size_t> nextChunk = 0;
+            std::atomic<bool> failed = false;
+            std::mutex errorMutex;
+            srt::Error firstError;
+
+            const auto worker = [&](const srt::NO<InferenceSession> &chunkSession) {
+                while (!failed) {
+                    const size_t i = nextChunk++;
+                    if (i >= chunks.size()) {
+                        break;
+                    }
+                    if (auto res = runChunk(chunkSession, chunks[i]); !res) {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if (!failed.exchange(true)) {
+                            firstError = res.takeError();
+                        }
+                        break;
+                    }
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(workerCount - 1);
+            for (size_t i = 1; i < workerCount; ++i) {
+                threads.emplace_back(worker, chunkSessions[i - 1]);
+            }
+            worker(session);
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            if (failed) {
+                return firstError;
+            }
+            return mel;
+        }
     };
 
-    AcousticInference::AcousticInference(const srt::InferenceSpec *spec)
+    AcousticInference::AcousticInference(const srt::InferenceSpec *spec,
+                                         const srt::NO<Ac::AcousticRuntimeOptions> &options)
         : Inference(spec), _impl(std::make_unique<Impl>()) {
+        __stdc_impl_t;
+        impl.options = options ? options : srt::NO<Ac::AcousticRuntimeOptions>::create();
     }
 
     AcousticInference::~AcousticInference() = default;
@@ -79,7 +316,7 @@ namespace ds {
         // If there are existing result, they will be cleared.
         impl.result.reset();
 
-        if (auto res = inferutil::getInferenceDriver(this); res) {
+        if (auto res = inferutil::getInferenceDriver(this, acousticArgs->driver); res) {
             impl.driver = res.take();
         } else {
             setState(Failed);
@@ -94,6 +331,13 @@ namespace ds {
         }
         const auto config = expConfig.take();
 
+        if (auto res = AcousticPrepared::create(config); res) {
+            impl.prepared = res.take();
+        } else {
+            setState(Failed);
+            return res.takeError();
+        }
+
         // Open acoustic session
         impl.session = impl.driver->createSession();
         auto sessionOpenArgs = srt::NO<Onnx::SessionOpenArgs>::create();
@@ -103,6 +347,19 @@ namespace ds {
             return res;
         }
 
+        // Open extra sessions for concurrent chunks. The model image is shared by the driver.
+        impl.chunkSessions.clear();
+        if (impl.options->chunkFrames > 0) {
+            for (int i = 1; i < impl.options->chunkConcurrency; ++i) {
+                auto chunkSession = impl.driver->createSession();
+                if (auto res = chunkSession->open(config->model, sessionOpenArgs); !res) {
+                    setState(Failed);
+                    return res;
+                }
+                impl.chunkSessions.push_back(std::move(chunkSession));
+            }
+        }
+
         // Initialize inference state
         setState(Idle);
 
@@ -115,23 +372,19 @@ namespace ds {
 
         __stdc_impl_t;
 
+        std::shared_ptr<const AcousticPrepared> prepared;
         {
             std::shared_lock<std::shared_mutex> lock(impl.mutex);
-            if (!impl.driver) {
+            if (!impl.driver || !impl.prepared) {
                 setState(Failed);
                 return srt::Error(srt::Error::SessionError, "inference driver not initialized");
             }
+            prepared = impl.prepared;
         }
 
         setState(Running);
 
-        // Get acoustic config
-        auto expConfig = getConfig(spec());
-        if (!expConfig) {
-            setState(Failed);
-            return expConfig.takeError();
-        }
-        const auto config = expConfig.take();
+        const auto &config = prepared->config;
 
         if (!input) {
             setState(Failed);
@@ -149,9 +402,9 @@ namespace ds {
         const auto acousticInput = input.as<Ac::AcousticStartInput>();
         // ...
 
-        auto sessionInput = srt::NO<Onnx::SessionStartInput>::create();
+        auto sessionInput = prepared->skeleton.instantiate();
 
-        double frameWidth = 1.0 * config->hopSize / config->sampleRate;
+        const double frameWidth = prepared->frameWidth;
 
         // input param: tokens
         if (auto res =
@@ -198,11 +451,7 @@ namespace ds {
                 setState(Failed);
                 return exp.takeError();
             }
-            if (config->useContinuousAcceleration) {
-                sessionInput->inputs["steps"] = exp.take();
-            } else {
-                sessionInput->inputs["speedup"] = exp.take();
-            }
+            sessionInput->inputs[prepared->accelerationInput] = exp.take();
         }
 
         // input param: depth
@@ -227,25 +476,9 @@ namespace ds {
             sessionInput->inputs["depth"] = exp.take();
         }
 
-        // We define some requirements according to config.
-        //
-        // If the config supports a parameter, the flag is set to false, and
-        // when the input contains such valid parameter, the flag is then set to true.
-        //
-        // If the config does NOT support a parameter, the flag is automatically set to true.
-        // No need to check such input.
-        const auto hasParam = [&](const ParamTag &tag) -> bool {
-            return config->parameters.find(tag) != config->parameters.end();
-        };
-
-        bool satisfyGender = !hasParam(Co::Tags::Gender);
-        bool satisfyVelocity = !hasParam(Co::Tags::Velocity);
-
-        bool satisfyEnergy = !hasParam(Co::Tags::Energy);
-        bool satisfyBreathiness = !hasParam(Co::Tags::Breathiness);
-        bool satisfyVoicing = !hasParam(Co::Tags::Voicing);
-        bool satisfyTension = !hasParam(Co::Tags::Tension);
-        bool satisfyMouthOpening = !hasParam(Co::Tags::MouthOpening);
+        // The parameters the model takes and whether the request supplied them are tracked in the
+        // order of the prepared slots. Missing required ones are reported by the skeleton check.
+        std::vector<bool> satisfyParams(prepared->params.size(), false);
 
         srt::NO<ITensor> f0TensorForVocoder;
 
@@ -253,6 +486,11 @@ namespace ds {
         const Co::InputParameterInfo *pF0Param = nullptr;
         const Co::InputParameterInfo *pToneShiftParam = nullptr;
 
+        // The curves and the speakers are processed by the tasks below, concurrently for long
+        // inputs. The tasks only fill their own buffers, the session inputs are set around them.
+        const bool parallel = targetLength >= inferutil::ParallelFrameThreshold;
+        std::vector<std::function<srt::Expected<void>()>> tasks;
+
         for (const auto &param : acousticInput->parameters) {
             if (param.tag == Co::Tags::F0) {
                 pF0Param = &param;
@@ -269,90 +507,46 @@ namespace ds {
                 continue;
             }
 
-            // Resample the parameters to target time step,
-            // and resize to target frame length (fill with last value)
-            auto resampled = inferutil::resample(param.values, param.interval, frameWidth,
-                                                         targetLength, true);
-            if (resampled.empty()) {
-                // These parameters are optional
-                if (param.tag == Co::Tags::Gender) {
-                    // Fill gender with 0
-                    auto exp =
-                        Tensor::createFilled<float>(std::vector<int64_t>{1, targetLength}, 0.0f);
-                    if (!exp) {
-                        setState(Failed);
-                        return exp.takeError();
-                    }
-                    sessionInput->inputs["gender"] = exp.take();
-                    satisfyGender = true;
-                    continue;
-                }
-                if (param.tag == Co::Tags::Velocity) {
-                    // Fill velocity with 0
-                    auto exp =
-                        Tensor::createFilled<float>(std::vector<int64_t>{1, targetLength}, 1.0f);
-                    if (!exp) {
-                        setState(Failed);
-                        return exp.takeError();
-                    }
-                    sessionInput->inputs["velocity"] = exp.take();
-                    satisfyVelocity = true;
-                    continue;
-                }
+            size_t j = 0;
+            while (j < prepared->params.size() && param.tag != *prepared->params[j]->tag) {
+                ++j;
             }
-            if (resampled.size() != targetLength) {
-                setState(Failed);
-                return srt::Error(srt::Error::SessionError, "parameter " +
-                                                                std::string(param.tag.name()) +
-                                                                " resample failed");
+            if (j == prepared->params.size() || satisfyParams[j]) {
+                // Not taken by the model, or already supplied
+                continue;
             }
+            const auto &slot = *prepared->params[j];
 
-            auto exp = inferutil::TensorHelper<float>::createFor1DArray(targetLength);
+            auto exp = Tensor::create(ITensor::Float, std::vector<int64_t>{1, targetLength});
             if (!exp) {
                 setState(Failed);
                 return exp.takeError();
             }
-            auto &helper = exp.value();
-
-            // for other parameters, simply fill them in.
-            for (const auto item : std::as_const(resampled)) {
-                helper.writeUnchecked(static_cast<float>(item));
-            }
-            if (!satisfyGender && param.tag == Co::Tags::Gender) {
-                sessionInput->inputs["gender"] = helper.take();
-                satisfyGender = true;
-                continue;
-            }
-            if (!satisfyVelocity && param.tag == Co::Tags::Velocity) {
-                sessionInput->inputs["velocity"] = helper.take();
-                satisfyVelocity = true;
-                continue;
-            }
-            if (!satisfyEnergy && param.tag == Co::Tags::Energy) {
-                sessionInput->inputs["energy"] = helper.take();
-                satisfyEnergy = true;
-                continue;
-            }
-            if (!satisfyBreathiness && param.tag == Co::Tags::Breathiness) {
-                sessionInput->inputs["breathiness"] = helper.take();
-                satisfyBreathiness = true;
-                continue;
-            }
-            if (!satisfyVoicing && param.tag == Co::Tags::Voicing) {
-                sessionInput->inputs["voicing"] = helper.take();
-                satisfyVoicing = true;
-                continue;
-            }
-            if (!satisfyTension && param.tag == Co::Tags::Tension) {
-                sessionInput->inputs["tension"] = helper.take();
-                satisfyTension = true;
-                continue;
-            }
-            if (!satisfyMouthOpening && param.tag == Co::Tags::MouthOpening) {
-                sessionInput->inputs["mouth_opening"] = helper.take();
-                satisfyMouthOpening = true;
-                continue;
+            auto paramTensor = exp.take();
+            auto paramBuffer = paramTensor->mutableData<float>();
+            if (!paramBuffer) {
+                setState(Failed);
+                return srt::Error(srt::Error::SessionError, "failed to create param tensor");
             }
+
+            // Resample the parameters to target time step straight into the tensor,
+            // and resize to target frame length (fill with last value)
+            tasks.emplace_back([&param, &slot, paramBuffer, frameWidth,
+                                targetLength]() -> srt::Expected<void> {
+                if (!inferutil::resampleInto(param.values, param.interval, frameWidth,
+                                             targetLength, true, paramBuffer)) {
+                    if (!slot.fillIfEmpty) {
+                        return srt::Error(srt::Error::SessionError,
+                                          "parameter " + std::string(param.tag.name()) +
+                                              " resample failed");
+                    }
+                    // These parameters are optional
+                    std::fill_n(paramBuffer, targetLength, slot.fillValue);
+                }
+                return srt::Expected<void>();
+            });
+            sessionInput->inputs[std::string(param.tag.name())] = std::move(paramTensor);
+            satisfyParams[j] = true;
         }
 
         // First check for f0.
@@ -367,112 +561,118 @@ namespace ds {
                                                                 std::string(param.tag.name()) +
                                                                 " resample failed");
             }
+            std::vector<double> toneShiftSamples;
+            if (pToneShiftParam && !pToneShiftParam->values.empty()) {
+                const auto &toneShift = *pToneShiftParam;
+                toneShiftSamples = inferutil::resample(toneShift.values, toneShift.interval,
+                                                       frameWidth, targetLength, false);
+                if (toneShiftSamples.size() != targetLength) {
+                    return srt::Error(srt::Error::SessionError,
+                                      "parameter " + std::string(toneShift.tag.name()) +
+                                          " resample failed");
+                }
+            }
+
             // Create f0 tensor for acoustic model
-            auto expForAcoustic = inferutil::TensorHelper<float>::createFor1DArray(targetLength);
-            if (!expForAcoustic) {
-                return expForAcoustic.takeError();
+            auto exp = Tensor::create(ITensor::Float, std::vector<int64_t>{1, targetLength});
+            if (!exp) {
+                return exp.takeError();
+            }
+            auto f0Tensor = exp.take();
+            auto f0Buffer = f0Tensor->mutableData<float>();
+            if (!f0Buffer) {
+                return srt::Error(srt::Error::SessionError, "failed to create f0 tensor");
             }
-            auto &acousticHelper = expForAcoustic.value();
 
-            if (pToneShiftParam) {
-                const auto &toneShift = *pToneShiftParam;
-                if (!toneShift.values.empty()) {
-                    auto toneShiftSamples = inferutil::resample(
-                        toneShift.values, toneShift.interval, frameWidth, targetLength, false);
-                    if (toneShiftSamples.size() != targetLength) {
-                        return srt::Error(srt::Error::SessionError,
-                                          "parameter " + std::string(toneShift.tag.name()) +
-                                              " resample failed");
+            // Apply the tone shift, and convert midi note to hz
+            const auto convertFrames = [&](int64_t begin, int64_t end) {
+                constexpr double a4_freq_hz = 440.0;
+                constexpr double midi_a4_note = 69.0;
+                for (int64_t i = begin; i < end; ++i) {
+                    double sample = samples[i];
+                    if (!toneShiftSamples.empty()) {
+                        sample = convertToF0 ? sample + toneShiftSamples[i] / 100.0
+                                             : sample * std::exp2(toneShiftSamples[i] / 1200.0);
                     }
                     if (convertToF0) {
-                        for (size_t i = 0; i < targetLength; ++i) {
-                            samples[i] += toneShiftSamples[i] / 100.0;
-                        }
-                    } else {
-                        for (size_t i = 0; i < targetLength; ++i) {
-                            samples[i] *= std::exp2(toneShiftSamples[i] / 1200.0);
-                        }
+                        sample = a4_freq_hz * std::exp2((sample - midi_a4_note) / 12.0);
                     }
+                    f0Buffer[i] = static_cast<float>(sample);
                 }
-            }
-            if (convertToF0) {
-                // Convert midi note to hz
-                for (const auto midi_note : std::as_const(samples)) {
-                    constexpr double a4_freq_hz = 440.0;
-                    constexpr double midi_a4_note = 69.0;
-                    const auto f0Acoustic =
-                        a4_freq_hz * std::exp2((midi_note - midi_a4_note) / 12.0);
-                    // Buffer guaranteed not to overflow,
-                    // given (resampled.size() == targetLength), which has been checked before
-                    acousticHelper.writeUnchecked(static_cast<float>(f0Acoustic));
-                }
+            };
+            if (parallel) {
+                inferutil::parallelTiles(targetLength, inferutil::ParallelMinTile, convertFrames);
             } else {
-                for (const auto sample : std::as_const(samples)) {
-                    // Buffer guaranteed not to overflow,
-                    // given (resampled.size() == targetLength), which has been checked before
-                    acousticHelper.writeUnchecked(static_cast<float>(sample));
-                }
+                convertFrames(0, targetLength);
             }
-            f0TensorForVocoder = acousticHelper.take();
-            sessionInput->inputs["f0"] = f0TensorForVocoder; // ref count +1
+            f0TensorForVocoder = f0Tensor;
             return srt::Expected<void>();
         };
 
-        if (pF0Param) {
-            // Has f0 parameter
-            if (auto exp = processF0Param(*pF0Param, false); !exp) {
-                setState(Failed);
-                return exp.takeError();
-            }
-        } else if (pPitchParam) {
-            // Has pitch parameter
-            if (auto exp = processF0Param(*pPitchParam, true); !exp) {
-                setState(Failed);
-                return exp.takeError();
-            }
+        if (pF0Param || pPitchParam) {
+            // Has f0 parameter, or pitch parameter otherwise
+            tasks.emplace_back([&]() {
+                return pF0Param ? processF0Param(*pF0Param, false)
+                                : processF0Param(*pPitchParam, true);
+            });
         } else {
             // No pitch or f0 found
             setState(Failed);
             return srt::Error(srt::Error::SessionError, "parameter f0 or pitch missing");
         }
 
-        // Some parameter requirements are not satisfied
-        if (!satisfyEnergy || !satisfyBreathiness || !satisfyVoicing || !satisfyTension) {
-            setState(Failed);
-            std::string msg = "some required parameters missing:";
-            if (!satisfyEnergy)
-                msg += R"( "energy")";
-            if (!satisfyBreathiness)
-                msg += R"( "breathiness")";
-            if (!satisfyVoicing)
-                msg += R"( "voicing")";
-            if (!satisfyTension)
-                msg += R"( "tension")";
-            return srt::Error(srt::Error::SessionError, std::move(msg));
-        }
-
-        // Speaker embedding
+        // Speaker embedding, only mixed for each chunk in chunked mode
+        const bool chunked = impl.isChunked(targetLength);
+        srt::NO<ITensor> speakerEmbedding;
+        std::optional<inferutil::SpeakerFrames> speakerFrames;
         if (config->useSpeakerEmbedding) {
             if (acousticInput->speakers.empty()) {
                 setState(Failed);
                 return srt::Error(srt::Error::SessionError, "no speakers found in acoustic input");
             }
 
-            auto exp = inferutil::preprocessSpeakerEmbeddingFrames(
-                acousticInput->speakers, config->speakers, config->hiddenSize, frameWidth,
-                targetLength);
-            if (exp) {
-                sessionInput->inputs["spk_embed"] = exp.take();
-            } else {
-                setState(Failed);
-                return exp.takeError();
-            }
+            tasks.emplace_back([&]() -> srt::Expected<void> {
+                auto exp = inferutil::resampleSpeakerFrames(acousticInput->speakers,
+                                                            config->speakers, config->hiddenSize,
+                                                            frameWidth, targetLength);
+                if (!exp) {
+                    return exp.takeError();
+                }
+                if (chunked) {
+                    speakerFrames = exp.take();
+                    return srt::Expected<void>();
+                }
+                auto expEmbedding =
+                    inferutil::mixSpeakerEmbeddingFrames(exp.value(), 0, targetLength);
+                if (!expEmbedding) {
+                    return expEmbedding.takeError();
+                }
+                speakerEmbedding = expEmbedding.take();
+                return srt::Expected<void>();
+            });
         } else {
             // Nothing to do: speaker embedding is not supported
         }
 
+        if (auto res = inferutil::runTasks(tasks, parallel); !res) {
+            setState(Failed);
+            return res.takeError();
+        }
+        sessionInput->inputs["f0"] = f0TensorForVocoder; // ref count +1
+        if (speakerEmbedding) {
+            sessionInput->inputs["spk_embed"] = speakerEmbedding;
+        }
+
+        // Some parameter requirements are not satisfied. The inputs of each chunk are checked
+        // instead in chunked mode.
+        if (!chunked) {
+            if (auto res = prepared->skeleton.checkInputs(*sessionInput); !res) {
+                setState(Failed);
+                return res.takeError();
+            }
+        }
+
         constexpr const char *outParamMel = "mel";
-        sessionInput->outputs.emplace(outParamMel);
 
         std::unique_lock<std::shared_mutex> lock(impl.mutex);
         if (!impl.session || !impl.session->isOpen()) {
@@ -480,6 +680,24 @@ namespace ds {
             return srt::Error(srt::Error::SessionError, "acoustic session is not initialized");
         }
 
+        auto acousticResult = srt::NO<Ac::AcousticResult>::create();
+
+        if (chunked) {
+            auto melExp = impl.runChunked(*prepared, sessionInput,
+                                          speakerFrames ? &*speakerFrames : nullptr, targetLength,
+                                          outParamMel);
+            if (!melExp) {
+                setState(Failed);
+                return melExp.takeError();
+            }
+            acousticResult->mel = melExp.take();
+            acousticResult->f0 = f0TensorForVocoder;
+            impl.result = acousticResult;
+
+            setState(Idle);
+            return acousticResult;
+        }
+
         srt::NO<srt::TaskResult> sessionTaskResult;
         auto sessionExp = impl.session->start(sessionInput);
         if (!sessionExp) {
@@ -489,8 +707,6 @@ namespace ds {
             sessionTaskResult = sessionExp.take();
         }
 
-        auto acousticResult = srt::NO<Ac::AcousticResult>::create();
-
         // Get session results
         if (!sessionTaskResult) {
             setState(Failed);
@@ -529,6 +745,9 @@ namespace ds {
         if (!impl.session->stop()) {
             return false;
         }
+        for (const auto &chunkSession : impl.chunkSessions) {
+            chunkSession->stop();
+        }
         setState(Terminated);
         return true;
     }
@@ -3,11 +3,14 @@
 
 #include <synthrt/SVS/Inference.h>
 
+#include <dsinfer/Api/Inferences/Acoustic/1/AcousticApiL1.h>
+
 namespace ds {
 
     class AcousticInference : public srt::Inference {
     public:
-        explicit AcousticInference(const srt::InferenceSpec *spec);
+        AcousticInference(const srt::InferenceSpec *spec,
+                          const srt::NO<Api::Acoustic::L1::AcousticRuntimeOptions> &options);
         ~AcousticInference();
 
     public:
@@ -257,7 +257,21 @@ namespace ds {
     srt::Expected<srt::NO<srt::Inference>> AcousticInterpreter::createInference(
         const srt::InferenceSpec *spec, const srt::NO<srt::InferenceImportOptions> &importOptions,
         const srt::NO<srt::InferenceRuntimeOptions> &runtimeOptions) {
-        return srt::NO<AcousticInference>::create(spec);
+        srt::NO<Ac::AcousticRuntimeOptions> acousticOptions;
+        if (runtimeOptions) {
+            if (runtimeOptions->objectName() != Ac::API_NAME) {
+                return srt::Error{
+                    srt::Error::InvalidArgument,
+                    stdc::formatN(
+                        R"(invalid acoustic runtime options name: expected "%1", got "%2")",
+                        Ac::API_NAME, runtimeOptions->objectName()),
+                };
+            }
+            acousticOptions = runtimeOptions.as<Ac::AcousticRuntimeOptions>();
+        } else {
+            acousticOptions = srt::NO<Ac::AcousticRuntimeOptions>::create();
+        }
+        return srt::NO<AcousticInference>::create(spec, acousticOptions);
     }
 
 }
\ No newline at end of file
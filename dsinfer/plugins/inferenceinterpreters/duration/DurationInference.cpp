@@ -129,7 +129,7 @@ namespace ds {
         // If there are existing result, they will be cleared.
         impl.result.reset();
 
-        if (auto res = inferutil::getInferenceDriver(this); res) {
+        if (auto res = inferutil::getInferenceDriver(this, durationArgs->driver); res) {
             impl.driver = res.take();
         } else {
             setState(Failed);
@@ -1,6 +1,7 @@
 #include "PitchInference.h"
 
 #include <cmath>
+#include <memory>
 #include <mutex>
 #include <numeric>
 #include <shared_mutex>
@@ -22,6 +23,7 @@
 #include <inferutil/Algorithm.h>
 #include <inferutil/InputWord.h>
 #include <inferutil/LinguisticEncoder.h>
+#include <inferutil/SessionSkeleton.h>
 #include <inferutil/SpeakerEmbedding.h>
 #include <inferutil/Speedup.h>
 
@@ -46,8 +48,68 @@ namespace ds {
         return genericConfig.as<Pit::PitchConfiguration>();
     }
 
+    // The singer data derived from the configuration, which every request would otherwise
+    // recompute. Built in initialize() and shared read-only by the requests.
+    struct PitchPrepared {
+        srt::NO<Pit::PitchConfiguration> config;
+        double frameWidth = 0;
+        const char *accelerationInput = nullptr;
+        inferutil::SessionSkeleton skeleton;
+
+        static srt::Expected<std::shared_ptr<const PitchPrepared>>
+            create(const srt::NO<Pit::PitchConfiguration> &config) {
+            auto prepared = std::make_shared<PitchPrepared>();
+            prepared->config = config;
+
+            prepared->frameWidth = config->frameWidth;
+            if (!std::isfinite(prepared->frameWidth) || prepared->frameWidth <= 0) {
+                return srt::Error(srt::Error::InvalidArgument, "frame width must be positive");
+            }
+            if (config->linguisticMode != Co::LinguisticMode::LM_Word &&
+                config->linguisticMode != Co::LinguisticMode::LM_Phoneme) {
+                return srt::Error(srt::Error::InvalidArgument, "invalid LinguisticMode");
+            }
+            if (config->phonemes.empty()) {
+                return srt::Error(srt::Error::InvalidArgument, "pitch phoneme list is empty");
+            }
+            if (config->useLanguageId && config->languages.empty()) {
+                return srt::Error(srt::Error::InvalidArgument, "pitch language list is empty");
+            }
+            if (config->useSpeakerEmbedding) {
+                if (auto res = inferutil::validateSpeakerEmbeddings(config->speakers,
+                                                                    config->hiddenSize);
+                    !res) {
+                    return res.takeError();
+                }
+            }
+
+            prepared->accelerationInput = config->useContinuousAcceleration ? "steps" : "speedup";
+
+            auto &skeleton = prepared->skeleton;
+            skeleton.addInput("encoder_out");
+            skeleton.addInput("note_midi");
+            if (config->useRestFlags) {
+                skeleton.addInput("note_rest");
+            }
+            skeleton.addInput("note_dur");
+            skeleton.addInput("ph_dur");
+            skeleton.addInput("pitch");
+            skeleton.addInput("retake");
+            if (config->useExpressiveness) {
+                skeleton.addInput("expr");
+            }
+            if (config->useSpeakerEmbedding) {
+                skeleton.addInput("spk_embed");
+            }
+            skeleton.addInput(prepared->accelerationInput);
+            skeleton.addOutput("pitch_pred");
+            return std::shared_ptr<const PitchPrepared>(std::move(prepared));
+        }
+    };
+
     class PitchInference::Impl {
     public:
+        std::shared_ptr<const PitchPrepared> prepared;
         srt::NO<Pit::PitchResult> result;
         srt::NO<InferenceDriver> driver;
         srt::NO<InferenceSession> encoderSession;
@@ -81,7 +143,7 @@ namespace ds {
         // If there are existing result, they will be cleared.
         impl.result.reset();
 
-        if (auto res = inferutil::getInferenceDriver(this); res) {
+        if (auto res = inferutil::getInferenceDriver(this, pitchArgs->driver); res) {
             impl.driver = res.take();
         } else {
             setState(Failed);
@@ -96,6 +158,13 @@ namespace ds {
         }
         const auto config = expConfig.take();
 
+        if (auto res = PitchPrepared::create(config); res) {
+            impl.prepared = res.take();
+        } else {
+            setState(Failed);
+            return res.takeError();
+        }
+
         // Open pitch session (encoder)
         impl.encoderSession = impl.driver->createSession();
         auto encoderOpenArgs = srt::NO<Onnx::SessionOpenArgs>::create();
@@ -124,23 +193,19 @@ namespace ds {
     srt::Expected<srt::NO<srt::TaskResult>> PitchInference::start(const srt::NO<srt::TaskStartInput> &input) {
         __stdc_impl_t;
 
+        std::shared_ptr<const PitchPrepared> prepared;
         {
             std::shared_lock<std::shared_mutex> lock(impl.mutex);
-            if (!impl.driver) {
+            if (!impl.driver || !impl.prepared) {
                 setState(Failed);
                 return srt::Error(srt::Error::SessionError, "inference driver not initialized");
             }
+            prepared = impl.prepared;
         }
 
         setState(Running);
 
-        // Get pitch config
-        auto expConfig = getConfig(spec());
-        if (!expConfig) {
-            setState(Failed);
-            return expConfig.takeError();
-        }
-        const auto config = expConfig.take();
+        const auto &config = prepared->config;
 
         if (!input) {
             setState(Failed);
@@ -158,13 +223,9 @@ namespace ds {
         auto pitchInput = input.as<Pit::PitchStartInput>();
         // ...
 
-        auto sessionInput = srt::NO<Onnx::SessionStartInput>::create();
+        auto sessionInput = prepared->skeleton.instantiate();
 
-        double frameWidth = config->frameWidth;
-        if (!std::isfinite(frameWidth) || frameWidth <= 0) {
-            setState(Failed);
-            return srt::Error(srt::Error::InvalidArgument, "frame width must be positive");
-        }
+        const double frameWidth = prepared->frameWidth;
 
         // Part 1: Linguistic Encoder Inference
         {
@@ -279,8 +340,7 @@ namespace ds {
             return exp.takeError();
         }
 
-        if (auto exp = inferutil::preprocessPhonemeDurations(pitchInput->words,
-                                                                     config->frameWidth);
+        if (auto exp = inferutil::preprocessPhonemeDurations(pitchInput->words, frameWidth);
             exp) {
             sessionInput->inputs.emplace("ph_dur", exp.take());
         } else {
@@ -296,15 +356,17 @@ namespace ds {
             if (!isPitch && !isExpr) {
                 continue;
             }
-            // Resample
-            auto samples = inferutil::resample(param.values, param.interval, frameWidth,
-                                                       targetLength, true);
-            if (samples.size() != targetLength) {
-                setState(Failed);
-                return srt::Error(srt::Error::SessionError, "parameter " +
-                                                                std::string(param.tag.name()) +
-                                                                " resample failed");
-            }
+            // Resample straight into the tensor buffer, which is a copy if the parameter is
+            // already on the frame grid of the model
+            const auto resampleInto = [&](float *buffer) -> srt::Expected<void> {
+                if (!inferutil::resampleInto(param.values, param.interval, frameWidth,
+                                             targetLength, true, buffer)) {
+                    return srt::Error(srt::Error::SessionError,
+                                      "parameter " + std::string(param.tag.name()) +
+                                          " resample failed");
+                }
+                return srt::Expected<void>();
+            };
 
             if (isPitch) {
                 if (auto exp = Tensor::create(ITensor::Float, {1, targetLength}); exp) {
@@ -321,8 +383,9 @@ namespace ds {
                         return srt::Error(srt::Error::SessionError,
                                           "failed to create pitch tensor");
                     }
-                    for (size_t i = 0; i < targetLength; ++i) {
-                        pitchBuffer[i] = static_cast<float>(samples[i]);
+                    if (auto res = resampleInto(pitchBuffer); !res) {
+                        setState(Failed);
+                        return res.takeError();
                     }
                     sessionInput->inputs.emplace("pitch", std::move(pitchTensor));
                 } else {
@@ -368,8 +431,9 @@ namespace ds {
                         setState(Failed);
                         return srt::Error(srt::Error::SessionError, "failed to create expr tensor");
                     }
-                    for (size_t i = 0; i < targetLength; ++i) {
-                        exprBuffer[i] = static_cast<float>(samples[i]);
+                    if (auto res = resampleInto(exprBuffer); !res) {
+                        setState(Failed);
+                        return res.takeError();
                     }
                     sessionInput->inputs.emplace("expr", std::move(exprTensor));
                     satisfyExpr = true;
@@ -443,15 +507,15 @@ namespace ds {
                 setState(Failed);
                 return exp.takeError();
             }
-            if (config->useContinuousAcceleration) {
-                sessionInput->inputs["steps"] = exp.take();
-            } else {
-                sessionInput->inputs["speedup"] = exp.take();
-            }
+            sessionInput->inputs[prepared->accelerationInput] = exp.take();
+        }
+
+        if (auto res = prepared->skeleton.checkInputs(*sessionInput); !res) {
+            setState(Failed);
+            return res.takeError();
         }
 
         constexpr const char *outParamPitchPred = "pitch_pred";
-        sessionInput->outputs.emplace(outParamPitchPred);
 
         std::unique_lock<std::shared_mutex> lock(impl.mutex);
         if (!impl.predictorSession || !impl.predictorSession->isOpen()) {
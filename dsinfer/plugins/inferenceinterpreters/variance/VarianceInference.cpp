@@ -2,6 +2,8 @@
 
 #include <cmath>
 #include <cstring>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <numeric>
 #include <shared_mutex>
@@ -23,6 +25,8 @@
 #include <inferutil/Algorithm.h>
 #include <inferutil/InputWord.h>
 #include <inferutil/LinguisticEncoder.h>
+#include <inferutil/Parallel.h>
+#include <inferutil/SessionSkeleton.h>
 #include <inferutil/SpeakerEmbedding.h>
 #include <inferutil/Speedup.h>
 
@@ -61,8 +65,77 @@ namespace ds {
         return genericSchema.as<Var::VarianceSchema>();
     }
 
+    // The singer data derived from the configuration, which every request would otherwise
+    // recompute. Built in initialize() and shared read-only by the requests.
+    struct VariancePrepared {
+        srt::NO<Var::VarianceConfiguration> config;
+        srt::NO<Var::VarianceSchema> schema;
+        double frameWidth = 0;
+        const char *accelerationInput = nullptr;
+
+        // The input and output names of each prediction, in the order of the schema
+        std::vector<std::string> predictionInputs;
+        std::vector<std::string> predictionOutputs;
+
+        inferutil::SessionSkeleton skeleton;
+
+        static srt::Expected<std::shared_ptr<const VariancePrepared>>
+            create(const srt::NO<Var::VarianceConfiguration> &config,
+                   const srt::NO<Var::VarianceSchema> &schema) {
+            auto prepared = std::make_shared<VariancePrepared>();
+            prepared->config = config;
+            prepared->schema = schema;
+
+            prepared->frameWidth = config->frameWidth;
+            if (!std::isfinite(prepared->frameWidth) || prepared->frameWidth <= 0) {
+                return srt::Error(srt::Error::InvalidArgument, "frame width must be positive");
+            }
+            if (config->linguisticMode != Co::LinguisticMode::LM_Word &&
+                config->linguisticMode != Co::LinguisticMode::LM_Phoneme) {
+                return srt::Error(srt::Error::InvalidArgument, "invalid LinguisticMode");
+            }
+            if (config->phonemes.empty()) {
+                return srt::Error(srt::Error::InvalidArgument, "variance phoneme list is empty");
+            }
+            if (config->useLanguageId && config->languages.empty()) {
+                return srt::Error(srt::Error::InvalidArgument, "variance language list is empty");
+            }
+            if (config->useSpeakerEmbedding) {
+                if (auto res = inferutil::validateSpeakerEmbeddings(config->speakers,
+                                                                    config->hiddenSize);
+                    !res) {
+                    return res.takeError();
+                }
+            }
+            if (schema->predictions.empty()) {
+                return srt::Error(srt::Error::InvalidArgument, "no parameters to predict");
+            }
+
+            prepared->accelerationInput = config->useContinuousAcceleration ? "steps" : "speedup";
+
+            auto &skeleton = prepared->skeleton;
+            skeleton.addInput("encoder_out");
+            skeleton.addInput("ph_dur");
+            skeleton.addInput("pitch");
+            skeleton.addInput("retake");
+            for (const auto &prediction : schema->predictions) {
+                std::string name(prediction.name());
+                prepared->predictionOutputs.push_back(name + "_pred");
+                skeleton.addInput(name);
+                skeleton.addOutput(prepared->predictionOutputs.back());
+                prepared->predictionInputs.push_back(std::move(name));
+            }
+            if (config->useSpeakerEmbedding) {
+                skeleton.addInput("spk_embed");
+            }
+            skeleton.addInput(prepared->accelerationInput);
+            return std::shared_ptr<const VariancePrepared>(std::move(prepared));
+        }
+    };
+
     class VarianceInference::Impl {
     public:
+        std::shared_ptr<const VariancePrepared> prepared;
         srt::NO<Var::VarianceResult> result;
         srt::NO<InferenceDriver> driver;
         srt::NO<InferenceSession> encoderSession;
@@ -96,7 +169,7 @@ namespace ds {
         // If there are existing result, they will be cleared.
         impl.result.reset();
 
-        if (auto res = inferutil::getInferenceDriver(this); res) {
+        if (auto res = inferutil::getInferenceDriver(this, varianceArgs->driver); res) {
             impl.driver = res.take();
         } else {
             setState(Failed);
@@ -111,6 +184,20 @@ namespace ds {
         }
         const auto config = expConfig.take();
 
+        // Get variance schema
+        auto expSchema = getSchema(spec());
+        if (!expSchema) {
+            setState(Failed);
+            return expSchema.takeError();
+        }
+
+        if (auto res = VariancePrepared::create(config, expSchema.take()); res) {
+            impl.prepared = res.take();
+        } else {
+            setState(Failed);
+            return res.takeError();
+        }
+
         // Open variance session (encoder)
         impl.encoderSession = impl.driver->createSession();
         auto encoderOpenArgs = srt::NO<Onnx::SessionOpenArgs>::create();
@@ -139,31 +226,20 @@ namespace ds {
     srt::Expected<srt::NO<srt::TaskResult>> VarianceInference::start(const srt::NO<srt::TaskStartInput> &input) {
         __stdc_impl_t;
 
+        std::shared_ptr<const VariancePrepared> prepared;
         {
             std::shared_lock<std::shared_mutex> lock(impl.mutex);
-            if (!impl.driver) {
+            if (!impl.driver || !impl.prepared) {
                 setState(Failed);
                 return srt::Error(srt::Error::SessionError, "inference driver not initialized");
             }
+            prepared = impl.prepared;
         }
 
         setState(Running);
 
-        // Get variance config
-        auto expConfig = getConfig(spec());
-        if (!expConfig) {
-            setState(Failed);
-            return expConfig.takeError();
-        }
-        const auto config = expConfig.take();
-
-        // Get variance schema
-        auto expSchema = getSchema(spec());
-        if (!expSchema) {
-            setState(Failed);
-            return expSchema.takeError();
-        }
-        const auto schema = expSchema.take();
+        const auto &config = prepared->config;
+        const auto &schema = prepared->schema;
 
         if (!input) {
             setState(Failed);
@@ -181,13 +257,9 @@ namespace ds {
         const auto varianceInput = input.as<Var::VarianceStartInput>();
         // ...
 
-        auto sessionInput = srt::NO<Onnx::SessionStartInput>::create();
+        auto sessionInput = prepared->skeleton.instantiate();
 
-        double frameWidth = config->frameWidth;
-        if (!std::isfinite(frameWidth) || frameWidth <= 0) {
-            setState(Failed);
-            return srt::Error(srt::Error::InvalidArgument, "frame width must be positive");
-        }
+        const double frameWidth = prepared->frameWidth;
 
         // Part 1: Linguistic Encoder Inference
         {
@@ -245,8 +317,7 @@ namespace ds {
         const auto targetLength = static_cast<int64_t>(std::llround(totalDuration / frameWidth));
 
         // ph_dur
-        if (auto exp = inferutil::preprocessPhonemeDurations(varianceInput->words,
-                                                                     config->frameWidth);
+        if (auto exp = inferutil::preprocessPhonemeDurations(varianceInput->words, frameWidth);
             exp) {
             sessionInput->inputs.emplace("ph_dur", exp.take());
         } else {
@@ -255,10 +326,6 @@ namespace ds {
         }
 
         // pitch and parameters
-        if (schema->predictions.empty()) {
-            setState(Failed);
-            return srt::Error(srt::Error::SessionError, "no parameters to predict");
-        }
         bool satisfyPitch = false;
         std::vector<bool> satisfyParams(schema->predictions.size(), false);
 
@@ -266,20 +333,32 @@ namespace ds {
         constexpr auto kRetakeFalse = std::byte{0};
         Tensor::Container retake(targetLength * schema->predictions.size(), kRetakeTrue);
 
+        // The curves and the speakers are processed by the tasks below, concurrently for long
+        // inputs. The tasks only fill their own buffers, the session inputs are set around them.
+        const bool parallel = targetLength >= inferutil::ParallelFrameThreshold;
+        std::vector<std::function<srt::Expected<void>()>> tasks;
+
         for (const auto &param : varianceInput->parameters) {
             const auto isPitch = param.tag == Co::Tags::Pitch;
 
-            // Resample
-            auto samples = inferutil::resample(param.values, param.interval, frameWidth,
-                                                       targetLength, true);
-            if (samples.size() != targetLength) {
-                setState(Failed);
-                return srt::Error(srt::Error::SessionError, "parameter " +
-                                                                std::string(param.tag.name()) +
-                                                                " resample failed");
-            }
+            // Resample straight into the tensor buffer, which is a copy if the parameter is
+            // already on the frame grid of the model
+            const auto resampleInto = [&param, frameWidth,
+                                       targetLength](float *buffer) -> srt::Expected<void> {
+                if (!inferutil::resampleInto(param.values, param.interval, frameWidth,
+                                             targetLength, true, buffer)) {
+                    return srt::Error(srt::Error::SessionError,
+                                      "parameter " + std::string(param.tag.name()) +
+                                          " resample failed");
+                }
+                return srt::Expected<void>();
+            };
 
             if (isPitch) {
+                if (satisfyPitch) {
+                    // Already supplied
+                    continue;
+                }
                 if (auto exp = Tensor::create(ITensor::Float, {1, targetLength}); exp) {
                     auto pitchTensor = exp.take();
                     if (pitchTensor->elementCount() != targetLength) {
@@ -294,9 +373,8 @@ namespace ds {
                         return srt::Error(srt::Error::SessionError,
                                           "failed to create pitch tensor");
                     }
-                    for (size_t i = 0; i < targetLength; ++i) {
-                        pitchBuffer[i] = static_cast<float>(samples[i]);
-                    }
+                    tasks.emplace_back(
+                        [resampleInto, pitchBuffer]() { return resampleInto(pitchBuffer); });
                     sessionInput->inputs.emplace("pitch", std::move(pitchTensor));
                     satisfyPitch = true;
                     continue;
@@ -308,9 +386,11 @@ namespace ds {
 
             for (size_t j = 0; j < schema->predictions.size(); ++j) {
                 const auto &prediction = schema->predictions[j];
-                if (param.tag != prediction) {
+                if (param.tag != prediction || satisfyParams[j]) {
+                    // Not predicted, or already supplied
                     continue;
                 }
+                float *paramBuffer;
                 if (auto exp = Tensor::create(ITensor::Float, {1, targetLength}); exp) {
                     auto paramTensor = exp.take();
                     if (paramTensor->elementCount() != targetLength) {
@@ -319,73 +399,113 @@ namespace ds {
                             srt::Error::SessionError,
                             "param tensor element count does not match target length");
                     }
-                    auto paramBuffer = paramTensor->mutableData<float>();
+                    paramBuffer = paramTensor->mutableData<float>();
                     if (!paramBuffer) {
                         setState(Failed);
                         return srt::Error(srt::Error::SessionError,
                                           "failed to create param tensor");
                     }
-                    for (size_t i = 0; i < targetLength; ++i) {
-                        paramBuffer[i] = static_cast<float>(samples[i]);
-                    }
-                    sessionInput->inputs.emplace(param.tag.name(), std::move(paramTensor));
-                    sessionInput->outputs.emplace(std::string(param.tag.name()) + "_pred");
+                    sessionInput->inputs.emplace(prepared->predictionInputs[j],
+                                                 std::move(paramTensor));
                 } else {
                     setState(Failed);
                     return exp.takeError();
                 }
 
-                // Retake
-                if (param.retake.has_value()) {
-                    const auto &[start, end] = *param.retake;
-
-                    // Compute frame index range for this parameter
-                    /// Note: startIndex is inclusive, endIndex is exclusive
-                    const auto startIndex = static_cast<int64_t>(j * targetLength);
-                    const auto endIndex = static_cast<int64_t>((j + 1) * targetLength);
-
-                    // Convert retake start/end time (in seconds) to frame indices,
-                    // clamped to [0, targetLength]
-                    // Note: retakeStartFrame is inclusive, retakeEndFrame is exclusive
-                    int64_t retakeStartFrame = 0;
-                    if (std::isfinite(start) && start >= 0) {
-                        retakeStartFrame = std::clamp<int64_t>(
-                            static_cast<int64_t>(std::llround(start / frameWidth)), int64_t{0},
-                            targetLength);
-                    } else {
-                        // For invalid start (NaN, Inf, or negative): default to 0
-                    }
-                    int64_t retakeEndFrame = targetLength;
-                    if (std::isfinite(end) && end >= 0) {
-                        retakeEndFrame = std::clamp<int64_t>(
-                            static_cast<int64_t>(std::llround(end / frameWidth)), int64_t{0},
-                            targetLength);
-                    } else {
-                        // For invalid end (NaN, Inf, or negative): default to last frame
+                tasks.emplace_back([&retake, &param, resampleInto, paramBuffer, j, frameWidth,
+                                    targetLength, kRetakeFalse]() -> srt::Expected<void> {
+                    if (auto res = resampleInto(paramBuffer); !res) {
+                        return res;
                     }
 
-                    // Get iterators pointing to the beginning and end
-                    // of this parameter's retake region in the tensor
-                    auto it_begin = retake.begin() + startIndex;
-                    auto it_end = retake.begin() + endIndex;
-
-                    if (retakeStartFrame == retakeEndFrame) {
-                        // Zero-length retake interval: mark entire region as 'no retake' (false)
-                        std::fill(it_begin, it_end, kRetakeFalse);
-                    } else if (retakeStartFrame < retakeEndFrame) {
-                        // Mark frames before retake start as "no retake" (false)
-                        std::fill(it_begin, it_begin + retakeStartFrame, kRetakeFalse);
-                        // Frames in [retake start, retake end) remain true
-                        // Mark frames after retake end as "no retake" (false)
-                        std::fill(it_begin + retakeEndFrame, it_end, kRetakeFalse);
+                    // Retake
+                    if (param.retake.has_value()) {
+                        const auto &[start, end] = *param.retake;
+
+                        // Compute frame index range for this parameter
+                        /// Note: startIndex is inclusive, endIndex is exclusive
+                        const auto startIndex = static_cast<int64_t>(j * targetLength);
+                        const auto endIndex = static_cast<int64_t>((j + 1) * targetLength);
+
+                        // Convert retake start/end time (in seconds) to frame indices,
+                        // clamped to [0, targetLength]
+                        // Note: retakeStartFrame is inclusive, retakeEndFrame is exclusive
+                        int64_t retakeStartFrame = 0;
+                        if (std::isfinite(start) && start >= 0) {
+                            retakeStartFrame = std::clamp<int64_t>(
+                                static_cast<int64_t>(std::llround(start / frameWidth)), int64_t{0},
+                                targetLength);
+                        } else {
+                            // For invalid start (NaN, Inf, or negative): default to 0
+                        }
+                        int64_t retakeEndFrame = targetLength;
+                        if (std::isfinite(end) && end >= 0) {
+                            retakeEndFrame = std::clamp<int64_t>(
+                                static_cast<int64_t>(std::llround(end / frameWidth)), int64_t{0},
+                                targetLength);
+                        } else {
+                            // For invalid end (NaN, Inf, or negative): default to last frame
+                        }
+
+                        // Get iterators pointing to the beginning and end
+                        // of this parameter's retake region in the tensor
+                        auto it_begin = retake.begin() + startIndex;
+                        auto it_end = retake.begin() + endIndex;
+
+                        if (retakeStartFrame == retakeEndFrame) {
+                            // Zero-length retake interval: mark entire region as
+                            // 'no retake' (false)
+                            std::fill(it_begin, it_end, kRetakeFalse);
+                        } else if (retakeStartFrame < retakeEndFrame) {
+                            // Mark frames before retake start as "no retake" (false)
+                            std::fill(it_begin, it_begin + retakeStartFrame, kRetakeFalse);
+                            // Frames in [retake start, retake end) remain true
+                            // Mark frames after retake end as "no retake" (false)
+                            std::fill(it_begin + retakeEndFrame, it_end, kRetakeFalse);
+                        }
+                    } else {
+                        // No retake specified: keep full region as true.
+                        // Nothing to do here.
                     }
-                } else {
-                    // No retake specified: keep full region as true.
-                    // Nothing to do here.
-                }
+                    return srt::Expected<void>();
+                });
                 satisfyParams[j] = true;
             }
+        }
+
+        if (!satisfyPitch) {
+            setState(Failed);
+            return srt::Error(srt::Error::SessionError, "missing pitch input");
+        }
+
+        // Speaker embedding
+        srt::NO<ITensor> speakerEmbedding;
+        if (config->useSpeakerEmbedding) {
+            if (varianceInput->speakers.empty()) {
+                setState(Failed);
+                return srt::Error(srt::Error::SessionError, "no speakers found in variance input");
+            }
+
+            tasks.emplace_back([&]() -> srt::Expected<void> {
+                auto exp = inferutil::preprocessSpeakerEmbeddingFrames(
+                    varianceInput->speakers, config->speakers, config->hiddenSize, frameWidth,
+                    targetLength);
+                if (!exp) {
+                    return exp.takeError();
+                }
+                speakerEmbedding = exp.take();
+                return srt::Expected<void>();
+            });
+        } else {
+            // Nothing to do: speaker embedding is not supported
+        }
 
+        if (auto res = inferutil::runTasks(tasks, parallel); !res) {
+            setState(Failed);
+            return res.takeError();
+        }
+        if (speakerEmbedding) {
+            sessionInput->inputs["spk_embed"] = speakerEmbedding;
         }
 
         if (auto exp = Tensor::createFromRawData(
@@ -398,47 +518,20 @@ namespace ds {
             return exp.takeError();
         }
 
-        if (!satisfyPitch) {
-            setState(Failed);
-            return srt::Error(srt::Error::SessionError, "missing pitch input");
-        }
-
         for (size_t j = 0; j < schema->predictions.size(); ++j) {
             if (satisfyParams[j]) {
                 continue;
             }
-            const auto &prediction = schema->predictions[j];
             // If some parameters are not supplied, fill them with 0
             auto exp = Tensor::createFilled<float>({1, targetLength}, 0.0f);
             if (exp) {
-                sessionInput->inputs.emplace(prediction.name(), exp.take());
-                sessionInput->outputs.emplace(std::string(prediction.name()) + "_pred");
+                sessionInput->inputs.emplace(prepared->predictionInputs[j], exp.take());
             } else {
                 setState(Failed);
                 return exp.takeError();
             }
         }
 
-        // Speaker embedding
-        if (config->useSpeakerEmbedding) {
-            if (varianceInput->speakers.empty()) {
-                setState(Failed);
-                return srt::Error(srt::Error::SessionError, "no speakers found in variance input");
-            }
-
-            auto exp = inferutil::preprocessSpeakerEmbeddingFrames(
-                varianceInput->speakers, config->speakers, config->hiddenSize, frameWidth,
-                targetLength);
-            if (exp) {
-                sessionInput->inputs["spk_embed"] = exp.take();
-            } else {
-                setState(Failed);
-                return exp.takeError();
-            }
-        } else {
-            // Nothing to do: speaker embedding is not supported
-        }
-
         // input param: steps / speedup
         int64_t acceleration = varianceInput->steps;
         if (!config->useContinuousAcceleration) {
@@ -450,11 +543,12 @@ namespace ds {
                 setState(Failed);
                 return exp.takeError();
             }
-            if (config->useContinuousAcceleration) {
-                sessionInput->inputs["steps"] = exp.take();
-            } else {
-                sessionInput->inputs["speedup"] = exp.take();
-            }
+            sessionInput->inputs[prepared->accelerationInput] = exp.take();
+        }
+
+        if (auto res = prepared->skeleton.checkInputs(*sessionInput); !res) {
+            setState(Failed);
+            return res.takeError();
         }
 
         std::unique_lock<std::shared_mutex> lock(impl.mutex);
@@ -488,12 +582,12 @@ namespace ds {
         auto sessionResult = sessionTaskResult.as<Onnx::SessionResult>();
         varianceResult->predictions.reserve(sessionResult->outputs.size());
         for (const auto &[outputName, output] : sessionResult->outputs) {
-            for (const auto &prediction : schema->predictions) {
-                if (outputName != std::string(prediction.name()) + "_pred") {
+            for (size_t j = 0; j < schema->predictions.size(); ++j) {
+                if (outputName != prepared->predictionOutputs[j]) {
                     continue;
                 }
                 const auto view = output->view<float>();
-                Co::InputParameterInfo inputParam{prediction};
+                Co::InputParameterInfo inputParam{schema->predictions[j]};
                 inputParam.interval = frameWidth;
                 inputParam.values.assign(view.begin(), view.end());
                 varianceResult->predictions.emplace_back(std::move(inputParam));
@@ -1,5 +1,6 @@
 #include "VocoderInference.h"
 
+#include <algorithm>
 #include <cstring>
 #include <mutex>
 #include <shared_mutex>
@@ -14,6 +15,7 @@
 #include <dsinfer/Api/Inferences/Vocoder/1/VocoderApiL1.h>
 
 #include <inferutil/Driver.h>
+#include <inferutil/PeakPyramid.h>
 
 namespace ds {
 
@@ -70,7 +72,7 @@ namespace ds {
         // If there are existing result, they will be cleared.
         impl.result.reset();
 
-        if (auto res = inferutil::getInferenceDriver(this); res) {
+        if (auto res = inferutil::getInferenceDriver(this, vocoderArgs->driver); res) {
             impl.driver = res.take();
         } else {
             setState(Failed);
@@ -132,7 +134,13 @@ namespace ds {
         }
 
         const auto vocoderInput = input.as<Vo::VocoderStartInput>();
-        // ...
+        for (const auto binSize : vocoderInput->peakBinSizes) {
+            if (binSize <= 0) {
+                setState(Failed);
+                return srt::Error(srt::Error::InvalidArgument,
+                                  stdc::formatN("invalid peak bin size: %1", binSize));
+            }
+        }
 
         auto sessionInput = srt::NO<Onnx::SessionStartInput>::create();
         sessionInput->inputs["mel"] = vocoderInput->mel;
@@ -173,7 +181,26 @@ namespace ds {
             const auto &waveformTensor = it_waveform->second;
             const auto size = waveformTensor->byteSize();
             vocoderResult->audioData.resize(size);
-            if (auto waveformBuffer = waveformTensor->rawData()) {
+            const auto &binSizes = vocoderInput->peakBinSizes;
+            if (!binSizes.empty() && waveformTensor->dataType() != ITensor::Float) {
+                setState(Failed);
+                return srt::Error(srt::Error::SessionError,
+                                  "waveform peaks require a float32 waveform output");
+            }
+            if (const auto waveformBuffer =
+                    binSizes.empty() ? nullptr : waveformTensor->data<float>()) {
+                // Scan each block for peaks right after copying it, while it is still in cache
+                constexpr size_t blockSize = 16384;
+                const auto sampleCount = size / sizeof(float);
+                auto audioBuffer = reinterpret_cast<float *>(vocoderResult->audioData.data());
+                inferutil::PeakPyramidBuilder peaks(binSizes, sampleCount);
+                for (size_t pos = 0; pos < sampleCount; pos += blockSize) {
+                    const auto count = std::min(blockSize, sampleCount - pos);
+                    std::memcpy(audioBuffer + pos, waveformBuffer + pos, count * sizeof(float));
+                    peaks.append(audioBuffer + pos, count);
+                }
+                vocoderResult->peaks = peaks.finish();
+            } else if (auto waveformBuffer = waveformTensor->rawData()) {
                 std::memcpy(vocoderResult->audioData.data(), waveformBuffer, size);
             }
         } else {
@@ -0,0 +1,157 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include <inferutil/FrameChunk.h>
+#include <inferutil/SpeakerEmbedding.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace Co = ds::Api::Common::L1;
+
+using ds::ITensor;
+using ds::Tensor;
+using ds::inferutil::FrameChunk;
+using ds::inferutil::splitFrameChunks;
+using srt::NO;
+
+static NO<ITensor> makeDurations(const std::vector<int64_t> &durations) {
+    return Tensor::createFromView<int64_t>({1, static_cast<int64_t>(durations.size())},
+                                           {durations.data(), durations.data() + durations.size()})
+        .take();
+}
+
+BOOST_AUTO_TEST_SUITE(test_FrameChunk)
+
+BOOST_AUTO_TEST_CASE(test_SplitClampsContext) {
+    // A single chunk when the input is short enough
+    auto chunks = splitFrameChunks(100, 300, 50, 60);
+    BOOST_REQUIRE_EQUAL(chunks.size(), 1);
+    BOOST_CHECK_EQUAL(chunks[0].contextBegin, 0);
+    BOOST_CHECK_EQUAL(chunks[0].contextEnd, 100);
+
+    chunks = splitFrameChunks(1000, 300, 50, 60);
+    BOOST_REQUIRE_EQUAL(chunks.size(), 4);
+    // The context is clamped at both ends of the frame axis
+    BOOST_CHECK_EQUAL(chunks.front().begin, 0);
+    BOOST_CHECK_EQUAL(chunks.front().contextBegin, 0);
+    BOOST_CHECK_EQUAL(chunks.front().contextEnd, chunks.front().end + 60);
+    BOOST_CHECK_EQUAL(chunks.back().end, 1000);
+    BOOST_CHECK_EQUAL(chunks.back().contextEnd, 1000);
+    BOOST_CHECK_EQUAL(chunks.back().contextBegin, chunks.back().begin - 50);
+    BOOST_CHECK_EQUAL(chunks[1].contextBegin, chunks[1].begin - 50);
+    BOOST_CHECK_EQUAL(chunks[1].contextEnd, chunks[1].end + 60);
+}
+
+BOOST_AUTO_TEST_CASE(test_LastShortChunk) {
+    const auto chunks = splitFrameChunks(1001, 250, 16, 16);
+    BOOST_REQUIRE_EQUAL(chunks.size(), 5);
+    int64_t expectedBegin = 0;
+    for (const auto &chunk : chunks) {
+        BOOST_CHECK_EQUAL(chunk.begin, expectedBegin);
+        BOOST_CHECK(chunk.end - chunk.begin <= 250);
+        expectedBegin = chunk.end;
+    }
+    BOOST_CHECK_EQUAL(expectedBegin, 1001);
+    // Balanced, the last chunk is only a little shorter than the others
+    BOOST_CHECK_EQUAL(chunks.front().end - chunks.front().begin, 201);
+    BOOST_CHECK_EQUAL(chunks.back().end - chunks.back().begin, 197);
+}
+
+BOOST_AUTO_TEST_CASE(test_PhonemeStraddlesBoundary) {
+    // Phonemes over [0, 10), [10, 40) and [40, 60)
+    const auto durations = makeDurations({10, 30, 20});
+
+    auto exp = ds::inferutil::slicePhonemeDurations(durations, 20, 45);
+    BOOST_REQUIRE(exp.hasValue());
+    BOOST_CHECK_EQUAL(exp.value().first, 1);
+    BOOST_CHECK_EQUAL(exp.value().last, 3);
+    const auto clipped = exp.value().durations->view<int64_t>();
+    BOOST_CHECK(std::vector<int64_t>(clipped.begin(), clipped.end()) ==
+                std::vector<int64_t>({20, 5}));
+
+    // A range ending on a phoneme boundary does not take the next phoneme
+    exp = ds::inferutil::slicePhonemeDurations(durations, 0, 10);
+    BOOST_REQUIRE(exp.hasValue());
+    BOOST_CHECK_EQUAL(exp.value().first, 0);
+    BOOST_CHECK_EQUAL(exp.value().last, 1);
+
+    BOOST_CHECK(!ds::inferutil::slicePhonemeDurations(durations, 60, 70).hasValue());
+}
+
+BOOST_AUTO_TEST_CASE(test_SliceAxis1) {
+    std::vector<float> values(10 * 3);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<float>(i);
+    }
+    const NO<ITensor> tensor =
+        Tensor::createFromView<float>({1, 10, 3}, {values.data(), values.data() + values.size()})
+            .take();
+
+    auto exp = ds::inferutil::sliceTensorAxis1(tensor, 2, 5);
+    BOOST_REQUIRE(exp.hasValue());
+    BOOST_CHECK(exp.value()->shape() == std::vector<int64_t>({1, 3, 3}));
+    BOOST_CHECK_EQUAL(exp.value()->data<float>()[0], 6.0f);
+    BOOST_CHECK_EQUAL(exp.value()->data<float>()[8], 14.0f);
+
+    BOOST_CHECK(!ds::inferutil::sliceTensorAxis1(tensor, 8, 11).hasValue());
+}
+
+BOOST_AUTO_TEST_CASE(test_StitchWritesEachFrameOnce) {
+    const int64_t length = 1001;
+    const auto chunks = splitFrameChunks(length, 250, 24, 40);
+
+    NO<ITensor> stitched = Tensor::create(ITensor::Float, {1, length, 2}).take();
+    std::vector<int> writes(length, 0);
+    for (const auto &chunk : chunks) {
+        // Each output frame holds its absolute index, context frames included
+        NO<ITensor> output = Tensor::create(ITensor::Float, {1, chunk.contextLength(), 2}).take();
+        auto outputData = output->mutableData<float>();
+        for (int64_t i = 0; i < chunk.contextLength() * 2; ++i) {
+            outputData[i] = static_cast<float>(chunk.contextBegin + i / 2);
+        }
+        BOOST_REQUIRE(ds::inferutil::stitchFrames(output, chunk, stitched).hasValue());
+
+        // Count the frames written by this chunk alone
+        NO<ITensor> marker = Tensor::create(ITensor::Float, {1, length, 2}).take();
+        NO<ITensor> ones = Tensor::createFilled<float>({1, chunk.contextLength(), 2}, 1.0f).take();
+        BOOST_REQUIRE(ds::inferutil::stitchFrames(ones, chunk, marker).hasValue());
+        for (int64_t i = 0; i < length; ++i) {
+            writes[i] += static_cast<int>(marker->data<float>()[i * 2]);
+        }
+    }
+    for (int64_t i = 0; i < length; ++i) {
+        BOOST_REQUIRE_EQUAL(writes[i], 1);
+        BOOST_REQUIRE_EQUAL(stitched->data<float>()[i * 2 + 1], static_cast<float>(i));
+    }
+
+    // The chunk output must cover the context
+    NO<ITensor> shortOutput = Tensor::create(ITensor::Float, {1, 10, 2}).take();
+    BOOST_CHECK(!ds::inferutil::stitchFrames(shortOutput, chunks[0], stitched).hasValue());
+}
+
+BOOST_AUTO_TEST_CASE(test_ChunkSpeakerEmbedding) {
+    const std::map<std::string, std::vector<float>> embeddings{
+        {"a", {1, 2, 3}},
+        {"b", {0.5f, -1, 2}},
+    };
+    const std::vector<Co::InputSpeakerInfo> speakers{
+        {"a", 0.01, std::vector<double>(500, 0.25)},
+        {"b", 0.01, std::vector<double>(300, 0.75)},
+    };
+    auto exp = ds::inferutil::resampleSpeakerFrames(speakers, embeddings, 3, 0.01, 600);
+    BOOST_REQUIRE(exp.hasValue());
+    const auto &frames = exp.value();
+
+    // The embedding of a chunk is the same range of the full one
+    const auto full = ds::inferutil::mixSpeakerEmbeddingFrames(frames, 0, 600).take();
+    const auto chunk = ds::inferutil::mixSpeakerEmbeddingFrames(frames, 250, 420).take();
+    BOOST_REQUIRE(chunk->shape() == std::vector<int64_t>({1, 170, 3}));
+    for (int64_t i = 0; i < 170 * 3; ++i) {
+        BOOST_REQUIRE_EQUAL(chunk->data<float>()[i], full->data<float>()[250 * 3 + i]);
+    }
+
+    BOOST_CHECK(!ds::inferutil::mixSpeakerEmbeddingFrames(frames, 500, 601).hasValue());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
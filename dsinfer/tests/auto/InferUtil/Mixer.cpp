@@ -0,0 +1,46 @@
+#include <cmath>
+#include <vector>
+
+#include <inferutil/Mixer.h>
+
+#include <boost/test/unit_test.hpp>
+
+using ds::inferutil::mixMonoToStereo;
+using ds::inferutil::panGain;
+
+BOOST_AUTO_TEST_SUITE(test_Mixer)
+
+BOOST_AUTO_TEST_CASE(test_PanGain) {
+    const auto center = panGain(1, 0);
+    BOOST_CHECK_CLOSE(center.left, std::sqrt(0.5f), 1e-4);
+    BOOST_CHECK_CLOSE(center.right, std::sqrt(0.5f), 1e-4);
+
+    const auto left = panGain(0.5f, -1);
+    BOOST_CHECK_CLOSE(left.left, 0.5f, 1e-4);
+    BOOST_CHECK_SMALL(left.right, 1e-6f);
+
+    // Out of range pans are clamped
+    const auto right = panGain(1, 3);
+    BOOST_CHECK_SMALL(right.left, 1e-6f);
+    BOOST_CHECK_CLOSE(right.right, 1.0f, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(test_MixMatchesScalar) {
+    // An odd count covers both the vector loop and the tail
+    std::vector<float> samples(37);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = std::sin(0.3f * static_cast<float>(i));
+    }
+    std::vector<float> frames(2 * samples.size(), 0.25f);
+
+    const ds::inferutil::StereoGain gain{0.8f, -0.5f};
+    mixMonoToStereo(samples.data(), samples.size(), gain, frames.data());
+    mixMonoToStereo(samples.data(), samples.size(), gain, frames.data());
+
+    for (size_t i = 0; i < samples.size(); ++i) {
+        BOOST_CHECK_SMALL(frames[2 * i] - (0.25f + 2 * 0.8f * samples[i]), 1e-5f);
+        BOOST_CHECK_SMALL(frames[2 * i + 1] - (0.25f - 2 * 0.5f * samples[i]), 1e-5f);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <inferutil/Parallel.h>
+
+#include <boost/test/unit_test.hpp>
+
+using ds::inferutil::maxParallelThreads;
+using ds::inferutil::parallelFor;
+using ds::inferutil::parallelTiles;
+using ds::inferutil::runTasks;
+
+BOOST_AUTO_TEST_SUITE(test_Parallel)
+
+BOOST_AUTO_TEST_CASE(test_TilesCoverRange) {
+    for (const int64_t length : {1, 1000, 1023, 100000}) {
+        std::vector<int> hits(length, 0);
+        std::mutex mutex;
+        std::vector<int64_t> tileSizes;
+        parallelTiles(length, 1024, [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+                ++hits[i];
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            tileSizes.push_back(end - begin);
+        });
+        BOOST_REQUIRE(!tileSizes.empty());
+        // Tiles are at least the minimum size unless the range is shorter
+        BOOST_CHECK(*std::min_element(tileSizes.begin(), tileSizes.end()) >=
+                    (std::min) (length, int64_t(1024)));
+        for (const auto hit : hits) {
+            BOOST_REQUIRE_EQUAL(hit, 1);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_FirstErrorInOrder) {
+    for (const bool parallel : {false, true}) {
+        std::atomic<int> ran = 0;
+        std::vector<std::function<srt::Expected<void>()>> tasks;
+        for (int i = 0; i < 8; ++i) {
+            tasks.emplace_back([i, &ran]() -> srt::Expected<void> {
+                ++ran;
+                if (i == 3 || i == 5) {
+                    return srt::Error(srt::Error::SessionError, std::to_string(i));
+                }
+                return srt::Expected<void>();
+            });
+        }
+        const auto res = runTasks(tasks, parallel);
+        BOOST_REQUIRE(!res.hasValue());
+        BOOST_CHECK_EQUAL(res.error().message(), "3");
+        // Sequential runs stop at the first error
+        BOOST_CHECK_EQUAL(ran, parallel ? 8 : 4);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_ExceptionRethrown) {
+    for (int round = 0; round < 3; ++round) {
+        std::atomic<int> ran = 0;
+        BOOST_CHECK_THROW(parallelFor(1000,
+                                      [&](size_t i) {
+                                          ++ran;
+                                          if (i == 37) {
+                                              throw std::runtime_error("task failed");
+                                          }
+                                      }),
+                          std::runtime_error);
+        BOOST_CHECK(ran > 0);
+    }
+
+    // The helpers are back in the budget
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    parallelFor(64, [&](size_t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    });
+    BOOST_CHECK_EQUAL(threads.size() > 1, maxParallelThreads() > 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
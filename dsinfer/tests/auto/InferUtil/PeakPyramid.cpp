@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <inferutil/PeakPyramid.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace Vo = ds::Api::Vocoder::L1;
+
+using ds::inferutil::PeakPyramidBuilder;
+using ds::inferutil::computePeakPyramid;
+
+static std::vector<float> makeWaveform(size_t count) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> samples(count);
+    for (auto &sample : samples) {
+        sample = dist(rng);
+    }
+    return samples;
+}
+
+// One bin after another, the last one holding the remaining samples
+static Vo::WaveformPeaks naivePeaks(const std::vector<float> &samples, int binSize) {
+    Vo::WaveformPeaks peaks;
+    peaks.binSize = binSize;
+    for (size_t begin = 0; begin < samples.size(); begin += binSize) {
+        const auto end = (std::min) (begin + binSize, samples.size());
+        float lo = samples[begin];
+        float hi = samples[begin];
+        double sumSquares = 0;
+        for (size_t i = begin; i < end; ++i) {
+            lo = (std::min) (lo, samples[i]);
+            hi = (std::max) (hi, samples[i]);
+            sumSquares += double(samples[i]) * samples[i];
+        }
+        peaks.min.push_back(lo);
+        peaks.max.push_back(hi);
+        peaks.rms.push_back(static_cast<float>(std::sqrt(sumSquares / double(end - begin))));
+    }
+    return peaks;
+}
+
+static void checkPeaks(const Vo::WaveformPeaks &peaks, const Vo::WaveformPeaks &expected) {
+    BOOST_CHECK_EQUAL(peaks.binSize, expected.binSize);
+    BOOST_REQUIRE_EQUAL(peaks.min.size(), expected.min.size());
+    BOOST_REQUIRE_EQUAL(peaks.max.size(), expected.max.size());
+    BOOST_REQUIRE_EQUAL(peaks.rms.size(), expected.rms.size());
+    for (size_t i = 0; i < expected.min.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(peaks.min[i], expected.min[i]);
+        BOOST_REQUIRE_EQUAL(peaks.max[i], expected.max[i]);
+        BOOST_REQUIRE_CLOSE(peaks.rms[i], expected.rms[i], 1e-3);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(test_PeakPyramid)
+
+BOOST_AUTO_TEST_CASE(test_MatchesNaive) {
+    // Not a multiple of any bin size, so that every level ends with a short bin
+    const auto samples = makeWaveform(10007);
+
+    // 96 is not a multiple of 64 and reads the samples, 256 is aggregated from 64, and 3000
+    // spans several reduction blocks
+    for (const auto &binSizes : std::vector<std::vector<int>>{
+             {64, 96, 256},
+             {256, 64, 64, 1024},
+             {3000, 96},
+             {1},
+         }) {
+        const auto levels = computePeakPyramid(samples.data(), samples.size(), binSizes);
+        BOOST_REQUIRE_EQUAL(levels.size(), binSizes.size());
+        for (size_t i = 0; i < binSizes.size(); ++i) {
+            checkPeaks(levels[i], naivePeaks(samples, binSizes[i]));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_BlocksStraddleBins) {
+    const auto samples = makeWaveform(20000);
+    const std::vector<int> binSizes{64, 96, 256, 4096};
+
+    // Appending in odd blocks gives the same peaks as one block
+    PeakPyramidBuilder builder(binSizes);
+    const size_t blockSizes[] = {1, 3, 63, 65, 95, 1000, 1025, 2049};
+    size_t pos = 0;
+    for (size_t k = 0; pos < samples.size(); ++k) {
+        const auto count = (std::min) (blockSizes[k % std::size(blockSizes)], samples.size() - pos);
+        builder.append(samples.data() + pos, count);
+        pos += count;
+    }
+    const auto levels = builder.finish();
+    BOOST_REQUIRE_EQUAL(levels.size(), binSizes.size());
+    for (size_t i = 0; i < binSizes.size(); ++i) {
+        checkPeaks(levels[i], naivePeaks(samples, binSizes[i]));
+    }
+
+    // The builder is reset
+    builder.append(samples.data(), 100);
+    const auto next = builder.finish();
+    checkPeaks(next[0], naivePeaks(std::vector<float>(samples.begin(), samples.begin() + 100), 64));
+}
+
+BOOST_AUTO_TEST_CASE(test_InvalidBinSize) {
+    const auto samples = makeWaveform(100);
+    const auto levels = computePeakPyramid(samples.data(), samples.size(), {0, 64});
+    BOOST_REQUIRE_EQUAL(levels.size(), 2);
+    BOOST_CHECK(levels[0].min.empty());
+    checkPeaks(levels[1], naivePeaks(samples, 64));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,58 @@
+#include <cmath>
+#include <vector>
+
+#include <inferutil/Algorithm.h>
+
+#include <boost/test/unit_test.hpp>
+
+using ds::inferutil::isSameFrameGrid;
+using ds::inferutil::resample;
+using ds::inferutil::resampleInto;
+
+BOOST_AUTO_TEST_SUITE(test_Resample)
+
+BOOST_AUTO_TEST_CASE(test_SameFrameGrid) {
+    BOOST_CHECK(isSameFrameGrid(512.0 / 44100.0, 0.011609977324263039));
+    BOOST_CHECK(!isSameFrameGrid(512.0 / 44100.0, 0.0116));
+    BOOST_CHECK(!isSameFrameGrid(0.0, 0.0));
+}
+
+BOOST_AUTO_TEST_CASE(test_IdentityCopiesValues) {
+    const std::vector<double> values{1, 2, 3, 4};
+    const double interval = 512.0 / 44100.0;
+
+    // The values are copied as they are, and the tail is filled with the last one
+    BOOST_CHECK(resample(values, interval, 512.0 / 44100.0, 6, true) ==
+                std::vector<double>({1, 2, 3, 4, 4, 4}));
+    BOOST_CHECK(resample(values, interval, interval, 6, false) ==
+                std::vector<double>({1, 2, 3, 4, 0, 0}));
+    BOOST_CHECK(resample(values, interval, interval, 2, true) == std::vector<double>({1, 2}));
+
+    std::vector<float> out(4);
+    BOOST_CHECK(resampleInto(values, interval, interval, 4, true, out.data()));
+    BOOST_CHECK(out == std::vector<float>({1, 2, 3, 4}));
+}
+
+BOOST_AUTO_TEST_CASE(test_LinearInterpolation) {
+    // 0 at t = 0 rising to 1 at t = 1, sampled every 0.25 s
+    const std::vector<double> values{0, 1};
+    const auto samples = resample(values, 1.0, 0.25, 6, true);
+    BOOST_REQUIRE_EQUAL(samples.size(), 6);
+    const double expected[] = {0, 0.25, 0.5, 0.75, 0.75, 0.75};
+    for (size_t i = 0; i < samples.size(); ++i) {
+        BOOST_CHECK_CLOSE(samples[i] + 1, expected[i] + 1, 1e-9);
+    }
+
+    // Downsampling picks the source points
+    const std::vector<double> ramp{0, 1, 2, 3, 4, 5, 6};
+    BOOST_CHECK(resample(ramp, 0.5, 1.0, 3, true) == std::vector<double>({0, 2, 4}));
+}
+
+BOOST_AUTO_TEST_CASE(test_InvalidInput) {
+    BOOST_CHECK(resample({}, 1.0, 1.0, 4, true).empty());
+    BOOST_CHECK(resample(std::vector<double>{1, 2}, 0.0, 1.0, 4, true).empty());
+    BOOST_CHECK(resample(std::vector<double>{3}, 0.0, 1.0, 3, true) ==
+                std::vector<double>({3, 3, 3}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,57 @@
+#include <vector>
+
+#include <internal/Elastic.h>
+
+#include <boost/test/unit_test.hpp>
+
+using ds::onnxdriver::ThreadCoordinator;
+
+BOOST_AUTO_TEST_SUITE(test_Elastic)
+
+BOOST_AUTO_TEST_CASE(test_Levels) {
+    BOOST_CHECK((ThreadCoordinator::levels(16) == std::vector<int>{16, 8, 4}));
+    BOOST_CHECK((ThreadCoordinator::levels(6) == std::vector<int>{6, 3, 1}));
+    BOOST_CHECK((ThreadCoordinator::levels(4) == std::vector<int>{4, 2, 1}));
+    BOOST_CHECK((ThreadCoordinator::levels(3) == std::vector<int>{3, 1}));
+    BOOST_CHECK((ThreadCoordinator::levels(2) == std::vector<int>{2, 1}));
+    BOOST_CHECK((ThreadCoordinator::levels(1) == std::vector<int>{1}));
+    BOOST_CHECK((ThreadCoordinator::levels(0) == std::vector<int>{1}));
+}
+
+BOOST_AUTO_TEST_CASE(test_LevelFor) {
+    BOOST_CHECK_EQUAL(ThreadCoordinator::levelFor(16, 100), 16);
+    BOOST_CHECK_EQUAL(ThreadCoordinator::levelFor(16, 16), 16);
+    BOOST_CHECK_EQUAL(ThreadCoordinator::levelFor(16, 15), 8);
+    BOOST_CHECK_EQUAL(ThreadCoordinator::levelFor(16, 8), 8);
+
+    // Three runs share 16 threads without falling to one thread each
+    BOOST_CHECK_EQUAL(ThreadCoordinator::levelFor(16, 16 / 3), 4);
+    BOOST_CHECK_EQUAL(ThreadCoordinator::levelFor(16, 1), 4);
+    BOOST_CHECK_EQUAL(ThreadCoordinator::levelFor(16, 0), 4);
+
+    BOOST_CHECK_EQUAL(ThreadCoordinator::levelFor(3, 2), 1);
+    BOOST_CHECK_EQUAL(ThreadCoordinator::levelFor(1, 0), 1);
+    BOOST_CHECK_EQUAL(ThreadCoordinator::levelFor(0, 4), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_ThreadsFor) {
+    ThreadCoordinator coordinator;
+    BOOST_CHECK_EQUAL(coordinator.threadsFor(16), 16);
+    coordinator.acquire();
+    BOOST_CHECK_EQUAL(coordinator.threadsFor(16), 8);
+    coordinator.acquire();
+    BOOST_CHECK_EQUAL(coordinator.threadsFor(16), 4);
+    coordinator.acquire();
+    BOOST_CHECK_EQUAL(coordinator.inFlight(), 3);
+    BOOST_CHECK_EQUAL(coordinator.threadsFor(16), 4);
+
+    coordinator.release();
+    coordinator.release();
+    BOOST_CHECK_EQUAL(coordinator.inFlight(), 1);
+    BOOST_CHECK_EQUAL(coordinator.threadsFor(16), 8);
+    coordinator.release();
+    BOOST_CHECK_EQUAL(coordinator.inFlight(), 0);
+    BOOST_CHECK_EQUAL(coordinator.threadsFor(16), 16);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,137 @@
+#include <vector>
+
+#include <MixBuffer_p.h>
+
+#include <boost/test/unit_test.hpp>
+
+using ds::inferutil::StereoGain;
+using ds::pipeline::finalFrame;
+using ds::pipeline::MixBuffer;
+
+// Collects the streamed frames and the size of each block
+struct Recorder {
+    std::vector<float> frames;
+    std::vector<size_t> blocks;
+    int sampleRate = 0;
+
+    ds::pipeline::EnsembleRenderer::Sink sink() {
+        return [this](const float *samples, size_t count, int rate) {
+            frames.insert(frames.end(), samples, samples + 2 * count);
+            blocks.push_back(count);
+            sampleRate = rate;
+            return true;
+        };
+    }
+
+    // The left channel of the streamed frames
+    std::vector<float> left() const {
+        std::vector<float> res;
+        for (size_t i = 0; i < frames.size(); i += 2) {
+            res.push_back(frames[i]);
+        }
+        return res;
+    }
+};
+
+static constexpr StereoGain Unity{1, 1};
+
+static void addVoice(MixBuffer &buffer, const std::vector<float> &samples, int64_t position,
+                     StereoGain gain = Unity) {
+    buffer.add(samples.data(), samples.size(), position, gain);
+}
+
+BOOST_AUTO_TEST_SUITE(test_MixBuffer)
+
+BOOST_AUTO_TEST_CASE(test_OutOfOrderCompletion) {
+    MixBuffer buffer;
+    Recorder recorder;
+
+    // The later voice completes first: nothing is final before the earlier one
+    addVoice(buffer, {5, 6}, 4);
+    BOOST_CHECK_EQUAL(finalFrame(buffer, {0}), 0);
+    BOOST_REQUIRE(buffer.flush(finalFrame(buffer, {0}), 64, 44100, recorder.sink()));
+    BOOST_CHECK(recorder.frames.empty());
+
+    addVoice(buffer, {1, 2}, 0);
+    BOOST_CHECK_EQUAL(finalFrame(buffer, {}), 6);
+    BOOST_REQUIRE(buffer.flush(finalFrame(buffer, {}), 64, 44100, recorder.sink()));
+    BOOST_CHECK((recorder.left() == std::vector<float>{1, 2, 0, 0, 5, 6}));
+    BOOST_CHECK_EQUAL(recorder.sampleRate, 44100);
+    BOOST_CHECK_EQUAL(buffer.start(), 6);
+    BOOST_CHECK_EQUAL(buffer.end(), 6);
+}
+
+BOOST_AUTO_TEST_CASE(test_FlushUntilEarliestPending) {
+    MixBuffer buffer;
+    Recorder recorder;
+
+    addVoice(buffer, {1, 1, 1, 1}, 0);
+    BOOST_CHECK_EQUAL(finalFrame(buffer, {6, 3}), 3);
+    BOOST_REQUIRE(buffer.flush(finalFrame(buffer, {6, 3}), 64, 8000, recorder.sink()));
+    BOOST_CHECK((recorder.left() == std::vector<float>{1, 1, 1}));
+    BOOST_CHECK_EQUAL(buffer.start(), 3);
+
+    // The voice at 3 overlaps the rest of the first one, the frame before 6 is silence
+    addVoice(buffer, {2, 2}, 3);
+    BOOST_REQUIRE(buffer.flush(finalFrame(buffer, {6}), 64, 8000, recorder.sink()));
+    BOOST_CHECK((recorder.left() == std::vector<float>{1, 1, 1, 3, 2, 0}));
+    BOOST_CHECK_EQUAL(buffer.start(), 6);
+}
+
+BOOST_AUTO_TEST_CASE(test_DropBeforeFlushedStart) {
+    MixBuffer buffer;
+    Recorder recorder;
+    BOOST_REQUIRE(buffer.flush(5, 64, 8000, recorder.sink()));
+    BOOST_CHECK_EQUAL(buffer.start(), 5);
+
+    // Only the samples from the streamed start on are mixed
+    addVoice(buffer, {1, 2, 3, 4}, 3);
+    BOOST_CHECK_EQUAL(buffer.end(), 7);
+
+    // A voice entirely before it changes nothing
+    addVoice(buffer, {9, 9}, 1);
+    BOOST_CHECK_EQUAL(buffer.end(), 7);
+
+    recorder = {};
+    BOOST_REQUIRE(buffer.flush(buffer.end(), 64, 8000, recorder.sink()));
+    BOOST_CHECK((recorder.left() == std::vector<float>{3, 4}));
+}
+
+BOOST_AUTO_TEST_CASE(test_GainAndSilencePadding) {
+    MixBuffer buffer;
+    Recorder recorder;
+    addVoice(buffer, {2}, 1, {0.5f, 0.25f});
+
+    // Flushing past the mixed frames pads with silence
+    BOOST_REQUIRE(buffer.flush(4, 64, 8000, recorder.sink()));
+    BOOST_CHECK((recorder.frames == std::vector<float>{0, 0, 1, 0.5f, 0, 0, 0, 0}));
+    BOOST_CHECK_EQUAL(buffer.start(), 4);
+    BOOST_CHECK_EQUAL(buffer.end(), 4);
+
+    // Nothing to stream before the start
+    BOOST_REQUIRE(buffer.flush(2, 64, 8000, recorder.sink()));
+    BOOST_CHECK_EQUAL(recorder.blocks.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_BlockSplitting) {
+    MixBuffer buffer;
+    Recorder recorder;
+    addVoice(buffer, std::vector<float>(10, 1), 0);
+    BOOST_REQUIRE(buffer.flush(10, 4, 8000, recorder.sink()));
+    BOOST_CHECK((recorder.blocks == std::vector<size_t>{4, 4, 2}));
+    BOOST_CHECK_EQUAL(recorder.frames.size(), 20);
+
+    // A sink refusing a block stops the flush, the frames stay in the buffer
+    addVoice(buffer, std::vector<float>(6, 1), 10);
+    size_t calls = 0;
+    const auto refuse = [&calls](const float *, size_t, int) {
+        ++calls;
+        return false;
+    };
+    BOOST_CHECK(!buffer.flush(16, 4, 8000, refuse));
+    BOOST_CHECK_EQUAL(calls, 1);
+    BOOST_CHECK_EQUAL(buffer.start(), 10);
+    BOOST_CHECK_EQUAL(buffer.end(), 16);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,66 @@
+#include <pipeline/Preflight.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace Co = ds::Api::Common::L1;
+namespace Ac = ds::Api::Acoustic::L1;
+namespace Dur = ds::Api::Duration::L1;
+namespace Var = ds::Api::Variance::L1;
+
+static ds::pipeline::PreflightSpec makeSpec() {
+    ds::pipeline::PreflightSpec spec;
+    spec.duration = srt::NO<Dur::DurationConfiguration>::create();
+    spec.duration->phonemes = {{"SP", 0}, {"zh/a", 1}};
+    spec.acoustic = srt::NO<Ac::AcousticConfiguration>::create();
+    spec.acoustic->phonemes = {{"SP", 0}, {"a", 1}};
+    spec.acoustic->languages = {{"zh", 1}};
+    spec.acoustic->useLanguageId = true;
+    spec.acoustic->parameters.insert(Co::Tags::Energy);
+    spec.acoustic->parameters.insert(Co::Tags::Breathiness);
+    spec.varianceSchema = srt::NO<Var::VarianceSchema>::create();
+    spec.varianceSchema->predictions.push_back(Co::Tags::Energy);
+    return spec;
+}
+
+static srt::NO<Ac::AcousticStartInput> makeInput(const std::vector<std::string> &tokens) {
+    auto input = srt::NO<Ac::AcousticStartInput>::create();
+    for (const auto &token : tokens) {
+        Co::InputWordInfo word;
+        word.phones.push_back({token, "zh", 0, 0, {}});
+        word.notes.push_back({60, 0, 0.5, Co::GT_None, false});
+        input->words.push_back(word);
+    }
+    input->parameters.push_back({Co::Tags::Breathiness, {}, 0, {}});
+    return input;
+}
+
+BOOST_AUTO_TEST_SUITE(test_Preflight)
+
+BOOST_AUTO_TEST_CASE(test_Valid) {
+    const auto spec = makeSpec();
+    BOOST_CHECK(ds::pipeline::preflight(*makeInput({"SP", "a", "SP"}), spec).hasValue());
+}
+
+BOOST_AUTO_TEST_CASE(test_AllErrorsReported) {
+    auto spec = makeSpec();
+    spec.limits.maxPhonemes = 2;
+
+    auto input = makeInput({"a", "b", "b"});
+    input->words[0].phones[0].language = "ja";
+    input->parameters.clear();
+
+    const auto res = ds::pipeline::preflight(*input, spec);
+    BOOST_REQUIRE(!res.hasValue());
+    BOOST_CHECK(res.error().type() == srt::Error::InvalidArgument);
+
+    const auto &message = res.error().message();
+    BOOST_CHECK(message.find(R"(duration: unknown token "ja/a")") != std::string::npos);
+    BOOST_CHECK(message.find(R"(acoustic: unknown token "zh/b")") != std::string::npos);
+    BOOST_CHECK(message.find(R"(acoustic: unknown language "ja")") != std::string::npos);
+    BOOST_CHECK(message.find("parameter breathiness missing") != std::string::npos);
+    BOOST_CHECK(message.find("parameter energy missing") == std::string::npos);
+    BOOST_CHECK(message.find("exceed the limit") != std::string::npos);
+    BOOST_CHECK(message.find("(6 errors found)") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
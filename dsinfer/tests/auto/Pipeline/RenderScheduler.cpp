@@ -0,0 +1,201 @@
+#include <pipeline/RenderScheduler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace Ac = ds::Api::Acoustic::L1;
+
+using ds::pipeline::RenderPriority;
+using ds::pipeline::RenderResult;
+using ds::pipeline::RenderScheduler;
+using srt::NO;
+
+using ResultRef = std::shared_ptr<const RenderResult>;
+
+// Inputs are told apart by their steps, which the stub renderer copies to the sample rate
+static NO<Ac::AcousticStartInput> makeInput(int steps) {
+    auto input = NO<Ac::AcousticStartInput>::create();
+    input->steps = steps;
+    return input;
+}
+
+// Renders the inputs in the order they are started. An input is held until released or
+// cancelled, unless it is not blocking.
+class StubRenderer {
+public:
+    explicit StubRenderer(std::vector<int> blocking = {}) : blocking(std::move(blocking)) {
+    }
+
+    srt::Expected<RenderResult> operator()(const NO<Ac::AcousticStartInput> &input,
+                                           const RenderResult *previous,
+                                           const std::atomic<bool> *cancelled) {
+        const int steps = input->steps;
+        std::unique_lock<std::mutex> lock(mutex);
+        started.push_back(steps);
+        previousOf.push_back(previous ? previous->sampleRate : 0);
+        cv.notify_all();
+        if (std::find(blocking.begin(), blocking.end(), steps) != blocking.end()) {
+            while (!released && !*cancelled) {
+                cv.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+        if (*cancelled) {
+            return srt::Error(srt::Error::SessionError, "stub render cancelled");
+        }
+        RenderResult result;
+        result.source = input;
+        result.sampleRate = steps;
+        return result;
+    }
+
+    void waitStarted(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return started.size() >= count; });
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+        cv.notify_all();
+    }
+
+    std::vector<int> blocking;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<int> started;
+    std::vector<int> previousOf;
+    bool released = false;
+};
+
+// Collects the outcome of a submitted render
+struct Outcome {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    ResultRef result;
+    srt::Error error;
+
+    RenderScheduler::Callback callback() {
+        return [this](const ResultRef &result, const srt::Error &error) {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->result = result;
+            this->error = error;
+            done = true;
+            cv.notify_all();
+        };
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return done; });
+    }
+};
+
+static void openScheduler(RenderScheduler &scheduler, StubRenderer &renderer,
+                          bool separateSpeculativePipeline = true) {
+    ds::pipeline::RenderSchedulerOptions options;
+    options.separateSpeculativePipeline = separateSpeculativePipeline;
+    options.renderer = [&renderer](const NO<Ac::AcousticStartInput> &input,
+                                   const RenderResult *previous,
+                                   const std::atomic<bool> *cancelled) {
+        return renderer(input, previous, cancelled);
+    };
+    BOOST_REQUIRE(scheduler.open(nullptr, options).hasValue());
+}
+
+BOOST_AUTO_TEST_SUITE(test_RenderScheduler)
+
+BOOST_AUTO_TEST_CASE(test_CacheHitSkipsRender) {
+    StubRenderer renderer;
+    RenderScheduler scheduler;
+    openScheduler(scheduler, renderer);
+
+    Outcome first;
+    scheduler.submit("p", makeInput(10), RenderPriority::Foreground, first.callback());
+    first.wait();
+    BOOST_REQUIRE(first.result);
+    BOOST_CHECK_EQUAL(first.result->sampleRate, 10);
+
+    // Completed on the submitting thread without rendering again
+    Outcome second;
+    scheduler.submit("p", makeInput(10), RenderPriority::Foreground, second.callback());
+    BOOST_CHECK(second.done);
+    BOOST_CHECK(second.result == first.result);
+    BOOST_CHECK(scheduler.cachedResult(*makeInput(10)) == first.result);
+    BOOST_CHECK(!scheduler.cachedResult(*makeInput(11)));
+
+    scheduler.close();
+    BOOST_CHECK(renderer.started == std::vector<int>({10}));
+}
+
+BOOST_AUTO_TEST_CASE(test_ForegroundPreemptsSpeculative) {
+    for (const bool separate : {true, false}) {
+        StubRenderer renderer({1});
+        RenderScheduler scheduler;
+        openScheduler(scheduler, renderer, separate);
+
+        scheduler.speculate("a", makeInput(1));
+        renderer.waitStarted(1);
+
+        // The speculative render is interrupted, and restarted once the foreground one is done
+        Outcome foreground;
+        scheduler.submit("b", makeInput(2), RenderPriority::Foreground, foreground.callback());
+        foreground.wait();
+        BOOST_REQUIRE(foreground.result);
+        BOOST_CHECK_EQUAL(foreground.result->sampleRate, 2);
+
+        renderer.waitStarted(3);
+        renderer.release();
+        while (!scheduler.cachedResult(*makeInput(1))) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        scheduler.close();
+        BOOST_CHECK(renderer.started == std::vector<int>({1, 2, 1}));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_InvalidationDropsStaleResults) {
+    StubRenderer renderer({1, 2});
+    RenderScheduler scheduler;
+    openScheduler(scheduler, renderer);
+
+    // An invalidated render fails and leaves nothing behind
+    Outcome invalidated;
+    scheduler.submit("p", makeInput(1), RenderPriority::Foreground, invalidated.callback());
+    renderer.waitStarted(1);
+    scheduler.invalidate("p");
+    invalidated.wait();
+    BOOST_CHECK(!invalidated.result);
+    BOOST_CHECK_EQUAL(invalidated.error.message(), "render cancelled");
+    BOOST_CHECK(!scheduler.cachedResult(*makeInput(1)));
+
+    // A new input of the phrase supersedes the running one
+    Outcome superseded;
+    scheduler.submit("p", makeInput(2), RenderPriority::Foreground, superseded.callback());
+    renderer.waitStarted(2);
+    Outcome latest;
+    scheduler.submit("p", makeInput(3), RenderPriority::Foreground, latest.callback());
+    superseded.wait();
+    latest.wait();
+    BOOST_CHECK(!superseded.result);
+    BOOST_REQUIRE(latest.result);
+    BOOST_CHECK_EQUAL(latest.result->sampleRate, 3);
+
+    // The next render of the phrase is diffed against the latest result only
+    Outcome next;
+    scheduler.submit("p", makeInput(4), RenderPriority::Foreground, next.callback());
+    next.wait();
+    scheduler.close();
+    BOOST_CHECK(renderer.started == std::vector<int>({1, 2, 3, 4}));
+    BOOST_CHECK(renderer.previousOf == std::vector<int>({0, 0, 0, 3}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,97 @@
+#include <pipeline/ScoreDiff.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace Co = ds::Api::Common::L1;
+namespace Ac = ds::Api::Acoustic::L1;
+
+using ds::pipeline::Stage;
+
+static Co::InputWordInfo makeWord(const std::string &token, int key, double duration) {
+    Co::InputWordInfo word;
+    word.phones.push_back({token, "zh", 0, 0, {}});
+    word.notes.push_back({key, 0, duration, Co::GT_None, false});
+    return word;
+}
+
+static srt::NO<Ac::AcousticStartInput> makeScore(const std::vector<int> &keys) {
+    auto input = srt::NO<Ac::AcousticStartInput>::create();
+    for (const auto key : keys) {
+        input->words.push_back(makeWord("a", key, 1.0));
+    }
+    input->duration = static_cast<double>(keys.size());
+    return input;
+}
+
+static bool covers(const std::vector<ds::pipeline::TimeRange> &ranges, double t) {
+    for (const auto &range : ranges) {
+        if (t >= range.start && t < range.end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+BOOST_AUTO_TEST_SUITE(test_ScoreDiff)
+
+BOOST_AUTO_TEST_CASE(test_Identical) {
+    const auto score = makeScore({60, 62, 64, 65});
+    const auto diff = ds::pipeline::diffScores(*score, *score);
+    BOOST_CHECK(diff.identical());
+    BOOST_CHECK(diff.wordMapping == std::vector<int64_t>({0, 1, 2, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(test_InsertShiftsFollowingWords) {
+    ds::pipeline::ScoreDiffOptions options;
+    options.context.fill(0.25);
+
+    const auto oldScore = makeScore({60, 62, 64, 65, 67, 69});
+    const auto newScore = makeScore({60, 62, 71, 64, 65, 67, 69});
+    const auto diff = ds::pipeline::diffScores(*oldScore, *newScore, options);
+
+    BOOST_CHECK(!diff.identical());
+    BOOST_CHECK(diff.wordMapping == std::vector<int64_t>({0, 1, -1, 2, 3, 4, 5}));
+
+    // Only the inserted word and its context are dirty
+    const auto &acoustic = diff.stage(Stage::Acoustic);
+    BOOST_CHECK(covers(acoustic.dirty, 2.5));
+    BOOST_CHECK(!covers(acoustic.dirty, 0.5));
+    BOOST_CHECK(!covers(acoustic.dirty, 5.5));
+
+    // The words after the insertion are reused with a shift of one word
+    bool shifted = false;
+    for (const auto &span : acoustic.reusable) {
+        if (span.start <= 5.5 && 5.5 < span.end) {
+            BOOST_CHECK_CLOSE(span.shift, 1.0, 1e-9);
+            shifted = true;
+        }
+    }
+    BOOST_CHECK(shifted);
+}
+
+BOOST_AUTO_TEST_CASE(test_ParameterEditDirtiesLaterStages) {
+    ds::pipeline::ScoreDiffOptions options;
+    options.context.fill(0);
+
+    auto oldScore = makeScore({60, 62, 64, 65});
+    oldScore->parameters.push_back({Co::Tags::Breathiness, std::vector<double>(41, 0.0), 0.1});
+    auto newScore = makeScore({60, 62, 64, 65});
+    newScore->parameters.push_back({Co::Tags::Breathiness, std::vector<double>(41, 0.0), 0.1});
+    newScore->parameters.back().values[25] = 1.0;
+
+    const auto diff = ds::pipeline::diffScores(*oldScore, *newScore, options);
+    BOOST_CHECK(diff.stage(Stage::Duration).clean());
+    BOOST_CHECK(diff.stage(Stage::Pitch).clean());
+    BOOST_CHECK(covers(diff.stage(Stage::Variance).dirty, 2.5));
+    BOOST_CHECK(covers(diff.stage(Stage::Vocoder).dirty, 2.5));
+    BOOST_CHECK(!covers(diff.stage(Stage::Vocoder).dirty, 1.0));
+}
+
+BOOST_AUTO_TEST_CASE(test_RemapCurve) {
+    const std::vector<double> values = {0, 1, 2, 3, 4, 5};
+    const std::vector<ds::pipeline::ShiftedSpan> spans = {{0.0, 0.2, 0.0}, {0.4, 0.8, 0.2}};
+    const auto remapped = ds::pipeline::remapCurve(values, 0.1, spans, 8);
+    BOOST_CHECK(remapped == std::vector<double>({0, 1, 1, 1, 2, 3, 4, 5}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,148 @@
+#include <pipeline/SingleFlight.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using ds::pipeline::InputHash;
+using ds::pipeline::SingleFlight;
+
+using Value = std::shared_ptr<const int>;
+
+static InputHash makeKey(uint8_t id) {
+    InputHash key{};
+    key[0] = id;
+    return key;
+}
+
+BOOST_AUTO_TEST_SUITE(test_SingleFlight)
+
+BOOST_AUTO_TEST_CASE(test_coalesce) {
+    SingleFlight<Value> flight;
+    std::atomic<int> calls = 0;
+    std::atomic<bool> release = false;
+
+    const auto fn = [&]() -> srt::Expected<Value> {
+        ++calls;
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return std::make_shared<const int>(42);
+    };
+
+    constexpr int threadCount = 8;
+    std::vector<Value> results(threadCount);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&, i]() {
+            auto exp = flight.run(makeKey(1), fn);
+            BOOST_REQUIRE(exp.hasValue());
+            results[i] = exp.value();
+        });
+    }
+    while (flight.sharedCount() == 0 && calls == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    release = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    BOOST_CHECK(calls + flight.sharedCount() == threadCount);
+    BOOST_CHECK(flight.size() == 0);
+    for (const auto &result : results) {
+        BOOST_CHECK(result && *result == 42);
+    }
+
+    // Nothing is kept once done
+    auto exp = flight.run(makeKey(1), [&]() -> srt::Expected<Value> {
+        ++calls;
+        return std::make_shared<const int>(7);
+    });
+    BOOST_CHECK(exp.hasValue() && *exp.value() == 7);
+}
+
+BOOST_AUTO_TEST_CASE(test_errorShared) {
+    SingleFlight<Value> flight;
+    std::atomic<bool> started = false;
+    std::atomic<bool> release = false;
+
+    std::thread leader([&]() {
+        auto exp = flight.run(makeKey(2), [&]() -> srt::Expected<Value> {
+            started = true;
+            while (!release) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return srt::Error(srt::Error::SessionError, "failed");
+        });
+        BOOST_CHECK(!exp.hasValue());
+    });
+    while (!started) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    bool waiterRan = false;
+    std::thread waiter([&]() {
+        bool shared = false;
+        auto exp = flight.run(
+            makeKey(2),
+            [&]() -> srt::Expected<Value> {
+                waiterRan = true;
+                return std::make_shared<const int>(0);
+            },
+            nullptr, &shared);
+        BOOST_CHECK(!exp.hasValue());
+        BOOST_CHECK(shared);
+    });
+    while (flight.size() != 1 || flight.sharedCount() != 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    release = true;
+    leader.join();
+    waiter.join();
+    BOOST_CHECK(!waiterRan);
+}
+
+BOOST_AUTO_TEST_CASE(test_cancelledLeader) {
+    SingleFlight<Value> flight;
+    std::atomic<bool> leaderCancelled = false;
+    std::atomic<bool> started = false;
+
+    std::thread leader([&]() {
+        auto exp = flight.run(
+            makeKey(3),
+            [&]() -> srt::Expected<Value> {
+                started = true;
+                while (!leaderCancelled) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                return srt::Error(srt::Error::SessionError, "render cancelled");
+            },
+            &leaderCancelled);
+        BOOST_CHECK(!exp.hasValue());
+    });
+    while (!started) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // The waiter does not fail with the cancelled leader, it runs the computation itself
+    std::thread waiter([&]() {
+        bool shared = true;
+        auto exp = flight.run(
+            makeKey(3), [&]() -> srt::Expected<Value> { return std::make_shared<const int>(3); },
+            nullptr, &shared);
+        BOOST_CHECK(exp.hasValue() && *exp.value() == 3);
+        BOOST_CHECK(!shared);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    leaderCancelled = true;
+    leader.join();
+    waiter.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,198 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#  include <unistd.h>
+#endif
+
+#include <stdcorelib/str.h>
+
+#include <dsinfer/Api/Inferences/Acoustic/1/AcousticApiL1.h>
+#include <dsinfer/Api/Inferences/Duration/1/DurationApiL1.h>
+#include <dsinfer/Api/Inferences/Variance/1/VarianceApiL1.h>
+
+#include <pipeline/StageClient.h>
+#include <pipeline/StageCodec.h>
+#include <pipeline/StageServer.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace Co = ds::Api::Common::L1;
+namespace Ac = ds::Api::Acoustic::L1;
+namespace Dur = ds::Api::Duration::L1;
+namespace Var = ds::Api::Variance::L1;
+
+using ds::pipeline::Stage;
+using ds::pipeline::StageMessage;
+using srt::NO;
+
+static NO<Dur::DurationStartInput> makeDurationInput(int phoneCount) {
+    auto input = NO<Dur::DurationStartInput>::create();
+    Co::InputWordInfo word;
+    for (int i = 0; i < phoneCount; ++i) {
+        word.phones.push_back({"a", "zh", 0, 0, {}});
+    }
+    word.notes.push_back({60, 0, 0.5, Co::GT_None, false});
+    input->words.push_back(word);
+    return input;
+}
+
+// Gives every phoneme the same duration
+static srt::Expected<NO<srt::TaskResult>> runDuration(const NO<srt::TaskStartInput> &input) {
+    const auto durationInput = input.as<Dur::DurationStartInput>();
+    if (durationInput->words.empty()) {
+        return srt::Error(srt::Error::InvalidArgument, "no words");
+    }
+    auto result = NO<Dur::DurationResult>::create();
+    for (const auto &word : durationInput->words) {
+        result->durations.resize(result->durations.size() + word.phones.size(), 0.1);
+    }
+    return NO<srt::TaskResult>(result);
+}
+
+BOOST_AUTO_TEST_SUITE(test_StageTransport)
+
+BOOST_AUTO_TEST_CASE(test_CodecRoundTrip) {
+    auto input = NO<Var::VarianceStartInput>::create();
+    input->duration = 12;
+    input->words = makeDurationInput(2)->words;
+    // Long enough to be moved out to a blob
+    std::vector<double> pitch(4096);
+    for (size_t i = 0; i < pitch.size(); ++i) {
+        pitch[i] = 60 + 0.001 * static_cast<double>(i);
+    }
+    input->parameters.push_back({Co::Tags::Pitch, pitch, 0.01, {}});
+    input->parameters.push_back({Co::Tags::Energy, {0.5, 0.25}, 0.01, {{1, 2}}});
+    input->speakers.push_back({"alto", 0.05, {1, 1}});
+    input->steps = 20;
+
+    StageMessage message;
+    BOOST_REQUIRE(ds::pipeline::encodeStageInput(Stage::Variance, *input, message).hasValue());
+    BOOST_CHECK_EQUAL(message.blobs.size(), 1);
+
+    auto exp = ds::pipeline::decodeStageInput(message);
+    BOOST_REQUIRE(exp.hasValue());
+    const auto decoded = exp.value().as<Var::VarianceStartInput>();
+    BOOST_CHECK_EQUAL(decoded->duration, 12);
+    BOOST_CHECK_EQUAL(decoded->words.size(), 1);
+    BOOST_CHECK_EQUAL(decoded->words[0].phones[1].token, "a");
+    BOOST_REQUIRE_EQUAL(decoded->parameters.size(), 2);
+    BOOST_CHECK(decoded->parameters[0].tag == Co::Tags::Pitch);
+    BOOST_CHECK(decoded->parameters[0].values == pitch);
+    BOOST_REQUIRE(decoded->parameters[1].retake.has_value());
+    BOOST_CHECK_EQUAL(decoded->parameters[1].retake->end, 2);
+    BOOST_CHECK_EQUAL(decoded->speakers[0].name, "alto");
+    BOOST_CHECK_EQUAL(decoded->steps, 20);
+
+    // Tensors, and a message of the wrong kind
+    auto result = NO<Ac::AcousticResult>::create();
+    result->mel = ds::Tensor::createFilled<float>({1, 1000, 128}, 0.5f).take();
+    BOOST_REQUIRE(ds::pipeline::encodeStageResult(Stage::Acoustic, *result, message).hasValue());
+    BOOST_CHECK(!ds::pipeline::decodeStageInput(message).hasValue());
+
+    auto resultExp = ds::pipeline::decodeStageResult(message);
+    BOOST_REQUIRE(resultExp.hasValue());
+    const auto mel = resultExp.value().as<Ac::AcousticResult>()->mel;
+    BOOST_REQUIRE(mel);
+    BOOST_CHECK(mel->shape() == result->mel->shape());
+    BOOST_CHECK_EQUAL(mel->data<float>()[1000 * 128 - 1], 0.5f);
+    BOOST_CHECK(!resultExp.value().as<Ac::AcousticResult>()->f0);
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(test_ServerAndClient) {
+    const auto path = stdc::formatN("/tmp/dsinfer-test-stage-%1.sock", ::getpid());
+    ds::pipeline::StageServer server(Stage::Duration, runDuration);
+    BOOST_REQUIRE(server.listen(path).hasValue());
+    std::thread serving([&server]() { server.serve(true); });
+
+    // The unreachable endpoint is skipped
+    ds::pipeline::StageClient client(Stage::Duration, {path + ".missing", path});
+    auto exp = client.run(*makeDurationInput(3));
+    BOOST_REQUIRE(exp.hasValue());
+    const auto durations = exp.value().as<Dur::DurationResult>()->durations;
+    BOOST_CHECK(durations == std::vector<double>({0.1, 0.1, 0.1}));
+
+    // Errors of the handler are sent back
+    exp = client.run(Dur::DurationStartInput());
+    BOOST_REQUIRE(!exp.hasValue());
+    BOOST_CHECK_EQUAL(exp.error().message(), "no words");
+
+    // Inputs of another stage are rejected
+    ds::pipeline::StageClient wrongStage(Stage::Pitch, {path});
+    BOOST_CHECK(!wrongStage.run(Dur::DurationStartInput()).hasValue());
+
+    server.stop();
+    serving.join();
+    server.close();
+
+    BOOST_CHECK(!client.run(*makeDurationInput(1)).hasValue());
+    BOOST_CHECK_EQUAL(client.inFlight(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_Backpressure) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int running = 0;
+    bool released = false;
+
+    const auto path = stdc::formatN("/tmp/dsinfer-test-stage-bp-%1.sock", ::getpid());
+    ds::pipeline::StageServer server(
+        Stage::Duration, [&](const NO<srt::TaskStartInput> &input) {
+            std::unique_lock<std::mutex> lock(mutex);
+            ++running;
+            cv.notify_all();
+            cv.wait(lock, [&]() { return released; });
+            --running;
+            return runDuration(input);
+        });
+    BOOST_REQUIRE(server.listen(path).hasValue());
+    std::thread serving([&server]() { server.serve(true); });
+
+    ds::pipeline::StageClient client(Stage::Duration, {path}, 1);
+    std::atomic<int> succeeded = 0;
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 3; ++i) {
+        callers.emplace_back([&]() {
+            if (client.run(*makeDurationInput(1)).hasValue()) {
+                ++succeeded;
+            }
+        });
+    }
+
+    // Only one call reaches the server, the others wait in the client
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return running > 0; });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        BOOST_CHECK_EQUAL(running, 1);
+        BOOST_CHECK_EQUAL(client.inFlight(), 1);
+    }
+
+    // A waiting call can be cancelled
+    std::atomic<bool> cancelled = true;
+    BOOST_CHECK(!client.run(*makeDurationInput(1), &cancelled).hasValue());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+    }
+    cv.notify_all();
+    for (auto &caller : callers) {
+        caller.join();
+    }
+    BOOST_CHECK_EQUAL(succeeded, 3);
+
+    server.stop();
+    serving.join();
+    server.close();
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
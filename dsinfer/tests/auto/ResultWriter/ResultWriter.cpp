@@ -0,0 +1,161 @@
+#include <string>
+#include <vector>
+
+#include <synthrt/Support/JSON.h>
+
+#include <AcousticInputParser.h>
+#include <ResultWriter.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace Ac = ds::Api::Acoustic::L1;
+namespace Co = ds::Api::Common::L1;
+
+static srt::NO<Ac::AcousticStartInput> sampleInput() {
+    auto input = srt::NO<Ac::AcousticStartInput>::create();
+    input->duration = 1.5;
+    input->steps = 20;
+    input->depth = 0.75f;
+
+    Co::InputWordInfo word;
+    Co::InputPhonemeInfo phone;
+    phone.token = "a";
+    phone.language = "zh";
+    phone.tone = 3;
+    phone.start = 0.125;
+    phone.speakers = {
+        {"alto",  0.25},
+        {"tenor", 0.75},
+    };
+    word.phones.push_back(phone);
+    phone.token = "SP \"quoted\"\t";
+    phone.language = "";
+    phone.tone = 0;
+    phone.start = 0.5;
+    phone.speakers.clear();
+    word.phones.push_back(phone);
+    word.notes.push_back({60, -12, 0.5, Co::GT_Up, false});
+    word.notes.push_back({0, 0, 1.0, Co::GT_None, true});
+    input->words.push_back(word);
+
+    Co::InputParameterInfo pitch{Co::Tags::Pitch};
+    pitch.values = {60.1, 60.25, 61.0, -0.5};
+    pitch.interval = 0.01;
+    pitch.retake = Co::InputParameterInfo::RetakeRange{0.02, 0.04};
+    input->parameters.push_back(pitch);
+
+    Co::InputParameterInfo energy{Co::Tags::Energy};
+    energy.values = {-12.5};
+    input->parameters.push_back(energy);
+
+    Co::InputSpeakerInfo speaker;
+    speaker.name = "alto";
+    speaker.interval = 0.5;
+    speaker.proportions = {0.1, 0.2, 0.3};
+    input->speakers.push_back(speaker);
+    speaker.name = "tenor";
+    speaker.interval = 0;
+    speaker.proportions = {1};
+    input->speakers.push_back(speaker);
+    return input;
+}
+
+static srt::NO<Ac::AcousticStartInput> roundTrip(const Ac::AcousticStartInput &input,
+                                                 ds::CurveFormat format) {
+    std::string json;
+    ds::writeAcousticStartInput(json, input, {format});
+
+    std::string error;
+    const auto root = srt::JsonValue::fromJson(json, false, &error);
+    BOOST_REQUIRE_MESSAGE(error.empty(), error);
+    BOOST_REQUIRE(root.isObject());
+    auto exp = ds::parseAcousticStartInput(root.toObject());
+    BOOST_REQUIRE_MESSAGE(exp.hasValue(), json);
+    return exp.take();
+}
+
+// The float32 format rounds the curve values, not the other numbers
+static void checkCurve(const std::vector<double> &actual, const std::vector<double> &expected,
+                       ds::CurveFormat format) {
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (format == ds::CurveFormat::Float32 && expected.size() > 1) {
+            BOOST_CHECK_EQUAL(actual[i], static_cast<double>(static_cast<float>(expected[i])));
+        } else {
+            BOOST_CHECK_EQUAL(actual[i], expected[i]);
+        }
+    }
+}
+
+static void checkRoundTrip(ds::CurveFormat format) {
+    const auto expected = sampleInput();
+    const auto actual = roundTrip(*expected, format);
+
+    BOOST_CHECK_EQUAL(actual->duration, expected->duration);
+    BOOST_CHECK_EQUAL(actual->steps, expected->steps);
+    BOOST_CHECK_EQUAL(actual->depth, expected->depth);
+
+    BOOST_REQUIRE_EQUAL(actual->words.size(), expected->words.size());
+    for (size_t i = 0; i < expected->words.size(); ++i) {
+        const auto &actualWord = actual->words[i];
+        const auto &expectedWord = expected->words[i];
+        BOOST_REQUIRE_EQUAL(actualWord.phones.size(), expectedWord.phones.size());
+        for (size_t j = 0; j < expectedWord.phones.size(); ++j) {
+            const auto &actualPhone = actualWord.phones[j];
+            const auto &expectedPhone = expectedWord.phones[j];
+            BOOST_CHECK_EQUAL(actualPhone.token, expectedPhone.token);
+            BOOST_CHECK_EQUAL(actualPhone.language, expectedPhone.language);
+            BOOST_CHECK_EQUAL(actualPhone.tone, expectedPhone.tone);
+            BOOST_CHECK_EQUAL(actualPhone.start, expectedPhone.start);
+            BOOST_REQUIRE_EQUAL(actualPhone.speakers.size(), expectedPhone.speakers.size());
+            for (size_t k = 0; k < expectedPhone.speakers.size(); ++k) {
+                BOOST_CHECK_EQUAL(actualPhone.speakers[k].name, expectedPhone.speakers[k].name);
+                BOOST_CHECK_EQUAL(actualPhone.speakers[k].proportion,
+                                  expectedPhone.speakers[k].proportion);
+            }
+        }
+        BOOST_REQUIRE_EQUAL(actualWord.notes.size(), expectedWord.notes.size());
+        for (size_t j = 0; j < expectedWord.notes.size(); ++j) {
+            const auto &actualNote = actualWord.notes[j];
+            const auto &expectedNote = expectedWord.notes[j];
+            BOOST_CHECK_EQUAL(actualNote.key, expectedNote.key);
+            BOOST_CHECK_EQUAL(actualNote.cents, expectedNote.cents);
+            BOOST_CHECK_EQUAL(actualNote.duration, expectedNote.duration);
+            BOOST_CHECK_EQUAL(actualNote.glide, expectedNote.glide);
+            BOOST_CHECK_EQUAL(actualNote.is_rest, expectedNote.is_rest);
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL(actual->parameters.size(), expected->parameters.size());
+    for (size_t i = 0; i < expected->parameters.size(); ++i) {
+        const auto &actualParam = actual->parameters[i];
+        const auto &expectedParam = expected->parameters[i];
+        BOOST_CHECK(actualParam.tag == expectedParam.tag);
+        BOOST_CHECK_EQUAL(actualParam.interval, expectedParam.interval);
+        checkCurve(actualParam.values, expectedParam.values, format);
+        BOOST_REQUIRE_EQUAL(actualParam.retake.has_value(), expectedParam.retake.has_value());
+        if (expectedParam.retake) {
+            BOOST_CHECK_EQUAL(actualParam.retake->start, expectedParam.retake->start);
+            BOOST_CHECK_EQUAL(actualParam.retake->end, expectedParam.retake->end);
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL(actual->speakers.size(), expected->speakers.size());
+    for (size_t i = 0; i < expected->speakers.size(); ++i) {
+        BOOST_CHECK_EQUAL(actual->speakers[i].name, expected->speakers[i].name);
+        BOOST_CHECK_EQUAL(actual->speakers[i].interval, expected->speakers[i].interval);
+        checkCurve(actual->speakers[i].proportions, expected->speakers[i].proportions, format);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(test_result_writer)
+
+BOOST_AUTO_TEST_CASE(test_acoustic_round_trip_text) {
+    checkRoundTrip(ds::CurveFormat::Text);
+}
+
+BOOST_AUTO_TEST_CASE(test_acoustic_round_trip_float32) {
+    checkRoundTrip(ds::CurveFormat::Float32);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,72 @@
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include <dsinfer/Support/CurveEncoding.h>
+#include <dsinfer/Support/FloatFormat.h>
+
+#include <boost/test/unit_test.hpp>
+
+static std::string formatted(double value) {
+    char buf[ds::FloatFormatBufferSize];
+    return std::string(buf, ds::formatShortest(value, buf));
+}
+
+static std::string formatted(float value) {
+    char buf[ds::FloatFormatBufferSize];
+    return std::string(buf, ds::formatShortest(value, buf));
+}
+
+BOOST_AUTO_TEST_SUITE(test_float_format)
+
+BOOST_AUTO_TEST_CASE(test_shortest) {
+    BOOST_CHECK_EQUAL(formatted(0.1), "0.1");
+    BOOST_CHECK_EQUAL(formatted(-2.5), "-2.5");
+    BOOST_CHECK_EQUAL(formatted(100.0), "100");
+    BOOST_CHECK_EQUAL(formatted(0.1f), "0.1");
+    BOOST_CHECK_EQUAL(formatted(static_cast<float>(440.123)), "440.123");
+
+    std::string json;
+    ds::appendJsonArray(json, std::vector<double>{0.5, NAN, 3});
+    BOOST_CHECK_EQUAL(json, "[0.5,null,3]");
+}
+
+BOOST_AUTO_TEST_CASE(test_round_trip) {
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> dist(-1e6, 1e6);
+    for (int i = 0; i < 10000; ++i) {
+        const double value = dist(rng);
+        BOOST_CHECK_EQUAL(std::strtod(formatted(value).c_str(), nullptr), value);
+
+        const auto single = static_cast<float>(value);
+        BOOST_CHECK_EQUAL(std::strtof(formatted(single).c_str(), nullptr), single);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_float32_encoding) {
+    BOOST_CHECK_EQUAL(ds::decodeBase64("aGVsbG8").value(), "hello");
+
+    std::string encoded;
+    ds::appendBase64(encoded, "hello");
+    BOOST_CHECK_EQUAL(encoded, "aGVsbG8=");
+    BOOST_CHECK(!ds::decodeBase64("a$b=").hasValue());
+
+    const std::vector<double> values = {0, 1.5, -440.25, 1e-3};
+    encoded.clear();
+    ds::appendFloat32Base64(encoded, values);
+    BOOST_CHECK_EQUAL(encoded.size(), 24u);
+
+    auto exp = ds::decodeFloat32Base64(encoded);
+    BOOST_REQUIRE(exp.hasValue());
+    const auto &decoded = exp.value();
+    BOOST_REQUIRE_EQUAL(decoded.size(), values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        BOOST_CHECK_EQUAL(decoded[i], static_cast<double>(static_cast<float>(values[i])));
+    }
+
+    // Not a multiple of 4 bytes
+    BOOST_CHECK(!ds::decodeFloat32LE("abc").hasValue());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,230 @@
+#include "PackageTool.h"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <bit7z/bit7zlibrary.hpp>
+#include <bit7z/bitarchivereader.hpp>
+#include <bit7z/bitfilecompressor.hpp>
+
+#include <stdcorelib/system.h>
+#include <stdcorelib/path.h>
+#include <stdcorelib/str.h>
+
+#include <synthrt/Core/PackageManifest.h>
+#include <synthrt/Support/Logging.h>
+
+namespace fs = std::filesystem;
+
+static srt::LogCategory packageLog("cli");
+
+static int resolveThreads(int threads) {
+    if (threads > 0) {
+        return threads;
+    }
+    return static_cast<int>((std::max) (1u, std::thread::hardware_concurrency()));
+}
+
+static fs::path sevenZipLibraryPath() {
+    const auto appDir = stdc::system::application_directory();
+#ifdef _WIN32
+    const fs::path dirs[] = {appDir};
+    const fs::path names[] = {_TSTR("7zip.dll"), _TSTR("7z.dll")};
+#else
+    const fs::path dirs[] = {appDir, appDir.parent_path() / _TSTR("lib")};
+#  ifdef __APPLE__
+    const fs::path names[] = {_TSTR("lib7zip.dylib"), _TSTR("7z.dylib")};
+#  else
+    const fs::path names[] = {_TSTR("lib7zip.so"), _TSTR("7z.so")};
+#  endif
+#endif
+    for (const auto &dir : dirs) {
+        for (const auto &name : names) {
+            std::error_code ec;
+            if (fs::is_regular_file(dir / name, ec)) {
+                return dir / name;
+            }
+        }
+    }
+    throw std::runtime_error("7-Zip library not found next to the executable");
+}
+
+int execPack(const fs::path &packagePath, const fs::path &outputPath, int threads) {
+    threads = resolveThreads(threads);
+
+    auto exp = srt::PackageManifest::create(packagePath, threads);
+    if (!exp) {
+        throw std::runtime_error(stdc::formatN(R"(failed to checksum package "%1": %2)",
+                                               packagePath, exp.error().message()));
+    }
+    const auto &manifest = exp.value();
+    if (auto res = manifest.save(packagePath); !res) {
+        throw std::runtime_error(stdc::formatN(R"(failed to save manifest of "%1": %2)",
+                                               packagePath, res.error().message()));
+    }
+    packageLog.srtInfo("Checksummed %1 files", manifest.files.size());
+
+    std::error_code ec;
+    fs::remove(outputPath, ec);
+
+    bit7z::Bit7zLibrary lib(stdc::path::to_utf8(sevenZipLibraryPath()));
+    bit7z::BitFileCompressor compressor(lib, bit7z::BitFormat::Zip);
+    compressor.setThreadsCount(threads);
+    compressor.compressDirectoryContents(stdc::path::to_utf8(packagePath),
+                                         stdc::path::to_utf8(outputPath));
+
+    packageLog.srtSuccess("Packed " + stdc::path::to_utf8(outputPath));
+    return 0;
+}
+
+// Splits the files into groups of similar total size, largest first, so that a few big models do
+// not end up on the same thread
+static std::vector<std::vector<uint32_t>>
+    partitionItems(const std::vector<bit7z::BitArchiveItemInfo> &items, int groupCount) {
+    std::vector<const bit7z::BitArchiveItemInfo *> files;
+    for (const auto &item : items) {
+        if (!item.isDir()) {
+            files.push_back(&item);
+        }
+    }
+    std::sort(files.begin(), files.end(),
+              [](const auto *a, const auto *b) { return a->size() > b->size(); });
+
+    groupCount = (std::max) (1, (std::min) (groupCount, static_cast<int>(files.size())));
+    std::vector<std::vector<uint32_t>> groups(groupCount);
+    std::vector<uint64_t> groupSizes(groupCount, 0);
+    for (const auto *file : files) {
+        const auto i = std::min_element(groupSizes.begin(), groupSizes.end()) - groupSizes.begin();
+        groups[i].push_back(file->index());
+        groupSizes[i] += file->size();
+    }
+    return groups;
+}
+
+// Whether the destination can be replaced without asking: it is missing, empty, or a package
+static bool isReplaceable(const fs::path &dir) {
+    std::error_code ec;
+    if (!fs::exists(dir, ec)) {
+        return true;
+    }
+    if (!fs::is_directory(dir, ec)) {
+        return false;
+    }
+    if (fs::directory_iterator(dir, ec) == fs::directory_iterator()) {
+        return !ec;
+    }
+    return srt::PackageManifest::exists(dir) || fs::is_regular_file(dir / _TSTR("desc.json"), ec);
+}
+
+int execInstall(const fs::path &archivePath, const fs::path &destPath, int threads, bool force) {
+    threads = resolveThreads(threads);
+
+    auto destDir = fs::absolute(destPath).lexically_normal();
+    if (destDir.filename().empty()) {
+        // Trailing separator
+        destDir = destDir.parent_path();
+    }
+    if (!force && !isReplaceable(destDir)) {
+        throw std::runtime_error(
+            stdc::formatN(R"("%1" exists and is not a package, use --force to replace it)",
+                          destDir));
+    }
+    const auto tempDir = fs::path(destDir).concat(_TSTR(".installing"));
+    fs::remove_all(tempDir);
+    fs::create_directories(tempDir);
+
+    bit7z::Bit7zLibrary lib(stdc::path::to_utf8(sevenZipLibraryPath()));
+    const auto archive = stdc::path::to_utf8(archivePath);
+    const auto outDir = stdc::path::to_utf8(tempDir);
+
+    // Each thread extracts its own files through a separate reader
+    {
+        const auto groups = partitionItems(
+            bit7z::BitArchiveReader(lib, archive, bit7z::BitFormat::Zip).items(), threads);
+
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        const auto extract = [&](const std::vector<uint32_t> &indices) {
+            try {
+                bit7z::BitArchiveReader reader(lib, archive, bit7z::BitFormat::Zip);
+                reader.extractTo(outDir, indices);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(groups.size());
+        for (size_t i = 1; i < groups.size(); ++i) {
+            workers.emplace_back(extract, std::cref(groups[i]));
+        }
+        if (!groups.empty()) {
+            extract(groups[0]);
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        if (error) {
+            fs::remove_all(tempDir);
+            std::rethrow_exception(error);
+        }
+    }
+
+    const auto fail = [&](const std::string &message) {
+        std::error_code ec;
+        fs::remove_all(tempDir, ec);
+        throw std::runtime_error(stdc::formatN(R"(failed to install "%1": %2)", archivePath,
+                                               message));
+    };
+
+    if (!srt::PackageManifest::exists(tempDir)) {
+        fail("package has no manifest");
+    }
+    auto exp = srt::PackageManifest::load(tempDir);
+    if (!exp) {
+        fail(exp.error().message());
+    }
+    if (auto res = exp.value().verify(tempDir, threads); !res) {
+        fail(res.error().message());
+    }
+    // Stamp before moving, the modification times are kept by the rename
+    if (auto res = srt::PackageManifest::writeVerifiedStamp(tempDir); !res) {
+        fail(res.error().message());
+    }
+    packageLog.srtInfo("Verified %1 files", exp.value().files.size());
+
+    // Move the previous install aside, and only delete it once the new one is in place
+    const auto oldDir = fs::path(destDir).concat(_TSTR(".old"));
+    fs::remove_all(oldDir);
+    const bool hadPrevious = fs::exists(destDir);
+    if (hadPrevious) {
+        fs::rename(destDir, oldDir);
+    }
+    std::error_code ec;
+    fs::rename(tempDir, destDir, ec);
+    if (ec) {
+        if (hadPrevious) {
+            std::error_code restoreError;
+            fs::rename(oldDir, destDir, restoreError);
+        }
+        fail(ec.message());
+    }
+    if (hadPrevious) {
+        fs::remove_all(oldDir, ec);
+        if (ec) {
+            packageLog.srtWarning("Could not remove the previous install %1: %2",
+                                  stdc::path::to_utf8(oldDir), ec.message());
+        }
+    }
+
+    packageLog.srtSuccess("Installed to " + stdc::path::to_utf8(destDir));
+    return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef DSINFER_CLI_PACKAGETOOL_H
+#define DSINFER_CLI_PACKAGETOOL_H
+
+#include <filesystem>
+
+/// Checksums the files of the package directory into \c package-info/manifest.json and
+/// compresses the directory into a \c dspk archive.
+int execPack(const std::filesystem::path &packagePath, const std::filesystem::path &outputPath,
+             int threads);
+
+/// Extracts a \c dspk archive, verifies the files against the manifest, and moves the package
+/// into \a destPath, replacing the previous install.
+///
+/// \a destPath is only replaced if it is missing, empty or a package, unless \a force is set.
+/// The previous install is moved aside and deleted once the new one is in place.
+int execInstall(const std::filesystem::path &archivePath, const std::filesystem::path &destPath,
+                int threads, bool force = false);
+
+#endif // DSINFER_CLI_PACKAGETOOL_H
@@ -1,5 +1,19 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+
+#ifndef _WIN32
+#  include <sys/socket.h>
+#  include <sys/un.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
 
 #include <stdcorelib/system.h>
 #include <stdcorelib/console.h>
@@ -16,23 +30,21 @@
 #include <dsinfer/Inference/InferenceDriver.h>
 #include <dsinfer/Inference/InferenceDriverPlugin.h>
 #include <dsinfer/Api/Inferences/Acoustic/1/AcousticApiL1.h>
-#include <dsinfer/Api/Inferences/Duration/1/DurationApiL1.h>
-#include <dsinfer/Api/Inferences/Pitch/1/PitchApiL1.h>
-#include <dsinfer/Api/Inferences/Variance/1/VarianceApiL1.h>
-#include <dsinfer/Api/Inferences/Vocoder/1/VocoderApiL1.h>
 #include <dsinfer/Api/Drivers/Onnx/OnnxDriverApi.h>
 
+#include <pipeline/Pipeline.h>
+#include <pipeline/StageClient.h>
+#include <pipeline/StageServer.h>
+
 #include <AcousticInputParser.h>
+#include <ResultWriter.h>
 #include <WavFile.h>
 
+#include "PackageTool.h"
+
 namespace fs = std::filesystem;
 
-namespace Co = ds::Api::Common::L1;
 namespace Ac = ds::Api::Acoustic::L1;
-namespace Dur = ds::Api::Duration::L1;
-namespace Pit = ds::Api::Pitch::L1;
-namespace Var = ds::Api::Variance::L1;
-namespace Vo = ds::Api::Vocoder::L1;
 
 using EP = ds::Api::Onnx::ExecutionProvider;
 
@@ -108,7 +120,7 @@ static void log_report_callback(int level, const srt::LogContext &ctx,
     console::println(console::nostyle, foreground, console::nocolor, msg);
 }
 
-static void initializeSU(srt::SynthUnit &su, EP ep, int deviceIndex) {
+static void initializeSU(srt::SynthUnit &su, EP ep, int deviceIndex, int numThreads = 0) {
     // Get basic directories
     auto appDir = stdc::system::application_directory();
     auto defaultPluginDir =
@@ -138,6 +150,8 @@ static void initializeSU(srt::SynthUnit &su, EP ep, int deviceIndex) {
         onnxArgs->runtimePath = ortParentPath / _TSTR("default");
     }
     onnxArgs->deviceIndex = deviceIndex;
+    onnxArgs->intraOpNumThreads = numThreads;
+    onnxArgs->interOpNumThreads = numThreads;
 
     if (auto exp = onnxDriver->initialize(onnxArgs); !exp) {
         throw std::runtime_error(
@@ -195,26 +209,12 @@ struct InputObject {
     }
 };
 
-static int exec(const fs::path &packagePath, const fs::path &inputPath,
-                const fs::path &outputWavPath, EP ep, int deviceIndex) {
-    // Read input
-    InputObject input;
-    if (auto exp = InputObject::load(inputPath); !exp) {
-        const auto &err = exp.error();
-        throw std::runtime_error(
-            stdc::formatN(R"(failed to read input file "%1": %2)", inputPath, err.message()));
-    } else {
-        input = exp.take();
-    }
-
-    srt::SynthUnit su;
-    initializeSU(su, ep, deviceIndex);
-
+static void loadPackage(srt::SynthUnit &su, const fs::path &packagePath,
+                        srt::ScopedPackageRef &pkg) {
     // Add package directory to search path
     su.addPackagePath(packagePath.parent_path());
 
     // Load package
-    srt::ScopedPackageRef pkg;
     if (auto exp = su.open(packagePath, false); !exp) {
         throw std::runtime_error(stdc::formatN(R"(failed to open package "%1": %2)", packagePath,
                                                exp.error().message()));
@@ -225,420 +225,489 @@ static int exec(const fs::path &packagePath, const fs::path &inputPath,
         throw std::runtime_error(stdc::formatN(R"(failed to load package "%1": %2)", packagePath,
                                                pkg.error().message()));
     }
+}
 
-    // Find singer
+static const srt::SingerSpec *findSinger(srt::SynthUnit &su, const std::string &id) {
     auto &sc = *su.category("singer")->as<srt::SingerCategory>();
-    const auto &singers = sc.singers();
-    const srt::SingerSpec *singerSpec = nullptr;
-    for (const auto &singer : singers) {
-        if (singer->id() == input.singer) {
-            singerSpec = singer;
-            break;
+    for (const auto &singer : sc.singers()) {
+        if (singer->id() == id) {
+            return singer;
         }
     }
-    if (!singerSpec) {
-        throw std::runtime_error(
-            stdc::formatN(R"(singer "%1" not found in package)", input.singer));
-    }
+    throw std::runtime_error(stdc::formatN(R"(singer "%1" not found in package)", id));
+}
 
-    struct ImportData {
-        NO<srt::InferenceImportOptions> options;
-        srt::InferenceSpec *inference = nullptr;
-    };
+static int writeOutput(const ds::pipeline::RenderResult &result, const fs::path &outputPath) {
+    // Write the completed input instead of audio if a JSON output is requested, e.g.
+    // "out.json" for text curves or "out.f32.json" for base64 float32 curves
+    if (stdc::to_lower(stdc::path::to_utf8(outputPath.extension())) == ".json") {
+        ds::ResultWriterOptions writerOptions;
+        if (stdc::to_lower(stdc::path::to_utf8(outputPath.stem().extension())) == ".f32") {
+            writerOptions.curveFormat = ds::CurveFormat::Float32;
+        }
 
-    ImportData importDuration, importPitch, importVariance, importAcoustic, importVocoder;
+        std::string json;
+        ds::writeAcousticStartInput(json, *result.input, writerOptions);
 
-    struct ImportEntry {
-        std::string_view className;
-        std::string_view apiName;
-        ImportData *data;
-    };
+        std::ofstream file(outputPath, std::ios::binary);
+        if (!file.is_open()) {
+            cliLog.srtCritical("Failed to open output file.");
+            return -1;
+        }
+        file.write(json.data(), static_cast<std::streamsize>(json.size()));
+        file.close();
 
-    ImportEntry imports[] = {
-        {Dur::API_CLASS, Dur::API_NAME, &importDuration},
-        {Pit::API_CLASS, Pit::API_NAME, &importPitch   },
-        {Var::API_CLASS, Var::API_NAME, &importVariance},
-        {Ac::API_CLASS,  Ac::API_NAME,  &importAcoustic},
-        {Vo::API_CLASS,  Vo::API_NAME,  &importVocoder },
-    };
+        cliLog.srtSuccess("Saved parameters to " + stdc::path::to_utf8(outputPath));
+        return 0;
+    }
 
-    // Assign imports
-    for (const auto &imp : singerSpec->imports()) {
-        const auto &cls = imp.inference()->className();
-        for (auto &entry : imports) {
-            if (cls == entry.className) {
-                *entry.data = {imp.options(), imp.inference()};
-                break;
-            }
+    const auto &audioData = result.audioData;
+
+    // Process audio data
+    {
+        using ds::WavFile;
+
+        WavFile::DataFormat format{};
+        format.container = WavFile::Container::RIFF;
+        format.format = WavFile::WaveFormat::IEEE_FLOAT;
+        format.channels = 1;
+        format.sampleRate = result.sampleRate;
+        format.bitsPerSample = 32;
+
+        WavFile wav;
+        if (!wav.init_file_write(outputPath, format)) {
+            cliLog.srtCritical("Failed to initialize WAV writer.");
+            return -1;
         }
-    }
 
-    // Check for missing inferences
-    for (const auto &entry : imports) {
-        if (!entry.data->inference) {
-            throw std::runtime_error(stdc::formatN(R"(%1 inference not found for singer "%2")",
-                                                   entry.apiName, input.singer));
+        auto totalPCMFrameCount = audioData.size() / (format.channels * sizeof(float));
+
+        auto framesWritten = wav.write_pcm_frames(totalPCMFrameCount, audioData.data());
+        if (framesWritten != totalPCMFrameCount) {
+            cliLog.srtCritical("Failed to write all frames.");
         }
-    }
+        wav.close();
 
-    // Check whether acoustic and vocoder config match
-    const auto acousticConfig =
-        importAcoustic.inference->configuration().as<Ac::AcousticConfiguration>();
-    const auto vocoderConfig =
-        importVocoder.inference->configuration().as<Vo::VocoderConfiguration>();
-    std::vector<std::string> unmatchedFields;
-    if (acousticConfig->sampleRate != vocoderConfig->sampleRate) {
-        unmatchedFields.emplace_back("sampleRate");
+        cliLog.srtSuccess("Saved audio to " + stdc::path::to_utf8(outputPath));
     }
-    if (acousticConfig->hopSize != vocoderConfig->hopSize) {
-        unmatchedFields.emplace_back("hopSize");
+
+    return 0;
+}
+
+static InputObject loadInput(const fs::path &inputPath) {
+    auto exp = InputObject::load(inputPath);
+    if (!exp) {
+        throw std::runtime_error(stdc::formatN(R"(failed to read input file "%1": %2)",
+                                               inputPath, exp.error().message()));
     }
-    if (acousticConfig->winSize != vocoderConfig->winSize) {
-        unmatchedFields.emplace_back("winSize");
+    return exp.take();
+}
+
+static int exec(const fs::path &packagePath, const fs::path &inputPath,
+                const fs::path &outputPath, EP ep, int deviceIndex,
+                const ds::pipeline::PipelineOptions &options = {}) {
+    // Read input
+    InputObject input = loadInput(inputPath);
+
+    srt::SynthUnit su;
+    initializeSU(su, ep, deviceIndex);
+
+    // Load package and find singer
+    srt::ScopedPackageRef pkg;
+    loadPackage(su, packagePath, pkg);
+    const auto singerSpec = findSinger(su, input.singer);
+
+    // Run all stages
+    ds::pipeline::Pipeline pipeline;
+    if (auto exp = pipeline.open(singerSpec, options); !exp) {
+        throw std::runtime_error(exp.error().message());
     }
-    if (acousticConfig->fftSize != vocoderConfig->fftSize) {
-        unmatchedFields.emplace_back("fftSize");
+
+    ds::pipeline::RenderResult result;
+    if (auto exp = pipeline.render(input.input); !exp) {
+        throw std::runtime_error(exp.error().message());
+    } else {
+        result = exp.take();
     }
-    if (acousticConfig->melChannels != vocoderConfig->melChannels) {
-        unmatchedFields.emplace_back("melChannels");
+    return writeOutput(result, outputPath);
+}
+
+#ifndef _WIN32
+// Zygote mode: a single process loads the package and opens a pipeline for each singer, then
+// forks a worker per request. The workers inherit the loaded plugins, packages and sessions
+// copy-on-write, so they start without loading anything and share the model weight pages.
+//
+// Protocol over the Unix socket, one request per connection:
+//   request:  <input_path> '\t' <output_path> '\n'
+//   response: "0\n" on success, or "1 <message>\n"
+
+static volatile std::sig_atomic_t zygoteStopRequested = 0;
+
+static void zygoteStopHandler(int) {
+    zygoteStopRequested = 1;
+}
+
+static bool readLine(int fd, std::string &line) {
+    static constexpr size_t maxLength = 65536;
+    line.clear();
+    char ch;
+    while (line.size() < maxLength) {
+        auto n = ::read(fd, &ch, 1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        if (ch == '\n') {
+            return true;
+        }
+        line.push_back(ch);
     }
-    if (acousticConfig->melMinFreq != vocoderConfig->melMinFreq) {
-        unmatchedFields.emplace_back("melMinFreq");
+    return false;
+}
+
+static void writeAll(int fd, const std::string &data) {
+    size_t pos = 0;
+    while (pos < data.size()) {
+        auto n = ::write(fd, data.data() + pos, data.size() - pos);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        pos += n;
     }
-    if (acousticConfig->melMaxFreq != vocoderConfig->melMaxFreq) {
-        unmatchedFields.emplace_back("melMaxFreq");
+}
+
+static sockaddr_un unixSocketAddress(const std::string &path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error(stdc::formatN(R"(socket path too long: "%1")", path));
     }
-    if (acousticConfig->melBase != vocoderConfig->melBase) {
-        unmatchedFields.emplace_back("melBase");
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+using PipelineMap = std::map<std::string, std::unique_ptr<ds::pipeline::Pipeline>>;
+
+// Runs in the forked worker
+static int zygoteWorker(const PipelineMap &pipelines, const std::string &request) {
+    const auto sep = request.find('\t');
+    if (sep == std::string::npos) {
+        throw std::runtime_error("invalid request");
     }
-    if (acousticConfig->melScale != vocoderConfig->melScale) {
-        unmatchedFields.emplace_back("melScale");
+    const auto inputPath = stdc::path::from_utf8(request.substr(0, sep));
+    const auto outputPath = stdc::path::from_utf8(request.substr(sep + 1));
+
+    InputObject input = loadInput(inputPath);
+    auto it = pipelines.find(input.singer);
+    if (it == pipelines.end()) {
+        throw std::runtime_error(stdc::formatN(R"(singer "%1" not found in package)", input.singer));
     }
-    if (!unmatchedFields.empty()) {
-        throw std::runtime_error(stdc::formatN("acoustic and vocoder config mismatch: %1",
-                                               stdc::join(unmatchedFields, ", ")));
+
+    auto exp = it->second->render(input.input);
+    if (!exp) {
+        throw std::runtime_error(exp.error().message());
     }
+    return writeOutput(exp.value(), outputPath);
+}
 
-    // Run duration
-    {
-        NO<srt::Inference> inference;
-        if (auto exp = importDuration.inference->createInference(
-                importDuration.options, NO<Dur::DurationRuntimeOptions>::create());
-            !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to create duration inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        } else {
-            inference = exp.take();
-        }
-        if (auto exp = inference->initialize(NO<Dur::DurationInitArgs>::create()); !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to initialize duration inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        }
+static int execZygote(const fs::path &packagePath, const std::string &socketPath,
+                      const fs::path &warmupPath) {
+    // The workers are forked from this process, which must not own any thread at that time:
+    // only the forking thread survives in the child. The sessions therefore run on the calling
+    // thread, and requests are parallelized by running several workers.
+    srt::SynthUnit su;
+    initializeSU(su, EP::CPUExecutionProvider, 0, 1);
 
-        auto durationInput = NO<Dur::DurationStartInput>::create();
-        // Copy user inputs into duration model inputs
-        durationInput->duration = input.input->duration;
-        durationInput->words = input.input->words;
+    srt::ScopedPackageRef pkg;
+    loadPackage(su, packagePath, pkg);
 
-        // Start inference
-        NO<Dur::DurationResult> result;
-        if (auto exp = inference->start(durationInput); !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to start duration inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        } else {
-            result = exp.take().as<Dur::DurationResult>();
+    // Open a pipeline for every singer
+    PipelineMap pipelines;
+    auto &sc = *su.category("singer")->as<srt::SingerCategory>();
+    for (const auto &singer : sc.singers()) {
+        auto pipeline = std::make_unique<ds::pipeline::Pipeline>();
+        if (auto exp = pipeline->open(singer); !exp) {
+            cliLog.srtWarning("Zygote - skipping singer %1: %2", singer->id(),
+                              exp.error().message());
+            continue;
         }
-        if (inference->state() == srt::ITask::Failed) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to run duration inference for singer "%1": %2)",
-                              input.singer, result->error.message()));
-        }
-
-        // Update user inputs in-place with duration model outputs
-        auto updatePhonemeStarts = [](std::vector<Co::InputWordInfo> &words,
-                                      const std::vector<double> &phonemeDurations) {
-            size_t i = 0;
-            for (auto &word : words) {
-                double timeCursor = 0.0;
-                for (auto &phoneme : word.phones) {
-                    if (i >= phonemeDurations.size()) {
-                        return;
-                    }
-                    phoneme.start = timeCursor;
-                    timeCursor += phonemeDurations[i];
-                    ++i;
-                }
-            }
-        };
-
-        updatePhonemeStarts(input.input->words, result->durations);
+        cliLog.srtInfo("Zygote - loaded singer %1", singer->id());
+        pipelines[singer->id()] = std::move(pipeline);
+    }
+    if (pipelines.empty()) {
+        throw std::runtime_error("no singer could be loaded");
     }
 
-    // Run pitch
-    {
-        NO<srt::Inference> inference;
-        if (auto exp = importPitch.inference->createInference(
-                importPitch.options, NO<Pit::PitchRuntimeOptions>::create());
-            !exp) {
+    // Warm up the sessions, so that the lazy initializations are shared with the workers too
+    if (!warmupPath.empty()) {
+        InputObject input = loadInput(warmupPath);
+        auto it = pipelines.find(input.singer);
+        if (it == pipelines.end()) {
             throw std::runtime_error(
-                stdc::formatN(R"(failed to create pitch inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        } else {
-            inference = exp.take();
+                stdc::formatN(R"(singer "%1" not found in package)", input.singer));
         }
-        if (auto exp = inference->initialize(NO<Pit::PitchInitArgs>::create()); !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to initialize pitch inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        }
-
-        auto pitchInput = NO<Pit::PitchStartInput>::create();
-        // Copy user inputs into pitch model inputs
-        pitchInput->duration = input.input->duration;
-        pitchInput->words = input.input->words;
-        for (const auto &param : input.input->parameters) {
-            if (param.tag == Co::Tags::Pitch) {
-                pitchInput->parameters.push_back(
-                    {Co::Tags::Pitch, param.values, param.interval, param.retake});
-            } else if (param.tag == Co::Tags::Expr) {
-                pitchInput->parameters.push_back(
-                    {Co::Tags::Expr, param.values, param.interval, param.retake});
-            }
+        if (auto exp = it->second->render(input.input); !exp) {
+            throw std::runtime_error(exp.error().message());
         }
-        pitchInput->speakers = input.input->speakers;
-        pitchInput->steps = input.input->steps;
+        cliLog.srtInfo("Zygote - warm-up finished");
+    }
 
-        // Start inference
-        NO<Pit::PitchResult> result;
-        if (auto exp = inference->start(pitchInput); !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to start pitch inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        } else {
-            result = exp.take().as<Pit::PitchResult>();
-        }
-        if (inference->state() == srt::ITask::Failed) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to run pitch inference for singer "%1": %2)", input.singer,
-                              result->error.message()));
-        }
-
-        // Update user inputs in-place with pitch model outputs
-        auto res = result->pitch;
-        auto interval = result->interval;
-        bool hasPitch = false;
-        for (auto &param : input.input->parameters) {
-            if (param.tag == Co::Tags::Pitch) {
-                param.interval = interval;
-                param.values = res;
-                hasPitch = true;
-            }
-        }
-        if (!hasPitch) {
-            input.input->parameters.emplace_back(
-                Co::InputParameterInfo{Co::Tags::Pitch, res, interval});
-        }
+    // Listen
+    const auto addr = unixSocketAddress(socketPath);
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        throw std::runtime_error(stdc::formatN("socket failed: %1", std::strerror(errno)));
+    }
+    ::unlink(socketPath.c_str());
+    if (::bind(listenFd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listenFd, SOMAXCONN) != 0) {
+        const auto msg = stdc::formatN("failed to listen on \"%1\": %2", socketPath,
+                                       std::strerror(errno));
+        ::close(listenFd);
+        throw std::runtime_error(msg);
     }
 
-    // Run variance
-    {
-        NO<srt::Inference> inference;
-        const auto schema = importVariance.inference->schema().as<Var::VarianceSchema>();
-        if (auto exp = importVariance.inference->createInference(
-                importVariance.options, NO<Var::VarianceRuntimeOptions>::create());
-            !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to create variance inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        } else {
-            inference = exp.take();
-        }
-        if (auto exp = inference->initialize(NO<Var::VarianceInitArgs>::create()); !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to initialize variance inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        }
-
-        auto varianceInput = NO<Var::VarianceStartInput>::create();
-        // Copy user inputs into variance model inputs
-        varianceInput->duration = input.input->duration;
-        varianceInput->words = input.input->words;
-        for (const auto &param : input.input->parameters) {
-            if (param.tag == Co::Tags::Pitch) {
-                varianceInput->parameters.push_back(
-                    {Co::Tags::Pitch, param.values, param.interval, param.retake});
-                continue;
-            }
+    // Exited workers are reaped automatically
+    std::signal(SIGCHLD, SIG_IGN);
 
-            for (const auto &prediction : schema->predictions) {
-                if (prediction == param.tag) {
-                    varianceInput->parameters.push_back(
-                        {prediction, param.values, param.interval, param.retake});
-                }
+    // Stop on SIGINT or SIGTERM, without SA_RESTART so that accept() is interrupted
+    struct sigaction sa{};
+    sa.sa_handler = zygoteStopHandler;
+    sigemptyset(&sa.sa_mask);
+    ::sigaction(SIGINT, &sa, nullptr);
+    ::sigaction(SIGTERM, &sa, nullptr);
+
+    cliLog.srtSuccess("Zygote - listening on " + socketPath);
+
+    while (!zygoteStopRequested) {
+        int connFd = ::accept(listenFd, nullptr, nullptr);
+        if (connFd < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            cliLog.srtCritical("Zygote - accept failed: %1", std::strerror(errno));
+            break;
         }
-        varianceInput->speakers = input.input->speakers;
-        varianceInput->steps = input.input->steps;
 
-        // Start inference
-        NO<Var::VarianceResult> result;
-        if (auto exp = inference->start(varianceInput); !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to start variance inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        } else {
-            result = exp.take().as<Var::VarianceResult>();
+        // Flush before forking, otherwise the buffered output would be written twice
+        std::fflush(nullptr);
+
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            cliLog.srtCritical("Zygote - fork failed: %1", std::strerror(errno));
+            writeAll(connFd, "1 fork failed\n");
+            ::close(connFd);
+            continue;
         }
-        if (inference->state() == srt::ITask::Failed) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to run variance inference for singer "%1": %2)",
-                              input.singer, result->error.message()));
-        }
-
-        // Update user inputs in-place with variance model outputs
-        const auto nParams = schema->predictions.size();
-        std::vector<char> satisfyParams(nParams, false);
-        // schema->predictions.size() == result->predictions.size()
-        // guaranteed if inference is successful
-        for (size_t i = 0; i < nParams; i++) {
-            auto &originalParam = input.input->parameters[i];
-            for (auto &predicted : result->predictions) {
-                if (originalParam.tag == predicted.tag) {
-                    originalParam.interval = predicted.interval;
-                    originalParam.values = std::move(predicted.values);
-                    originalParam.retake = std::nullopt;
-                    satisfyParams[i] = true;
-                    break;
-                }
-            }
+        if (pid > 0) {
+            ::close(connFd);
+            continue;
         }
-        for (size_t i = 0; i < nParams; i++) {
-            if (satisfyParams[i]) {
-                continue;
-            }
-            for (auto &predictedParam : result->predictions) {
-                if (predictedParam.tag == schema->predictions[i]) {
-                    input.input->parameters.emplace_back(std::move(predictedParam));
-                    break;
-                }
+
+        // Worker
+        ::close(listenFd);
+        std::signal(SIGCHLD, SIG_DFL);
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+
+        int ret = -1;
+        std::string response;
+        try {
+            std::string request;
+            if (!readLine(connFd, request)) {
+                throw std::runtime_error("failed to read request");
             }
+            ret = zygoteWorker(pipelines, request);
+            response = ret == 0 ? "0\n" : "1 failed to write output\n";
+        } catch (const std::exception &e) {
+            response = "1 " + std::string(e.what()) + "\n";
         }
+        writeAll(connFd, response);
+        ::close(connFd);
+
+        // Skip the destructors, the state belongs to the zygote
+        std::fflush(nullptr);
+        ::_exit(ret == 0 ? 0 : 1);
     }
 
-    // Run acoustic
-    NO<ds::ITensor> mel;
-    NO<ds::ITensor> f0;
-    {
-        // Prepare
-        NO<srt::Inference> inference;
-        if (auto exp = importAcoustic.inference->createInference(
-                importAcoustic.options, NO<Ac::AcousticRuntimeOptions>::create());
-            !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to create acoustic inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        } else {
-            inference = exp.take();
-        }
-        if (auto exp = inference->initialize(NO<Ac::AcousticInitArgs>::create()); !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to initialize acoustic inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        }
+    ::close(listenFd);
+    ::unlink(socketPath.c_str());
+    return 0;
+}
 
-        // Start inference
-        NO<Ac::AcousticResult> result;
-        if (auto exp = inference->start(input.input); !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to start acoustic inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        } else {
-            result = exp.take().as<Ac::AcousticResult>();
-        }
-        if (inference->state() == srt::ITask::Failed) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to run acoustic inference for singer "%1": %2)",
-                              input.singer, result->error.message()));
-        }
-        mel = result->mel;
-        f0 = result->f0;
+static int execSubmit(const std::string &socketPath, const std::string &inputPath,
+                      const std::string &outputPath) {
+    const auto addr = unixSocketAddress(socketPath);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error(stdc::formatN("socket failed: %1", std::strerror(errno)));
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+        const auto msg = stdc::formatN("failed to connect to \"%1\": %2", socketPath,
+                                       std::strerror(errno));
+        ::close(fd);
+        throw std::runtime_error(msg);
     }
 
-    // Run vocoder
-    std::vector<uint8_t> audioData;
-    {
-        // Prepare
-        NO<srt::Inference> inference;
-        if (auto exp = importVocoder.inference->createInference(
-                importVocoder.options, NO<Vo::VocoderRuntimeOptions>::create());
-            !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to create vocoder inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        } else {
-            inference = exp.take();
-        }
-        if (auto exp = inference->initialize(NO<Vo::VocoderInitArgs>::create()); !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to initialize vocoder inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        }
+    // The worker resolves the paths from its own working directory
+    const auto absolutePath = [](const std::string &path) {
+        return stdc::path::to_utf8(fs::absolute(stdc::path::from_utf8(path)));
+    };
+    writeAll(fd, absolutePath(inputPath) + "\t" + absolutePath(outputPath) + "\n");
 
-        auto vocoderInput = NO<Vo::VocoderStartInput>::create();
-        vocoderInput->mel = mel;
-        vocoderInput->f0 = f0;
+    std::string response;
+    const bool ok = readLine(fd, response);
+    ::close(fd);
+    if (!ok) {
+        throw std::runtime_error("worker exited without response");
+    }
+    if (response != "0") {
+        throw std::runtime_error(response.size() > 2 ? response.substr(2) : response);
+    }
+    cliLog.srtSuccess("Saved output to " + outputPath);
+    return 0;
+}
 
-        // Start inference
-        NO<Vo::VocoderResult> result;
-        if (auto exp = inference->start(vocoderInput); !exp) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to start vocoder inference for singer "%1": %2)",
-                              input.singer, exp.error().message()));
-        } else {
-            result = exp.take().as<Vo::VocoderResult>();
-        }
-        if (inference->state() == srt::ITask::Failed) {
-            throw std::runtime_error(
-                stdc::formatN(R"(failed to run vocoder inference for singer "%1": %2)",
-                              input.singer, result->error.message()));
-        }
-        audioData = std::move(result->audioData);
+// Stage server mode: the inference of one stage of a singer is loaded once, and a pool of
+// worker processes forked from it serve the socket, see ds::pipeline::StageServer. The workers
+// that crash are replaced.
+static int execStageServer(const fs::path &packagePath, const std::string &singerId,
+                           const std::string &stageName, const std::string &socketPath,
+                           int processes) {
+    const auto stage = ds::pipeline::stageFromName(stageName);
+    if (!stage) {
+        throw std::runtime_error(stdc::formatN(R"(unknown stage "%1")", stageName));
     }
 
-    // Process audio data
-    {
-        using ds::WavFile;
+    // No thread may exist when the workers are forked, as in the zygote mode
+    srt::SynthUnit su;
+    initializeSU(su, EP::CPUExecutionProvider, 0, 1);
 
-        WavFile::DataFormat format{};
-        format.container = WavFile::Container::RIFF;
-        format.format = WavFile::WaveFormat::IEEE_FLOAT;
-        format.channels = 1;
-        format.sampleRate = 44100;
-        format.bitsPerSample = 32;
+    srt::ScopedPackageRef pkg;
+    loadPackage(su, packagePath, pkg);
 
-        WavFile wav;
-        if (!wav.init_file_write(outputWavPath, format)) {
-            cliLog.srtCritical("Failed to initialize WAV writer.");
-            return -1;
+    auto handler =
+        ds::pipeline::StageServer::inferenceHandler(findSinger(su, singerId), stage.value());
+    if (!handler) {
+        throw std::runtime_error(handler.error().message());
+    }
+    ds::pipeline::StageServer server(stage.value(), handler.take());
+    if (auto res = server.listen(socketPath); !res) {
+        throw std::runtime_error(res.error().message());
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = zygoteStopHandler;
+    sigemptyset(&sa.sa_mask);
+    ::sigaction(SIGINT, &sa, nullptr);
+    ::sigaction(SIGTERM, &sa, nullptr);
+
+    std::set<pid_t> workers;
+    const auto spawn = [&]() {
+        // Flush before forking, otherwise the buffered output would be written twice
+        std::fflush(nullptr);
+
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            cliLog.srtCritical("Stage server - fork failed: %1", std::strerror(errno));
+            return false;
+        }
+        if (pid > 0) {
+            workers.insert(pid);
+            return true;
         }
 
-        auto totalPCMFrameCount = audioData.size() / (format.channels * sizeof(float));
+        // Worker
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        auto res = server.serve();
+        if (!res) {
+            cliLog.srtCritical("Stage server - %1", res.error().message());
+        }
 
-        auto framesWritten = wav.write_pcm_frames(totalPCMFrameCount, audioData.data());
-        if (framesWritten != totalPCMFrameCount) {
-            cliLog.srtCritical("Failed to write all frames.");
+        // Skip the destructors, the state belongs to the parent
+        std::fflush(nullptr);
+        ::_exit(res ? 0 : 1);
+    };
+    for (int i = 0; i < (std::max) (processes, 1); ++i) {
+        if (!spawn()) {
+            break;
         }
-        wav.close();
+    }
+    cliLog.srtSuccess("Stage server - %1 of %2 listening on %3 with %4 processes", stageName,
+                      singerId, socketPath, workers.size());
 
-        cliLog.srtSuccess("Saved audio to " + stdc::path::to_utf8(outputWavPath));
+    while (!zygoteStopRequested && !workers.empty()) {
+        int status;
+        pid_t pid = ::waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        workers.erase(pid);
+        if (!zygoteStopRequested && WIFSIGNALED(status)) {
+            cliLog.srtWarning("Stage server - worker %1 killed by signal %2, restarting", pid,
+                              WTERMSIG(status));
+            spawn();
+        }
     }
 
+    for (const auto pid : workers) {
+        ::kill(pid, SIGTERM);
+    }
+    for (const auto pid : workers) {
+        ::waitpid(pid, nullptr, 0);
+    }
+    server.close();
     return 0;
 }
 
+// Parses "<stage>[:<in_flight>]=<socket>[,<socket>...]"
+static void parseRemoteStage(const std::string &arg, ds::pipeline::PipelineOptions &options) {
+    const auto eq = arg.find('=');
+    if (eq == std::string::npos) {
+        throw std::runtime_error(stdc::formatN(R"(invalid remote stage "%1")", arg));
+    }
+    std::string name = arg.substr(0, eq);
+    int maxInFlight = 1;
+    if (const auto colon = name.find(':'); colon != std::string::npos) {
+        try {
+            maxInFlight = std::stoi(name.substr(colon + 1));
+        } catch (const std::exception &) {
+            throw std::runtime_error(stdc::formatN(R"(invalid remote stage "%1")", arg));
+        }
+        name.resize(colon);
+    }
+    const auto stage = ds::pipeline::stageFromName(name);
+    if (!stage) {
+        throw std::runtime_error(stdc::formatN(R"(unknown stage "%1")", name));
+    }
+
+    std::vector<std::string> endpoints;
+    size_t pos = eq + 1;
+    while (pos <= arg.size()) {
+        auto end = arg.find(',', pos);
+        if (end == std::string::npos) {
+            end = arg.size();
+        }
+        if (end > pos) {
+            endpoints.push_back(arg.substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+    options.remoteStages[static_cast<int>(stage.value())] =
+        std::make_shared<ds::pipeline::StageClient>(stage.value(), std::move(endpoints),
+                                                    maxInFlight);
+}
+#endif
+
 static inline std::string exception_message(const std::exception &e) {
     std::string msg = e.what();
 #ifdef _WIN32
@@ -650,11 +719,124 @@ static inline std::string exception_message(const std::exception &e) {
     return msg;
 }
 
+static int parseThreads(const std::vector<std::string> &cmdline, size_t index) {
+    if (cmdline.size() <= index) {
+        return 0;
+    }
+    try {
+        return std::stoi(cmdline[index]);
+    } catch (const std::invalid_argument &e) {
+        return 0;
+    } catch (const std::out_of_range &e) {
+        return 0;
+    }
+}
+
+static int execSubcommand(const std::vector<std::string> &cmdline) {
+    const auto &command = cmdline[1];
+    if (command == "pack") {
+        if (cmdline.size() < 4) {
+            stdc::u8println("Usage: %1 pack <package> <output_dspk> [threads]",
+                            stdc::system::application_name());
+            return 1;
+        }
+        return execPack(stdc::path::from_utf8(cmdline[2]), stdc::path::from_utf8(cmdline[3]),
+                        parseThreads(cmdline, 4));
+    }
+    if (command == "install") {
+        auto args = cmdline;
+        const auto forceIt = std::find(args.begin() + 2, args.end(), "--force");
+        const bool force = forceIt != args.end();
+        if (force) {
+            args.erase(forceIt);
+        }
+        if (args.size() < 4) {
+            stdc::u8println("Usage: %1 install [--force] <dspk> <package> [threads]",
+                            stdc::system::application_name());
+            return 1;
+        }
+        return execInstall(stdc::path::from_utf8(args[2]), stdc::path::from_utf8(args[3]),
+                           parseThreads(args, 4), force);
+    }
+#ifndef _WIN32
+    if (command == "zygote") {
+        if (cmdline.size() < 4) {
+            stdc::u8println("Usage: %1 zygote <package> <socket> [warmup_input]",
+                            stdc::system::application_name());
+            return 1;
+        }
+        return execZygote(stdc::path::from_utf8(cmdline[2]), cmdline[3],
+                          cmdline.size() >= 5 ? stdc::path::from_utf8(cmdline[4]) : fs::path());
+    }
+    if (command == "submit") {
+        if (cmdline.size() < 5) {
+            stdc::u8println("Usage: %1 submit <socket> <input> <output_wav|output_json>",
+                            stdc::system::application_name());
+            return 1;
+        }
+        return execSubmit(cmdline[2], cmdline[3], cmdline[4]);
+    }
+    if (command == "stage-server") {
+        if (cmdline.size() < 6) {
+            stdc::u8println("Usage: %1 stage-server <package> <singer> <stage> <socket> "
+                            "[processes]",
+                            stdc::system::application_name());
+            return 1;
+        }
+        return execStageServer(stdc::path::from_utf8(cmdline[2]), cmdline[3], cmdline[4],
+                               cmdline[5], cmdline.size() >= 7 ? parseThreads(cmdline, 6) : 1);
+    }
+    if (command == "render-remote") {
+        if (cmdline.size() < 6) {
+            stdc::u8println("Usage: %1 render-remote <package> <input> <output_wav|output_json> "
+                            "<stage>[:<in_flight>]=<socket>[,<socket>...]...",
+                            stdc::system::application_name());
+            return 1;
+        }
+        ds::pipeline::PipelineOptions options;
+        for (size_t i = 5; i < cmdline.size(); ++i) {
+            parseRemoteStage(cmdline[i], options);
+        }
+        return exec(stdc::path::from_utf8(cmdline[2]), stdc::path::from_utf8(cmdline[3]),
+                    stdc::path::from_utf8(cmdline[4]), EP::CPUExecutionProvider, 0, options);
+    }
+#endif
+    stdc::console::critical("Error: %1 is not supported on this platform", command);
+    return 1;
+}
+
 int main(int /*argc*/, char * /*argv*/[]) {
     auto cmdline = stdc::system::command_line_arguments();
+    if (cmdline.size() >= 2 &&
+        (cmdline[1] == "zygote" || cmdline[1] == "submit" || cmdline[1] == "pack" ||
+         cmdline[1] == "install" || cmdline[1] == "stage-server" ||
+         cmdline[1] == "render-remote")) {
+        srt::Logger::setLogCallback(log_report_callback);
+        try {
+            return execSubcommand(cmdline);
+        } catch (const std::exception &e) {
+            stdc::console::critical("Error: %1", exception_message(e));
+            return -1;
+        }
+    }
     if (cmdline.size() < 4) {
-        stdc::u8println("Usage: %1 <package> <input> <output_wav> <ep> <device_index>",
+        stdc::u8println("Usage: %1 <package> <input> <output_wav|output_json> <ep> <device_index>",
+                        stdc::system::application_name());
+        stdc::u8println("       %1 pack <package> <output_dspk> [threads]",
                         stdc::system::application_name());
+        stdc::u8println("       %1 install [--force] <dspk> <package> [threads]",
+                        stdc::system::application_name());
+#ifndef _WIN32
+        stdc::u8println("       %1 zygote <package> <socket> [warmup_input]",
+                        stdc::system::application_name());
+        stdc::u8println("       %1 submit <socket> <input> <output_wav|output_json>",
+                        stdc::system::application_name());
+        stdc::u8println("       %1 stage-server <package> <singer> <stage> <socket> [processes]",
+                        stdc::system::application_name());
+        stdc::u8println("       %1 render-remote <package> <input> <output_wav|output_json> "
+                        "<stage>[:<in_flight>]=<socket>[,<socket>...]...",
+                        stdc::system::application_name());
+#endif
         return 1;
     }
 
@@ -662,7 +844,7 @@ int main(int /*argc*/, char * /*argv*/[]) {
 
     const auto &packagePath = stdc::path::from_utf8(cmdline[1]);
     const auto &inputPath = stdc::path::from_utf8(cmdline[2]);
-    const auto &outputWavPath = stdc::path::from_utf8(cmdline[3]);
+    const auto &outputPath = stdc::path::from_utf8(cmdline[3]);
     auto ep = EP::CPUExecutionProvider;
     if (cmdline.size() >= 5) {
         const auto epString = stdc::to_lower(cmdline[4]);
@@ -687,7 +869,7 @@ int main(int /*argc*/, char * /*argv*/[]) {
 
     int ret;
     try {
-        ret = exec(packagePath, inputPath, outputWavPath, ep, deviceIndex);
+        ret = exec(packagePath, inputPath, outputPath, ep, deviceIndex);
     } catch (const std::exception &e) {
         std::string msg = exception_message(e);
         stdc::console::critical("Error: %1", msg);
@@ -100,47 +100,83 @@ namespace ds::inferutil {
         return result;
     }
 
-    inline std::vector<double> resample(const stdc::array_view<double> &samples, double timestep,
-                                               double targetTimestep, int64_t targetLength,
-                                               bool fillLast) {
-        if (samples.empty() || targetLength == 0) {
-            return {};
+    /// Whether two frame widths describe the same frame grid, i.e. curves sampled at one of them
+    /// can be handed to the other as they are. The tolerance only absorbs the rounding of the
+    /// widths computed in different ways, such as \c hopSize/sampleRate and a configured value.
+    inline bool isSameFrameGrid(double interval, double otherInterval) {
+        return interval > 0 && otherInterval > 0 &&
+               std::abs(interval - otherInterval) <= 1e-9 * otherInterval;
+    }
+
+    /// Resamples a curve to the frame grid of \a targetTimestep and writes exactly
+    /// \a targetLength values to \a out, converted to \a T. The tail past the end of the curve
+    /// is filled with the last value if \a fillLast is true, or with 0 otherwise.
+    ///
+    /// When both grids are the same the values are copied as they are. Otherwise they are
+    /// linearly interpolated in a single pass, without the intermediate time axes.
+    ///
+    /// Returns false if the curve is empty or the time steps are not positive.
+    template <class T>
+    inline bool resampleInto(const stdc::array_view<double> &samples, double timestep,
+                             double targetTimestep, int64_t targetLength, bool fillLast, T *out) {
+        if (samples.empty() || targetLength <= 0) {
+            return false;
         }
         if (samples.size() == 1) {
-            std::vector<double> result(targetLength, samples[0]);
-            return result;
+            std::fill_n(out, targetLength, static_cast<T>(samples[0]));
+            return true;
         }
-        if (timestep == 0 || targetTimestep == 0) {
-            return {};
+        if (!(timestep > 0) || !(targetTimestep > 0)) {
+            return false;
         }
         if (targetLength == 1) {
-            return {samples[0]};
+            out[0] = static_cast<T>(samples[0]);
+            return true;
+        }
+
+        const auto sampleCount = static_cast<int64_t>(samples.size());
+        int64_t count;
+        if (isSameFrameGrid(timestep, targetTimestep)) {
+            count = (std::min) (sampleCount, targetLength);
+            for (int64_t i = 0; i < count; ++i) {
+                out[i] = static_cast<T>(samples[i]);
+            }
+        } else {
+            // Target points are k * targetTimestep in [0, tMax), source points are
+            // i * timestep. Both increase, so the source segment is found by walking forward.
+            const auto tMax = static_cast<double>(sampleCount - 1) * timestep;
+            count = (std::min) (static_cast<int64_t>(std::ceil(tMax / targetTimestep)),
+                                targetLength);
+            int64_t index = 0;
+            for (int64_t k = 0; k < count; ++k) {
+                const auto t = static_cast<double>(k) * targetTimestep;
+                while (index < sampleCount - 1 && static_cast<double>(index) * timestep < t) {
+                    ++index;
+                }
+                const auto x1 = static_cast<double>(index) * timestep;
+                if (x1 <= t || index == 0) {
+                    out[k] = static_cast<T>(samples[index]);
+                    continue;
+                }
+                const auto x0 = static_cast<double>(index - 1) * timestep;
+                out[k] = static_cast<T>(
+                    interpolatePointLinear(x0, samples[index - 1], x1, samples[index], t));
+            }
         }
-        // Find the time duration of input samples in seconds.
-        auto tMax = static_cast<double>(samples.size() - 1) * timestep;
-
-        // Construct target time axis for interpolation.
-        auto targetTimeAxis = arange(0.0, tMax, targetTimestep);
-
-        // Construct input time axis (for interpolation).
-        auto inputTimeAxis = arange(0.0, static_cast<double>(samples.size()), 1.0);
-        std::transform(inputTimeAxis.begin(), inputTimeAxis.end(), inputTimeAxis.begin(),
-                       [timestep](double value) { return value * timestep; });
-
-        // Interpolate sample curve to target time axis
-        auto targetSamples =
-            interpolate<InterpolateLinear, double>(targetTimeAxis, inputTimeAxis, samples);
-
-        // Resize the interpolated curve vector to target length
-        auto actualLength = static_cast<int64_t>(targetSamples.size());
-
-        if (actualLength > targetLength) {
-            // Truncate vector to target length
-            targetSamples.resize(targetLength);
-        } else if (actualLength < targetLength) {
-            // Expand vector to target length, filling last value
-            double tailFillValue = fillLast ? targetSamples.back() : 0;
-            targetSamples.resize(targetLength, tailFillValue);
+
+        // Expand to target length, filling last value
+        const T tailFillValue = fillLast ? out[count - 1] : T(0);
+        std::fill(out + count, out + targetLength, tailFillValue);
+        return true;
+    }
+
+    inline std::vector<double> resample(const stdc::array_view<double> &samples, double timestep,
+                                               double targetTimestep, int64_t targetLength,
+                                               bool fillLast) {
+        std::vector<double> targetSamples(targetLength > 0 ? targetLength : 0);
+        if (!resampleInto(samples, timestep, targetTimestep, targetLength, fillLast,
+                          targetSamples.data())) {
+            return {};
         }
         return targetSamples;
     }
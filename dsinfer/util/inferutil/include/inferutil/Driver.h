@@ -1,12 +1,17 @@
 #ifndef DSINFER_INFERUTIL_DRIVER_H
 #define DSINFER_INFERUTIL_DRIVER_H
 
+#include <string_view>
+
 #include <synthrt/Support/Expected.h>
 #include <synthrt/SVS/Inference.h>
 #include <dsinfer/Inference/InferenceDriver.h>
 
 namespace ds::inferutil {
-    srt::Expected<srt::NO<InferenceDriver>> getInferenceDriver(const srt::Inference *obj);
+    /// Returns the inference driver with the given object name among all the drivers added
+    /// with the ID "dsdriver". If \a name is empty, the first driver is returned.
+    srt::Expected<srt::NO<InferenceDriver>> getInferenceDriver(const srt::Inference *obj,
+                                                               std::string_view name = {});
 }
 
 #endif // DSINFER_INFERUTIL_DRIVER_H
\ No newline at end of file
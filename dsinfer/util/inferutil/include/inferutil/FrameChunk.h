@@ -0,0 +1,54 @@
+#ifndef DSINFER_INFERUTIL_FRAMECHUNK_H
+#define DSINFER_INFERUTIL_FRAMECHUNK_H
+
+#include <cstdint>
+#include <vector>
+
+#include <synthrt/Support/Expected.h>
+
+#include <dsinfer/Core/Tensor.h>
+
+namespace ds::inferutil {
+
+    /// A window over the frame axis. The frames in [begin, end) are kept after stitching, while
+    /// [contextBegin, contextEnd) is the range actually fed to the model.
+    struct FrameChunk {
+        int64_t begin;
+        int64_t end;
+        int64_t contextBegin;
+        int64_t contextEnd;
+
+        inline int64_t contextLength() const {
+            return contextEnd - contextBegin;
+        }
+    };
+
+    /// Phonemes overlapping a frame range, with their durations clipped to the range.
+    struct PhonemeRange {
+        int64_t first;
+        int64_t last;
+        srt::NO<ITensor> durations;
+    };
+
+    /// Splits \a length frames into chunks of at most \a chunkSize frames with balanced sizes,
+    /// and extends each of them with the given context frames (clamped to the frame axis).
+    std::vector<FrameChunk> splitFrameChunks(int64_t length, int64_t chunkSize,
+                                             int64_t leftContext, int64_t rightContext);
+
+    /// Copies the range [begin, end) along axis 1 of a tensor shaped [1, N, ...].
+    srt::Expected<srt::NO<ITensor>> sliceTensorAxis1(const srt::NO<ITensor> &tensor,
+                                                     int64_t begin, int64_t end);
+
+    /// Finds the phonemes overlapping the frames [begin, end) given the phoneme durations tensor
+    /// (int64, shaped [1, N]), and returns their durations clipped to the range.
+    srt::Expected<PhonemeRange> slicePhonemeDurations(const srt::NO<ITensor> &durations,
+                                                      int64_t begin, int64_t end);
+
+    /// Copies the frames [chunk.begin, chunk.end) from \a chunkOutput, which covers
+    /// [chunk.contextBegin, chunk.contextEnd), into \a dst shaped [1, T, ...].
+    srt::Expected<void> stitchFrames(const srt::NO<ITensor> &chunkOutput, const FrameChunk &chunk,
+                                     const srt::NO<ITensor> &dst);
+
+}
+
+#endif // DSINFER_INFERUTIL_FRAMECHUNK_H
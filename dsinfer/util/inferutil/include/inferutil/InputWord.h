@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <map>
+#include <string>
 #include <vector>
 
 #include <synthrt/Support/Expected.h>
@@ -37,6 +38,22 @@ namespace ds::inferutil {
         return wordDuration;
     }
 
+    /// Returns the id of a phoneme, looked up as \c language/token first and as \c token then, or
+    /// nullptr if unknown. SP and AP are never tagged with a language.
+    inline const int *findPhonemeToken(const Api::Common::L1::InputPhonemeInfo &phone,
+                                       const std::map<std::string, int> &tokens) {
+        if (!phone.language.empty() && phone.token != "SP" && phone.token != "AP") {
+            if (const auto it = tokens.find(phone.language + '/' + phone.token);
+                it != tokens.end()) {
+                return &it->second;
+            }
+        }
+        if (const auto it = tokens.find(phone.token); it != tokens.end()) {
+            return &it->second;
+        }
+        return nullptr;
+    }
+
     srt::Expected<srt::NO<ITensor>>
         preprocessPhonemeTokens(const std::vector<Api::Common::L1::InputWordInfo> &words,
                                 const std::map<std::string, int> &tokens);
@@ -0,0 +1,23 @@
+#ifndef DSINFER_INFERUTIL_MIXER_H
+#define DSINFER_INFERUTIL_MIXER_H
+
+#include <cstddef>
+
+namespace ds::inferutil {
+
+    /// The left and right gains of a mono source placed in a stereo mix.
+    struct StereoGain {
+        float left;
+        float right;
+    };
+
+    /// Returns the gains of a source of linear \a gain at \a pan, from -1 (left) to 1 (right),
+    /// using the constant-power law: a centered source is 3 dB down on each side.
+    StereoGain panGain(float gain, float pan);
+
+    /// Adds \a count mono samples, scaled by \a gain, to \a count interleaved stereo frames.
+    void mixMonoToStereo(const float *samples, size_t count, StereoGain gain, float *frames);
+
+}
+
+#endif // DSINFER_INFERUTIL_MIXER_H
@@ -0,0 +1,45 @@
+#ifndef DSINFER_INFERUTIL_PARALLEL_H
+#define DSINFER_INFERUTIL_PARALLEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <synthrt/Support/Expected.h>
+
+namespace ds::inferutil {
+
+    /// Inputs shorter than this many frames are preprocessed on the calling thread, where
+    /// starting helper threads would cost more than it saves.
+    inline constexpr int64_t ParallelFrameThreshold = 2048;
+
+    /// Smallest range of frames handed to a thread by \c parallelTiles().
+    inline constexpr int64_t ParallelMinTile = 1024;
+
+    /// Returns the maximum number of helper threads running at once in the process.
+    int maxParallelThreads();
+
+    /// Runs \a task for every index in [0, \a count) and returns when all of them are done.
+    ///
+    /// The indices are shared by the calling thread and as many helper threads as the budget of
+    /// \c maxParallelThreads() allows, which may be none, e.g. in a nested call. The helpers only
+    /// live for the call, so that no thread is left behind for a fork.
+    ///
+    /// If a task throws, the indices not yet started are skipped and the first exception is
+    /// rethrown once the helpers are joined.
+    void parallelFor(size_t count, const std::function<void(size_t)> &task);
+
+    /// Splits [0, \a length) into tiles of at least \a minTile frames and runs \a task on each
+    /// of them, see \c parallelFor().
+    void parallelTiles(int64_t length, int64_t minTile,
+                       const std::function<void(int64_t begin, int64_t end)> &task);
+
+    /// Runs the tasks concurrently if \a parallel, otherwise in order. Returns the error of the
+    /// first failed task in order.
+    srt::Expected<void> runTasks(const std::vector<std::function<srt::Expected<void>()>> &tasks,
+                                 bool parallel);
+
+}
+
+#endif // DSINFER_INFERUTIL_PARALLEL_H
@@ -0,0 +1,60 @@
+#ifndef DSINFER_INFERUTIL_PEAKPYRAMID_H
+#define DSINFER_INFERUTIL_PEAKPYRAMID_H
+
+#include <cstddef>
+#include <vector>
+
+#include <dsinfer/Api/Inferences/Vocoder/1/VocoderApiL1.h>
+
+namespace ds::inferutil {
+
+    /// Computes min/max/RMS peaks of a waveform at several bin sizes in a single pass.
+    ///
+    /// Samples can be appended in blocks of any size as they are produced. Only the levels whose
+    /// bin size is not a multiple of a smaller requested one read the samples; the others are
+    /// aggregated from the finer level, so a 64/256/1024/4096 pyramid costs one scan.
+    class PeakPyramidBuilder {
+    public:
+        /// \a binSizes must be positive. \a expectedSamples is only used to reserve the levels.
+        explicit PeakPyramidBuilder(const std::vector<int> &binSizes, size_t expectedSamples = 0);
+
+        void append(const float *samples, size_t count);
+
+        /// Flushes the partial bins and returns one level per bin size, in the order given to the
+        /// constructor. The builder is reset.
+        std::vector<Api::Vocoder::L1::WaveformPeaks> finish();
+
+    protected:
+        struct Accumulator {
+            float min;
+            float max;
+            double sumSquares;
+            size_t count;
+
+            void reset();
+        };
+
+        struct Level {
+            int binSize;
+            std::vector<size_t> children;
+            Accumulator acc;
+            Api::Vocoder::L1::WaveformPeaks peaks;
+        };
+
+        void emit(size_t index);
+
+        /// Sorted by bin size. A level reads its parent's bins, or the samples if it has none.
+        std::vector<Level> _levels;
+
+        /// Level index of each requested bin size.
+        std::vector<size_t> _order;
+        std::vector<size_t> _roots;
+    };
+
+    /// Returns the peaks of a whole waveform, see \c PeakPyramidBuilder.
+    std::vector<Api::Vocoder::L1::WaveformPeaks>
+        computePeakPyramid(const float *samples, size_t count, const std::vector<int> &binSizes);
+
+}
+
+#endif // DSINFER_INFERUTIL_PEAKPYRAMID_H
@@ -0,0 +1,46 @@
+#ifndef DSINFER_INFERUTIL_SESSIONSKELETON_H
+#define DSINFER_INFERUTIL_SESSIONSKELETON_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <synthrt/Support/Expected.h>
+
+#include <dsinfer/Api/Drivers/Onnx/OnnxDriverApi.h>
+
+namespace ds::inferutil {
+
+    /// The input and output names of a session, which only depend on the model configuration.
+    ///
+    /// An inference builds it once when it is initialized. Each request then starts from a copy
+    /// that already has the output names, adds the tensors computed from the request data, and
+    /// checks that none of the expected inputs was left out.
+    class SessionSkeleton {
+    public:
+        void addInput(std::string name);
+        void addOutput(std::string name);
+
+        inline const std::vector<std::string> &inputs() const {
+            return _inputs;
+        }
+        inline const std::set<std::string> &outputs() const {
+            return _outputs;
+        }
+
+        /// Returns an empty session input with the output names set.
+        srt::NO<Api::Onnx::SessionStartInput> instantiate() const;
+
+        /// Fails with the list of expected inputs that \a input does not provide.
+        srt::Expected<void> checkInputs(const Api::Onnx::SessionStartInput &input) const;
+
+        void clear();
+
+    protected:
+        std::vector<std::string> _inputs;
+        std::set<std::string> _outputs;
+    };
+
+}
+
+#endif // DSINFER_INFERUTIL_SESSIONSKELETON_H
@@ -3,6 +3,7 @@
 
 #include <filesystem>
 #include <map>
+#include <vector>
 
 #include <synthrt/Support/Expected.h>
 
@@ -14,10 +15,36 @@ namespace ds::inferutil {
     srt::Expected<std::vector<float>> loadSpeakerEmbedding(int hiddenSize,
                                                            const std::filesystem::path &path);
 
+    /// The speaker proportions of a request resampled to the frame grid, along with the
+    /// embeddings they weight. The embedding frames of any range can be mixed from it, without
+    /// holding the whole [1, T, hiddenSize] tensor.
+    struct SpeakerFrames {
+        std::vector<const std::vector<float> *> embeddings;
+        std::vector<std::vector<double>> proportions;
+        int hiddenSize = 0;
+        int64_t targetLength = 0;
+    };
+
+    srt::Expected<SpeakerFrames>
+        resampleSpeakerFrames(const std::vector<Api::Common::L1::InputSpeakerInfo> &speakers,
+                              const std::map<std::string, std::vector<float>> &embMap,
+                              int hiddenSize, double frameWidth, int64_t targetLength);
+
+    /// Mixes the speaker embedding of the frames [\a begin, \a end) into a tensor shaped
+    /// [1, end - begin, hiddenSize].
+    srt::Expected<srt::NO<ITensor>> mixSpeakerEmbeddingFrames(const SpeakerFrames &frames,
+                                                              int64_t begin, int64_t end);
+
     srt::Expected<srt::NO<ITensor>> preprocessSpeakerEmbeddingFrames(
         const std::vector<Api::Common::L1::InputSpeakerInfo> &speakers,
         const std::map<std::string, std::vector<float>> &embMap, int hiddenSize,
         double frameWidth, int64_t targetLength);
+
+    /// Checks that every embedding of a singer has \a hiddenSize elements. Meant to be called
+    /// once when an inference is initialized, rather than on each request.
+    srt::Expected<void>
+        validateSpeakerEmbeddings(const std::map<std::string, std::vector<float>> &embMap,
+                                  int hiddenSize);
 }
 
 #endif // DSINFER_INFERUTIL_SPEAKEREMBEDDING_H
\ No newline at end of file
@@ -5,12 +5,29 @@
 #include <dsinfer/Api/Singers/DiffSinger/1/DiffSingerApiL1.h>
 
 namespace ds::inferutil {
-    srt::Expected<srt::NO<InferenceDriver>> getInferenceDriver(const srt::Inference *obj) {
+    srt::Expected<srt::NO<InferenceDriver>> getInferenceDriver(const srt::Inference *obj,
+                                                               std::string_view name) {
         namespace Onnx = Api::Onnx;
         namespace DiffSinger = Api::DiffSinger::L1;
 
         auto inferenceCate = obj->spec()->SU()->category("inference");
-        auto dsdriverObject = inferenceCate->getFirstObject("dsdriver");
+
+        srt::NO<srt::NamedObject> dsdriverObject;
+        if (name.empty()) {
+            dsdriverObject = inferenceCate->getFirstObject("dsdriver");
+        } else {
+            for (const auto &item : inferenceCate->getObjects("dsdriver")) {
+                if (item->objectName() == name) {
+                    dsdriverObject = item;
+                    break;
+                }
+            }
+            if (!dsdriverObject) {
+                return srt::Error(
+                    srt::Error::SessionError,
+                    stdc::formatN(R"(could not find dsdriver named "%1")", std::string(name)));
+            }
+        }
 
         if (!dsdriverObject) {
             return srt::Error(srt::Error::SessionError, "could not find dsdriver");
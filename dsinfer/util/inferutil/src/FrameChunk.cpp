@@ -0,0 +1,160 @@
+#include <inferutil/FrameChunk.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <stdcorelib/str.h>
+
+#include <inferutil/TensorHelper.h>
+
+namespace ds::inferutil {
+
+    static inline bool getAxis1Layout(const ITensor &tensor, int64_t &axisLength,
+                                      size_t &frameBytes) {
+        const auto shape = tensor.shape();
+        if (shape.size() < 2 || shape[0] != 1) {
+            return false;
+        }
+        int64_t inner = 1;
+        for (size_t i = 2; i < shape.size(); ++i) {
+            inner *= shape[i];
+        }
+        axisLength = shape[1];
+        frameBytes = static_cast<size_t>(inner) * tensor.elementSize();
+        return true;
+    }
+
+    std::vector<FrameChunk> splitFrameChunks(int64_t length, int64_t chunkSize,
+                                             int64_t leftContext, int64_t rightContext) {
+        std::vector<FrameChunk> chunks;
+        if (length <= 0) {
+            return chunks;
+        }
+        if (chunkSize <= 0 || chunkSize >= length) {
+            chunks.push_back({0, length, 0, length});
+            return chunks;
+        }
+        leftContext = (std::max) (leftContext, int64_t(0));
+        rightContext = (std::max) (rightContext, int64_t(0));
+
+        // Balance the chunk sizes so that the last chunk is not much shorter than the others
+        const int64_t chunkCount = (length + chunkSize - 1) / chunkSize;
+        const int64_t balancedSize = (length + chunkCount - 1) / chunkCount;
+
+        chunks.reserve(chunkCount);
+        for (int64_t begin = 0; begin < length; begin += balancedSize) {
+            const int64_t end = (std::min) (begin + balancedSize, length);
+            chunks.push_back({
+                begin,
+                end,
+                (std::max) (begin - leftContext, int64_t(0)),
+                (std::min) (end + rightContext, length),
+            });
+        }
+        return chunks;
+    }
+
+    srt::Expected<srt::NO<ITensor>> sliceTensorAxis1(const srt::NO<ITensor> &tensor,
+                                                     int64_t begin, int64_t end) {
+        if (!tensor) {
+            return srt::Error(srt::Error::InvalidArgument, "slice: tensor is nullptr");
+        }
+        int64_t axisLength;
+        size_t frameBytes;
+        if (!getAxis1Layout(*tensor, axisLength, frameBytes)) {
+            return srt::Error(srt::Error::InvalidArgument,
+                              "slice: tensor shape should be [1, N, ...]");
+        }
+        if (begin < 0 || end > axisLength || begin > end) {
+            return srt::Error(
+                srt::Error::InvalidArgument,
+                stdc::formatN("slice: range [%1, %2) out of bounds (%3)", begin, end, axisLength));
+        }
+        auto shape = tensor->shape();
+        shape[1] = end - begin;
+
+        const auto data = tensor->rawData() + begin * frameBytes;
+        const stdc::array_view<std::byte> view{data, data + (end - begin) * frameBytes};
+        auto exp = Tensor::createFromRawView(tensor->dataType(), shape, view);
+        if (!exp) {
+            return exp.takeError();
+        }
+        return exp.take();
+    }
+
+    srt::Expected<PhonemeRange> slicePhonemeDurations(const srt::NO<ITensor> &durations,
+                                                      int64_t begin, int64_t end) {
+        if (!durations) {
+            return srt::Error(srt::Error::InvalidArgument, "durations tensor is nullptr");
+        }
+        const auto values = durations->view<int64_t>();
+        if (values.empty()) {
+            return srt::Error(srt::Error::InvalidArgument, "durations tensor should be int64");
+        }
+
+        PhonemeRange range{-1, -1, {}};
+        std::vector<int64_t> clipped;
+
+        int64_t phoneStart = 0;
+        for (size_t i = 0; i < values.size(); ++i) {
+            const int64_t phoneEnd = phoneStart + values[i];
+            const int64_t overlap =
+                (std::min) (phoneEnd, end) - (std::max) (phoneStart, begin);
+            if (overlap > 0) {
+                if (range.first < 0) {
+                    range.first = static_cast<int64_t>(i);
+                }
+                range.last = static_cast<int64_t>(i) + 1;
+                clipped.push_back(overlap);
+            }
+            if (phoneEnd >= end) {
+                break;
+            }
+            phoneStart = phoneEnd;
+        }
+        if (clipped.empty()) {
+            return srt::Error(srt::Error::InvalidArgument,
+                              stdc::formatN("no phonemes in frame range [%1, %2)", begin, end));
+        }
+
+        auto exp = TensorHelper<int64_t>::createFor1DArray(clipped.size());
+        if (!exp) {
+            return exp.takeError();
+        }
+        auto &helper = exp.value();
+        for (const auto item : std::as_const(clipped)) {
+            helper.writeUnchecked(item);
+        }
+        range.durations = helper.take();
+        return range;
+    }
+
+    srt::Expected<void> stitchFrames(const srt::NO<ITensor> &chunkOutput, const FrameChunk &chunk,
+                                     const srt::NO<ITensor> &dst) {
+        if (!chunkOutput || !dst) {
+            return srt::Error(srt::Error::InvalidArgument, "stitch: tensor is nullptr");
+        }
+        if (chunkOutput->dataType() != dst->dataType()) {
+            return srt::Error(srt::Error::InvalidArgument, "stitch: data type mismatch");
+        }
+        int64_t srcLength, dstLength;
+        size_t srcFrameBytes, dstFrameBytes;
+        if (!getAxis1Layout(*chunkOutput, srcLength, srcFrameBytes) ||
+            !getAxis1Layout(*dst, dstLength, dstFrameBytes) || srcFrameBytes != dstFrameBytes) {
+            return srt::Error(srt::Error::InvalidArgument, "stitch: tensor shape mismatch");
+        }
+        if (srcLength != chunk.contextLength() || chunk.end > dstLength) {
+            return srt::Error(
+                srt::Error::InvalidArgument,
+                stdc::formatN("stitch: expected %1 frames in chunk output, got %2",
+                              chunk.contextLength(), srcLength));
+        }
+        const auto offset = chunk.begin - chunk.contextBegin;
+        std::memcpy(dst->mutableRawData() + chunk.begin * dstFrameBytes,
+                    chunkOutput->rawData() + offset * srcFrameBytes,
+                    (chunk.end - chunk.begin) * srcFrameBytes);
+        return srt::Expected<void>();
+    }
+
+}
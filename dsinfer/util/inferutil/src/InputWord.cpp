@@ -15,9 +15,6 @@ namespace ds::inferutil {
         preprocessPhonemeTokens(const std::vector<Co::InputWordInfo> &words,
                                 const std::map<std::string, int> &tokens) {
 
-        constexpr const char *SP_TOKEN = "SP";
-        constexpr const char *AP_TOKEN = "AP";
-
         using TensorType = int64_t;
         auto phoneCount = getPhoneCount(words);
         auto exp = TensorHelper<TensorType>::createFor1DArray(phoneCount);
@@ -28,18 +25,8 @@ namespace ds::inferutil {
 
         for (const auto &word : words) {
             for (const auto &phone : word.phones) {
-                // tokens
-                std::string tokenWithLang =
-                    (phone.language.empty() || phone.token == SP_TOKEN || phone.token == AP_TOKEN)
-                        ? phone.token
-                        : (phone.language + '/' + phone.token);
-
-                if (const auto it1 = tokens.find(tokenWithLang); it1 != tokens.end()) {
-                    // first try finding the phoneme with the language tag (lang/phoneme)
-                    helper.write(it1->second);
-                } else if (const auto it2 = tokens.find(phone.token); it2 != tokens.end()) {
-                    // then try finding the phoneme without the language tag (phoneme)
-                    helper.write(it2->second);
+                if (const auto id = findPhonemeToken(phone, tokens)) {
+                    helper.write(*id);
                 } else {
                     return srt::Error(srt::Error::InvalidArgument, "unknown token " + phone.token);
                 }
@@ -0,0 +1,55 @@
+#include <inferutil/Mixer.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define INFERUTIL_MIXER_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define INFERUTIL_MIXER_NEON
+#endif
+
+namespace ds::inferutil {
+
+    StereoGain panGain(float gain, float pan) {
+        constexpr double quarterPi = 0.78539816339744830962;
+        const double angle = (std::clamp(static_cast<double>(pan), -1.0, 1.0) + 1) * quarterPi;
+        return {
+            static_cast<float>(gain * std::cos(angle)),
+            static_cast<float>(gain * std::sin(angle)),
+        };
+    }
+
+    void mixMonoToStereo(const float *samples, size_t count, StereoGain gain, float *frames) {
+        size_t i = 0;
+#if defined(INFERUTIL_MIXER_SSE2)
+        // Each mono sample is duplicated into a left/right pair, 4 samples make 2 vectors
+        const __m128 vgain = _mm_setr_ps(gain.left, gain.right, gain.left, gain.right);
+        for (; i + 4 <= count; i += 4) {
+            const __m128 v = _mm_loadu_ps(samples + i);
+            float *out = frames + 2 * i;
+            const __m128 lo = _mm_mul_ps(_mm_unpacklo_ps(v, v), vgain);
+            const __m128 hi = _mm_mul_ps(_mm_unpackhi_ps(v, v), vgain);
+            _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), lo));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), hi));
+        }
+#elif defined(INFERUTIL_MIXER_NEON)
+        // The frames are deinterleaved on load and interleaved again on store
+        for (; i + 4 <= count; i += 4) {
+            const float32x4_t v = vld1q_f32(samples + i);
+            float *out = frames + 2 * i;
+            float32x4x2_t lr = vld2q_f32(out);
+            lr.val[0] = vmlaq_n_f32(lr.val[0], v, gain.left);
+            lr.val[1] = vmlaq_n_f32(lr.val[1], v, gain.right);
+            vst2q_f32(out, lr);
+        }
+#endif
+        for (; i < count; ++i) {
+            frames[2 * i] += samples[i] * gain.left;
+            frames[2 * i + 1] += samples[i] * gain.right;
+        }
+    }
+
+}
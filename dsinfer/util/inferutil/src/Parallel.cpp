@@ -0,0 +1,153 @@
+#include <inferutil/Parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace ds::inferutil {
+
+    // Helper threads running in the process, bounded by maxParallelThreads()
+    static std::atomic<int> busyHelpers = 0;
+
+    int maxParallelThreads() {
+        static const int count = [] {
+            const int hardware = static_cast<int>(std::thread::hardware_concurrency());
+            return std::clamp(hardware - 1, 0, 7);
+        }();
+        return count;
+    }
+
+    // Takes up to n helpers from the budget
+    static int reserveHelpers(int n) {
+        int busy = busyHelpers.load(std::memory_order_relaxed);
+        while (true) {
+            const int reserved = (std::min) (n, maxParallelThreads() - busy);
+            if (reserved <= 0) {
+                return 0;
+            }
+            if (busyHelpers.compare_exchange_weak(busy, busy + reserved,
+                                                  std::memory_order_relaxed)) {
+                return reserved;
+            }
+        }
+    }
+
+    // Joins the helper threads and returns their reservation to the budget
+    class HelperThreads {
+    public:
+        explicit HelperThreads(int reserved) : _reserved(reserved) {
+        }
+
+        ~HelperThreads() {
+            for (auto &thread : _threads) {
+                thread.join();
+            }
+            busyHelpers.fetch_sub(static_cast<int>(_threads.size()), std::memory_order_relaxed);
+        }
+
+        HelperThreads(const HelperThreads &) = delete;
+        HelperThreads &operator=(const HelperThreads &) = delete;
+
+        template <class F>
+        void start(const F &worker) {
+            try {
+                _threads.reserve(_reserved);
+                for (int i = 0; i < _reserved; ++i) {
+                    _threads.emplace_back(worker);
+                }
+            } catch (...) {
+                // No more threads could be started, the calling thread takes over their share
+            }
+            busyHelpers.fetch_sub(_reserved - static_cast<int>(_threads.size()),
+                                  std::memory_order_relaxed);
+        }
+
+    protected:
+        int _reserved;
+        std::vector<std::thread> _threads;
+    };
+
+    void parallelFor(size_t count, const std::function<void(size_t)> &task) {
+        const int helpers =
+            count > 1 ? reserveHelpers(static_cast<int>((std::min) (count - 1, size_t(64)))) : 0;
+        if (helpers == 0) {
+            for (size_t i = 0; i < count; ++i) {
+                task(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next = 0;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        const auto worker = [&]() {
+            try {
+                for (size_t i = next++; i < count; i = next++) {
+                    task(i);
+                }
+            } catch (...) {
+                // Skip the remaining indices, the first exception is rethrown after the join
+                next = count;
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        };
+
+        {
+            HelperThreads threads(helpers);
+            threads.start(worker);
+            worker();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void parallelTiles(int64_t length, int64_t minTile,
+                       const std::function<void(int64_t begin, int64_t end)> &task) {
+        if (length <= 0) {
+            return;
+        }
+        // At most one tile per thread, but no tile below the minimum size
+        const int64_t tileSize = (std::max) (minTile, int64_t(1));
+        const int64_t maxTiles = (std::max) (length / tileSize, int64_t(1));
+        const auto tiles =
+            static_cast<size_t>((std::min) (maxTiles, int64_t(maxParallelThreads() + 1)));
+        parallelFor(tiles, [&](size_t i) {
+            const auto begin = static_cast<int64_t>(i) * length / static_cast<int64_t>(tiles);
+            const auto end = static_cast<int64_t>(i + 1) * length / static_cast<int64_t>(tiles);
+            task(begin, end);
+        });
+    }
+
+    srt::Expected<void> runTasks(const std::vector<std::function<srt::Expected<void>()>> &tasks,
+                                 bool parallel) {
+        if (!parallel) {
+            for (const auto &task : tasks) {
+                if (auto res = task(); !res) {
+                    return res;
+                }
+            }
+            return srt::Expected<void>();
+        }
+
+        std::vector<std::optional<srt::Error>> errors(tasks.size());
+        parallelFor(tasks.size(), [&](size_t i) {
+            if (auto res = tasks[i](); !res) {
+                errors[i] = res.takeError();
+            }
+        });
+        for (auto &error : errors) {
+            if (error) {
+                return std::move(*error);
+            }
+        }
+        return srt::Expected<void>();
+    }
+
+}
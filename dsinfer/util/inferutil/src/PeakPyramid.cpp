@@ -0,0 +1,204 @@
+#include <inferutil/PeakPyramid.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define INFERUTIL_PEAKS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define INFERUTIL_PEAKS_NEON
+#endif
+
+namespace ds::inferutil {
+
+    namespace Vo = Api::Vocoder::L1;
+
+    // Sums of squares are accumulated in float lanes for at most this many samples, then added
+    // to a double, which keeps the error negligible for long bins.
+    static constexpr size_t ReduceBlockSize = 1024;
+
+    static inline void reduceBlock(const float *samples, size_t count, float &outMin,
+                                   float &outMax, double &outSumSquares) {
+        size_t i = 0;
+        float lo = outMin;
+        float hi = outMax;
+        float sumSquares = 0;
+#if defined(INFERUTIL_PEAKS_SSE2)
+        if (count >= 4) {
+            __m128 vmin = _mm_set1_ps(lo);
+            __m128 vmax = _mm_set1_ps(hi);
+            __m128 vsum = _mm_setzero_ps();
+            for (; i + 4 <= count; i += 4) {
+                const __m128 v = _mm_loadu_ps(samples + i);
+                vmin = _mm_min_ps(vmin, v);
+                vmax = _mm_max_ps(vmax, v);
+                vsum = _mm_add_ps(vsum, _mm_mul_ps(v, v));
+            }
+            alignas(16) float lanes[3][4];
+            _mm_store_ps(lanes[0], vmin);
+            _mm_store_ps(lanes[1], vmax);
+            _mm_store_ps(lanes[2], vsum);
+            for (int k = 0; k < 4; ++k) {
+                lo = std::min(lo, lanes[0][k]);
+                hi = std::max(hi, lanes[1][k]);
+                sumSquares += lanes[2][k];
+            }
+        }
+#elif defined(INFERUTIL_PEAKS_NEON)
+        if (count >= 4) {
+            float32x4_t vmin = vdupq_n_f32(lo);
+            float32x4_t vmax = vdupq_n_f32(hi);
+            float32x4_t vsum = vdupq_n_f32(0);
+            for (; i + 4 <= count; i += 4) {
+                const float32x4_t v = vld1q_f32(samples + i);
+                vmin = vminq_f32(vmin, v);
+                vmax = vmaxq_f32(vmax, v);
+                vsum = vmlaq_f32(vsum, v, v);
+            }
+            lo = vminvq_f32(vmin);
+            hi = vmaxvq_f32(vmax);
+            sumSquares = vaddvq_f32(vsum);
+        }
+#endif
+        for (; i < count; ++i) {
+            const float v = samples[i];
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+            sumSquares += v * v;
+        }
+        outMin = lo;
+        outMax = hi;
+        outSumSquares += sumSquares;
+    }
+
+    void PeakPyramidBuilder::Accumulator::reset() {
+        min = std::numeric_limits<float>::infinity();
+        max = -std::numeric_limits<float>::infinity();
+        sumSquares = 0;
+        count = 0;
+    }
+
+    PeakPyramidBuilder::PeakPyramidBuilder(const std::vector<int> &binSizes,
+                                           size_t expectedSamples) {
+        std::vector<int> sizes;
+        for (const auto binSize : binSizes) {
+            if (binSize > 0) {
+                sizes.push_back(binSize);
+            }
+        }
+        std::sort(sizes.begin(), sizes.end());
+        sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+
+        _levels.resize(sizes.size());
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            auto &level = _levels[i];
+            level.binSize = sizes[i];
+            level.peaks.binSize = sizes[i];
+            level.acc.reset();
+
+            const auto bins = (expectedSamples + sizes[i] - 1) / sizes[i];
+            level.peaks.min.reserve(bins);
+            level.peaks.max.reserve(bins);
+            level.peaks.rms.reserve(bins);
+
+            // Aggregate from the largest finer level that divides the bin size
+            bool hasParent = false;
+            for (size_t j = i; j-- > 0;) {
+                if (sizes[i] % sizes[j] == 0) {
+                    _levels[j].children.push_back(i);
+                    hasParent = true;
+                    break;
+                }
+            }
+            if (!hasParent) {
+                _roots.push_back(i);
+            }
+        }
+
+        _order.reserve(binSizes.size());
+        for (const auto binSize : binSizes) {
+            const auto it = std::lower_bound(sizes.begin(), sizes.end(), binSize);
+            _order.push_back(it != sizes.end() && *it == binSize ? it - sizes.begin()
+                                                                 : sizes.size());
+        }
+    }
+
+    void PeakPyramidBuilder::append(const float *samples, size_t count) {
+        for (const auto index : _roots) {
+            auto &acc = _levels[index].acc;
+            const auto binSize = static_cast<size_t>(_levels[index].binSize);
+            size_t pos = 0;
+            while (pos < count) {
+                const auto n = std::min({count - pos, binSize - acc.count, ReduceBlockSize});
+                reduceBlock(samples + pos, n, acc.min, acc.max, acc.sumSquares);
+                acc.count += n;
+                pos += n;
+                if (acc.count == binSize) {
+                    emit(index);
+                }
+            }
+        }
+    }
+
+    void PeakPyramidBuilder::emit(size_t index) {
+        auto &level = _levels[index];
+        auto &acc = level.acc;
+        level.peaks.min.push_back(acc.min);
+        level.peaks.max.push_back(acc.max);
+        level.peaks.rms.push_back(
+            static_cast<float>(std::sqrt(acc.sumSquares / static_cast<double>(acc.count))));
+
+        for (const auto childIndex : level.children) {
+            auto &child = _levels[childIndex];
+            child.acc.min = std::min(child.acc.min, acc.min);
+            child.acc.max = std::max(child.acc.max, acc.max);
+            child.acc.sumSquares += acc.sumSquares;
+            child.acc.count += acc.count;
+            if (child.acc.count == static_cast<size_t>(child.binSize)) {
+                emit(childIndex);
+            }
+        }
+        acc.reset();
+    }
+
+    std::vector<Vo::WaveformPeaks> PeakPyramidBuilder::finish() {
+        // Finer levels first, so that their partial bins reach the coarser ones before those are
+        // flushed
+        for (size_t i = 0; i < _levels.size(); ++i) {
+            if (_levels[i].acc.count > 0) {
+                emit(i);
+            }
+        }
+
+        std::vector<Vo::WaveformPeaks> res;
+        res.reserve(_order.size());
+        for (size_t i = 0; i < _order.size(); ++i) {
+            const auto index = _order[i];
+            if (index >= _levels.size()) {
+                res.emplace_back();
+                continue;
+            }
+            // The same bin size may be requested twice, only move it out the last time
+            const bool lastUse = std::find(_order.begin() + i + 1, _order.end(), index) ==
+                                 _order.end();
+            res.push_back(lastUse ? std::move(_levels[index].peaks) : _levels[index].peaks);
+        }
+
+        for (auto &level : _levels) {
+            level.peaks = {};
+            level.peaks.binSize = level.binSize;
+        }
+        return res;
+    }
+
+    std::vector<Vo::WaveformPeaks> computePeakPyramid(const float *samples, size_t count,
+                                                      const std::vector<int> &binSizes) {
+        PeakPyramidBuilder builder(binSizes, count);
+        builder.append(samples, count);
+        return builder.finish();
+    }
+
+}
@@ -0,0 +1,43 @@
+#include <inferutil/SessionSkeleton.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace ds::inferutil {
+
+    void SessionSkeleton::addInput(std::string name) {
+        if (std::find(_inputs.begin(), _inputs.end(), name) == _inputs.end()) {
+            _inputs.push_back(std::move(name));
+        }
+    }
+
+    void SessionSkeleton::addOutput(std::string name) {
+        _outputs.insert(std::move(name));
+    }
+
+    srt::NO<Api::Onnx::SessionStartInput> SessionSkeleton::instantiate() const {
+        auto input = srt::NO<Api::Onnx::SessionStartInput>::create();
+        input->outputs = _outputs;
+        return input;
+    }
+
+    srt::Expected<void>
+        SessionSkeleton::checkInputs(const Api::Onnx::SessionStartInput &input) const {
+        std::string missing;
+        for (const auto &name : _inputs) {
+            if (input.inputs.find(name) == input.inputs.end()) {
+                missing += R"( ")" + name + '"';
+            }
+        }
+        if (!missing.empty()) {
+            return srt::Error(srt::Error::SessionError, "some required inputs missing:" + missing);
+        }
+        return srt::Expected<void>();
+    }
+
+    void SessionSkeleton::clear() {
+        _inputs.clear();
+        _outputs.clear();
+    }
+
+}
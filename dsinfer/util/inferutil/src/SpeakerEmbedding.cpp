@@ -1,11 +1,14 @@
 #include <inferutil/SpeakerEmbedding.h>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <utility>
 
 #include <stdcorelib/path.h>
 
 #include <inferutil/Algorithm.h>
+#include <inferutil/Parallel.h>
 
 namespace ds::inferutil {
     namespace Co = Api::Common::L1;
@@ -39,45 +42,115 @@ namespace ds::inferutil {
         return outVec;
     }
 
-    srt::Expected<srt::NO<ITensor>> preprocessSpeakerEmbeddingFrames(
-        const std::vector<Api::Common::L1::InputSpeakerInfo> &speakers,
-        const std::map<std::string, std::vector<float>> &embMap, int hiddenSize,
-        double frameWidth, int64_t targetLength) {
+    srt::Expected<SpeakerFrames>
+        resampleSpeakerFrames(const std::vector<Co::InputSpeakerInfo> &speakers,
+                              const std::map<std::string, std::vector<float>> &embMap,
+                              int hiddenSize, double frameWidth, int64_t targetLength) {
+        SpeakerFrames frames;
+        frames.hiddenSize = hiddenSize;
+        frames.targetLength = targetLength;
 
-        std::vector<int64_t> shape = {1, targetLength, hiddenSize};
-        if (auto exp = Tensor::create(ITensor::Float, shape); exp) {
-            // get tensor buffer
-            auto tensor = exp.take();
-            auto buffer = tensor->mutableData<float>();
-            if (!buffer) {
-                return srt::Error(srt::Error::SessionError, "failed to create spk_embed tensor");
+        // find speaker embeddings
+        frames.embeddings.reserve(speakers.size());
+        for (const auto &speaker : std::as_const(speakers)) {
+            if (auto it_speaker = embMap.find(speaker.name); it_speaker != embMap.end()) {
+                if (it_speaker->second.size() != hiddenSize) {
+                    return srt::Error(srt::Error::SessionError,
+                                      "speaker embedding vector length does not match hiddenSize");
+                }
+                frames.embeddings.push_back(&it_speaker->second);
+            } else {
+                return srt::Error(srt::Error::InvalidArgument,
+                                  "invalid speaker name: " + speaker.name);
             }
+        }
 
-            // mix speaker embedding
-            for (const auto &speaker : std::as_const(speakers)) {
-                if (auto it_speaker = embMap.find(speaker.name); it_speaker != embMap.end()) {
-                    const auto &embedding = it_speaker->second;
-                    if (embedding.size() != hiddenSize) {
-                        return srt::Error(
-                            srt::Error::SessionError,
-                            "speaker embedding vector length does not match hiddenSize");
-                    }
-                    auto resampled = resample(speaker.proportions, speaker.interval, frameWidth,
-                                              targetLength, true);
-                    for (size_t i = 0; i < resampled.size(); ++i) {
-                        for (size_t j = 0; j < embedding.size(); ++j) {
-                            float &val = buffer[i * embedding.size() + j];
-                            val = std::fmaf(static_cast<float>(resampled[i]), embedding[j], val);
-                        }
+        // resample speaker proportions
+        frames.proportions.resize(speakers.size());
+        const auto resampleSpeaker = [&](size_t k) {
+            const auto &speaker = speakers[k];
+            frames.proportions[k] = resample(speaker.proportions, speaker.interval, frameWidth,
+                                             targetLength, true);
+        };
+        if (targetLength >= ParallelFrameThreshold) {
+            parallelFor(speakers.size(), resampleSpeaker);
+        } else {
+            for (size_t k = 0; k < speakers.size(); ++k) {
+                resampleSpeaker(k);
+            }
+        }
+        return frames;
+    }
+
+    srt::Expected<srt::NO<ITensor>> mixSpeakerEmbeddingFrames(const SpeakerFrames &frames,
+                                                              int64_t begin, int64_t end) {
+        if (begin < 0 || end > frames.targetLength || begin > end) {
+            return srt::Error(srt::Error::InvalidArgument,
+                              "speaker embedding frame range out of bounds");
+        }
+        const int64_t length = end - begin;
+        std::vector<int64_t> shape = {1, length, frames.hiddenSize};
+        auto exp = Tensor::create(ITensor::Float, shape);
+        if (!exp) {
+            return exp.takeError();
+        }
+        // get tensor buffer
+        auto tensor = exp.take();
+        auto buffer = tensor->mutableData<float>();
+        if (!buffer) {
+            return srt::Error(srt::Error::SessionError, "failed to create spk_embed tensor");
+        }
+
+        // mix speaker embedding, the speakers are summed in order whatever the tiling
+        const auto mixFrames = [&](int64_t tileBegin, int64_t tileEnd) {
+            for (size_t k = 0; k < frames.embeddings.size(); ++k) {
+                const auto &embedding = *frames.embeddings[k];
+                const auto &resampled = frames.proportions[k];
+                const auto last =
+                    (std::min) (static_cast<size_t>(begin + tileEnd), resampled.size());
+                for (size_t i = begin + tileBegin; i < last; ++i) {
+                    float *dst = buffer + (i - begin) * embedding.size();
+                    for (size_t j = 0; j < embedding.size(); ++j) {
+                        dst[j] = std::fmaf(static_cast<float>(resampled[i]), embedding[j], dst[j]);
                     }
-                } else {
-                    return srt::Error(srt::Error::InvalidArgument,
-                                      "invalid speaker name: " + speaker.name);
                 }
             }
-            return tensor;
+        };
+        if (length >= ParallelFrameThreshold) {
+            parallelTiles(length, ParallelMinTile, mixFrames);
         } else {
+            mixFrames(0, length);
+        }
+        return tensor;
+    }
+
+    srt::Expected<srt::NO<ITensor>> preprocessSpeakerEmbeddingFrames(
+        const std::vector<Api::Common::L1::InputSpeakerInfo> &speakers,
+        const std::map<std::string, std::vector<float>> &embMap, int hiddenSize,
+        double frameWidth, int64_t targetLength) {
+        auto exp = resampleSpeakerFrames(speakers, embMap, hiddenSize, frameWidth, targetLength);
+        if (!exp) {
             return exp.takeError();
         }
+        return mixSpeakerEmbeddingFrames(exp.value(), 0, targetLength);
+    }
+
+    srt::Expected<void>
+        validateSpeakerEmbeddings(const std::map<std::string, std::vector<float>> &embMap,
+                                  int hiddenSize) {
+        if (embMap.empty()) {
+            return srt::Expected<void>();
+        }
+        if (hiddenSize <= 0) {
+            return srt::Error(srt::Error::InvalidArgument, "hiddenSize must be a positive integer");
+        }
+        for (const auto &[name, embedding] : embMap) {
+            if (embedding.size() != hiddenSize) {
+                return srt::Error(srt::Error::InvalidArgument,
+                                  "speaker embedding vector length of " + name +
+                                      " does not match hiddenSize");
+            }
+        }
+        return srt::Expected<void>();
     }
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 
 #include <stdcorelib/str.h>
 
+#include <dsinfer/Support/CurveEncoding.h>
+
 namespace ds {
 
     namespace Co = Api::Common::L1;
@@ -111,21 +113,50 @@ namespace ds {
         if (isDynamic) {
             // if dynamic, then look for `values` array of numbers and `interval`
             if (auto it_value = parameter.find("values"); it_value != parameter.end()) {
-                // for dynamic parameter, populate values array from JSON input
-                if (!it_value->second.isArray()) {
-                    return srt::Error(srt::Error::InvalidFormat,
-                                      "for dynamic parameter, " + paramName +
-                                          "[].values must be an array of numbers");
+                // parameters[].encoding optional field, values are an array of numbers by default
+                std::string encoding;
+                if (auto it_encoding = parameter.find("encoding"); it_encoding != parameter.end()) {
+                    if (!it_encoding->second.isString()) {
+                        return srt::Error(srt::Error::InvalidFormat,
+                                          paramName + "[].encoding must be a string");
+                    }
+                    encoding = it_encoding->second.toString();
+                    if (encoding != Float32CurveEncoding) {
+                        return srt::Error(srt::Error::InvalidFormat,
+                                          paramName + "[].encoding unknown: " + encoding);
+                    }
                 }
-                const auto &values = it_value->second.toArray();
-                outValues.reserve(values.size());
-                for (const auto &value : values) {
-                    if (!value.isNumber()) {
+                if (!encoding.empty()) {
+                    // for encoded parameter, decode values from base64 string
+                    if (!it_value->second.isString()) {
+                        return srt::Error(srt::Error::InvalidFormat,
+                                          "for encoded parameter, " + paramName +
+                                              "[].values must be a base64 string");
+                    }
+                    auto exp = decodeFloat32Base64(it_value->second.toStringView());
+                    if (!exp) {
+                        return srt::Error(srt::Error::InvalidFormat,
+                                          "for encoded parameter, " + paramName +
+                                              "[].values decode failed: " + exp.error().message());
+                    }
+                    outValues = exp.take();
+                } else {
+                    // for dynamic parameter, populate values array from JSON input
+                    if (!it_value->second.isArray()) {
                         return srt::Error(srt::Error::InvalidFormat,
                                           "for dynamic parameter, " + paramName +
-                                              "[].values[] item must be a number");
+                                              "[].values must be an array of numbers");
+                    }
+                    const auto &values = it_value->second.toArray();
+                    outValues.reserve(values.size());
+                    for (const auto &value : values) {
+                        if (!value.isNumber()) {
+                            return srt::Error(srt::Error::InvalidFormat,
+                                              "for dynamic parameter, " + paramName +
+                                                  "[].values[] item must be a number");
+                        }
+                        outValues.push_back(value.toDouble());
                     }
-                    outValues.push_back(value.toDouble());
                 }
                 // for dynamic parameter, `interval` must exist and be a positive number
                 if (auto it_interval = parameter.find("interval"); it_interval != parameter.end()) {
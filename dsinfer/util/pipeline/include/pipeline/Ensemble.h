@@ -0,0 +1,89 @@
+#ifndef DSINFER_PIPELINE_ENSEMBLE_H
+#define DSINFER_PIPELINE_ENSEMBLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pipeline/Pipeline.h>
+
+namespace ds::pipeline {
+
+    /// A voice of an ensemble.
+    struct EnsembleTrack {
+        /// Name of the track in the error messages.
+        std::string name;
+
+        const srt::SingerSpec *singer = nullptr;
+        srt::NO<Api::Acoustic::L1::AcousticStartInput> input;
+
+        /// Start of the track in the mix, in seconds.
+        double offset = 0;
+
+        /// Linear gain.
+        float gain = 1;
+
+        /// Position in the stereo field, from -1 (left) to 1 (right).
+        float pan = 0;
+    };
+
+    struct EnsembleOptions {
+        /// The options of the pipelines. Unless a coalescer is given, the pipelines of the
+        /// ensemble share one, so that voices singing the same part are rendered once.
+        PipelineOptions pipelineOptions;
+
+        /// Maximum number of voices rendered at once. (0 means the number of hardware threads)
+        int concurrency = 0;
+
+        /// Maximum number of frames passed to the sink at once.
+        size_t blockSize = 4096;
+    };
+
+    /// EnsembleRenderer - Renders the voices of a choir or a harmony and mixes them into a stereo
+    /// stream.
+    ///
+    /// The voices are rendered concurrently, earliest first, by a pool of pipelines per singer
+    /// that is kept across renders. Each voice is mixed in as soon as it is done, and the mix is
+    /// streamed up to the start of the earliest voice still being rendered.
+    ///
+    /// Renders on the same renderer must not overlap.
+    class EnsembleRenderer {
+    public:
+        /// Receives \a frames interleaved stereo frames of the mix, in order. Called on the
+        /// rendering thread. Returning false stops the render.
+        using Sink = std::function<bool(const float *samples, size_t frames, int sampleRate)>;
+
+        EnsembleRenderer();
+        ~EnsembleRenderer();
+
+        EnsembleRenderer(const EnsembleRenderer &) = delete;
+        EnsembleRenderer &operator=(const EnsembleRenderer &) = delete;
+
+    public:
+        void setOptions(const EnsembleOptions &options);
+        const EnsembleOptions &options() const;
+
+        /// Renders and mixes the tracks. All the singers must share a sample rate.
+        ///
+        /// If \a cancelled is set, the render fails as soon as it becomes true. The tracks are
+        /// checked with \c Pipeline::validate() before any of them is rendered.
+        srt::Expected<void> render(const std::vector<EnsembleTrack> &tracks, const Sink &sink,
+                                   const std::atomic<bool> *cancelled = nullptr);
+
+        /// Stops the render in progress, if any. The render fails.
+        void stop();
+
+        /// Closes the idle pipelines.
+        void clear();
+
+    protected:
+        class Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
+}
+
+#endif // DSINFER_PIPELINE_ENSEMBLE_H
@@ -0,0 +1,84 @@
+#ifndef DSINFER_PIPELINE_INPUTHASH_H
+#define DSINFER_PIPELINE_INPUTHASH_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <dsinfer/Api/Inferences/Common/1/CommonApiL1.h>
+#include <dsinfer/Api/Inferences/Acoustic/1/AcousticApiL1.h>
+
+namespace srt {
+    class SingerSpec;
+}
+
+namespace ds::pipeline {
+
+    struct PipelineOptions;
+
+    /// 256-bit content hash of a render input.
+    using InputHash = std::array<uint8_t, 32>;
+
+    std::string toHexString(const InputHash &hash);
+
+    /// InputHasher - Incremental BLAKE3 hasher over a canonical encoding of the input structures.
+    ///
+    /// Every value is written with its type-specific width and every sequence is prefixed with
+    /// its length, so that different structures never produce the same byte stream.
+    class InputHasher {
+    public:
+        InputHasher();
+        ~InputHasher();
+
+        InputHasher(const InputHasher &) = delete;
+        InputHasher &operator=(const InputHasher &) = delete;
+
+        void update(const void *data, size_t size);
+
+        inline void update(int64_t value) {
+            update(&value, sizeof(value));
+        }
+        inline void update(double value) {
+            // Treat +0.0 and -0.0 as the same value
+            if (value == 0) {
+                value = 0;
+            }
+            update(&value, sizeof(value));
+        }
+        inline void update(std::string_view str) {
+            update(static_cast<int64_t>(str.size()));
+            update(str.data(), str.size());
+        }
+
+        void update(const Api::Common::L1::InputWordInfo &word);
+        void update(const Api::Common::L1::InputParameterInfo &param);
+        void update(const Api::Common::L1::InputSpeakerInfo &speaker);
+        void update(const Api::Acoustic::L1::AcousticStartInput &input);
+
+        /// Hashes the identity of a singer: its id and the id and version of its package, as
+        /// the same singer id may be provided by several packages or package versions.
+        void update(const srt::SingerSpec &singer);
+
+        InputHash finalize() const;
+
+    protected:
+        class Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
+    /// Hashes all the fields of an acoustic input that affect the render result.
+    /// \a salt is mixed in first, e.g. the singer id, so that equal inputs of different singers
+    /// produce different hashes.
+    InputHash hashAcousticInput(const Api::Acoustic::L1::AcousticStartInput &input,
+                                std::string_view salt = {});
+
+    /// Hashes a render request: the acoustic input, the singer, and the pipeline options that
+    /// affect the render result.
+    InputHash hashRenderRequest(const Api::Acoustic::L1::AcousticStartInput &input,
+                                const srt::SingerSpec &singer, const PipelineOptions &options);
+
+}
+
+#endif // DSINFER_PIPELINE_INPUTHASH_H
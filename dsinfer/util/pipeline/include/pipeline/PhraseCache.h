@@ -0,0 +1,54 @@
+#ifndef DSINFER_PIPELINE_PHRASECACHE_H
+#define DSINFER_PIPELINE_PHRASECACHE_H
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <pipeline/InputHash.h>
+#include <pipeline/Pipeline.h>
+
+namespace ds::pipeline {
+
+    /// PhraseCache - Thread-safe LRU cache of render results, keyed by input hash.
+    ///
+    /// Entries are content-addressed, so editing a phrase never makes an entry stale; the old
+    /// result is simply no longer looked up and ages out.
+    class PhraseCache {
+    public:
+        using Value = std::shared_ptr<const RenderResult>;
+
+        explicit PhraseCache(size_t capacity = 64);
+        ~PhraseCache();
+
+        PhraseCache(const PhraseCache &) = delete;
+        PhraseCache &operator=(const PhraseCache &) = delete;
+
+    public:
+        /// Returns the cached result and marks it as the most recently used, or null on miss.
+        Value find(const InputHash &key);
+        bool contains(const InputHash &key) const;
+
+        void insert(const InputHash &key, Value value);
+        bool remove(const InputHash &key);
+        void clear();
+
+        size_t size() const;
+        size_t capacity() const;
+        void setCapacity(size_t capacity);
+
+    protected:
+        using List = std::list<std::pair<InputHash, Value>>;
+
+        void shrink();
+
+        mutable std::mutex _mutex;
+        size_t _capacity;
+        List _list;
+        std::map<InputHash, List::iterator> _index;
+    };
+
+}
+
+#endif // DSINFER_PIPELINE_PHRASECACHE_H
@@ -0,0 +1,147 @@
+#ifndef DSINFER_PIPELINE_PIPELINE_H
+#define DSINFER_PIPELINE_PIPELINE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <synthrt/Support/Expected.h>
+#include <synthrt/SVS/Inference.h>
+#include <synthrt/SVS/SingerContrib.h>
+
+#include <dsinfer/Core/Tensor.h>
+#include <dsinfer/Api/Inferences/Acoustic/1/AcousticApiL1.h>
+#include <dsinfer/Api/Inferences/Vocoder/1/VocoderApiL1.h>
+
+#include <pipeline/Preflight.h>
+#include <pipeline/ScoreDiff.h>
+#include <pipeline/Stage.h>
+
+namespace ds::pipeline {
+
+    struct RenderCoalescer;
+    class StageClient;
+
+    struct PipelineOptions {
+        /// The object name of the inference driver used by all stages. (empty means use the first
+        /// driver)
+        std::string driver;
+
+        /// The runtime options of the acoustic inference. (null means use the defaults)
+        srt::NO<Api::Acoustic::L1::AcousticRuntimeOptions> acousticOptions;
+
+        /// The options of the score diff run by \c renderIncremental().
+        ScoreDiffOptions diffOptions;
+
+        /// Bin sizes of the waveform peak pyramid returned with each render, e.g.
+        /// {64, 256, 1024, 4096}. (empty means no peaks)
+        std::vector<int> peakBinSizes;
+
+        /// The in-flight computations shared with other pipelines, e.g. one per singer or per
+        /// client. Concurrent renders of the same request attach to the one in progress instead
+        /// of running again, see \c SingleFlight. (null means no coalescing)
+        std::shared_ptr<RenderCoalescer> coalescer;
+
+        /// The size limits of a rendered input, checked by \c validate().
+        PreflightLimits limits;
+
+        /// The stages run by stage servers, see \c StageServer. The inferences of these stages
+        /// are not created by the pipeline. (null means the stage runs in process)
+        std::array<std::shared_ptr<StageClient>, StageCount> remoteStages;
+    };
+
+    /// Creates and initializes the inference of a stage of a singer, with the driver and the
+    /// runtime options of \a options.
+    srt::Expected<srt::NO<srt::Inference>> createStageInference(const srt::SingerSpec *singer,
+                                                                Stage stage,
+                                                                const PipelineOptions &options);
+
+    /// The outputs of a full render.
+    struct RenderResult {
+        /// The input as given to the pipeline.
+        srt::NO<Api::Acoustic::L1::AcousticStartInput> source;
+
+        /// The input completed with the predicted durations, pitch and variance parameters.
+        srt::NO<Api::Acoustic::L1::AcousticStartInput> input;
+
+        srt::NO<ITensor> mel;
+        srt::NO<ITensor> f0;
+
+        /// Mono 32-bit float samples.
+        std::vector<uint8_t> audioData;
+        int sampleRate = 0;
+
+        /// Waveform overview, one level per \c PipelineOptions::peakBinSizes.
+        std::vector<Api::Vocoder::L1::WaveformPeaks> peaks;
+    };
+
+    /// Pipeline - Runs the duration, pitch, variance, acoustic and vocoder inferences of a singer
+    /// in sequence.
+    ///
+    /// The inferences are created and initialized once in \c open() and reused by every render.
+    /// Renders on the same pipeline are serialized. \c open() and \c close() may be called while
+    /// renders are pending on other threads: the renders requested before fail instead of running
+    /// on the new state.
+    class Pipeline {
+    public:
+        Pipeline();
+        ~Pipeline();
+
+        Pipeline(const Pipeline &) = delete;
+        Pipeline &operator=(const Pipeline &) = delete;
+
+    public:
+        srt::Expected<void> open(const srt::SingerSpec *singer,
+                                 const PipelineOptions &options = {});
+        void close();
+        bool isOpen() const;
+
+        const srt::SingerSpec *singer() const;
+
+        /// Returns the options of the pipeline, which must not be reopened meanwhile.
+        const PipelineOptions &options() const;
+
+        /// Checks an input against the configurations of all the stages, see \c preflight().
+        /// Every render does it before running any stage.
+        srt::Expected<void>
+            validate(const Api::Acoustic::L1::AcousticStartInput &input) const;
+
+        /// Renders a phrase. The input is left untouched.
+        ///
+        /// If \a cancelled is set, it is checked between stages and the render fails as soon as
+        /// it becomes true.
+        ///
+        /// With a coalescer, an identical render in progress on another pipeline is joined, and
+        /// so are the duration, pitch and variance stages of a render of the same input.
+        srt::Expected<RenderResult>
+            render(const srt::NO<Api::Acoustic::L1::AcousticStartInput> &input,
+                   const std::atomic<bool> *cancelled = nullptr);
+
+        /// Renders a phrase, reusing the outputs of a previous render of the same phrase.
+        ///
+        /// The two inputs are diffed: the stages whose inputs are unchanged up to a time shift are
+        /// skipped and their previous outputs moved to the new positions, and the pitch and
+        /// variance stages only retake the dirty ranges of the curves.
+        srt::Expected<RenderResult>
+            renderIncremental(const srt::NO<Api::Acoustic::L1::AcousticStartInput> &input,
+                              const RenderResult &previous,
+                              const std::atomic<bool> *cancelled = nullptr);
+
+        /// Stops the stage being run, if any. The render in progress fails.
+        bool stop();
+
+        /// Returns a deep copy of an acoustic input.
+        static srt::NO<Api::Acoustic::L1::AcousticStartInput>
+            copyInput(const Api::Acoustic::L1::AcousticStartInput &input);
+
+    protected:
+        class Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
+}
+
+#endif // DSINFER_PIPELINE_PIPELINE_H
@@ -0,0 +1,46 @@
+#ifndef DSINFER_PIPELINE_PREFLIGHT_H
+#define DSINFER_PIPELINE_PREFLIGHT_H
+
+#include <cstddef>
+
+#include <synthrt/Support/Expected.h>
+
+#include <dsinfer/Api/Inferences/Acoustic/1/AcousticApiL1.h>
+#include <dsinfer/Api/Inferences/Duration/1/DurationApiL1.h>
+#include <dsinfer/Api/Inferences/Pitch/1/PitchApiL1.h>
+#include <dsinfer/Api/Inferences/Variance/1/VarianceApiL1.h>
+
+namespace ds::pipeline {
+
+    struct PreflightLimits {
+        /// The maximum number of phonemes of an input. (0 means unlimited)
+        size_t maxPhonemes = 0;
+
+        /// The maximum length of an input in seconds. (0 means unlimited)
+        double maxDuration = 0;
+    };
+
+    /// The configurations and schemas of a singer's stages an input is checked against. The
+    /// vocoder only takes the acoustic outputs, so it has nothing to check.
+    struct PreflightSpec {
+        srt::NO<Api::Duration::L1::DurationConfiguration> duration;
+        srt::NO<Api::Pitch::L1::PitchConfiguration> pitch;
+        srt::NO<Api::Variance::L1::VarianceConfiguration> variance;
+        srt::NO<Api::Variance::L1::VarianceSchema> varianceSchema;
+        srt::NO<Api::Acoustic::L1::AcousticConfiguration> acoustic;
+
+        PreflightLimits limits;
+    };
+
+    /// Checks an input against the stages of a pipeline without running any of them: the phoneme
+    /// tokens, languages and speakers must resolve in every stage that takes them, the
+    /// parameters required by the acoustic model must be supplied or predicted, and the timing
+    /// must be valid and within the limits.
+    ///
+    /// All the problems found are reported at once in an \c InvalidArgument error.
+    srt::Expected<void> preflight(const Api::Acoustic::L1::AcousticStartInput &input,
+                                  const PreflightSpec &spec);
+
+}
+
+#endif // DSINFER_PIPELINE_PREFLIGHT_H
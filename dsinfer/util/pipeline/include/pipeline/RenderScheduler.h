@@ -0,0 +1,109 @@
+#ifndef DSINFER_PIPELINE_RENDERSCHEDULER_H
+#define DSINFER_PIPELINE_RENDERSCHEDULER_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <pipeline/PhraseCache.h>
+#include <pipeline/Pipeline.h>
+
+namespace ds::pipeline {
+
+    enum class RenderPriority {
+        /// Requested by the user, e.g. playback. Runs as soon as possible.
+        Foreground,
+
+        /// Predicted to be requested soon, e.g. the phrase being edited. Only runs while no
+        /// foreground render is pending, and is dropped as soon as the phrase changes.
+        Speculative,
+    };
+
+    /// Renders a phrase, reusing \a previous, the latest result of the phrase, if not null. Must
+    /// fail as soon as \a cancelled becomes true.
+    using PhraseRenderer = std::function<srt::Expected<RenderResult>(
+        const srt::NO<Api::Acoustic::L1::AcousticStartInput> &input,
+        const RenderResult *previous, const std::atomic<bool> *cancelled)>;
+
+    struct RenderSchedulerOptions {
+        PipelineOptions pipelineOptions;
+
+        /// Renders the phrases instead of the pipelines of the singer, which are then not opened
+        /// and \c pipelineOptions is unused. (null means render with \c Pipeline)
+        PhraseRenderer renderer;
+
+        /// Maximum number of results kept in the phrase cache.
+        size_t cacheCapacity = 64;
+
+        /// Whether to open a second pipeline for speculative renders. If false, speculative
+        /// renders share the foreground pipeline and only run when it is idle.
+        bool separateSpeculativePipeline = true;
+    };
+
+    /// RenderScheduler - Renders the phrases of an editor session in the background and keeps the
+    /// results in a phrase cache.
+    ///
+    /// Each phrase is identified by a caller-defined id. Submitting a new input for a phrase
+    /// supersedes the pending and running renders of the previous input of the same phrase.
+    /// Results are cached by input hash, so re-submitting an input that has been rendered before
+    /// completes immediately. Otherwise the new input is diffed against the latest result of the
+    /// phrase and only the edited ranges are recomputed, see \c Pipeline::renderIncremental().
+    class RenderScheduler {
+    public:
+        /// Called on a worker thread, or on the submitting thread on cache hit. \a result is null
+        /// if \a error is set.
+        using Callback = std::function<void(const std::shared_ptr<const RenderResult> &result,
+                                            const srt::Error &error)>;
+
+        RenderScheduler();
+        ~RenderScheduler();
+
+        RenderScheduler(const RenderScheduler &) = delete;
+        RenderScheduler &operator=(const RenderScheduler &) = delete;
+
+    public:
+        srt::Expected<void> open(const srt::SingerSpec *singer,
+                                 const RenderSchedulerOptions &options = {});
+
+        /// Cancels all renders and joins the worker threads. Pending callbacks are called with a
+        /// cancellation error.
+        void close();
+        bool isOpen() const;
+
+        /// Schedules a render of \a input for \a phraseId. The input is copied.
+        ///
+        /// If a speculative render of the same input is pending or running, it is promoted and
+        /// \a callback is attached to it instead of starting a new render.
+        void submit(const std::string &phraseId,
+                    const srt::NO<Api::Acoustic::L1::AcousticStartInput> &input,
+                    RenderPriority priority = RenderPriority::Foreground,
+                    Callback callback = {});
+
+        /// Same as \c submit() with speculative priority and no callback; the result only fills
+        /// the cache.
+        inline void speculate(const std::string &phraseId,
+                              const srt::NO<Api::Acoustic::L1::AcousticStartInput> &input) {
+            submit(phraseId, input, RenderPriority::Speculative);
+        }
+
+        /// Cancels the pending and running renders of a phrase.
+        void invalidate(const std::string &phraseId);
+
+        /// Cancels all pending and running speculative renders.
+        void cancelSpeculative();
+
+        /// Returns the cached result of an input, or null if it has not been rendered yet.
+        std::shared_ptr<const RenderResult>
+            cachedResult(const Api::Acoustic::L1::AcousticStartInput &input) const;
+
+        PhraseCache &cache();
+
+    protected:
+        class Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
+}
+
+#endif // DSINFER_PIPELINE_RENDERSCHEDULER_H
@@ -0,0 +1,101 @@
+#ifndef DSINFER_PIPELINE_SCOREDIFF_H
+#define DSINFER_PIPELINE_SCOREDIFF_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <dsinfer/Api/Inferences/Acoustic/1/AcousticApiL1.h>
+
+#include <pipeline/Stage.h>
+
+namespace ds::pipeline {
+
+    /// Time range in seconds, [start, end).
+    struct TimeRange {
+        double start = 0;
+        double end = 0;
+    };
+
+    /// Frame range, [begin, end).
+    struct FrameRange {
+        int64_t begin = 0;
+        int64_t end = 0;
+    };
+
+    /// A span of the new score whose content is unchanged from the old score, up to a time shift.
+    struct ShiftedSpan {
+        /// Range in the new score, in seconds.
+        double start = 0;
+        double end = 0;
+
+        /// New time minus old time, in seconds.
+        double shift = 0;
+    };
+
+    struct StageDiff {
+        /// Ranges of the new score to recompute, sorted and disjoint.
+        std::vector<TimeRange> dirty;
+
+        /// Ranges of the new score whose previous outputs can be reused after shifting, sorted and
+        /// disjoint. Together with \c dirty, covers the whole score.
+        std::vector<ShiftedSpan> reusable;
+
+        inline bool clean() const {
+            return dirty.empty();
+        }
+    };
+
+    struct ScoreDiffOptions {
+        /// Extra range recomputed on both sides of each edit, per stage, in seconds. Covers the
+        /// receptive field of the models, whose outputs near an edit also change.
+        std::array<double, StageCount> context = {0.5, 0.5, 0.5, 0.2, 0.1};
+
+        /// Parameter values closer than this are considered equal.
+        double tolerance = 1e-6;
+
+        /// Above this many changed words in a row, the alignment gives up matching them one by
+        /// one and treats the whole run as replaced.
+        int64_t maxAlignWords = 2048;
+    };
+
+    struct ScoreDiff {
+        /// For each word of the new score, the index of the same word in the old score, or -1 if
+        /// it is new or changed.
+        std::vector<int64_t> wordMapping;
+
+        /// Dirty and reusable ranges per stage, indexed by \c Stage. The dirty ranges of a stage
+        /// include those of the stages before it.
+        std::array<StageDiff, StageCount> stages;
+
+        inline const StageDiff &stage(Stage s) const {
+            return stages[static_cast<int>(s)];
+        }
+
+        /// Returns true if no stage needs to be recomputed and no output moved.
+        bool identical() const;
+    };
+
+    /// Aligns two scores by word content and timing, and reports which ranges of each stage have
+    /// to be recomputed after the edit.
+    ///
+    /// Words are matched by content regardless of their position, so inserting or deleting notes
+    /// only dirties the edited region and the words after it are reported as shifted.
+    ScoreDiff diffScores(const Api::Acoustic::L1::AcousticStartInput &oldInput,
+                         const Api::Acoustic::L1::AcousticStartInput &newInput,
+                         const ScoreDiffOptions &options = {});
+
+    /// Converts time ranges to frame ranges, rounding outwards and clamping to [0, frameCount).
+    std::vector<FrameRange> toFrameRanges(const std::vector<TimeRange> &ranges, double frameWidth,
+                                          int64_t frameCount);
+
+    /// Moves the samples of an old curve to their new positions. Samples outside the reusable
+    /// spans are filled with the nearest reused value.
+    ///
+    /// Returns an empty vector if no sample can be reused.
+    std::vector<double> remapCurve(const std::vector<double> &oldValues, double interval,
+                                   const std::vector<ShiftedSpan> &spans, size_t newLength);
+
+}
+
+#endif // DSINFER_PIPELINE_SCOREDIFF_H
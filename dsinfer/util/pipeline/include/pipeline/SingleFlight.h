@@ -0,0 +1,166 @@
+#ifndef DSINFER_PIPELINE_SINGLEFLIGHT_H
+#define DSINFER_PIPELINE_SINGLEFLIGHT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <synthrt/Support/Expected.h>
+
+#include <pipeline/InputHash.h>
+#include <pipeline/Pipeline.h>
+
+namespace ds::pipeline {
+
+    /// SingleFlight - Coalesces concurrent computations of the same key.
+    ///
+    /// The first caller of a key runs the computation; the callers arriving while it is in flight
+    /// wait for it and share its result, including its error. Nothing is kept once the
+    /// computation is done, see \c PhraseCache for caching.
+    ///
+    /// \a Value is copied to every caller, so it should be a handle such as a shared pointer.
+    template <class Value>
+    class SingleFlight {
+    public:
+        SingleFlight() = default;
+
+        SingleFlight(const SingleFlight &) = delete;
+        SingleFlight &operator=(const SingleFlight &) = delete;
+
+    public:
+        /// Returns the result of \a fn, or of the call of the same key already in flight.
+        ///
+        /// \a cancelled is the caller's cancellation flag, checked while waiting. If the call in
+        /// flight fails because its own caller cancelled it, the waiters do not fail with it:
+        /// one of them runs \a fn again. \a shared is set to whether the result came from another
+        /// caller.
+        template <class Fn>
+        srt::Expected<Value> run(const InputHash &key, Fn &&fn,
+                                 const std::atomic<bool> *cancelled = nullptr,
+                                 bool *shared = nullptr);
+
+        /// Returns the number of computations in flight.
+        size_t size() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _calls.size();
+        }
+
+        /// Returns the number of callers that shared the result of another one.
+        uint64_t sharedCount() const {
+            return _sharedCount.load(std::memory_order_relaxed);
+        }
+
+    protected:
+        struct Call {
+            bool done = false;
+
+            // Set when the caller running the computation cancelled it
+            bool abandoned = false;
+
+            Value value{};
+            srt::Error error;
+        };
+
+        static bool isCancelled(const std::atomic<bool> *cancelled) {
+            return cancelled && cancelled->load(std::memory_order_acquire);
+        }
+
+        void finish(const InputHash &key, const std::shared_ptr<Call> &call) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                call->done = true;
+                _calls.erase(key);
+            }
+            _cv.notify_all();
+        }
+
+        mutable std::mutex _mutex;
+        std::condition_variable _cv;
+        std::map<InputHash, std::shared_ptr<Call>> _calls;
+        std::atomic<uint64_t> _sharedCount = 0;
+    };
+
+    template <class Value>
+    template <class Fn>
+    srt::Expected<Value> SingleFlight<Value>::run(const InputHash &key, Fn &&fn,
+                                                  const std::atomic<bool> *cancelled,
+                                                  bool *shared) {
+        // The pipeline cannot notify the waiters when it is stopped, so they poll
+        static constexpr auto pollInterval = std::chrono::milliseconds(10);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            if (isCancelled(cancelled)) {
+                return srt::Error(srt::Error::SessionError, "render cancelled");
+            }
+
+            auto it = _calls.find(key);
+            if (it == _calls.end()) {
+                break;
+            }
+
+            // Wait for the call in flight
+            const auto call = it->second;
+            while (!call->done && !isCancelled(cancelled)) {
+                if (cancelled) {
+                    _cv.wait_for(lock, pollInterval);
+                } else {
+                    _cv.wait(lock);
+                }
+            }
+            if (!call->done || call->abandoned) {
+                continue;
+            }
+            _sharedCount.fetch_add(1, std::memory_order_relaxed);
+            if (shared) {
+                *shared = true;
+            }
+            if (!call->error.ok()) {
+                return call->error;
+            }
+            return call->value;
+        }
+
+        // Run the computation
+        const auto call = std::make_shared<Call>();
+        _calls.emplace(key, call);
+        lock.unlock();
+
+        if (shared) {
+            *shared = false;
+        }
+        try {
+            srt::Expected<Value> exp = fn();
+            if (exp.hasValue()) {
+                call->value = exp.value();
+            } else {
+                call->error = exp.error();
+                call->abandoned = isCancelled(cancelled);
+            }
+            finish(key, call);
+            return exp;
+        } catch (...) {
+            call->abandoned = true;
+            finish(key, call);
+            throw;
+        }
+    }
+
+    /// RenderCoalescer - The in-flight computations shared by a set of pipelines, see
+    /// \c PipelineOptions::coalescer.
+    struct RenderCoalescer {
+        /// Whole renders, keyed by \c hashRenderRequest().
+        SingleFlight<std::shared_ptr<const RenderResult>> renders;
+
+        /// The input completed by the duration, pitch and variance stages, keyed by the input,
+        /// the singer and the driver. Shared by the renders that only differ in the later stages.
+        SingleFlight<srt::NO<Api::Acoustic::L1::AcousticStartInput>> predictions;
+    };
+
+}
+
+#endif // DSINFER_PIPELINE_SINGLEFLIGHT_H
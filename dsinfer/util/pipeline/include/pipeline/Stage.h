@@ -0,0 +1,31 @@
+#ifndef DSINFER_PIPELINE_STAGE_H
+#define DSINFER_PIPELINE_STAGE_H
+
+#include <optional>
+#include <string_view>
+
+namespace ds::pipeline {
+
+    /// The stages of a full render, in execution order.
+    enum class Stage {
+        Duration = 0,
+        Pitch,
+        Variance,
+        Acoustic,
+        Vocoder,
+    };
+
+    inline constexpr int StageCount = 5;
+
+    /// Returns the API name of a stage, e.g. "acoustic".
+    const char *stageName(Stage stage);
+
+    /// Returns the class name of the inferences of a stage, e.g. "ai.svs.AcousticInference".
+    const char *stageClassName(Stage stage);
+
+    /// Returns the stage of an API name.
+    std::optional<Stage> stageFromName(std::string_view name);
+
+}
+
+#endif // DSINFER_PIPELINE_STAGE_H
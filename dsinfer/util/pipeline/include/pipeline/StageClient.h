@@ -0,0 +1,57 @@
+#ifndef DSINFER_PIPELINE_STAGECLIENT_H
+#define DSINFER_PIPELINE_STAGECLIENT_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <synthrt/Support/Expected.h>
+#include <synthrt/Task/ITask.h>
+
+#include <pipeline/Stage.h>
+
+namespace ds::pipeline {
+
+    /// StageClient - Dispatches the calls of a stage to a set of stage servers, see
+    /// \c StageServer.
+    ///
+    /// Each call goes to the endpoint with the fewest calls in flight, falling back to the others
+    /// if it cannot be reached. When every endpoint has \c maxInFlight calls in flight, the
+    /// callers wait for one of them to finish, so that a slow stage holds back the callers
+    /// instead of queueing up unbounded work on the servers.
+    ///
+    /// A client may be shared by several pipelines and used from several threads.
+    class StageClient {
+    public:
+        /// \a endpoints are the socket paths of the servers, \a maxInFlight the number of calls
+        /// sent to each of them at once, e.g. the number of its worker processes.
+        StageClient(Stage stage, std::vector<std::string> endpoints, int maxInFlight = 1);
+        ~StageClient();
+
+        StageClient(const StageClient &) = delete;
+        StageClient &operator=(const StageClient &) = delete;
+
+    public:
+        Stage stage() const;
+        const std::vector<std::string> &endpoints() const;
+        int maxInFlight() const;
+
+        /// Returns the number of calls sent and not yet answered.
+        int inFlight() const;
+
+        /// Runs a stage input on one of the servers. The error of a failed run is returned in
+        /// \c TaskResult::error.
+        ///
+        /// If \a cancelled is set, the call fails as soon as it becomes true, waiting or not.
+        srt::Expected<srt::NO<srt::TaskResult>> run(const srt::TaskStartInput &input,
+                                                    const std::atomic<bool> *cancelled = nullptr);
+
+    protected:
+        class Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
+}
+
+#endif // DSINFER_PIPELINE_STAGECLIENT_H
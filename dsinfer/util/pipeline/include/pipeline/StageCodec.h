@@ -0,0 +1,63 @@
+#ifndef DSINFER_PIPELINE_STAGECODEC_H
+#define DSINFER_PIPELINE_STAGECODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <synthrt/Support/Expected.h>
+#include <synthrt/Task/ITask.h>
+
+#include <pipeline/Stage.h>
+
+namespace ds::pipeline {
+
+    /// A bulk payload of a stage message, e.g. the data of a tensor.
+    struct StageBlob {
+        const std::byte *data = nullptr;
+        size_t size = 0;
+
+        /// Keeps the data alive, e.g. the received buffer or a mapping. (null means the data
+        /// belongs to the encoded object)
+        std::shared_ptr<const void> holder;
+    };
+
+    /// The encoded input or result of a stage.
+    ///
+    /// The small fields are packed in \c body. The arrays of at least \c BlobThreshold bytes are
+    /// moved out to \c blobs, which the transport passes through shared memory.
+    struct StageMessage {
+        enum Kind : uint32_t {
+            Request = 1,
+            Response,
+            Failure,
+        };
+
+        static constexpr size_t BlobThreshold = 16384;
+
+        Kind kind = Request;
+        Stage stage = Stage::Duration;
+        std::vector<std::byte> body;
+        std::vector<StageBlob> blobs;
+    };
+
+    /// Encodes a stage input. The blobs refer to the data of \a input, which must outlive the
+    /// message.
+    srt::Expected<void> encodeStageInput(Stage stage, const srt::TaskStartInput &input,
+                                         StageMessage &message);
+
+    srt::Expected<srt::NO<srt::TaskStartInput>> decodeStageInput(const StageMessage &message);
+
+    /// Encodes a stage result, see \c encodeStageInput().
+    srt::Expected<void> encodeStageResult(Stage stage, const srt::TaskResult &result,
+                                          StageMessage &message);
+
+    srt::Expected<srt::NO<srt::TaskResult>> decodeStageResult(const StageMessage &message);
+
+    /// Encodes an error, decoded by \c decodeStageResult().
+    void encodeStageFailure(Stage stage, const srt::Error &error, StageMessage &message);
+
+}
+
+#endif // DSINFER_PIPELINE_STAGECODEC_H
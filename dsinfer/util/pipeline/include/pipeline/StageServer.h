@@ -0,0 +1,71 @@
+#ifndef DSINFER_PIPELINE_STAGESERVER_H
+#define DSINFER_PIPELINE_STAGESERVER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <synthrt/Support/Expected.h>
+#include <synthrt/SVS/SingerContrib.h>
+#include <synthrt/Task/ITask.h>
+
+#include <pipeline/Pipeline.h>
+#include <pipeline/Stage.h>
+
+namespace ds::pipeline {
+
+    /// StageServer - Runs a stage of a pipeline for the clients of a Unix socket, see
+    /// \c StageClient.
+    ///
+    /// A connection carries one call at a time, and the inputs and results are passed as stage
+    /// messages whose tensors and long curves travel through shared memory, see \c StageMessage.
+    ///
+    /// A server scales out by serving the same socket from several processes: listen once, fork
+    /// the workers and call \c serve() in each of them. The kernel hands every connection to one
+    /// of the idle workers.
+    ///
+    /// Not supported on Windows.
+    class StageServer {
+    public:
+        /// Runs a stage input, returns the result or the error sent back to the client.
+        using Handler = std::function<srt::Expected<srt::NO<srt::TaskResult>>(
+            const srt::NO<srt::TaskStartInput> &input)>;
+
+        StageServer(Stage stage, Handler handler);
+        ~StageServer();
+
+        StageServer(const StageServer &) = delete;
+        StageServer &operator=(const StageServer &) = delete;
+
+    public:
+        Stage stage() const;
+
+        /// Binds the socket, replacing a stale socket file at \a path.
+        srt::Expected<void> listen(const std::string &path);
+
+        /// Accepts and serves connections until \c stop() is called.
+        ///
+        /// With \a threaded, each connection is served on its own thread and the calls run
+        /// concurrently; otherwise the connections are served one by one on the calling thread,
+        /// which is what a forked worker needs.
+        srt::Expected<void> serve(bool threaded = false);
+
+        /// Stops \c serve() and the connections being served. Thread-safe.
+        void stop();
+
+        /// Closes the socket, and removes the socket file if this process created it.
+        void close();
+
+        /// Returns a handler running the inference of a stage of a singer, created with
+        /// \c createStageInference(). The calls are serialized.
+        static srt::Expected<Handler> inferenceHandler(const srt::SingerSpec *singer, Stage stage,
+                                                       const PipelineOptions &options = {});
+
+    protected:
+        class Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
+}
+
+#endif // DSINFER_PIPELINE_STAGESERVER_H
@@ -0,0 +1,368 @@
+#include <pipeline/Ensemble.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#include <stdcorelib/pimpl.h>
+#include <stdcorelib/str.h>
+
+#include <synthrt/Support/Logging.h>
+
+#include <inferutil/ErrorCollector.h>
+#include <inferutil/Mixer.h>
+
+#include <pipeline/SingleFlight.h>
+
+#include "MixBuffer_p.h"
+
+namespace ds::pipeline {
+
+    static srt::LogCategory Log("ensemble");
+
+    static inline srt::Error cancelledError() {
+        return srt::Error(srt::Error::SessionError, "render cancelled");
+    }
+
+    class EnsembleRenderer::Impl {
+    public:
+        EnsembleOptions options;
+        std::shared_ptr<RenderCoalescer> coalescer;
+
+        // Pipelines opened with older options are closed when released
+        int generation = 0;
+
+        std::mutex poolMutex;
+        std::map<const srt::SingerSpec *, std::vector<std::unique_ptr<Pipeline>>> idle;
+        std::vector<Pipeline *> busy;
+
+        // Set by stop() or when the render fails, checked by the pipelines between stages
+        std::atomic<bool> cancelled = false;
+
+        struct Lease {
+            const srt::SingerSpec *singer = nullptr;
+            std::unique_ptr<Pipeline> pipeline;
+            int generation = 0;
+        };
+
+        srt::Expected<Lease> acquire(const srt::SingerSpec *singer) {
+            PipelineOptions pipelineOptions;
+            int gen;
+            {
+                std::lock_guard<std::mutex> lock(poolMutex);
+                gen = generation;
+                auto &pipelines = idle[singer];
+                if (!pipelines.empty()) {
+                    auto pipeline = std::move(pipelines.back());
+                    pipelines.pop_back();
+                    busy.push_back(pipeline.get());
+                    return Lease{singer, std::move(pipeline), gen};
+                }
+                pipelineOptions = options.pipelineOptions;
+                pipelineOptions.coalescer = coalescer;
+            }
+
+            // The inferences share the sessions of the singer's models, so an extra pipeline
+            // mostly costs the per-request buffers
+            auto pipeline = std::make_unique<Pipeline>();
+            if (auto res = pipeline->open(singer, pipelineOptions); !res) {
+                return res.takeError();
+            }
+            std::lock_guard<std::mutex> lock(poolMutex);
+            busy.push_back(pipeline.get());
+            return Lease{singer, std::move(pipeline), gen};
+        }
+
+        void release(Lease &lease) {
+            std::unique_ptr<Pipeline> closed;
+            std::lock_guard<std::mutex> lock(poolMutex);
+            busy.erase(std::find(busy.begin(), busy.end(), lease.pipeline.get()));
+            if (lease.generation == generation) {
+                idle[lease.singer].push_back(std::move(lease.pipeline));
+            } else {
+                closed = std::move(lease.pipeline);
+            }
+        }
+
+        void stopAll() {
+            cancelled.store(true, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(poolMutex);
+            for (const auto pipeline : busy) {
+                pipeline->stop();
+            }
+        }
+
+        srt::Expected<void> validate(const std::vector<EnsembleTrack> &tracks) {
+            inferutil::ErrorCollector ec;
+            std::map<const srt::SingerSpec *, std::vector<size_t>> singerTracks;
+            for (size_t i = 0; i < tracks.size(); ++i) {
+                const auto &track = tracks[i];
+                if (!track.singer) {
+                    ec.collectError(
+                        stdc::formatN(R"(track "%1": singer is nullptr)", track.name));
+                } else if (!track.input) {
+                    ec.collectError(
+                        stdc::formatN(R"(track "%1": input is nullptr)", track.name));
+                } else if (!std::isfinite(track.offset)) {
+                    ec.collectError(
+                        stdc::formatN(R"(track "%1": invalid offset)", track.name));
+                } else {
+                    singerTracks[track.singer].push_back(i);
+                }
+            }
+
+            // Opens a pipeline of every singer, which is needed anyway
+            for (const auto &[singer, indices] : singerTracks) {
+                auto exp = acquire(singer);
+                if (!exp) {
+                    return exp.takeError();
+                }
+                auto lease = exp.take();
+                for (const auto i : indices) {
+                    if (auto res = lease.pipeline->validate(*tracks[i].input); !res) {
+                        ec.collectError(stdc::formatN(R"(track "%1": %2)", tracks[i].name,
+                                                      res.error().message()));
+                    }
+                }
+                release(lease);
+            }
+
+            if (ec.hasErrors()) {
+                return srt::Error(srt::Error::InvalidArgument,
+                                  ec.getErrorMessage("invalid ensemble"));
+            }
+            return srt::Expected<void>();
+        }
+    };
+
+    namespace {
+
+        // The state of a render shared by the workers and the mixing thread
+        struct EnsembleRender {
+            struct Voice {
+                bool done = false;
+                bool mixed = false;
+                std::vector<uint8_t> audioData;
+                int sampleRate = 0;
+                srt::Error error;
+            };
+
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::vector<Voice> voices;
+
+            // Tracks by offset, the next one to render
+            std::vector<size_t> order;
+            size_t next = 0;
+            size_t finished = 0;
+        };
+
+    }
+
+    EnsembleRenderer::EnsembleRenderer() : _impl(std::make_unique<Impl>()) {
+        setOptions({});
+    }
+
+    EnsembleRenderer::~EnsembleRenderer() = default;
+
+    void EnsembleRenderer::setOptions(const EnsembleOptions &options) {
+        __stdc_impl_t;
+        std::map<const srt::SingerSpec *, std::vector<std::unique_ptr<Pipeline>>> closed;
+        std::lock_guard<std::mutex> lock(impl.poolMutex);
+        impl.options = options;
+        impl.coalescer = options.pipelineOptions.coalescer
+                             ? options.pipelineOptions.coalescer
+                             : std::make_shared<RenderCoalescer>();
+        ++impl.generation;
+        closed.swap(impl.idle);
+    }
+
+    const EnsembleOptions &EnsembleRenderer::options() const {
+        __stdc_impl_t;
+        return impl.options;
+    }
+
+    srt::Expected<void> EnsembleRenderer::render(const std::vector<EnsembleTrack> &tracks,
+                                                 const Sink &sink,
+                                                 const std::atomic<bool> *cancelled) {
+        __stdc_impl_t;
+        impl.cancelled = false;
+        if (auto res = impl.validate(tracks); !res) {
+            return res;
+        }
+        if (tracks.empty()) {
+            return srt::Expected<void>();
+        }
+
+        EnsembleRender state;
+        state.voices.resize(tracks.size());
+        state.order.resize(tracks.size());
+        std::iota(state.order.begin(), state.order.end(), 0);
+        std::stable_sort(state.order.begin(), state.order.end(), [&](size_t a, size_t b) {
+            return tracks[a].offset < tracks[b].offset;
+        });
+
+        const auto work = [&]() {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            while (state.next < state.order.size() &&
+                   !impl.cancelled.load(std::memory_order_acquire)) {
+                const auto i = state.order[state.next++];
+                lock.unlock();
+
+                const auto &track = tracks[i];
+                std::vector<uint8_t> audioData;
+                int sampleRate = 0;
+                srt::Error error;
+                if (auto exp = impl.acquire(track.singer); !exp) {
+                    error = exp.takeError();
+                } else {
+                    auto lease = exp.take();
+                    auto res = lease.pipeline->render(track.input, &impl.cancelled);
+                    impl.release(lease);
+                    if (res) {
+                        auto result = res.take();
+                        audioData = std::move(result.audioData);
+                        sampleRate = result.sampleRate;
+                    } else {
+                        error = res.takeError();
+                    }
+                }
+
+                lock.lock();
+                auto &voice = state.voices[i];
+                voice.done = true;
+                voice.audioData = std::move(audioData);
+                voice.sampleRate = sampleRate;
+                voice.error = std::move(error);
+                ++state.finished;
+                state.cv.notify_all();
+            }
+        };
+
+        const auto concurrency =
+            impl.options.concurrency > 0
+                ? static_cast<size_t>(impl.options.concurrency)
+                : static_cast<size_t>((std::max) (1u, std::thread::hardware_concurrency()));
+        const auto workerCount = (std::min) (concurrency, tracks.size());
+        std::vector<std::thread> workers;
+        workers.reserve(workerCount);
+        for (size_t i = 0; i < workerCount; ++i) {
+            workers.emplace_back(work);
+        }
+
+        // Mix the voices as they complete and stream what no pending voice can change
+        static constexpr auto pollInterval = std::chrono::milliseconds(10);
+        const auto blockSize = (std::max) (impl.options.blockSize, size_t(1));
+        MixBuffer buffer;
+        int sampleRate = 0;
+        const auto frameAt = [&sampleRate](double seconds) {
+            return static_cast<int64_t>(std::llround(seconds * sampleRate));
+        };
+        srt::Error error;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        while (true) {
+            if (cancelled && cancelled->load(std::memory_order_acquire)) {
+                error = cancelledError();
+            }
+            if (impl.cancelled.load(std::memory_order_acquire) && error.ok()) {
+                error = cancelledError();
+            }
+
+            std::vector<size_t> ready;
+            for (size_t i = 0; i < state.voices.size(); ++i) {
+                auto &voice = state.voices[i];
+                if (voice.done && !voice.mixed) {
+                    voice.mixed = true;
+                    ready.push_back(i);
+                }
+            }
+            const bool allDone = state.finished == tracks.size();
+            if (!error.ok()) {
+                break;
+            }
+            if (ready.empty() && !allDone) {
+                state.cv.wait_for(lock, pollInterval);
+                continue;
+            }
+
+            // The voices are only touched by this thread once done
+            lock.unlock();
+            for (const auto i : ready) {
+                auto &voice = state.voices[i];
+                const auto &track = tracks[i];
+                if (!voice.error.ok()) {
+                    // A voice stopped along with the render only reports the cancellation
+                    error = impl.cancelled.load(std::memory_order_acquire)
+                                ? cancelledError()
+                                : srt::Error(voice.error.type(),
+                                             stdc::formatN(R"(failed to render track "%1": %2)",
+                                                           track.name, voice.error.message()));
+                    break;
+                }
+                if (sampleRate == 0) {
+                    sampleRate = voice.sampleRate;
+                } else if (voice.sampleRate != sampleRate) {
+                    error = srt::Error(
+                        srt::Error::InvalidArgument,
+                        stdc::formatN(R"(track "%1": sample rate %2 does not match %3)",
+                                      track.name, voice.sampleRate, sampleRate));
+                    break;
+                }
+                buffer.add(reinterpret_cast<const float *>(voice.audioData.data()),
+                           voice.audioData.size() / sizeof(float), frameAt(track.offset),
+                           inferutil::panGain(track.gain, track.pan));
+                voice.audioData = {};
+            }
+
+            // Everything before the earliest voice still rendering is final
+            std::vector<int64_t> pendingOffsets;
+            for (size_t i = 0; i < state.voices.size(); ++i) {
+                if (!state.voices[i].mixed) {
+                    pendingOffsets.push_back(frameAt(tracks[i].offset));
+                }
+            }
+            const int64_t until = finalFrame(buffer, pendingOffsets);
+            if (error.ok() && sampleRate > 0 &&
+                !buffer.flush(until, blockSize, sampleRate, sink)) {
+                error = cancelledError();
+            }
+            lock.lock();
+            if (!error.ok() || allDone) {
+                break;
+            }
+        }
+        if (lock.owns_lock()) {
+            lock.unlock();
+        }
+
+        if (!error.ok()) {
+            impl.stopAll();
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        if (!error.ok()) {
+            Log.srtDebug("Render - %1", error.message());
+            return error;
+        }
+        return srt::Expected<void>();
+    }
+
+    void EnsembleRenderer::stop() {
+        __stdc_impl_t;
+        impl.stopAll();
+    }
+
+    void EnsembleRenderer::clear() {
+        __stdc_impl_t;
+        std::map<const srt::SingerSpec *, std::vector<std::unique_ptr<Pipeline>>> closed;
+        std::lock_guard<std::mutex> lock(impl.poolMutex);
+        closed.swap(impl.idle);
+    }
+
+}
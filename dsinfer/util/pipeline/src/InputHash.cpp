@@ -0,0 +1,147 @@
+#include <pipeline/InputHash.h>
+
+#include <blake3.h>
+
+#include <stdcorelib/pimpl.h>
+
+#include <synthrt/Core/PackageRef.h>
+#include <synthrt/SVS/SingerContrib.h>
+
+#include <pipeline/Pipeline.h>
+
+namespace ds::pipeline {
+
+    namespace Co = Api::Common::L1;
+    namespace Ac = Api::Acoustic::L1;
+
+    std::string toHexString(const InputHash &hash) {
+        static constexpr char hexDigits[] = "0123456789abcdef";
+        std::string result(hash.size() * 2, '0');
+        for (size_t i = 0; i < hash.size(); ++i) {
+            result[2 * i] = hexDigits[hash[i] >> 4];
+            result[2 * i + 1] = hexDigits[hash[i] & 0x0f];
+        }
+        return result;
+    }
+
+    class InputHasher::Impl {
+    public:
+        blake3_hasher hasher;
+    };
+
+    InputHasher::InputHasher() : _impl(std::make_unique<Impl>()) {
+        __stdc_impl_t;
+        blake3_hasher_init(&impl.hasher);
+    }
+
+    InputHasher::~InputHasher() = default;
+
+    void InputHasher::update(const void *data, size_t size) {
+        __stdc_impl_t;
+        blake3_hasher_update(&impl.hasher, data, size);
+    }
+
+    void InputHasher::update(const Co::InputWordInfo &word) {
+        update(static_cast<int64_t>(word.phones.size()));
+        for (const auto &phone : word.phones) {
+            update(phone.token);
+            update(phone.language);
+            update(static_cast<int64_t>(phone.tone));
+            update(phone.start);
+            update(static_cast<int64_t>(phone.speakers.size()));
+            for (const auto &speaker : phone.speakers) {
+                update(speaker.name);
+                update(speaker.proportion);
+            }
+        }
+        update(static_cast<int64_t>(word.notes.size()));
+        for (const auto &note : word.notes) {
+            update(static_cast<int64_t>(note.key));
+            update(static_cast<int64_t>(note.cents));
+            update(note.duration);
+            update(static_cast<int64_t>(note.glide));
+            update(static_cast<int64_t>(note.is_rest));
+        }
+    }
+
+    void InputHasher::update(const Co::InputParameterInfo &param) {
+        update(param.tag.name());
+        update(param.interval);
+        update(static_cast<int64_t>(param.values.size()));
+        update(param.values.data(), param.values.size() * sizeof(double));
+        update(static_cast<int64_t>(param.retake.has_value()));
+        if (param.retake) {
+            update(param.retake->start);
+            update(param.retake->end);
+        }
+    }
+
+    void InputHasher::update(const Co::InputSpeakerInfo &speaker) {
+        update(speaker.name);
+        update(speaker.interval);
+        update(static_cast<int64_t>(speaker.proportions.size()));
+        update(speaker.proportions.data(), speaker.proportions.size() * sizeof(double));
+    }
+
+    InputHash InputHasher::finalize() const {
+        __stdc_impl_t;
+        InputHash result;
+        blake3_hasher_finalize(&impl.hasher, result.data(), result.size());
+        return result;
+    }
+
+    void InputHasher::update(const Ac::AcousticStartInput &input) {
+        update(input.duration);
+        update(static_cast<int64_t>(input.words.size()));
+        for (const auto &word : input.words) {
+            update(word);
+        }
+        update(static_cast<int64_t>(input.parameters.size()));
+        for (const auto &param : input.parameters) {
+            update(param);
+        }
+        update(static_cast<int64_t>(input.speakers.size()));
+        for (const auto &speaker : input.speakers) {
+            update(speaker);
+        }
+        update(static_cast<double>(input.depth));
+        update(input.steps);
+    }
+
+    void InputHasher::update(const srt::SingerSpec &singer) {
+        const auto package = singer.parent();
+        update(singer.id());
+        update(package.id());
+        update(package.version().toString());
+    }
+
+    InputHash hashAcousticInput(const Ac::AcousticStartInput &input, std::string_view salt) {
+        InputHasher hasher;
+        hasher.update(salt);
+        hasher.update(input);
+        return hasher.finalize();
+    }
+
+    InputHash hashRenderRequest(const Ac::AcousticStartInput &input, const srt::SingerSpec &singer,
+                                const PipelineOptions &options) {
+        InputHasher hasher;
+        hasher.update(std::string_view("render"));
+        hasher.update(singer);
+        hasher.update(options.driver);
+        const auto &acousticOptions = options.acousticOptions;
+        hasher.update(static_cast<int64_t>(bool(acousticOptions)));
+        if (acousticOptions) {
+            // The chunk concurrency does not change the result
+            hasher.update(acousticOptions->chunkFrames);
+            hasher.update(acousticOptions->chunkLeftContext);
+            hasher.update(acousticOptions->chunkRightContext);
+        }
+        hasher.update(static_cast<int64_t>(options.peakBinSizes.size()));
+        for (const auto &binSize : options.peakBinSizes) {
+            hasher.update(static_cast<int64_t>(binSize));
+        }
+        hasher.update(input);
+        return hasher.finalize();
+    }
+
+}
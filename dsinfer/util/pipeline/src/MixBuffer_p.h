@@ -0,0 +1,81 @@
+#ifndef DSINFER_PIPELINE_MIXBUFFER_P_H
+#define DSINFER_PIPELINE_MIXBUFFER_P_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <inferutil/Mixer.h>
+
+#include <pipeline/Ensemble.h>
+
+namespace ds::pipeline {
+
+    // Interleaved stereo frames not streamed yet, starting at a frame of the mix
+    class MixBuffer {
+    public:
+        int64_t start() const {
+            return _start;
+        }
+
+        int64_t end() const {
+            return _start + static_cast<int64_t>(_samples.size() / 2);
+        }
+
+        void add(const float *samples, size_t count, int64_t position,
+                 inferutil::StereoGain gain) {
+            // Samples before the streamed part, e.g. at a negative offset, are dropped
+            if (position < _start) {
+                const auto skip = static_cast<size_t>(
+                    (std::min) (_start - position, static_cast<int64_t>(count)));
+                samples += skip;
+                count -= skip;
+                position = _start;
+            }
+            reserveUntil(position + static_cast<int64_t>(count));
+            inferutil::mixMonoToStereo(samples, count, gain,
+                                       _samples.data() + 2 * (position - _start));
+        }
+
+        // Streams the frames before \a until in blocks of \a blockSize, padded with silence
+        bool flush(int64_t until, size_t blockSize, int sampleRate,
+                   const EnsembleRenderer::Sink &sink) {
+            if (until <= _start) {
+                return true;
+            }
+            reserveUntil(until);
+            const auto frames = static_cast<size_t>(until - _start);
+            for (size_t pos = 0; pos < frames; pos += blockSize) {
+                const auto n = (std::min) (blockSize, frames - pos);
+                if (sink && !sink(_samples.data() + 2 * pos, n, sampleRate)) {
+                    return false;
+                }
+            }
+            _samples.erase(_samples.begin(), _samples.begin() + 2 * frames);
+            _start = until;
+            return true;
+        }
+
+    protected:
+        void reserveUntil(int64_t frame) {
+            if (frame > end()) {
+                _samples.resize(2 * static_cast<size_t>(frame - _start), 0.0f);
+            }
+        }
+
+        int64_t _start = 0;
+        std::vector<float> _samples;
+    };
+
+    // Returns the frame before which the mix is final: the earliest offset of the voices not
+    // mixed yet, or the end of the buffer once all of them are
+    inline int64_t finalFrame(const MixBuffer &buffer, const std::vector<int64_t> &pendingOffsets) {
+        if (pendingOffsets.empty()) {
+            return buffer.end();
+        }
+        return *std::min_element(pendingOffsets.begin(), pendingOffsets.end());
+    }
+
+}
+
+#endif // DSINFER_PIPELINE_MIXBUFFER_P_H
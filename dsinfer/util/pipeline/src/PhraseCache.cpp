@@ -0,0 +1,77 @@
+#include <pipeline/PhraseCache.h>
+
+namespace ds::pipeline {
+
+    PhraseCache::PhraseCache(size_t capacity) : _capacity(capacity) {
+    }
+
+    PhraseCache::~PhraseCache() = default;
+
+    PhraseCache::Value PhraseCache::find(const InputHash &key) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _index.find(key);
+        if (it == _index.end()) {
+            return nullptr;
+        }
+        _list.splice(_list.begin(), _list, it->second);
+        return it->second->second;
+    }
+
+    bool PhraseCache::contains(const InputHash &key) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _index.count(key) != 0;
+    }
+
+    void PhraseCache::insert(const InputHash &key, Value value) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (auto it = _index.find(key); it != _index.end()) {
+            it->second->second = std::move(value);
+            _list.splice(_list.begin(), _list, it->second);
+            return;
+        }
+        _list.emplace_front(key, std::move(value));
+        _index.emplace(key, _list.begin());
+        shrink();
+    }
+
+    bool PhraseCache::remove(const InputHash &key) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _index.find(key);
+        if (it == _index.end()) {
+            return false;
+        }
+        _list.erase(it->second);
+        _index.erase(it);
+        return true;
+    }
+
+    void PhraseCache::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _index.clear();
+        _list.clear();
+    }
+
+    size_t PhraseCache::size() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _list.size();
+    }
+
+    size_t PhraseCache::capacity() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _capacity;
+    }
+
+    void PhraseCache::setCapacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _capacity = capacity;
+        shrink();
+    }
+
+    void PhraseCache::shrink() {
+        while (_list.size() > _capacity) {
+            _index.erase(_list.back().first);
+            _list.pop_back();
+        }
+    }
+
+}
@@ -0,0 +1,966 @@
+#include <pipeline/Pipeline.h>
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <optional>
+
+#include <stdcorelib/pimpl.h>
+#include <stdcorelib/str.h>
+
+#include <synthrt/SVS/InferenceContrib.h>
+#include <synthrt/SVS/Inference.h>
+#include <synthrt/Support/Logging.h>
+
+#include <dsinfer/Api/Inferences/Common/1/CommonApiL1.h>
+#include <dsinfer/Api/Inferences/Duration/1/DurationApiL1.h>
+#include <dsinfer/Api/Inferences/Pitch/1/PitchApiL1.h>
+#include <dsinfer/Api/Inferences/Variance/1/VarianceApiL1.h>
+#include <dsinfer/Api/Inferences/Vocoder/1/VocoderApiL1.h>
+
+#include <inferutil/Algorithm.h>
+#include <inferutil/InputWord.h>
+#include <inferutil/PeakPyramid.h>
+
+#include <pipeline/InputHash.h>
+#include <pipeline/SingleFlight.h>
+#include <pipeline/StageClient.h>
+
+namespace ds::pipeline {
+
+    namespace Co = Api::Common::L1;
+    namespace Ac = Api::Acoustic::L1;
+    namespace Dur = Api::Duration::L1;
+    namespace Pit = Api::Pitch::L1;
+    namespace Var = Api::Variance::L1;
+    namespace Vo = Api::Vocoder::L1;
+
+    using srt::NO;
+
+    static srt::LogCategory Log("pipeline");
+
+    const char *stageName(Stage stage) {
+        switch (stage) {
+            case Stage::Duration:
+                return Dur::API_NAME;
+            case Stage::Pitch:
+                return Pit::API_NAME;
+            case Stage::Variance:
+                return Var::API_NAME;
+            case Stage::Acoustic:
+                return Ac::API_NAME;
+            case Stage::Vocoder:
+                return Vo::API_NAME;
+        }
+        return "unknown";
+    }
+
+    const char *stageClassName(Stage stage) {
+        switch (stage) {
+            case Stage::Duration:
+                return Dur::API_CLASS;
+            case Stage::Pitch:
+                return Pit::API_CLASS;
+            case Stage::Variance:
+                return Var::API_CLASS;
+            case Stage::Acoustic:
+                return Ac::API_CLASS;
+            case Stage::Vocoder:
+                return Vo::API_CLASS;
+        }
+        return "unknown";
+    }
+
+    std::optional<Stage> stageFromName(std::string_view name) {
+        for (int i = 0; i < StageCount; ++i) {
+            const auto stage = static_cast<Stage>(i);
+            if (name == stageName(stage)) {
+                return stage;
+            }
+        }
+        return std::nullopt;
+    }
+
+    static srt::Error stageError(const srt::SingerSpec *singer, Stage stage, const char *action,
+                                 const std::string &message) {
+        return srt::Error(srt::Error::SessionError,
+                          stdc::formatN(R"(failed to %1 %2 inference for singer "%3": %4)",
+                                        action, stageName(stage), singer->id(), message));
+    }
+
+    static const srt::SingerImport *findImport(const srt::SingerSpec *singer, Stage stage) {
+        const std::string_view className = stageClassName(stage);
+        for (const auto &imp : singer->imports()) {
+            if (imp.inference()->className() == className) {
+                return &imp;
+            }
+        }
+        return nullptr;
+    }
+
+    template <class InitArgs, class RuntimeOptions>
+    static srt::Expected<NO<srt::Inference>>
+        createInference(const srt::SingerSpec *singer, Stage stage, const srt::SingerImport &imp,
+                        const std::string &driver, NO<RuntimeOptions> runtimeOptions) {
+        if (!runtimeOptions) {
+            runtimeOptions = NO<RuntimeOptions>::create();
+        }
+        NO<srt::Inference> inference;
+        if (auto exp = imp.inference()->createInference(imp.options(), runtimeOptions); !exp) {
+            return stageError(singer, stage, "create", exp.error().message());
+        } else {
+            inference = exp.take();
+        }
+        auto initArgs = NO<InitArgs>::create();
+        initArgs->driver = driver;
+        if (auto exp = inference->initialize(initArgs); !exp) {
+            return stageError(singer, stage, "initialize", exp.error().message());
+        }
+        return inference;
+    }
+
+    srt::Expected<NO<srt::Inference>> createStageInference(const srt::SingerSpec *singer,
+                                                           Stage stage,
+                                                           const PipelineOptions &options) {
+        if (!singer) {
+            return srt::Error(srt::Error::InvalidArgument, "singer is nullptr");
+        }
+        const auto imp = findImport(singer, stage);
+        if (!imp) {
+            return srt::Error(srt::Error::InvalidArgument,
+                              stdc::formatN(R"(%1 inference not found for singer "%2")",
+                                            stageName(stage), singer->id()));
+        }
+        switch (stage) {
+            case Stage::Duration:
+                return createInference<Dur::DurationInitArgs, Dur::DurationRuntimeOptions>(
+                    singer, stage, *imp, options.driver, {});
+            case Stage::Pitch:
+                return createInference<Pit::PitchInitArgs, Pit::PitchRuntimeOptions>(
+                    singer, stage, *imp, options.driver, {});
+            case Stage::Variance:
+                return createInference<Var::VarianceInitArgs, Var::VarianceRuntimeOptions>(
+                    singer, stage, *imp, options.driver, {});
+            case Stage::Acoustic:
+                return createInference<Ac::AcousticInitArgs, Ac::AcousticRuntimeOptions>(
+                    singer, stage, *imp, options.driver, options.acousticOptions);
+            case Stage::Vocoder:
+                return createInference<Vo::VocoderInitArgs, Vo::VocoderRuntimeOptions>(
+                    singer, stage, *imp, options.driver, {});
+        }
+        return srt::Error(srt::Error::InvalidArgument, "unknown stage");
+    }
+
+    static inline bool isCancelled(const std::atomic<bool> *cancelled) {
+        return cancelled && cancelled->load(std::memory_order_acquire);
+    }
+
+    static inline srt::Error cancelledError() {
+        return srt::Error(srt::Error::SessionError, "render cancelled");
+    }
+
+    class Pipeline::Impl {
+    public:
+        const srt::SingerSpec *singer = nullptr;
+        PipelineOptions options;
+
+        std::array<NO<srt::Inference>, StageCount> inferences;
+        NO<Var::VarianceSchema> varianceSchema;
+        PreflightSpec preflightSpec;
+        int sampleRate = 0;
+        int hopSize = 0;
+
+        std::mutex renderMutex;
+
+        // Guards the fields read before a render takes renderMutex: singer, options,
+        // preflightSpec and generation. Written with both mutexes held.
+        mutable std::mutex stateMutex;
+
+        // Incremented by open() and close(), so that a render started against a previous state
+        // does not run on the new one
+        uint64_t generation = 0;
+
+        struct State {
+            const srt::SingerSpec *singer;
+            PipelineOptions options;
+            PreflightSpec preflightSpec;
+            uint64_t generation;
+        };
+
+        State state() const {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            return {singer, options, preflightSpec, generation};
+        }
+
+        // Index of the stage being run, -1 if idle
+        std::atomic<int> currentStage = -1;
+
+        // Set by stop() to cancel the call to a stage server in progress
+        std::atomic<bool> remoteStopped = false;
+
+        srt::Error stageError(Stage stage, const char *action, const std::string &message) const {
+            return pipeline::stageError(singer, stage, action, message);
+        }
+
+        srt::Expected<NO<srt::TaskResult>> runStage(Stage stage,
+                                                    const NO<srt::TaskStartInput> &input) {
+            if (const auto &client = options.remoteStages[static_cast<int>(stage)]) {
+                remoteStopped = false;
+                currentStage = static_cast<int>(stage);
+                auto exp = client->run(*input, &remoteStopped);
+                currentStage = -1;
+
+                if (!exp) {
+                    return stageError(stage, "start", exp.error().message());
+                }
+                auto result = exp.take();
+                if (!result->error.ok()) {
+                    return stageError(stage, "run", result->error.message());
+                }
+                return result;
+            }
+
+            const auto &inference = inferences[static_cast<int>(stage)];
+
+            currentStage = static_cast<int>(stage);
+            auto exp = inference->start(input);
+            currentStage = -1;
+
+            if (!exp) {
+                return stageError(stage, "start", exp.error().message());
+            }
+            auto result = exp.take();
+            if (inference->state() == srt::ITask::Failed) {
+                return stageError(stage, "run", result->error.message());
+            }
+            return result;
+        }
+
+        srt::Expected<void> runDuration(Ac::AcousticStartInput &work) {
+            auto durationInput = NO<Dur::DurationStartInput>::create();
+            durationInput->duration = work.duration;
+            durationInput->words = work.words;
+
+            auto exp = runStage(Stage::Duration, durationInput);
+            if (!exp) {
+                return exp.takeError();
+            }
+            const auto result = exp.take().as<Dur::DurationResult>();
+
+            // Update phoneme starts in-place with duration model outputs
+            const auto &phonemeDurations = result->durations;
+            size_t i = 0;
+            for (auto &word : work.words) {
+                double timeCursor = 0.0;
+                for (auto &phoneme : word.phones) {
+                    if (i >= phonemeDurations.size()) {
+                        return srt::Expected<void>();
+                    }
+                    phoneme.start = timeCursor;
+                    timeCursor += phonemeDurations[i];
+                    ++i;
+                }
+            }
+            return srt::Expected<void>();
+        }
+
+        // Hands a curve of the work input over to a stage input without copying the values, the
+        // interval travels with them so that the stage resamples at most once (or not at all if
+        // the curve is already on its frame grid). The values are given back by returnCurves().
+        static void lendCurve(Co::InputParameterInfo &param,
+                              std::vector<Co::InputParameterInfo> &stageParams,
+                              std::vector<Co::InputParameterInfo *> &lent) {
+            stageParams.push_back(
+                Co::InputParameterInfo{param.tag, std::move(param.values), param.interval,
+                                       param.retake});
+            lent.push_back(&param);
+        }
+
+        static void returnCurves(std::vector<Co::InputParameterInfo> &stageParams,
+                                 const std::vector<Co::InputParameterInfo *> &lent) {
+            for (size_t i = 0; i < lent.size(); ++i) {
+                lent[i]->values = std::move(stageParams[i].values);
+            }
+        }
+
+        srt::Expected<void> runPitch(Ac::AcousticStartInput &work) {
+            auto pitchInput = NO<Pit::PitchStartInput>::create();
+            pitchInput->duration = work.duration;
+            pitchInput->words = work.words;
+            std::vector<Co::InputParameterInfo *> lent;
+            for (auto &param : work.parameters) {
+                if (param.tag == Co::Tags::Pitch || param.tag == Co::Tags::Expr) {
+                    lendCurve(param, pitchInput->parameters, lent);
+                }
+            }
+            pitchInput->speakers = work.speakers;
+            pitchInput->steps = work.steps;
+
+            auto exp = runStage(Stage::Pitch, pitchInput);
+            returnCurves(pitchInput->parameters, lent);
+            if (!exp) {
+                return exp.takeError();
+            }
+            auto result = exp.take().as<Pit::PitchResult>();
+
+            // Update pitch in-place with pitch model outputs, the retake range is kept
+            for (auto &param : work.parameters) {
+                if (param.tag == Co::Tags::Pitch) {
+                    param.interval = result->interval;
+                    param.values = std::move(result->pitch);
+                    return srt::Expected<void>();
+                }
+            }
+            work.parameters.push_back(Co::InputParameterInfo{
+                Co::Tags::Pitch, std::move(result->pitch), result->interval, std::nullopt});
+            return srt::Expected<void>();
+        }
+
+        srt::Expected<void> runVariance(Ac::AcousticStartInput &work) {
+            const auto &predictions = varianceSchema->predictions;
+
+            auto varianceInput = NO<Var::VarianceStartInput>::create();
+            varianceInput->duration = work.duration;
+            varianceInput->words = work.words;
+            std::vector<Co::InputParameterInfo *> lent;
+            for (auto &param : work.parameters) {
+                if (param.tag == Co::Tags::Pitch ||
+                    std::find(predictions.begin(), predictions.end(), param.tag) !=
+                        predictions.end()) {
+                    lendCurve(param, varianceInput->parameters, lent);
+                }
+            }
+            varianceInput->speakers = work.speakers;
+            varianceInput->steps = work.steps;
+
+            auto exp = runStage(Stage::Variance, varianceInput);
+            returnCurves(varianceInput->parameters, lent);
+            if (!exp) {
+                return exp.takeError();
+            }
+            auto result = exp.take().as<Var::VarianceResult>();
+
+            // Update parameters in-place with variance model outputs
+            for (auto &predicted : result->predictions) {
+                bool found = false;
+                for (auto &param : work.parameters) {
+                    if (param.tag == predicted.tag) {
+                        param.interval = predicted.interval;
+                        param.values = std::move(predicted.values);
+                        param.retake = std::nullopt;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    work.parameters.push_back(std::move(predicted));
+                }
+            }
+            return srt::Expected<void>();
+        }
+
+        srt::Expected<void> runAcoustic(const NO<Ac::AcousticStartInput> &work,
+                                        RenderResult &out) {
+            auto exp = runStage(Stage::Acoustic, work);
+            if (!exp) {
+                return exp.takeError();
+            }
+            const auto result = exp.take().as<Ac::AcousticResult>();
+            out.mel = result->mel;
+            out.f0 = result->f0;
+            return srt::Expected<void>();
+        }
+
+        srt::Expected<void> runVocoder(RenderResult &out) {
+            auto vocoderInput = NO<Vo::VocoderStartInput>::create();
+            vocoderInput->mel = out.mel;
+            vocoderInput->f0 = out.f0;
+            vocoderInput->peakBinSizes = options.peakBinSizes;
+
+            auto exp = runStage(Stage::Vocoder, vocoderInput);
+            if (!exp) {
+                return exp.takeError();
+            }
+            auto result = exp.take().as<Vo::VocoderResult>();
+            out.audioData = std::move(result->audioData);
+            out.peaks = std::move(result->peaks);
+            out.sampleRate = sampleRate;
+            return srt::Expected<void>();
+        }
+
+        static double scoreEnd(const Ac::AcousticStartInput &input) {
+            double wordsEnd = 0;
+            for (const auto &word : input.words) {
+                wordsEnd += inferutil::getWordDuration(word);
+            }
+            return (std::max) (input.duration, wordsEnd);
+        }
+
+        static Co::InputParameterInfo *findParameter(Ac::AcousticStartInput &input,
+                                                     const ParamTag &tag) {
+            for (auto &param : input.parameters) {
+                if (param.tag == tag) {
+                    return &param;
+                }
+            }
+            return nullptr;
+        }
+
+        // Copies the phoneme starts of the matched words from the previous render
+        static bool reuseDurations(Ac::AcousticStartInput &work, const RenderResult &previous,
+                                   const ScoreDiff &diff) {
+            const auto &oldWords = previous.input->words;
+            for (size_t i = 0; i < work.words.size(); ++i) {
+                const auto oldIndex = diff.wordMapping[i];
+                if (oldIndex < 0 || oldIndex >= static_cast<int64_t>(oldWords.size()) ||
+                    oldWords[oldIndex].phones.size() != work.words[i].phones.size()) {
+                    return false;
+                }
+            }
+            for (size_t i = 0; i < work.words.size(); ++i) {
+                auto &phones = work.words[i].phones;
+                const auto &oldPhones = oldWords[diff.wordMapping[i]].phones;
+                for (size_t j = 0; j < phones.size(); ++j) {
+                    phones[j].start = oldPhones[j].start;
+                }
+            }
+            return true;
+        }
+
+        // Replaces a curve with the previous output moved to the new positions, and restricts
+        // the retake range to the dirty ranges of the stage
+        static bool reuseCurve(Ac::AcousticStartInput &work, const RenderResult &previous,
+                               const ParamTag &tag, const StageDiff &stageDiff, double end) {
+            const auto oldParam = findParameter(*previous.input, tag);
+            if (!oldParam || !(oldParam->interval > 0)) {
+                return false;
+            }
+            auto param = findParameter(work, tag);
+            if (param && param->retake) {
+                // A retake range given by the user is honored as is
+                return false;
+            }
+            const auto length = static_cast<size_t>(std::ceil(end / oldParam->interval)) + 1;
+            auto values = remapCurve(oldParam->values, oldParam->interval, stageDiff.reusable,
+                                     length);
+            if (values.empty()) {
+                return false;
+            }
+
+            std::optional<Co::InputParameterInfo::RetakeRange> retake;
+            if (!stageDiff.clean()) {
+                retake = Co::InputParameterInfo::RetakeRange{stageDiff.dirty.front().start,
+                                                             stageDiff.dirty.back().end};
+            }
+            if (param) {
+                param->interval = oldParam->interval;
+                param->values = std::move(values);
+                param->retake = retake;
+            } else {
+                work.parameters.push_back(
+                    Co::InputParameterInfo{oldParam->tag, std::move(values), oldParam->interval,
+                                           retake});
+            }
+            return true;
+        }
+
+        // Moves the frames of a previous output to the new positions. Fails if a frame is not
+        // covered by a reusable span or is shifted by a fraction of a frame.
+        static bool remapFrames(const std::byte *src, int64_t srcFrames, std::byte *dst,
+                                int64_t dstFrames, size_t frameBytes,
+                                const std::vector<ShiftedSpan> &spans, double origin,
+                                double frameWidth) {
+            if (spans.empty()) {
+                return false;
+            }
+            size_t spanIndex = 0;
+            for (int64_t k = 0; k < dstFrames; ++k) {
+                const double t = std::clamp(origin + (k + 0.5) * frameWidth, spans.front().start,
+                                            std::nextafter(spans.back().end, spans.front().start));
+                while (spanIndex < spans.size() && spans[spanIndex].end <= t) {
+                    ++spanIndex;
+                }
+                if (spanIndex == spans.size() || spans[spanIndex].start > t) {
+                    return false;
+                }
+                const double shiftFrames = spans[spanIndex].shift / frameWidth;
+                const auto rounded = std::llround(shiftFrames);
+                if (std::abs(shiftFrames - static_cast<double>(rounded)) > 1e-6) {
+                    return false;
+                }
+                const int64_t srcIndex = k - rounded;
+                if (srcIndex < 0 || srcIndex >= srcFrames) {
+                    return false;
+                }
+                std::memcpy(dst + k * frameBytes, src + srcIndex * frameBytes, frameBytes);
+            }
+            return true;
+        }
+
+        static NO<ITensor> remapTensorFrames(const NO<ITensor> &tensor, int64_t dstFrames,
+                                             const std::vector<ShiftedSpan> &spans,
+                                             double origin, double frameWidth) {
+            if (!tensor) {
+                return nullptr;
+            }
+            auto shape = tensor->shape();
+            if (shape.size() < 2 || shape[0] != 1) {
+                return nullptr;
+            }
+            const int64_t srcFrames = shape[1];
+            size_t frameBytes = tensor->elementSize();
+            for (size_t i = 2; i < shape.size(); ++i) {
+                frameBytes *= shape[i];
+            }
+            shape[1] = dstFrames;
+            auto exp = Tensor::create(tensor->dataType(), shape);
+            if (!exp) {
+                return nullptr;
+            }
+            auto result = exp.take();
+            if (!remapFrames(tensor->rawData(), srcFrames, result->mutableRawData(), dstFrames,
+                             frameBytes, spans, origin, frameWidth)) {
+                return nullptr;
+            }
+            return result;
+        }
+
+        // Reuses the mel and f0 of the previous render, then the audio if possible
+        bool reuseAcoustic(const Ac::AcousticStartInput &work, const RenderResult &previous,
+                           const ScoreDiff &diff, RenderResult &out) const {
+            const double frameWidth = 1.0 * hopSize / sampleRate;
+            const auto &oldWords = previous.input->words;
+            if (work.words.empty() || work.words[0].phones.empty() || oldWords.empty() ||
+                oldWords[0].phones.empty() ||
+                work.words[0].phones[0].start != oldWords[0].phones[0].start) {
+                return false;
+            }
+            int64_t frameCount = 0;
+            if (!inferutil::preprocessPhonemeDurations(work.words, frameWidth, &frameCount)) {
+                return false;
+            }
+            const double origin = work.words[0].phones[0].start;
+
+            const auto &spans = diff.stage(Stage::Acoustic).reusable;
+            auto mel = remapTensorFrames(previous.mel, frameCount, spans, origin, frameWidth);
+            auto f0 = remapTensorFrames(previous.f0, frameCount, spans, origin, frameWidth);
+            if (!mel || !f0) {
+                return false;
+            }
+            out.mel = std::move(mel);
+            out.f0 = std::move(f0);
+
+            // The vocoder outputs exactly one hop of samples per frame
+            const size_t frameBytes = hopSize * sizeof(float);
+            const auto &oldAudio = previous.audioData;
+            if (!diff.stage(Stage::Vocoder).clean() || oldAudio.size() % frameBytes != 0) {
+                return true;
+            }
+            std::vector<uint8_t> audio(frameCount * frameBytes);
+            if (remapFrames(reinterpret_cast<const std::byte *>(oldAudio.data()),
+                            static_cast<int64_t>(oldAudio.size() / frameBytes),
+                            reinterpret_cast<std::byte *>(audio.data()), frameCount, frameBytes,
+                            diff.stage(Stage::Vocoder).reusable, origin, frameWidth)) {
+                out.audioData = std::move(audio);
+                out.sampleRate = sampleRate;
+                if (!options.peakBinSizes.empty()) {
+                    out.peaks = inferutil::computePeakPyramid(
+                        reinterpret_cast<const float *>(out.audioData.data()),
+                        out.audioData.size() / sizeof(float), options.peakBinSizes);
+                }
+            }
+            return true;
+        }
+
+        // Runs the duration, pitch and variance stages of a phrase rendered from scratch, or
+        // joins the same run in progress on another pipeline
+        srt::Expected<void> predictCoalesced(Ac::AcousticStartInput &work,
+                                             const std::atomic<bool> *cancelled) {
+            InputHasher hasher;
+            hasher.update(std::string_view("predict"));
+            hasher.update(*singer);
+            hasher.update(options.driver);
+            hasher.update(work);
+
+            bool shared = false;
+            auto exp = options.coalescer->predictions.run(
+                hasher.finalize(),
+                [&]() -> srt::Expected<NO<Ac::AcousticStartInput>> {
+                    if (auto res = runDuration(work); !res) {
+                        return res.takeError();
+                    }
+                    if (isCancelled(cancelled)) {
+                        return cancelledError();
+                    }
+                    if (auto res = runPitch(work); !res) {
+                        return res.takeError();
+                    }
+                    if (isCancelled(cancelled)) {
+                        return cancelledError();
+                    }
+                    if (auto res = runVariance(work); !res) {
+                        return res.takeError();
+                    }
+                    return copyInput(work);
+                },
+                cancelled, &shared);
+            if (!exp) {
+                return exp.takeError();
+            }
+            if (!shared) {
+                return srt::Expected<void>();
+            }
+
+            // Only the words and the parameters are completed by these stages
+            const auto &predicted = *exp.value();
+            work.words = predicted.words;
+            work.parameters.clear();
+            work.parameters.reserve(predicted.parameters.size());
+            for (const auto &param : predicted.parameters) {
+                work.parameters.push_back(param);
+            }
+            Log.srtDebug("Render - joined %1, %2 and %3 in progress", stageName(Stage::Duration),
+                         stageName(Stage::Pitch), stageName(Stage::Variance));
+            return srt::Expected<void>();
+        }
+
+        srt::Expected<RenderResult> render(const NO<Ac::AcousticStartInput> &input,
+                                           const RenderResult *previous,
+                                           const std::atomic<bool> *cancelled,
+                                           uint64_t expectedGeneration) {
+            if (!input) {
+                return srt::Error(srt::Error::InvalidArgument, "pipeline input is nullptr");
+            }
+
+            std::lock_guard<std::mutex> lock(renderMutex);
+            if (!singer) {
+                return srt::Error(srt::Error::SessionError, "pipeline is not open");
+            }
+            if (generation != expectedGeneration) {
+                return srt::Error(srt::Error::SessionError,
+                                  "pipeline was reopened during the render");
+            }
+
+            RenderResult out;
+            out.source = copyInput(*input);
+            out.input = copyInput(*input);
+            auto &work = *out.input;
+
+            std::optional<ScoreDiff> diff;
+            if (previous && previous->source && previous->input) {
+                diff = diffScores(*previous->source, work, options.diffOptions);
+            }
+            const auto isClean = [&diff](Stage stage) {
+                return diff && diff->stage(stage).clean();
+            };
+            const double end = scoreEnd(work);
+
+            // Duration, pitch and variance
+            if (!diff && options.coalescer) {
+                if (auto res = predictCoalesced(work, cancelled); !res) {
+                    return res.takeError();
+                }
+            } else {
+                // Duration
+                if (isClean(Stage::Duration) && reuseDurations(work, *previous, *diff)) {
+                    Log.srtDebug("Render - reused %1 outputs", stageName(Stage::Duration));
+                } else if (auto res = runDuration(work); !res) {
+                    return res.takeError();
+                }
+                if (isCancelled(cancelled)) {
+                    return cancelledError();
+                }
+
+                // Pitch
+                if (diff && reuseCurve(work, *previous, Co::Tags::Pitch, diff->stage(Stage::Pitch),
+                                       end) &&
+                    isClean(Stage::Pitch)) {
+                    Log.srtDebug("Render - reused %1 outputs", stageName(Stage::Pitch));
+                } else if (auto res = runPitch(work); !res) {
+                    return res.takeError();
+                }
+                if (isCancelled(cancelled)) {
+                    return cancelledError();
+                }
+
+                // Variance
+                bool varianceReused = diff.has_value();
+                if (diff) {
+                    for (const auto &tag : varianceSchema->predictions) {
+                        varianceReused &=
+                            reuseCurve(work, *previous, tag, diff->stage(Stage::Variance), end);
+                    }
+                }
+                if (varianceReused && isClean(Stage::Variance)) {
+                    Log.srtDebug("Render - reused %1 outputs", stageName(Stage::Variance));
+                } else if (auto res = runVariance(work); !res) {
+                    return res.takeError();
+                }
+                if (isCancelled(cancelled)) {
+                    return cancelledError();
+                }
+            }
+
+            // Acoustic
+            if (isClean(Stage::Acoustic) && reuseAcoustic(work, *previous, *diff, out)) {
+                Log.srtDebug("Render - reused %1 outputs", stageName(Stage::Acoustic));
+            } else if (auto res = runAcoustic(out.input, out); !res) {
+                return res.takeError();
+            }
+            if (isCancelled(cancelled)) {
+                return cancelledError();
+            }
+
+            // Vocoder, unless reused along with the acoustic outputs
+            if (!out.audioData.empty()) {
+                Log.srtDebug("Render - reused %1 outputs", stageName(Stage::Vocoder));
+            } else if (auto res = runVocoder(out); !res) {
+                return res.takeError();
+            }
+            return out;
+        }
+    };
+
+    Pipeline::Pipeline() : _impl(std::make_unique<Impl>()) {
+    }
+
+    Pipeline::~Pipeline() = default;
+
+    srt::Expected<void> Pipeline::open(const srt::SingerSpec *singer,
+                                       const PipelineOptions &options) {
+        __stdc_impl_t;
+        if (!singer) {
+            return srt::Error(srt::Error::InvalidArgument, "singer is nullptr");
+        }
+        if (isOpen()) {
+            close();
+        }
+
+        // Find imports, the configurations of the remote stages are read from them as well
+        std::array<const srt::SingerImport *, StageCount> imports;
+        for (int i = 0; i < StageCount; ++i) {
+            imports[i] = findImport(singer, static_cast<Stage>(i));
+            if (!imports[i]) {
+                return srt::Error(srt::Error::InvalidArgument,
+                                  stdc::formatN(R"(%1 inference not found for singer "%2")",
+                                                stageName(static_cast<Stage>(i)), singer->id()));
+            }
+        }
+        const auto configuration = [&imports](Stage stage) {
+            return imports[static_cast<int>(stage)]->inference()->configuration();
+        };
+
+        // Check whether acoustic and vocoder config match
+        const auto acousticConfig = configuration(Stage::Acoustic).as<Ac::AcousticConfiguration>();
+        const auto vocoderConfig = configuration(Stage::Vocoder).as<Vo::VocoderConfiguration>();
+        std::vector<std::string> unmatchedFields;
+        if (acousticConfig->sampleRate != vocoderConfig->sampleRate) {
+            unmatchedFields.emplace_back("sampleRate");
+        }
+        if (acousticConfig->hopSize != vocoderConfig->hopSize) {
+            unmatchedFields.emplace_back("hopSize");
+        }
+        if (acousticConfig->winSize != vocoderConfig->winSize) {
+            unmatchedFields.emplace_back("winSize");
+        }
+        if (acousticConfig->fftSize != vocoderConfig->fftSize) {
+            unmatchedFields.emplace_back("fftSize");
+        }
+        if (acousticConfig->melChannels != vocoderConfig->melChannels) {
+            unmatchedFields.emplace_back("melChannels");
+        }
+        if (acousticConfig->melMinFreq != vocoderConfig->melMinFreq) {
+            unmatchedFields.emplace_back("melMinFreq");
+        }
+        if (acousticConfig->melMaxFreq != vocoderConfig->melMaxFreq) {
+            unmatchedFields.emplace_back("melMaxFreq");
+        }
+        if (acousticConfig->melBase != vocoderConfig->melBase) {
+            unmatchedFields.emplace_back("melBase");
+        }
+        if (acousticConfig->melScale != vocoderConfig->melScale) {
+            unmatchedFields.emplace_back("melScale");
+        }
+        if (!unmatchedFields.empty()) {
+            return srt::Error(srt::Error::InvalidArgument,
+                              stdc::formatN("acoustic and vocoder config mismatch: %1",
+                                            stdc::join(unmatchedFields, ", ")));
+        }
+
+        // Create and initialize inferences, the pipeline is only updated once all of them are
+        // ready
+        std::array<NO<srt::Inference>, StageCount> inferences;
+        for (int i = 0; i < StageCount; ++i) {
+            if (options.remoteStages[i]) {
+                continue;
+            }
+            auto exp = createStageInference(singer, static_cast<Stage>(i), options);
+            if (!exp) {
+                return exp.takeError();
+            }
+            inferences[i] = exp.take();
+        }
+
+        auto varianceSchema = imports[static_cast<int>(Stage::Variance)]->inference()->schema()
+                                  .as<Var::VarianceSchema>();
+        PreflightSpec preflightSpec{
+            configuration(Stage::Duration).as<Dur::DurationConfiguration>(),
+            configuration(Stage::Pitch).as<Pit::PitchConfiguration>(),
+            configuration(Stage::Variance).as<Var::VarianceConfiguration>(),
+            varianceSchema,
+            acousticConfig,
+            options.limits,
+        };
+
+        // Curves are handed between stages with their interval, and a stage copies them as they
+        // are when it runs on the same frame grid. Otherwise they are resampled once per stage.
+        const double pitchFrameWidth = preflightSpec.pitch->frameWidth;
+        const double varianceFrameWidth = preflightSpec.variance->frameWidth;
+        const double acousticFrameWidth = 1.0 * vocoderConfig->hopSize / vocoderConfig->sampleRate;
+        if (!inferutil::isSameFrameGrid(pitchFrameWidth, varianceFrameWidth) ||
+            !inferutil::isSameFrameGrid(varianceFrameWidth, acousticFrameWidth)) {
+            Log.srtDebug("Open - frame grids differ (pitch %1 s, variance %2 s, acoustic %3 s), "
+                         "curves are resampled between stages",
+                         pitchFrameWidth, varianceFrameWidth, acousticFrameWidth);
+        }
+
+        std::lock_guard<std::mutex> renderLock(impl.renderMutex);
+        std::lock_guard<std::mutex> stateLock(impl.stateMutex);
+        impl.singer = singer;
+        impl.options = options;
+        impl.inferences = std::move(inferences);
+        impl.varianceSchema = std::move(varianceSchema);
+        impl.preflightSpec = std::move(preflightSpec);
+        impl.sampleRate = vocoderConfig->sampleRate;
+        impl.hopSize = vocoderConfig->hopSize;
+        ++impl.generation;
+        return srt::Expected<void>();
+    }
+
+    void Pipeline::close() {
+        __stdc_impl_t;
+        std::lock_guard<std::mutex> renderLock(impl.renderMutex);
+        std::lock_guard<std::mutex> stateLock(impl.stateMutex);
+        for (auto &inference : impl.inferences) {
+            inference.reset();
+        }
+        impl.varianceSchema.reset();
+        impl.preflightSpec = {};
+        impl.singer = nullptr;
+        impl.sampleRate = 0;
+        impl.hopSize = 0;
+        ++impl.generation;
+    }
+
+    bool Pipeline::isOpen() const {
+        __stdc_impl_t;
+        std::lock_guard<std::mutex> lock(impl.stateMutex);
+        return impl.singer != nullptr;
+    }
+
+    const srt::SingerSpec *Pipeline::singer() const {
+        __stdc_impl_t;
+        std::lock_guard<std::mutex> lock(impl.stateMutex);
+        return impl.singer;
+    }
+
+    const PipelineOptions &Pipeline::options() const {
+        __stdc_impl_t;
+        return impl.options;
+    }
+
+    srt::Expected<void> Pipeline::validate(const Ac::AcousticStartInput &input) const {
+        __stdc_impl_t;
+        const auto state = impl.state();
+        if (!state.singer) {
+            return srt::Error(srt::Error::SessionError, "pipeline is not open");
+        }
+        return preflight(input, state.preflightSpec);
+    }
+
+    srt::Expected<RenderResult> Pipeline::render(const NO<Ac::AcousticStartInput> &input,
+                                                 const std::atomic<bool> *cancelled) {
+        __stdc_impl_t;
+        // Checked before waiting for the render in progress, if any, against a snapshot of the
+        // pipeline. The render fails if the pipeline is reopened in between.
+        const auto state = impl.state();
+        if (input && state.singer) {
+            if (auto res = preflight(*input, state.preflightSpec); !res) {
+                return res.takeError();
+            }
+        }
+        const auto &coalescer = state.options.coalescer;
+        if (!coalescer || !input || !state.singer) {
+            return impl.render(input, nullptr, cancelled, state.generation);
+        }
+
+        bool shared = false;
+        auto exp = coalescer->renders.run(
+            hashRenderRequest(*input, *state.singer, state.options),
+            [&]() -> srt::Expected<std::shared_ptr<const RenderResult>> {
+                auto exp = impl.render(input, nullptr, cancelled, state.generation);
+                if (!exp) {
+                    return exp.takeError();
+                }
+                return std::make_shared<const RenderResult>(exp.take());
+            },
+            cancelled, &shared);
+        if (!exp) {
+            return exp.takeError();
+        }
+        if (shared) {
+            Log.srtDebug("Render - joined a render in progress");
+        }
+
+        // The result is shared by all the callers, the inputs are copied so that each caller may
+        // edit its own
+        RenderResult result = *exp.value();
+        result.source = copyInput(*result.source);
+        result.input = copyInput(*result.input);
+        return result;
+    }
+
+    srt::Expected<RenderResult> Pipeline::renderIncremental(const NO<Ac::AcousticStartInput> &input,
+                                                            const RenderResult &previous,
+                                                            const std::atomic<bool> *cancelled) {
+        __stdc_impl_t;
+        const auto state = impl.state();
+        if (input && state.singer) {
+            if (auto res = preflight(*input, state.preflightSpec); !res) {
+                return res.takeError();
+            }
+        }
+        return impl.render(input, &previous, cancelled, state.generation);
+    }
+
+    bool Pipeline::stop() {
+        __stdc_impl_t;
+        const int stage = impl.currentStage;
+        if (stage < 0) {
+            return false;
+        }
+        if (impl.options.remoteStages[stage]) {
+            impl.remoteStopped = true;
+            return true;
+        }
+        const auto &inference = impl.inferences[stage];
+        return inference && inference->stop();
+    }
+
+    NO<Ac::AcousticStartInput> Pipeline::copyInput(const Ac::AcousticStartInput &input) {
+        auto result = NO<Ac::AcousticStartInput>::create();
+        result->duration = input.duration;
+        result->words = input.words;
+        // InputParameterInfo is not assignable, so copy-construct the elements one by one
+        result->parameters.reserve(input.parameters.size());
+        for (const auto &param : input.parameters) {
+            result->parameters.push_back(param);
+        }
+        result->speakers = input.speakers;
+        result->depth = input.depth;
+        result->steps = input.steps;
+        return result;
+    }
+
+}
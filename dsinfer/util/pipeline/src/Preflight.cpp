@@ -0,0 +1,220 @@
+#include <pipeline/Preflight.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <stdcorelib/str.h>
+
+#include <inferutil/ErrorCollector.h>
+#include <inferutil/InputWord.h>
+
+namespace ds::pipeline {
+
+    namespace Co = Api::Common::L1;
+    namespace Ac = Api::Acoustic::L1;
+
+    // The parameters the acoustic model fails without if it takes them, see the acoustic
+    // interpreter
+    static const ParamTag *const requiredAcousticParams[] = {
+        &Co::Tags::Energy,
+        &Co::Tags::Breathiness,
+        &Co::Tags::Voicing,
+        &Co::Tags::Tension,
+    };
+
+    // The linguistic inputs shared by the configurations of the duration, pitch, variance and
+    // acoustic stages
+    struct LinguisticConfig {
+        const char *stage;
+        const std::map<std::string, int> *phonemes;
+        const std::map<std::string, int> *languages;
+        const std::map<std::string, std::vector<float>> *speakers;
+        bool useLanguageId;
+        bool useSpeakerEmbedding;
+    };
+
+    template <class Config>
+    static LinguisticConfig linguisticConfig(const char *stage, const Config &config) {
+        return {
+            stage,
+            &config.phonemes,
+            &config.languages,
+            &config.speakers,
+            config.useLanguageId,
+            config.useSpeakerEmbedding,
+        };
+    }
+
+    static void checkLinguistic(const Ac::AcousticStartInput &input,
+                                const LinguisticConfig &config, bool phoneSpeakers,
+                                inferutil::ErrorCollector &ec) {
+        // Report each unresolved name once per stage
+        std::set<std::string> unknownTokens;
+        std::set<std::string> unknownLanguages;
+        size_t phonesWithoutSpeakers = 0;
+        for (const auto &word : input.words) {
+            for (const auto &phone : word.phones) {
+                if (!inferutil::findPhonemeToken(phone, *config.phonemes)) {
+                    unknownTokens.insert(phone.language.empty()
+                                             ? phone.token
+                                             : phone.language + '/' + phone.token);
+                }
+                if (config.useLanguageId && config.languages->count(phone.language) == 0) {
+                    unknownLanguages.insert(phone.language);
+                }
+                if (phoneSpeakers && config.useSpeakerEmbedding && phone.speakers.empty()) {
+                    ++phonesWithoutSpeakers;
+                }
+            }
+        }
+        for (const auto &token : unknownTokens) {
+            ec.collectError(stdc::formatN(R"(%1: unknown token "%2")", config.stage, token));
+        }
+        for (const auto &language : unknownLanguages) {
+            ec.collectError(stdc::formatN(R"(%1: unknown language "%2")", config.stage, language));
+        }
+        if (phonesWithoutSpeakers > 0) {
+            ec.collectError(stdc::formatN("%1: %2 phonemes missing speakers", config.stage,
+                                          phonesWithoutSpeakers));
+        }
+
+        // The duration stage mixes the speakers of the phonemes, the others those of the input
+        if (phoneSpeakers || !config.useSpeakerEmbedding) {
+            return;
+        }
+        if (input.speakers.empty()) {
+            ec.collectError(stdc::formatN("%1: no speakers found in input", config.stage));
+        }
+        for (const auto &speaker : input.speakers) {
+            if (config.speakers->count(speaker.name) == 0) {
+                ec.collectError(
+                    stdc::formatN(R"(%1: unknown speaker "%2")", config.stage, speaker.name));
+            }
+        }
+    }
+
+    static void checkTiming(const Ac::AcousticStartInput &input, const PreflightLimits &limits,
+                            inferutil::ErrorCollector &ec) {
+        const auto isTime = [](double t) { return std::isfinite(t) && t >= 0; };
+
+        if (!isTime(input.duration)) {
+            ec.collectError("invalid duration");
+        }
+
+        size_t phoneCount = 0;
+        double wordsEnd = 0;
+        for (size_t i = 0; i < input.words.size(); ++i) {
+            const auto &word = input.words[i];
+            for (const auto &phone : word.phones) {
+                if (!std::isfinite(phone.start)) {
+                    ec.collectError(stdc::formatN("word %1: invalid phoneme start", i));
+                    break;
+                }
+            }
+            for (const auto &note : word.notes) {
+                if (!isTime(note.duration)) {
+                    ec.collectError(stdc::formatN("word %1: invalid note duration", i));
+                    break;
+                }
+            }
+            phoneCount += word.phones.size();
+            wordsEnd += inferutil::getWordDuration(word);
+        }
+
+        for (const auto &param : input.parameters) {
+            if (!param.values.empty() && !(std::isfinite(param.interval) && param.interval > 0)) {
+                ec.collectError(stdc::formatN("parameter %1: interval must be positive",
+                                              std::string(param.tag.name())));
+            }
+            if (param.retake && !(param.retake->start <= param.retake->end)) {
+                ec.collectError(stdc::formatN("parameter %1: invalid retake range",
+                                              std::string(param.tag.name())));
+            }
+        }
+        for (const auto &speaker : input.speakers) {
+            if (!speaker.proportions.empty() &&
+                !(std::isfinite(speaker.interval) && speaker.interval > 0)) {
+                ec.collectError(
+                    stdc::formatN(R"(speaker "%1": interval must be positive)", speaker.name));
+            }
+        }
+
+        if (limits.maxPhonemes > 0 && phoneCount > limits.maxPhonemes) {
+            ec.collectError(stdc::formatN("%1 phonemes exceed the limit of %2", phoneCount,
+                                          limits.maxPhonemes));
+        }
+        const double end = (std::max) (input.duration, wordsEnd);
+        if (limits.maxDuration > 0 && end > limits.maxDuration) {
+            ec.collectError(
+                stdc::formatN("%1 s exceeds the limit of %2 s", end, limits.maxDuration));
+        }
+    }
+
+    static void checkAcoustic(const Ac::AcousticStartInput &input, const PreflightSpec &spec,
+                              inferutil::ErrorCollector &ec) {
+        const auto &config = *spec.acoustic;
+
+        // Pitch comes from the pitch stage, the variance predictions from the variance stage
+        for (const auto tag : requiredAcousticParams) {
+            if (config.parameters.count(*tag) == 0) {
+                continue;
+            }
+            bool supplied = false;
+            if (spec.varianceSchema) {
+                for (const auto &prediction : spec.varianceSchema->predictions) {
+                    supplied |= prediction == *tag;
+                }
+            }
+            for (const auto &param : input.parameters) {
+                supplied |= param.tag == *tag;
+            }
+            if (!supplied) {
+                ec.collectError(stdc::formatN("%1: parameter %2 missing", Ac::API_NAME,
+                                              std::string(tag->name())));
+            }
+        }
+
+        if (!std::isfinite(input.depth) || input.depth < 0) {
+            ec.collectError(stdc::formatN("%1: invalid depth", Ac::API_NAME));
+        }
+        // Otherwise the steps are converted to a speedup, falling back to a default
+        if (config.useContinuousAcceleration && input.steps <= 0) {
+            ec.collectError(stdc::formatN("%1: steps must be positive", Ac::API_NAME));
+        }
+    }
+
+    srt::Expected<void> preflight(const Ac::AcousticStartInput &input,
+                                  const PreflightSpec &spec) {
+        inferutil::ErrorCollector ec;
+
+        checkTiming(input, spec.limits, ec);
+        if (spec.duration) {
+            checkLinguistic(input,
+                            linguisticConfig(Api::Duration::L1::API_NAME, *spec.duration), true,
+                            ec);
+        }
+        if (spec.pitch) {
+            checkLinguistic(input, linguisticConfig(Api::Pitch::L1::API_NAME, *spec.pitch),
+                            false, ec);
+        }
+        if (spec.variance) {
+            checkLinguistic(input,
+                            linguisticConfig(Api::Variance::L1::API_NAME, *spec.variance), false,
+                            ec);
+        }
+        if (spec.acoustic) {
+            checkLinguistic(input, linguisticConfig(Ac::API_NAME, *spec.acoustic), false, ec);
+            checkAcoustic(input, spec, ec);
+        }
+
+        if (ec.hasErrors()) {
+            return srt::Error(srt::Error::InvalidArgument, ec.getErrorMessage("invalid input"));
+        }
+        return srt::Expected<void>();
+    }
+
+}
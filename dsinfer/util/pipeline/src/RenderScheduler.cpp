@@ -0,0 +1,445 @@
+#include <pipeline/RenderScheduler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <stdcorelib/pimpl.h>
+
+#include <synthrt/Support/Logging.h>
+
+namespace ds::pipeline {
+
+    namespace Ac = Api::Acoustic::L1;
+
+    using srt::NO;
+
+    static srt::LogCategory Log("scheduler");
+
+    static inline srt::Error cancelledError() {
+        return srt::Error(srt::Error::SessionError, "render cancelled");
+    }
+
+    class RenderScheduler::Impl {
+    public:
+        struct Job {
+            std::string phraseId;
+            InputHash hash;
+            NO<Ac::AcousticStartInput> input;
+            RenderPriority priority;
+            std::vector<Callback> callbacks;
+
+            // Checked by the pipeline between stages
+            std::atomic<bool> cancelled = false;
+
+            // Set when a speculative job is interrupted by a foreground one; the job is requeued
+            bool preempted = false;
+
+            // Set when the job is superseded or invalidated; the job is dropped
+            bool invalidated = false;
+        };
+        using JobRef = std::shared_ptr<Job>;
+
+        struct Lane {
+            // Null when the phrases are rendered by RenderSchedulerOptions::renderer
+            std::unique_ptr<Pipeline> pipeline;
+            std::thread thread;
+            JobRef running;
+
+            // Whether the lane only takes speculative jobs
+            bool speculative = false;
+        };
+
+        struct PendingCallback {
+            Callback callback;
+            srt::Error error;
+        };
+
+        const srt::SingerSpec *singer = nullptr;
+        RenderSchedulerOptions options;
+
+        mutable PhraseCache cache;
+
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        bool stopping = false;
+
+        std::deque<JobRef> foregroundQueue;
+        std::deque<JobRef> speculativeQueue;
+        std::vector<std::unique_ptr<Lane>> lanes;
+
+        // The latest result of each phrase, diffed against by the next render of the phrase
+        std::map<std::string, std::shared_ptr<const RenderResult>> lastResults;
+
+        InputHash hash(const Ac::AcousticStartInput &input) const {
+            InputHasher hasher;
+            if (singer) {
+                hasher.update(*singer);
+            }
+            hasher.update(input);
+            return hasher.finalize();
+        }
+
+        bool canTake(const Lane &lane) const {
+            if (lane.speculative) {
+                // Yield to foreground work
+                if (!foregroundQueue.empty()) {
+                    return false;
+                }
+                for (const auto &other : lanes) {
+                    if (other->running && other->running->priority == RenderPriority::Foreground) {
+                        return false;
+                    }
+                }
+                return !speculativeQueue.empty();
+            }
+            return !foregroundQueue.empty() || (lanes.size() == 1 && !speculativeQueue.empty());
+        }
+
+        JobRef take(const Lane &lane) {
+            auto &queue = (!lane.speculative && !foregroundQueue.empty()) ? foregroundQueue
+                                                                          : speculativeQueue;
+            auto job = queue.front();
+            queue.pop_front();
+            return job;
+        }
+
+        // Must be called with the mutex held
+        void cancelRunning(Lane &lane, bool invalidate) {
+            auto &job = lane.running;
+            if (invalidate) {
+                job->invalidated = true;
+            } else {
+                job->preempted = true;
+            }
+            job->cancelled.store(true, std::memory_order_release);
+            if (lane.pipeline) {
+                lane.pipeline->stop();
+            }
+        }
+
+        // Must be called with the mutex held
+        void dropQueued(const std::function<bool(const Job &)> &pred,
+                        std::vector<PendingCallback> &dropped) {
+            for (auto queue : {&foregroundQueue, &speculativeQueue}) {
+                for (auto it = queue->begin(); it != queue->end();) {
+                    if (!pred(**it)) {
+                        ++it;
+                        continue;
+                    }
+                    for (auto &callback : (*it)->callbacks) {
+                        dropped.push_back({std::move(callback), cancelledError()});
+                    }
+                    it = queue->erase(it);
+                }
+            }
+        }
+
+        static void invokeCallbacks(std::vector<PendingCallback> &callbacks) {
+            for (const auto &item : callbacks) {
+                if (item.callback) {
+                    item.callback(nullptr, item.error);
+                }
+            }
+        }
+
+        srt::Expected<RenderResult> render(Lane &lane, Job &job, const RenderResult *previous) {
+            if (options.renderer) {
+                return options.renderer(job.input, previous, &job.cancelled);
+            }
+            return previous
+                       ? lane.pipeline->renderIncremental(job.input, *previous, &job.cancelled)
+                       : lane.pipeline->render(job.input, &job.cancelled);
+        }
+
+        void work(Lane &lane) {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                cv.wait(lock, [&]() { return stopping || canTake(lane); });
+                if (stopping) {
+                    return;
+                }
+                auto job = take(lane);
+                lane.running = job;
+                std::shared_ptr<const RenderResult> previous;
+                if (auto it = lastResults.find(job->phraseId); it != lastResults.end()) {
+                    previous = it->second;
+                }
+                lock.unlock();
+
+                auto exp = render(lane, *job, previous.get());
+
+                std::shared_ptr<const RenderResult> result;
+                srt::Error error;
+                if (exp) {
+                    result = std::make_shared<const RenderResult>(exp.take());
+                    cache.insert(job->hash, result);
+                } else {
+                    error = exp.takeError();
+                }
+
+                lock.lock();
+                lane.running.reset();
+                if (result && !job->invalidated) {
+                    lastResults[job->phraseId] = result;
+                }
+                if (!result && job->preempted && !job->invalidated && !stopping) {
+                    // Restart the interrupted job, right away if it has been promoted meanwhile
+                    job->preempted = false;
+                    job->cancelled = false;
+                    (job->priority == RenderPriority::Foreground ? foregroundQueue
+                                                                 : speculativeQueue)
+                        .push_front(job);
+                    cv.notify_all();
+                    continue;
+                }
+                if (job->cancelled) {
+                    error = result ? srt::Error() : cancelledError();
+                } else if (!result) {
+                    Log.srtWarning(R"(failed to render phrase "%1": %2)", job->phraseId,
+                                   error.message());
+                }
+                auto callbacks = std::move(job->callbacks);
+                cv.notify_all();
+                lock.unlock();
+
+                for (const auto &callback : callbacks) {
+                    if (callback) {
+                        callback(result, error);
+                    }
+                }
+                lock.lock();
+            }
+        }
+    };
+
+    RenderScheduler::RenderScheduler() : _impl(std::make_unique<Impl>()) {
+    }
+
+    RenderScheduler::~RenderScheduler() {
+        close();
+    }
+
+    srt::Expected<void> RenderScheduler::open(const srt::SingerSpec *singer,
+                                              const RenderSchedulerOptions &options) {
+        __stdc_impl_t;
+        if (isOpen()) {
+            close();
+        }
+
+        const int laneCount = options.separateSpeculativePipeline ? 2 : 1;
+        std::vector<std::unique_ptr<Impl::Lane>> lanes;
+        for (int i = 0; i < laneCount; ++i) {
+            auto lane = std::make_unique<Impl::Lane>();
+            lane->speculative = i > 0;
+            if (!options.renderer) {
+                lane->pipeline = std::make_unique<Pipeline>();
+                if (auto exp = lane->pipeline->open(singer, options.pipelineOptions); !exp) {
+                    return exp.takeError();
+                }
+            }
+            lanes.push_back(std::move(lane));
+        }
+
+        impl.singer = singer;
+        impl.options = options;
+        impl.cache.setCapacity(options.cacheCapacity);
+        impl.stopping = false;
+        impl.lanes = std::move(lanes);
+        for (const auto &lane : impl.lanes) {
+            lane->thread = std::thread(&Impl::work, &impl, std::ref(*lane));
+        }
+        return srt::Expected<void>();
+    }
+
+    void RenderScheduler::close() {
+        __stdc_impl_t;
+        std::vector<Impl::PendingCallback> dropped;
+        {
+            std::lock_guard<std::mutex> lock(impl.mutex);
+            if (impl.lanes.empty()) {
+                return;
+            }
+            impl.stopping = true;
+            impl.dropQueued([](const Impl::Job &) { return true; }, dropped);
+            for (const auto &lane : impl.lanes) {
+                if (lane->running) {
+                    impl.cancelRunning(*lane, true);
+                }
+            }
+        }
+        impl.cv.notify_all();
+        for (const auto &lane : impl.lanes) {
+            lane->thread.join();
+        }
+        Impl::invokeCallbacks(dropped);
+
+        std::lock_guard<std::mutex> lock(impl.mutex);
+        impl.lanes.clear();
+        impl.lastResults.clear();
+        impl.singer = nullptr;
+    }
+
+    bool RenderScheduler::isOpen() const {
+        __stdc_impl_t;
+        std::lock_guard<std::mutex> lock(impl.mutex);
+        return !impl.lanes.empty() && !impl.stopping;
+    }
+
+    void RenderScheduler::submit(const std::string &phraseId,
+                                 const NO<Ac::AcousticStartInput> &input,
+                                 RenderPriority priority, Callback callback) {
+        __stdc_impl_t;
+        if (!input) {
+            if (callback) {
+                callback(nullptr,
+                         srt::Error(srt::Error::InvalidArgument, "render input is nullptr"));
+            }
+            return;
+        }
+
+        if (!isOpen()) {
+            if (callback) {
+                callback(nullptr,
+                         srt::Error(srt::Error::SessionError, "render scheduler is not open"));
+            }
+            return;
+        }
+
+        const auto hash = impl.hash(*input);
+        if (auto cached = impl.cache.find(hash)) {
+            if (callback) {
+                callback(cached, srt::Error());
+            }
+            return;
+        }
+
+        std::vector<Impl::PendingCallback> dropped;
+        {
+            std::lock_guard<std::mutex> lock(impl.mutex);
+
+            // Drop the pending renders of older inputs of the same phrase
+            impl.dropQueued(
+                [&](const Impl::Job &job) {
+                    return job.phraseId == phraseId && job.hash != hash;
+                },
+                dropped);
+
+            // Look for a job rendering the same input
+            Impl::JobRef existing;
+            for (const auto &lane : impl.lanes) {
+                const auto &job = lane->running;
+                if (!job || job->invalidated) {
+                    continue;
+                }
+                if (job->hash == hash) {
+                    existing = job;
+                } else if (job->phraseId == phraseId) {
+                    impl.cancelRunning(*lane, true);
+                }
+            }
+            for (auto queue : {&impl.foregroundQueue, &impl.speculativeQueue}) {
+                for (auto it = queue->begin(); !existing && it != queue->end(); ++it) {
+                    if ((*it)->hash == hash) {
+                        existing = *it;
+                        // Promote a pending speculative render
+                        if (priority == RenderPriority::Foreground &&
+                            queue == &impl.speculativeQueue) {
+                            queue->erase(it);
+                            impl.foregroundQueue.push_back(existing);
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if (existing) {
+                if (priority == RenderPriority::Foreground) {
+                    existing->priority = RenderPriority::Foreground;
+                }
+                if (callback) {
+                    existing->callbacks.push_back(std::move(callback));
+                }
+            } else {
+                auto job = std::make_shared<Impl::Job>();
+                job->phraseId = phraseId;
+                job->hash = hash;
+                job->input = Pipeline::copyInput(*input);
+                job->priority = priority;
+                if (callback) {
+                    job->callbacks.push_back(std::move(callback));
+                }
+                (priority == RenderPriority::Foreground ? impl.foregroundQueue
+                                                        : impl.speculativeQueue)
+                    .push_back(job);
+            }
+
+            // Interrupt the running speculative renders in favor of foreground work
+            if (priority == RenderPriority::Foreground) {
+                for (const auto &lane : impl.lanes) {
+                    const auto &job = lane->running;
+                    if (job && !job->invalidated &&
+                        job->priority == RenderPriority::Speculative) {
+                        impl.cancelRunning(*lane, false);
+                    }
+                }
+            }
+        }
+        impl.cv.notify_all();
+        Impl::invokeCallbacks(dropped);
+    }
+
+    void RenderScheduler::invalidate(const std::string &phraseId) {
+        __stdc_impl_t;
+        std::vector<Impl::PendingCallback> dropped;
+        {
+            std::lock_guard<std::mutex> lock(impl.mutex);
+            impl.dropQueued([&](const Impl::Job &job) { return job.phraseId == phraseId; },
+                            dropped);
+            for (const auto &lane : impl.lanes) {
+                if (lane->running && lane->running->phraseId == phraseId) {
+                    impl.cancelRunning(*lane, true);
+                }
+            }
+        }
+        impl.cv.notify_all();
+        Impl::invokeCallbacks(dropped);
+    }
+
+    void RenderScheduler::cancelSpeculative() {
+        __stdc_impl_t;
+        std::vector<Impl::PendingCallback> dropped;
+        {
+            std::lock_guard<std::mutex> lock(impl.mutex);
+            impl.dropQueued(
+                [](const Impl::Job &job) {
+                    return job.priority == RenderPriority::Speculative;
+                },
+                dropped);
+            for (const auto &lane : impl.lanes) {
+                if (lane->running && lane->running->priority == RenderPriority::Speculative) {
+                    impl.cancelRunning(*lane, true);
+                }
+            }
+        }
+        impl.cv.notify_all();
+        Impl::invokeCallbacks(dropped);
+    }
+
+    std::shared_ptr<const RenderResult>
+        RenderScheduler::cachedResult(const Ac::AcousticStartInput &input) const {
+        __stdc_impl_t;
+        return impl.cache.find(impl.hash(input));
+    }
+
+    PhraseCache &RenderScheduler::cache() {
+        __stdc_impl_t;
+        return impl.cache;
+    }
+
+}
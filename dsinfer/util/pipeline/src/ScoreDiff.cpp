@@ -0,0 +1,497 @@
+#include <pipeline/ScoreDiff.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <utility>
+
+#include <pipeline/InputHash.h>
+
+namespace ds::pipeline {
+
+    namespace Co = Api::Common::L1;
+    namespace Ac = Api::Acoustic::L1;
+
+    namespace {
+
+        struct WordLayout {
+            uint64_t fingerprint = 0;
+
+            // Range covered by the notes, in seconds
+            double start = 0;
+            double end = 0;
+
+            // Phonemes may start before the first note, e.g. leading consonants
+            double lead = 0;
+        };
+
+        struct ScoreLayout {
+            std::vector<WordLayout> words;
+            double wordsEnd = 0;
+            double end = 0;
+        };
+
+        ScoreLayout buildLayout(const Ac::AcousticStartInput &input) {
+            ScoreLayout layout;
+            layout.words.reserve(input.words.size());
+
+            double cursor = 0;
+            for (const auto &word : input.words) {
+                WordLayout item;
+
+                InputHasher hasher;
+                hasher.update(word);
+                const auto hash = hasher.finalize();
+                std::memcpy(&item.fingerprint, hash.data(), sizeof(item.fingerprint));
+
+                double duration = 0;
+                for (const auto &note : word.notes) {
+                    duration += note.duration;
+                }
+                for (const auto &phone : word.phones) {
+                    item.lead = (std::min) (item.lead, phone.start);
+                }
+                item.start = cursor;
+                item.end = cursor + duration;
+                cursor = item.end;
+                layout.words.push_back(item);
+            }
+            layout.wordsEnd = cursor;
+            layout.end = (std::max) (input.duration, cursor);
+            return layout;
+        }
+
+        /// Returns the matched (old, new) word index pairs, in increasing order.
+        std::vector<std::pair<int64_t, int64_t>> alignWords(const ScoreLayout &oldLayout,
+                                                            const ScoreLayout &newLayout,
+                                                            int64_t maxAlignWords) {
+            const auto &a = oldLayout.words;
+            const auto &b = newLayout.words;
+            const auto n = static_cast<int64_t>(a.size());
+            const auto m = static_cast<int64_t>(b.size());
+
+            // Common prefix and suffix, the usual case of a local edit
+            int64_t prefix = 0;
+            while (prefix < n && prefix < m && a[prefix].fingerprint == b[prefix].fingerprint) {
+                ++prefix;
+            }
+            int64_t suffix = 0;
+            while (suffix < n - prefix && suffix < m - prefix &&
+                   a[n - 1 - suffix].fingerprint == b[m - 1 - suffix].fingerprint) {
+                ++suffix;
+            }
+
+            std::vector<std::pair<int64_t, int64_t>> matches;
+            for (int64_t i = 0; i < prefix; ++i) {
+                matches.emplace_back(i, i);
+            }
+
+            // Longest common subsequence of the middle part
+            const int64_t n1 = n - prefix - suffix;
+            const int64_t m1 = m - prefix - suffix;
+            if (n1 > 0 && m1 > 0 && n1 <= maxAlignWords && m1 <= maxAlignWords) {
+                std::vector<uint32_t> table((n1 + 1) * (m1 + 1), 0);
+                const auto at = [&](int64_t i, int64_t j) -> uint32_t & {
+                    return table[i * (m1 + 1) + j];
+                };
+                for (int64_t i = n1 - 1; i >= 0; --i) {
+                    for (int64_t j = m1 - 1; j >= 0; --j) {
+                        at(i, j) = a[prefix + i].fingerprint == b[prefix + j].fingerprint
+                                       ? at(i + 1, j + 1) + 1
+                                       : (std::max) (at(i + 1, j), at(i, j + 1));
+                    }
+                }
+                int64_t i = 0, j = 0;
+                while (i < n1 && j < m1) {
+                    if (a[prefix + i].fingerprint == b[prefix + j].fingerprint) {
+                        matches.emplace_back(prefix + i, prefix + j);
+                        ++i;
+                        ++j;
+                    } else if (at(i + 1, j) >= at(i, j + 1)) {
+                        ++i;
+                    } else {
+                        ++j;
+                    }
+                }
+            }
+
+            for (int64_t k = suffix; k > 0; --k) {
+                matches.emplace_back(n - k, m - k);
+            }
+            return matches;
+        }
+
+        void normalizeRanges(std::vector<TimeRange> &ranges) {
+            std::sort(ranges.begin(), ranges.end(), [](const TimeRange &lhs, const TimeRange &rhs) {
+                return lhs.start < rhs.start;
+            });
+            std::vector<TimeRange> merged;
+            for (const auto &range : std::as_const(ranges)) {
+                if (range.end <= range.start) {
+                    continue;
+                }
+                if (!merged.empty() && range.start <= merged.back().end) {
+                    merged.back().end = (std::max) (merged.back().end, range.end);
+                } else {
+                    merged.push_back(range);
+                }
+            }
+            ranges = std::move(merged);
+        }
+
+        std::vector<TimeRange> expandRanges(const std::vector<TimeRange> &ranges, double context,
+                                            double end) {
+            std::vector<TimeRange> result;
+            result.reserve(ranges.size());
+            for (const auto &range : ranges) {
+                result.push_back({
+                    (std::max) (range.start - context, 0.0),
+                    (std::min) (range.end + context, end),
+                });
+            }
+            normalizeRanges(result);
+            return result;
+        }
+
+        std::vector<ShiftedSpan> subtractRanges(const std::vector<ShiftedSpan> &spans,
+                                                const std::vector<TimeRange> &dirty) {
+            std::vector<ShiftedSpan> result;
+            for (const auto &span : spans) {
+                double cursor = span.start;
+                for (const auto &range : dirty) {
+                    if (range.end <= cursor) {
+                        continue;
+                    }
+                    if (range.start >= span.end) {
+                        break;
+                    }
+                    if (range.start > cursor) {
+                        result.push_back({cursor, range.start, span.shift});
+                    }
+                    cursor = (std::max) (cursor, range.end);
+                }
+                if (cursor < span.end) {
+                    result.push_back({cursor, span.end, span.shift});
+                }
+            }
+            return result;
+        }
+
+        inline double sampleAt(const std::vector<double> &values, double pos) {
+            // Tolerate the rounding error of the time computations at both ends
+            constexpr double epsilon = 1e-9;
+            const auto last = static_cast<double>(values.size()) - 1;
+            if (values.empty() || pos < -epsilon || pos > last + epsilon) {
+                return std::numeric_limits<double>::quiet_NaN();
+            }
+            pos = std::clamp(pos, 0.0, last);
+            const auto index = static_cast<size_t>(pos + epsilon);
+            const double frac = pos - static_cast<double>(index);
+            if (frac < epsilon || index + 1 >= values.size()) {
+                return values[index];
+            }
+            return values[index] * (1 - frac) + values[index + 1] * frac;
+        }
+
+        inline bool sampleDiffers(double lhs, double rhs, double tolerance) {
+            const bool lhsNaN = std::isnan(lhs);
+            const bool rhsNaN = std::isnan(rhs);
+            if (lhsNaN || rhsNaN) {
+                return lhsNaN != rhsNaN;
+            }
+            return std::abs(lhs - rhs) > tolerance;
+        }
+
+        inline double mapOldToNew(const std::vector<ShiftedSpan> &spans, double t) {
+            for (const auto &span : spans) {
+                if (t >= span.start - span.shift && t < span.end - span.shift) {
+                    return t + span.shift;
+                }
+            }
+            return t;
+        }
+
+        /// Compares a curve of the new score against the shifted curve of the old score, over the
+        /// matched spans only; the other ranges are dirty anyway.
+        void diffCurve(const std::vector<double> &oldValues, double oldInterval,
+                       const std::vector<double> &newValues, double newInterval,
+                       const std::vector<ShiftedSpan> &spans, double end, double tolerance,
+                       std::vector<TimeRange> &dirty) {
+            if (oldInterval != newInterval || !(newInterval > 0)) {
+                dirty.push_back({0, end});
+                return;
+            }
+            const double interval = newInterval;
+            for (const auto &span : spans) {
+                auto k = static_cast<int64_t>(std::ceil(span.start / interval - 1e-9));
+                double runStart = -1;
+                for (; k * interval < span.end; ++k) {
+                    const double t = k * interval;
+                    const double newValue = k < static_cast<int64_t>(newValues.size())
+                                                ? newValues[k]
+                                                : std::numeric_limits<double>::quiet_NaN();
+                    const double oldValue = sampleAt(oldValues, (t - span.shift) / interval);
+                    if (sampleDiffers(oldValue, newValue, tolerance)) {
+                        if (runStart < 0) {
+                            runStart = t;
+                        }
+                    } else if (runStart >= 0) {
+                        dirty.push_back({runStart, t});
+                        runStart = -1;
+                    }
+                }
+                if (runStart >= 0) {
+                    dirty.push_back({runStart, span.end});
+                }
+            }
+        }
+
+        void diffRetake(const std::optional<Co::InputParameterInfo::RetakeRange> &oldRetake,
+                        const std::optional<Co::InputParameterInfo::RetakeRange> &newRetake,
+                        const std::vector<ShiftedSpan> &spans, double end,
+                        std::vector<TimeRange> &dirty) {
+            if (oldRetake.has_value() != newRetake.has_value()) {
+                dirty.push_back({0, end});
+                return;
+            }
+            if (!newRetake) {
+                return;
+            }
+            const double oldStart = mapOldToNew(spans, oldRetake->start);
+            const double oldEnd = mapOldToNew(spans, oldRetake->end);
+            if (oldStart != newRetake->start || oldEnd != newRetake->end) {
+                dirty.push_back({(std::min) (oldStart, newRetake->start),
+                                 (std::max) (oldEnd, newRetake->end)});
+            }
+        }
+
+        Stage stageOfParameter(const ParamTag &tag) {
+            if (tag == Co::Tags::Pitch || tag == Co::Tags::Expr) {
+                return Stage::Pitch;
+            }
+            if (tag == Co::Tags::Energy || tag == Co::Tags::Breathiness ||
+                tag == Co::Tags::Voicing || tag == Co::Tags::Tension ||
+                tag == Co::Tags::MouthOpening) {
+                return Stage::Variance;
+            }
+            return Stage::Acoustic;
+        }
+
+    }
+
+    bool ScoreDiff::identical() const {
+        for (const auto &stage : stages) {
+            if (!stage.clean()) {
+                return false;
+            }
+            for (const auto &span : stage.reusable) {
+                if (span.shift != 0) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    ScoreDiff diffScores(const Ac::AcousticStartInput &oldInput,
+                         const Ac::AcousticStartInput &newInput, const ScoreDiffOptions &options) {
+        const auto oldLayout = buildLayout(oldInput);
+        const auto newLayout = buildLayout(newInput);
+        const double end = newLayout.end;
+
+        ScoreDiff result;
+        result.wordMapping.assign(newLayout.words.size(), -1);
+
+        // Align the words, and collect the gaps between matched words as the edited ranges
+        const auto matches = alignWords(oldLayout, newLayout, options.maxAlignWords);
+
+        std::vector<TimeRange> scoreDirty;
+        std::vector<ShiftedSpan> matched;
+
+        int64_t prevOld = -1, prevNew = -1;
+        const auto addGap = [&](int64_t nextOld, int64_t nextNew) {
+            if (nextOld - prevOld <= 1 && nextNew - prevNew <= 1) {
+                return;
+            }
+            const auto &words = newLayout.words;
+            double start = prevNew >= 0 ? words[prevNew].end : 0;
+            if (prevNew + 1 < static_cast<int64_t>(words.size())) {
+                start = (std::min) (start, words[prevNew + 1].start + words[prevNew + 1].lead);
+            }
+            double gapEnd = nextNew < static_cast<int64_t>(words.size()) ? words[nextNew].start
+                                                                         : newLayout.wordsEnd;
+            // A pure deletion leaves an empty gap, which becomes dirty through the context
+            scoreDirty.push_back({start, (std::max) (start, gapEnd)});
+        };
+
+        for (const auto &[oldIndex, newIndex] : matches) {
+            addGap(oldIndex, newIndex);
+            result.wordMapping[newIndex] = oldIndex;
+
+            const auto &oldWord = oldLayout.words[oldIndex];
+            const auto &newWord = newLayout.words[newIndex];
+            const double shift = newWord.start - oldWord.start;
+            if (!matched.empty() && matched.back().end == newWord.start &&
+                matched.back().shift == shift) {
+                matched.back().end = newWord.end;
+            } else {
+                matched.push_back({newWord.start, newWord.end, shift});
+            }
+            prevOld = oldIndex;
+            prevNew = newIndex;
+        }
+        addGap(static_cast<int64_t>(oldLayout.words.size()),
+               static_cast<int64_t>(newLayout.words.size()));
+
+        // The tail after the last word
+        {
+            const double oldTail = oldLayout.end - oldLayout.wordsEnd;
+            const double newTail = newLayout.end - newLayout.wordsEnd;
+            const bool lastMatched = !matches.empty() &&
+                                     matches.back().first + 1 ==
+                                         static_cast<int64_t>(oldLayout.words.size()) &&
+                                     matches.back().second + 1 ==
+                                         static_cast<int64_t>(newLayout.words.size());
+            const double kept = lastMatched ? (std::min) (oldTail, newTail) : 0;
+            if (kept > 0) {
+                matched.push_back({newLayout.wordsEnd, newLayout.wordsEnd + kept,
+                                   newLayout.wordsEnd - oldLayout.wordsEnd});
+            }
+            if (newLayout.wordsEnd + kept < end) {
+                scoreDirty.push_back({newLayout.wordsEnd + kept, end});
+            }
+        }
+
+        // Compare the curves over the matched spans
+        std::array<std::vector<TimeRange>, StageCount> curveDirty;
+
+        std::map<std::string_view, const Co::InputParameterInfo *> oldParams, newParams;
+        for (const auto &param : oldInput.parameters) {
+            oldParams[param.tag.name()] = &param;
+        }
+        for (const auto &param : newInput.parameters) {
+            newParams[param.tag.name()] = &param;
+        }
+        for (const auto &[name, param] : std::as_const(newParams)) {
+            auto &dirty = curveDirty[static_cast<int>(stageOfParameter(param->tag))];
+            auto it = oldParams.find(name);
+            if (it == oldParams.end()) {
+                dirty.push_back({0, end});
+                continue;
+            }
+            const auto &oldParam = *it->second;
+            diffCurve(oldParam.values, oldParam.interval, param->values, param->interval, matched,
+                      end, options.tolerance, dirty);
+            diffRetake(oldParam.retake, param->retake, matched, end, dirty);
+        }
+        for (const auto &[name, param] : std::as_const(oldParams)) {
+            if (newParams.count(name) == 0) {
+                curveDirty[static_cast<int>(stageOfParameter(param->tag))].push_back({0, end});
+            }
+        }
+
+        std::map<std::string_view, const Co::InputSpeakerInfo *> oldSpeakers;
+        for (const auto &speaker : oldInput.speakers) {
+            oldSpeakers[speaker.name] = &speaker;
+        }
+        auto &speakerDirty = curveDirty[static_cast<int>(Stage::Duration)];
+        for (const auto &speaker : newInput.speakers) {
+            auto it = oldSpeakers.find(speaker.name);
+            if (it == oldSpeakers.end()) {
+                speakerDirty.push_back({0, end});
+                continue;
+            }
+            diffCurve(it->second->proportions, it->second->interval, speaker.proportions,
+                      speaker.interval, matched, end, options.tolerance, speakerDirty);
+            oldSpeakers.erase(it);
+        }
+        if (!oldSpeakers.empty()) {
+            speakerDirty.push_back({0, end});
+        }
+
+        // Global options
+        if (oldInput.steps != newInput.steps) {
+            curveDirty[static_cast<int>(Stage::Pitch)].push_back({0, end});
+        }
+        if (oldInput.depth != newInput.depth) {
+            curveDirty[static_cast<int>(Stage::Acoustic)].push_back({0, end});
+        }
+
+        // Each stage recomputes what the previous stage changed, plus its own inputs
+        normalizeRanges(scoreDirty);
+        std::vector<TimeRange> accumulated = scoreDirty;
+        for (int i = 0; i < StageCount; ++i) {
+            auto &stage = result.stages[i];
+            accumulated.insert(accumulated.end(), curveDirty[i].begin(), curveDirty[i].end());
+            normalizeRanges(accumulated);
+            accumulated = expandRanges(accumulated, options.context[i], end);
+            stage.dirty = accumulated;
+            stage.reusable = subtractRanges(matched, stage.dirty);
+        }
+        return result;
+    }
+
+    std::vector<FrameRange> toFrameRanges(const std::vector<TimeRange> &ranges, double frameWidth,
+                                          int64_t frameCount) {
+        std::vector<FrameRange> result;
+        if (!(frameWidth > 0)) {
+            return result;
+        }
+        for (const auto &range : ranges) {
+            const auto begin = std::clamp<int64_t>(
+                static_cast<int64_t>(std::floor(range.start / frameWidth)), 0, frameCount);
+            const auto end = std::clamp<int64_t>(
+                static_cast<int64_t>(std::ceil(range.end / frameWidth)), 0, frameCount);
+            if (begin >= end) {
+                continue;
+            }
+            if (!result.empty() && begin <= result.back().end) {
+                result.back().end = (std::max) (result.back().end, end);
+            } else {
+                result.push_back({begin, end});
+            }
+        }
+        return result;
+    }
+
+    std::vector<double> remapCurve(const std::vector<double> &oldValues, double interval,
+                                   const std::vector<ShiftedSpan> &spans, size_t newLength) {
+        if (!(interval > 0) || oldValues.empty()) {
+            return {};
+        }
+        std::vector<double> result(newLength, std::numeric_limits<double>::quiet_NaN());
+        bool reused = false;
+        for (const auto &span : spans) {
+            auto k = static_cast<size_t>(std::ceil(span.start / interval - 1e-9));
+            for (; k < newLength && k * interval < span.end; ++k) {
+                result[k] = sampleAt(oldValues, (k * interval - span.shift) / interval);
+                reused = reused || !std::isnan(result[k]);
+            }
+        }
+        if (!reused) {
+            return {};
+        }
+
+        // Hold the nearest reused value over the other ranges
+        double last = std::numeric_limits<double>::quiet_NaN();
+        for (auto &value : result) {
+            if (std::isnan(value)) {
+                value = last;
+            } else {
+                last = value;
+            }
+        }
+        last = std::numeric_limits<double>::quiet_NaN();
+        for (auto it = result.rbegin(); it != result.rend(); ++it) {
+            if (std::isnan(*it)) {
+                *it = last;
+            } else {
+                last = *it;
+            }
+        }
+        return result;
+    }
+
+}
@@ -0,0 +1,176 @@
+#include <pipeline/StageClient.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include <stdcorelib/pimpl.h>
+#include <stdcorelib/str.h>
+
+#include <synthrt/Support/Logging.h>
+
+#include <pipeline/StageCodec.h>
+
+#include "StageSocket_p.h"
+
+namespace ds::pipeline {
+
+    using srt::NO;
+
+    static srt::LogCategory Log("stageclient");
+
+    static inline bool isCancelled(const std::atomic<bool> *cancelled) {
+        return cancelled && cancelled->load(std::memory_order_acquire);
+    }
+
+    class StageClient::Impl {
+    public:
+        Impl(Stage stage, std::vector<std::string> endpoints, int maxInFlight)
+            : stage(stage), endpoints(std::move(endpoints)),
+              maxInFlight((std::max) (maxInFlight, 1)), loads(this->endpoints.size(), 0) {
+        }
+
+        Stage stage;
+        std::vector<std::string> endpoints;
+        int maxInFlight;
+
+        mutable std::mutex mutex;
+        std::condition_variable released;
+        std::vector<int> loads;
+        int inFlight = 0;
+
+        // Takes a slot of the least loaded endpoint not tried yet, waiting for one to be free
+        srt::Expected<size_t> acquire(const std::vector<bool> &tried,
+                                      const std::atomic<bool> *cancelled) {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                if (isCancelled(cancelled)) {
+                    return srt::Error(srt::Error::SessionError, "stage call cancelled");
+                }
+                size_t best = endpoints.size();
+                for (size_t i = 0; i < endpoints.size(); ++i) {
+                    if (!tried[i] && loads[i] < maxInFlight &&
+                        (best == endpoints.size() || loads[i] < loads[best])) {
+                        best = i;
+                    }
+                }
+                if (best < endpoints.size()) {
+                    ++loads[best];
+                    ++inFlight;
+                    return best;
+                }
+                // Polled, so that the cancellation is noticed while waiting
+                released.wait_for(lock, std::chrono::milliseconds(10));
+            }
+        }
+
+        void release(size_t index) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --loads[index];
+                --inFlight;
+            }
+            released.notify_all();
+        }
+
+        srt::Expected<NO<srt::TaskResult>> call(const std::string &endpoint,
+                                                const StageMessage &request,
+                                                const std::atomic<bool> *cancelled,
+                                                bool &connected) const {
+            connected = false;
+            auto exp = connectStageSocket(endpoint);
+            if (!exp) {
+                return exp.takeError();
+            }
+            connected = true;
+
+            const int fd = exp.value();
+            StageMessage response;
+            auto res = sendStageMessage(fd, request);
+            auto received = res ? receiveStageMessage(fd, response, cancelled)
+                                : srt::Expected<bool>(res.takeError());
+            closeStageSocket(fd);
+            if (!received) {
+                return received.takeError();
+            }
+            if (!received.value()) {
+                return srt::Error(srt::Error::SessionError,
+                                  stdc::formatN(R"(stage server "%1" closed the connection)",
+                                                endpoint));
+            }
+            if (response.stage != stage) {
+                return srt::Error(srt::Error::InvalidFormat,
+                                  stdc::formatN(R"(stage server "%1" runs the %2 stage)",
+                                                endpoint, stageName(response.stage)));
+            }
+            return decodeStageResult(response);
+        }
+    };
+
+    StageClient::StageClient(Stage stage, std::vector<std::string> endpoints, int maxInFlight)
+        : _impl(std::make_unique<Impl>(stage, std::move(endpoints), maxInFlight)) {
+    }
+
+    StageClient::~StageClient() = default;
+
+    Stage StageClient::stage() const {
+        __stdc_impl_t;
+        return impl.stage;
+    }
+
+    const std::vector<std::string> &StageClient::endpoints() const {
+        __stdc_impl_t;
+        return impl.endpoints;
+    }
+
+    int StageClient::maxInFlight() const {
+        __stdc_impl_t;
+        return impl.maxInFlight;
+    }
+
+    int StageClient::inFlight() const {
+        __stdc_impl_t;
+        std::lock_guard<std::mutex> lock(impl.mutex);
+        return impl.inFlight;
+    }
+
+    srt::Expected<NO<srt::TaskResult>> StageClient::run(const srt::TaskStartInput &input,
+                                                        const std::atomic<bool> *cancelled) {
+        __stdc_impl_t;
+        if (impl.endpoints.empty()) {
+            return srt::Error(srt::Error::InvalidArgument,
+                              stdc::formatN("no %1 stage server", stageName(impl.stage)));
+        }
+
+        StageMessage request;
+        if (auto res = encodeStageInput(impl.stage, input, request); !res) {
+            return res.takeError();
+        }
+
+        // Try the endpoints in turn until one of them is reached
+        std::vector<bool> tried(impl.endpoints.size(), false);
+        srt::Error lastError;
+        for (size_t attempt = 0; attempt < impl.endpoints.size(); ++attempt) {
+            auto slot = impl.acquire(tried, cancelled);
+            if (!slot) {
+                return slot.takeError();
+            }
+            const auto index = slot.value();
+            tried[index] = true;
+
+            bool connected;
+            auto exp = impl.call(impl.endpoints[index], request, cancelled, connected);
+            impl.release(index);
+            if (exp || connected) {
+                return exp;
+            }
+            Log.srtDebug("Run - %1", exp.error().message());
+            lastError = exp.takeError();
+        }
+        return srt::Error(srt::Error::SessionError,
+                          stdc::formatN("no %1 stage server reachable: %2", stageName(impl.stage),
+                                        lastError.message()));
+    }
+
+}
@@ -0,0 +1,607 @@
+#include <pipeline/StageCodec.h>
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include <stdcorelib/str.h>
+
+#include <dsinfer/Core/Tensor.h>
+#include <dsinfer/Api/Inferences/Acoustic/1/AcousticApiL1.h>
+#include <dsinfer/Api/Inferences/Duration/1/DurationApiL1.h>
+#include <dsinfer/Api/Inferences/Pitch/1/PitchApiL1.h>
+#include <dsinfer/Api/Inferences/Variance/1/VarianceApiL1.h>
+#include <dsinfer/Api/Inferences/Vocoder/1/VocoderApiL1.h>
+
+namespace ds::pipeline {
+
+    namespace Co = Api::Common::L1;
+    namespace Ac = Api::Acoustic::L1;
+    namespace Dur = Api::Duration::L1;
+    namespace Pit = Api::Pitch::L1;
+    namespace Var = Api::Variance::L1;
+    namespace Vo = Api::Vocoder::L1;
+
+    using srt::NO;
+
+    // Tags are views of literals, so the decoded ones are mapped back to the known literals
+    static const ParamTag *const knownTags[] = {
+        &Co::Tags::Pitch,       &Co::Tags::Expr,      &Co::Tags::F0,
+        &Co::Tags::ToneShift,   &Co::Tags::Energy,    &Co::Tags::Breathiness,
+        &Co::Tags::Voicing,     &Co::Tags::Tension,   &Co::Tags::MouthOpening,
+        &Co::Tags::Gender,      &Co::Tags::Velocity,
+    };
+
+    namespace {
+
+        class Writer {
+        public:
+            explicit Writer(StageMessage &message) : _message(message) {
+            }
+
+            template <class T>
+            void pod(const T &value) {
+                static_assert(std::is_trivially_copyable_v<T>);
+                raw(&value, sizeof(T));
+            }
+
+            void size(size_t n) {
+                pod(static_cast<uint64_t>(n));
+            }
+
+            void string(const std::string_view &s) {
+                size(s.size());
+                raw(s.data(), s.size());
+            }
+
+            // Large arrays are moved out to the blobs
+            void bytes(const void *data, size_t n) {
+                size(n);
+                if (n < StageMessage::BlobThreshold) {
+                    raw(data, n);
+                    return;
+                }
+                pod(static_cast<uint32_t>(_message.blobs.size()));
+                _message.blobs.push_back({static_cast<const std::byte *>(data), n, nullptr});
+            }
+
+            template <class T>
+            void array(const std::vector<T> &values) {
+                static_assert(std::is_trivially_copyable_v<T>);
+                bytes(values.data(), values.size() * sizeof(T));
+            }
+
+            void tensor(const NO<ITensor> &tensor) {
+                pod(static_cast<uint8_t>(tensor ? 1 : 0));
+                if (!tensor) {
+                    return;
+                }
+                pod(static_cast<int32_t>(tensor->dataType()));
+                array(tensor->shape());
+                bytes(tensor->rawData(), tensor->byteSize());
+            }
+
+            void words(const std::vector<Co::InputWordInfo> &words) {
+                size(words.size());
+                for (const auto &word : words) {
+                    size(word.phones.size());
+                    for (const auto &phone : word.phones) {
+                        string(phone.token);
+                        string(phone.language);
+                        pod(static_cast<int32_t>(phone.tone));
+                        pod(phone.start);
+                        size(phone.speakers.size());
+                        for (const auto &speaker : phone.speakers) {
+                            string(speaker.name);
+                            pod(speaker.proportion);
+                        }
+                    }
+                    size(word.notes.size());
+                    for (const auto &note : word.notes) {
+                        pod(static_cast<int32_t>(note.key));
+                        pod(static_cast<int32_t>(note.cents));
+                        pod(note.duration);
+                        pod(static_cast<int32_t>(note.glide));
+                        pod(static_cast<uint8_t>(note.is_rest));
+                    }
+                }
+            }
+
+            void parameters(const std::vector<Co::InputParameterInfo> &parameters) {
+                size(parameters.size());
+                for (const auto &param : parameters) {
+                    string(param.tag.name());
+                    array(param.values);
+                    pod(param.interval);
+                    pod(static_cast<uint8_t>(param.retake ? 1 : 0));
+                    if (param.retake) {
+                        pod(param.retake->start);
+                        pod(param.retake->end);
+                    }
+                }
+            }
+
+            void speakers(const std::vector<Co::InputSpeakerInfo> &speakers) {
+                size(speakers.size());
+                for (const auto &speaker : speakers) {
+                    string(speaker.name);
+                    pod(speaker.interval);
+                    array(speaker.proportions);
+                }
+            }
+
+            void error(const srt::Error &error) {
+                pod(static_cast<int32_t>(error.type()));
+                string(error.message());
+            }
+
+        protected:
+            void raw(const void *data, size_t n) {
+                const auto p = static_cast<const std::byte *>(data);
+                _message.body.insert(_message.body.end(), p, p + n);
+            }
+
+            StageMessage &_message;
+        };
+
+        class Reader {
+        public:
+            explicit Reader(const StageMessage &message) : _message(message) {
+            }
+
+            template <class T>
+            T pod() {
+                static_assert(std::is_trivially_copyable_v<T>);
+                T value{};
+                if (!fail(_message.body.size() - _pos < sizeof(T))) {
+                    std::memcpy(&value, _message.body.data() + _pos, sizeof(T));
+                    _pos += sizeof(T);
+                }
+                return value;
+            }
+
+            size_t size() {
+                const auto n = pod<uint64_t>();
+                // Every element takes at least a byte of the rest of the body, which bounds the
+                // allocations
+                return fail(n > _message.body.size() - _pos) ? 0 : static_cast<size_t>(n);
+            }
+
+            std::string string() {
+                const auto n = size();
+                if (fail(_message.body.size() - _pos < n)) {
+                    return {};
+                }
+                std::string s(reinterpret_cast<const char *>(_message.body.data() + _pos), n);
+                _pos += n;
+                return s;
+            }
+
+            StageBlob bytes() {
+                const auto n = pod<uint64_t>();
+                if (n < StageMessage::BlobThreshold) {
+                    if (fail(_message.body.size() - _pos < n)) {
+                        return {};
+                    }
+                    StageBlob blob{_message.body.data() + _pos, static_cast<size_t>(n), nullptr};
+                    _pos += n;
+                    return blob;
+                }
+                const auto index = pod<uint32_t>();
+                if (fail(index >= _message.blobs.size() || _message.blobs[index].size != n)) {
+                    return {};
+                }
+                return _message.blobs[index];
+            }
+
+            template <class T>
+            std::vector<T> array() {
+                static_assert(std::is_trivially_copyable_v<T>);
+                const auto blob = bytes();
+                if (fail(blob.size % sizeof(T) != 0)) {
+                    return {};
+                }
+                std::vector<T> values(blob.size / sizeof(T));
+                if (blob.size > 0) {
+                    std::memcpy(values.data(), blob.data, blob.size);
+                }
+                return values;
+            }
+
+            NO<ITensor> tensor() {
+                if (pod<uint8_t>() == 0) {
+                    return {};
+                }
+                const auto dataType = static_cast<ITensor::DataType>(pod<int32_t>());
+                const auto shape = array<int64_t>();
+                const auto blob = bytes();
+                if (_failed) {
+                    return {};
+                }
+                auto exp = Tensor::createFromRawView(dataType, shape, {blob.data, blob.size});
+                if (fail(!exp)) {
+                    return {};
+                }
+                return exp.take();
+            }
+
+            std::vector<Co::InputWordInfo> words() {
+                std::vector<Co::InputWordInfo> words(size());
+                for (auto &word : words) {
+                    word.phones.resize(size());
+                    for (auto &phone : word.phones) {
+                        phone.token = string();
+                        phone.language = string();
+                        phone.tone = pod<int32_t>();
+                        phone.start = pod<double>();
+                        phone.speakers.resize(size());
+                        for (auto &speaker : phone.speakers) {
+                            speaker.name = string();
+                            speaker.proportion = pod<double>();
+                        }
+                    }
+                    word.notes.resize(size());
+                    for (auto &note : word.notes) {
+                        note.key = pod<int32_t>();
+                        note.cents = pod<int32_t>();
+                        note.duration = pod<double>();
+                        note.glide = static_cast<Co::GlideType>(pod<int32_t>());
+                        note.is_rest = pod<uint8_t>() != 0;
+                    }
+                    if (_failed) {
+                        return {};
+                    }
+                }
+                return words;
+            }
+
+            // InputParameterInfo is not assignable, so the elements are appended
+            void parameters(std::vector<Co::InputParameterInfo> &parameters) {
+                const auto n = size();
+                parameters.clear();
+                parameters.reserve(n);
+                for (size_t i = 0; i < n && !_failed; ++i) {
+                    const auto name = string();
+                    const ParamTag *tag = nullptr;
+                    for (const auto known : knownTags) {
+                        if (known->name() == name) {
+                            tag = known;
+                            break;
+                        }
+                    }
+                    if (fail(!tag)) {
+                        _unknownTag = name;
+                        break;
+                    }
+                    parameters.push_back(Co::InputParameterInfo{*tag, {}, 0, std::nullopt});
+                    auto &param = parameters.back();
+                    param.values = array<double>();
+                    param.interval = pod<double>();
+                    if (pod<uint8_t>() != 0) {
+                        const auto start = pod<double>();
+                        const auto end = pod<double>();
+                        param.retake = Co::InputParameterInfo::RetakeRange{start, end};
+                    }
+                }
+            }
+
+            std::vector<Co::InputSpeakerInfo> speakers() {
+                std::vector<Co::InputSpeakerInfo> speakers(size());
+                for (auto &speaker : speakers) {
+                    speaker.name = string();
+                    speaker.interval = pod<double>();
+                    speaker.proportions = array<double>();
+                }
+                return speakers;
+            }
+
+            srt::Error error() {
+                const auto type = pod<int32_t>();
+                return srt::Error(type, string());
+            }
+
+            srt::Error result() const {
+                if (!_unknownTag.empty()) {
+                    return srt::Error(srt::Error::InvalidFormat,
+                                      stdc::formatN(R"(unknown parameter "%1")", _unknownTag));
+                }
+                if (_failed || _pos != _message.body.size()) {
+                    return srt::Error(srt::Error::InvalidFormat,
+                                      stdc::formatN("malformed %1 message",
+                                                    stageName(_message.stage)));
+                }
+                return {};
+            }
+
+        protected:
+            // Set on the first malformed field, the following reads return empty values
+            bool fail(bool condition) {
+                _failed |= condition;
+                return _failed;
+            }
+
+            const StageMessage &_message;
+            size_t _pos = 0;
+            bool _failed = false;
+            std::string _unknownTag;
+        };
+
+        template <class T>
+        const T *castTo(const srt::NamedObject &obj, Stage stage) {
+            if (obj.objectName() != stageName(stage)) {
+                return nullptr;
+            }
+            return static_cast<const T *>(&obj);
+        }
+
+        srt::Error typeMismatch(Stage stage, const std::string &name) {
+            return srt::Error(srt::Error::InvalidArgument,
+                              stdc::formatN(R"(expected a %1 object, got "%2")", stageName(stage),
+                                            name));
+        }
+
+    }
+
+    srt::Expected<void> encodeStageInput(Stage stage, const srt::TaskStartInput &input,
+                                         StageMessage &message) {
+        message = {};
+        message.kind = StageMessage::Request;
+        message.stage = stage;
+        Writer w(message);
+        switch (stage) {
+            case Stage::Duration: {
+                const auto in = castTo<Dur::DurationStartInput>(input, stage);
+                if (!in) {
+                    break;
+                }
+                w.pod(in->duration);
+                w.words(in->words);
+                return srt::Expected<void>();
+            }
+            case Stage::Pitch: {
+                const auto in = castTo<Pit::PitchStartInput>(input, stage);
+                if (!in) {
+                    break;
+                }
+                w.pod(in->duration);
+                w.words(in->words);
+                w.parameters(in->parameters);
+                w.speakers(in->speakers);
+                w.pod(in->steps);
+                return srt::Expected<void>();
+            }
+            case Stage::Variance: {
+                const auto in = castTo<Var::VarianceStartInput>(input, stage);
+                if (!in) {
+                    break;
+                }
+                w.pod(in->duration);
+                w.words(in->words);
+                w.parameters(in->parameters);
+                w.speakers(in->speakers);
+                w.pod(in->steps);
+                return srt::Expected<void>();
+            }
+            case Stage::Acoustic: {
+                const auto in = castTo<Ac::AcousticStartInput>(input, stage);
+                if (!in) {
+                    break;
+                }
+                w.pod(in->duration);
+                w.words(in->words);
+                w.parameters(in->parameters);
+                w.speakers(in->speakers);
+                w.pod(in->depth);
+                w.pod(in->steps);
+                return srt::Expected<void>();
+            }
+            case Stage::Vocoder: {
+                const auto in = castTo<Vo::VocoderStartInput>(input, stage);
+                if (!in) {
+                    break;
+                }
+                w.tensor(in->mel);
+                w.tensor(in->f0);
+                w.array(in->peakBinSizes);
+                return srt::Expected<void>();
+            }
+        }
+        return typeMismatch(stage, input.objectName());
+    }
+
+    srt::Expected<NO<srt::TaskStartInput>> decodeStageInput(const StageMessage &message) {
+        if (message.kind != StageMessage::Request) {
+            return srt::Error(srt::Error::InvalidFormat, "not a stage request");
+        }
+        Reader r(message);
+        NO<srt::TaskStartInput> input;
+        switch (message.stage) {
+            case Stage::Duration: {
+                auto in = NO<Dur::DurationStartInput>::create();
+                in->duration = r.pod<double>();
+                in->words = r.words();
+                input = in;
+                break;
+            }
+            case Stage::Pitch: {
+                auto in = NO<Pit::PitchStartInput>::create();
+                in->duration = r.pod<double>();
+                in->words = r.words();
+                r.parameters(in->parameters);
+                in->speakers = r.speakers();
+                in->steps = r.pod<int64_t>();
+                input = in;
+                break;
+            }
+            case Stage::Variance: {
+                auto in = NO<Var::VarianceStartInput>::create();
+                in->duration = r.pod<double>();
+                in->words = r.words();
+                r.parameters(in->parameters);
+                in->speakers = r.speakers();
+                in->steps = r.pod<int64_t>();
+                input = in;
+                break;
+            }
+            case Stage::Acoustic: {
+                auto in = NO<Ac::AcousticStartInput>::create();
+                in->duration = r.pod<double>();
+                in->words = r.words();
+                r.parameters(in->parameters);
+                in->speakers = r.speakers();
+                in->depth = r.pod<float>();
+                in->steps = r.pod<int64_t>();
+                input = in;
+                break;
+            }
+            case Stage::Vocoder: {
+                auto in = NO<Vo::VocoderStartInput>::create();
+                in->mel = r.tensor();
+                in->f0 = r.tensor();
+                in->peakBinSizes = r.array<int>();
+                input = in;
+                break;
+            }
+            default:
+                return srt::Error(srt::Error::InvalidFormat, "unknown stage");
+        }
+        if (auto error = r.result(); !error.ok()) {
+            return error;
+        }
+        return input;
+    }
+
+    srt::Expected<void> encodeStageResult(Stage stage, const srt::TaskResult &result,
+                                          StageMessage &message) {
+        message = {};
+        message.kind = StageMessage::Response;
+        message.stage = stage;
+        Writer w(message);
+        w.error(result.error);
+        switch (stage) {
+            case Stage::Duration: {
+                const auto res = castTo<Dur::DurationResult>(result, stage);
+                if (!res) {
+                    break;
+                }
+                w.array(res->durations);
+                return srt::Expected<void>();
+            }
+            case Stage::Pitch: {
+                const auto res = castTo<Pit::PitchResult>(result, stage);
+                if (!res) {
+                    break;
+                }
+                w.array(res->pitch);
+                w.pod(res->interval);
+                return srt::Expected<void>();
+            }
+            case Stage::Variance: {
+                const auto res = castTo<Var::VarianceResult>(result, stage);
+                if (!res) {
+                    break;
+                }
+                w.parameters(res->predictions);
+                return srt::Expected<void>();
+            }
+            case Stage::Acoustic: {
+                const auto res = castTo<Ac::AcousticResult>(result, stage);
+                if (!res) {
+                    break;
+                }
+                w.tensor(res->mel);
+                w.tensor(res->f0);
+                return srt::Expected<void>();
+            }
+            case Stage::Vocoder: {
+                const auto res = castTo<Vo::VocoderResult>(result, stage);
+                if (!res) {
+                    break;
+                }
+                w.array(res->audioData);
+                w.size(res->peaks.size());
+                for (const auto &level : res->peaks) {
+                    w.pod(static_cast<int32_t>(level.binSize));
+                    w.array(level.min);
+                    w.array(level.max);
+                    w.array(level.rms);
+                }
+                return srt::Expected<void>();
+            }
+        }
+        return typeMismatch(stage, result.objectName());
+    }
+
+    srt::Expected<NO<srt::TaskResult>> decodeStageResult(const StageMessage &message) {
+        Reader r(message);
+        if (message.kind == StageMessage::Failure) {
+            auto error = r.error();
+            if (auto malformed = r.result(); !malformed.ok()) {
+                return malformed;
+            }
+            return error;
+        }
+        if (message.kind != StageMessage::Response) {
+            return srt::Error(srt::Error::InvalidFormat, "not a stage response");
+        }
+
+        const auto error = r.error();
+        NO<srt::TaskResult> result;
+        switch (message.stage) {
+            case Stage::Duration: {
+                auto res = NO<Dur::DurationResult>::create();
+                res->durations = r.array<double>();
+                result = res;
+                break;
+            }
+            case Stage::Pitch: {
+                auto res = NO<Pit::PitchResult>::create();
+                res->pitch = r.array<double>();
+                res->interval = r.pod<double>();
+                result = res;
+                break;
+            }
+            case Stage::Variance: {
+                auto res = NO<Var::VarianceResult>::create();
+                r.parameters(res->predictions);
+                result = res;
+                break;
+            }
+            case Stage::Acoustic: {
+                auto res = NO<Ac::AcousticResult>::create();
+                res->mel = r.tensor();
+                res->f0 = r.tensor();
+                result = res;
+                break;
+            }
+            case Stage::Vocoder: {
+                auto res = NO<Vo::VocoderResult>::create();
+                res->audioData = r.array<uint8_t>();
+                res->peaks.resize(r.size());
+                for (auto &level : res->peaks) {
+                    level.binSize = r.pod<int32_t>();
+                    level.min = r.array<float>();
+                    level.max = r.array<float>();
+                    level.rms = r.array<float>();
+                }
+                result = res;
+                break;
+            }
+            default:
+                return srt::Error(srt::Error::InvalidFormat, "unknown stage");
+        }
+        if (auto malformed = r.result(); !malformed.ok()) {
+            return malformed;
+        }
+        result->error = error;
+        return result;
+    }
+
+    void encodeStageFailure(Stage stage, const srt::Error &error, StageMessage &message) {
+        message = {};
+        message.kind = StageMessage::Failure;
+        message.stage = stage;
+        Writer(message).error(error);
+    }
+
+}
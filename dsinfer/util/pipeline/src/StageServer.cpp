@@ -0,0 +1,223 @@
+#include <pipeline/StageServer.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#  include <unistd.h>
+#endif
+
+#include <stdcorelib/pimpl.h>
+#include <stdcorelib/str.h>
+
+#include <synthrt/SVS/Inference.h>
+#include <synthrt/Support/Logging.h>
+
+#include <pipeline/StageCodec.h>
+
+#include "StageSocket_p.h"
+
+namespace ds::pipeline {
+
+    using srt::NO;
+
+    static srt::LogCategory Log("stageserver");
+
+    class StageServer::Impl {
+    public:
+        Impl(Stage stage, Handler handler) : stage(stage), handler(std::move(handler)) {
+        }
+
+        Stage stage;
+        Handler handler;
+
+        int listenFd = -1;
+        std::string path;
+        int ownerPid = 0;
+
+        std::atomic<bool> stopped = false;
+
+        std::mutex connectionMutex;
+        std::condition_variable connectionFinished;
+        int connectionCount = 0;
+
+        // Runs a request, the returned result holds the data referred to by the response
+        NO<srt::TaskResult> respond(const StageMessage &request, StageMessage &response) const {
+            if (request.kind != StageMessage::Request || request.stage != stage) {
+                encodeStageFailure(stage,
+                                   srt::Error(srt::Error::InvalidArgument,
+                                              stdc::formatN("server runs the %1 stage, not %2",
+                                                            stageName(stage),
+                                                            stageName(request.stage))),
+                                   response);
+                return {};
+            }
+            auto input = decodeStageInput(request);
+            if (!input) {
+                encodeStageFailure(stage, input.error(), response);
+                return {};
+            }
+            auto exp = handler(input.value());
+            if (!exp) {
+                encodeStageFailure(stage, exp.error(), response);
+                return {};
+            }
+            auto result = exp.take();
+            if (auto res = encodeStageResult(stage, *result, response); !res) {
+                encodeStageFailure(stage, res.error(), response);
+                return {};
+            }
+            return result;
+        }
+
+        void serveConnection(int fd) {
+            while (true) {
+                StageMessage request;
+                auto exp = receiveStageMessage(fd, request, &stopped);
+                if (!exp) {
+                    if (!stopped) {
+                        Log.srtDebug("Serve - dropping connection: %1", exp.error().message());
+                    }
+                    break;
+                }
+                if (!exp.value()) {
+                    break;
+                }
+
+                StageMessage response;
+                const auto result = respond(request, response);
+                if (auto res = sendStageMessage(fd, response); !res) {
+                    Log.srtDebug("Serve - dropping connection: %1", res.error().message());
+                    break;
+                }
+            }
+            closeStageSocket(fd);
+        }
+    };
+
+    StageServer::StageServer(Stage stage, Handler handler)
+        : _impl(std::make_unique<Impl>(stage, std::move(handler))) {
+    }
+
+    StageServer::~StageServer() {
+        stop();
+        close();
+    }
+
+    Stage StageServer::stage() const {
+        __stdc_impl_t;
+        return impl.stage;
+    }
+
+    srt::Expected<void> StageServer::listen(const std::string &path) {
+        __stdc_impl_t;
+        if (impl.listenFd >= 0) {
+            return srt::Error(srt::Error::SessionError, "server is already listening");
+        }
+        auto exp = listenStageSocket(path);
+        if (!exp) {
+            return exp.takeError();
+        }
+        impl.listenFd = exp.value();
+        impl.path = path;
+#ifndef _WIN32
+        impl.ownerPid = ::getpid();
+#endif
+        impl.stopped = false;
+        return srt::Expected<void>();
+    }
+
+    srt::Expected<void> StageServer::serve(bool threaded) {
+        __stdc_impl_t;
+        if (impl.listenFd < 0) {
+            return srt::Error(srt::Error::SessionError, "server is not listening");
+        }
+
+        srt::Expected<void> res;
+        while (true) {
+            auto exp = acceptStageSocket(impl.listenFd, &impl.stopped);
+            if (!exp) {
+                res = exp.takeError();
+                break;
+            }
+            const int fd = exp.value();
+            if (fd < 0) {
+                break;
+            }
+            if (!threaded) {
+                impl.serveConnection(fd);
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(impl.connectionMutex);
+                ++impl.connectionCount;
+            }
+            std::thread([&impl, fd]() {
+                impl.serveConnection(fd);
+                std::lock_guard<std::mutex> lock(impl.connectionMutex);
+                --impl.connectionCount;
+                impl.connectionFinished.notify_all();
+            }).detach();
+        }
+
+        // The connection threads refer to the server
+        std::unique_lock<std::mutex> lock(impl.connectionMutex);
+        impl.connectionFinished.wait(lock, [&impl]() { return impl.connectionCount == 0; });
+        return res;
+    }
+
+    void StageServer::stop() {
+        __stdc_impl_t;
+        impl.stopped = true;
+    }
+
+    void StageServer::close() {
+        __stdc_impl_t;
+        if (impl.listenFd < 0) {
+            return;
+        }
+        closeStageSocket(impl.listenFd);
+        impl.listenFd = -1;
+#ifndef _WIN32
+        // The forked workers share the socket file with the process that created it
+        if (impl.ownerPid == ::getpid()) {
+            ::unlink(impl.path.c_str());
+        }
+#endif
+        impl.path.clear();
+    }
+
+    srt::Expected<StageServer::Handler>
+        StageServer::inferenceHandler(const srt::SingerSpec *singer, Stage stage,
+                                      const PipelineOptions &options) {
+        auto exp = createStageInference(singer, stage, options);
+        if (!exp) {
+            return exp.takeError();
+        }
+
+        struct State {
+            NO<srt::Inference> inference;
+            std::mutex mutex;
+        };
+        auto state = std::make_shared<State>();
+        state->inference = exp.take();
+
+        return Handler([state](const NO<srt::TaskStartInput> &input)
+                           -> srt::Expected<NO<srt::TaskResult>> {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            auto exp = state->inference->start(input);
+            if (!exp) {
+                return exp.takeError();
+            }
+            auto result = exp.take();
+            if (state->inference->state() == srt::ITask::Failed && result->error.ok()) {
+                result->error = srt::Error(srt::Error::SessionError, "inference failed");
+            }
+            return result;
+        });
+    }
+
+}
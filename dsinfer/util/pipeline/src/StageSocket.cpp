@@ -0,0 +1,433 @@
+#include "StageSocket_p.h"
+
+#ifndef _WIN32
+#  include <cerrno>
+#  include <cstring>
+
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <sys/mman.h>
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <sys/un.h>
+#  include <unistd.h>
+#endif
+
+#include <stdcorelib/str.h>
+
+namespace ds::pipeline {
+
+#ifdef _WIN32
+    static srt::Error notSupported() {
+        return srt::Error(srt::Error::FeatureNotSupported,
+                          "stage sockets are not supported on this platform");
+    }
+
+    srt::Expected<int> listenStageSocket(const std::string &) {
+        return notSupported();
+    }
+
+    srt::Expected<int> acceptStageSocket(int, const std::atomic<bool> *) {
+        return notSupported();
+    }
+
+    srt::Expected<int> connectStageSocket(const std::string &) {
+        return notSupported();
+    }
+
+    void closeStageSocket(int) {
+    }
+
+    srt::Expected<void> sendStageMessage(int, const StageMessage &) {
+        return notSupported();
+    }
+
+    srt::Expected<bool> receiveStageMessage(int, StageMessage &, const std::atomic<bool> *) {
+        return notSupported();
+    }
+#else
+#  ifdef MSG_NOSIGNAL
+    static constexpr int sendFlags = MSG_NOSIGNAL;
+#  else
+    static constexpr int sendFlags = 0;
+#  endif
+
+    static constexpr uint32_t frameMagic = 0x4d535344; // "DSSM"
+    static constexpr int pollInterval = 10;            // ms
+
+    // Limits of a received frame
+    static constexpr uint32_t maxBlobCount = 65536;
+    static constexpr uint64_t maxBodySize = uint64_t(1) << 30;
+
+    struct FrameHeader {
+        uint32_t magic;
+        uint32_t kind;
+        uint32_t stage;
+        uint32_t blobCount;
+        uint64_t bodySize;
+    };
+
+    static inline size_t alignBlob(size_t size) {
+        return (size + 63) & ~size_t(63);
+    }
+
+    static srt::Error socketError(const char *action) {
+        return srt::Error(srt::Error::SessionError, stdc::formatN("stage socket %1 failed: %2",
+                                                                  action, std::strerror(errno)));
+    }
+
+    static srt::Error closedError() {
+        return srt::Error(srt::Error::SessionError, "stage socket closed by peer");
+    }
+
+    static srt::Error cancelledError() {
+        return srt::Error(srt::Error::SessionError, "stage call cancelled");
+    }
+
+    static inline bool isCancelled(const std::atomic<bool> *cancelled) {
+        return cancelled && cancelled->load(std::memory_order_acquire);
+    }
+
+    static srt::Expected<sockaddr_un> socketAddress(const std::string &path) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) {
+            return srt::Error(srt::Error::InvalidArgument,
+                              stdc::formatN(R"(socket path too long: "%1")", path));
+        }
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        return addr;
+    }
+
+    static srt::Expected<int> createSocket() {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return socketError("creation");
+        }
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#  ifdef SO_NOSIGPIPE
+        int on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#  endif
+        return fd;
+    }
+
+    // Returns false if cancelled
+    static srt::Expected<bool> waitReadable(int fd, const std::atomic<bool> *cancelled) {
+        pollfd pfd{fd, POLLIN, 0};
+        while (true) {
+            if (isCancelled(cancelled)) {
+                return false;
+            }
+            const int n = ::poll(&pfd, 1, cancelled ? pollInterval : -1);
+            if (n > 0) {
+                return true;
+            }
+            if (n < 0 && errno != EINTR) {
+                return socketError("poll");
+            }
+        }
+    }
+
+    static srt::Expected<void> sendAll(int fd, const void *data, size_t size) {
+        auto p = static_cast<const char *>(data);
+        while (size > 0) {
+            const auto n = ::send(fd, p, size, sendFlags);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return socketError("send");
+            }
+            p += n;
+            size -= n;
+        }
+        return srt::Expected<void>();
+    }
+
+    // Reads exactly \a size bytes, keeping the last descriptor passed along with them in
+    // \a passedFd. Returns false if the peer closed the connection before the first byte.
+    static srt::Expected<bool> receiveAll(int fd, void *data, size_t size,
+                                          const std::atomic<bool> *cancelled,
+                                          int *passedFd = nullptr) {
+        auto p = static_cast<char *>(data);
+        const size_t total = size;
+        while (size > 0) {
+            if (auto exp = waitReadable(fd, cancelled); !exp) {
+                return exp.takeError();
+            } else if (!exp.value()) {
+                return cancelledError();
+            }
+
+            iovec iov{p, size};
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+            msghdr msg{};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            if (passedFd) {
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+            }
+            const auto n = ::recvmsg(fd, &msg, 0);
+            if (n < 0) {
+                if (errno == EINTR || errno == EAGAIN) {
+                    continue;
+                }
+                return socketError("receive");
+            }
+            if (n == 0) {
+                if (size == total) {
+                    return false;
+                }
+                return closedError();
+            }
+            if (passedFd) {
+                for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                        int received;
+                        std::memcpy(&received, CMSG_DATA(cmsg), sizeof(int));
+                        if (*passedFd >= 0) {
+                            ::close(*passedFd);
+                        }
+                        *passedFd = received;
+                    }
+                }
+            }
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    static int createSharedMemory() {
+#  ifdef __linux__
+        return ::memfd_create("dsinfer-stage", MFD_CLOEXEC);
+#  else
+        // The name is only needed until the segment is opened
+        static std::atomic<unsigned> counter = 0;
+        const auto name = stdc::formatN("/dsinfer-stage-%1-%2", ::getpid(), counter++);
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            ::shm_unlink(name.c_str());
+        }
+        return fd;
+#  endif
+    }
+
+    srt::Expected<int> listenStageSocket(const std::string &path) {
+        auto addr = socketAddress(path);
+        if (!addr) {
+            return addr.takeError();
+        }
+        auto fd = createSocket();
+        if (!fd) {
+            return fd.takeError();
+        }
+        ::unlink(path.c_str());
+        if (::bind(fd.value(), reinterpret_cast<const sockaddr *>(&addr.value()),
+                   sizeof(sockaddr_un)) != 0 ||
+            ::listen(fd.value(), SOMAXCONN) != 0) {
+            auto error = srt::Error(srt::Error::SessionError,
+                                    stdc::formatN(R"(failed to listen on "%1": %2)", path,
+                                                  std::strerror(errno)));
+            ::close(fd.value());
+            return error;
+        }
+        return fd;
+    }
+
+    srt::Expected<int> acceptStageSocket(int listenFd, const std::atomic<bool> *cancelled) {
+        while (true) {
+            if (auto exp = waitReadable(listenFd, cancelled); !exp) {
+                return exp.takeError();
+            } else if (!exp.value()) {
+                return -1;
+            }
+            // Another process of the pool may have taken the connection
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd >= 0) {
+                ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+                return fd;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK &&
+                errno != ECONNABORTED) {
+                return socketError("accept");
+            }
+        }
+    }
+
+    srt::Expected<int> connectStageSocket(const std::string &path) {
+        auto addr = socketAddress(path);
+        if (!addr) {
+            return addr.takeError();
+        }
+        auto fd = createSocket();
+        if (!fd) {
+            return fd.takeError();
+        }
+        if (::connect(fd.value(), reinterpret_cast<const sockaddr *>(&addr.value()),
+                      sizeof(sockaddr_un)) != 0) {
+            auto error = srt::Error(srt::Error::SessionError,
+                                    stdc::formatN(R"(failed to connect to "%1": %2)", path,
+                                                  std::strerror(errno)));
+            ::close(fd.value());
+            return error;
+        }
+        return fd;
+    }
+
+    void closeStageSocket(int fd) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    srt::Expected<void> sendStageMessage(int fd, const StageMessage &message) {
+        FrameHeader header{frameMagic, message.kind, static_cast<uint32_t>(message.stage),
+                           static_cast<uint32_t>(message.blobs.size()), message.body.size()};
+
+        // Copy the blobs into a shared memory segment
+        int shmFd = -1;
+        if (!message.blobs.empty()) {
+            size_t total = 0;
+            for (const auto &blob : message.blobs) {
+                total += alignBlob(blob.size);
+            }
+            shmFd = createSharedMemory();
+            if (shmFd < 0) {
+                return socketError("shared memory creation");
+            }
+            void *addr = MAP_FAILED;
+            if (::ftruncate(shmFd, static_cast<off_t>(total)) == 0) {
+                addr = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+            }
+            if (addr == MAP_FAILED) {
+                auto error = socketError("shared memory mapping");
+                ::close(shmFd);
+                return error;
+            }
+            auto p = static_cast<std::byte *>(addr);
+            for (const auto &blob : message.blobs) {
+                std::memcpy(p, blob.data, blob.size);
+                p += alignBlob(blob.size);
+            }
+            ::munmap(addr, total);
+        }
+
+        // Send the header along with the segment
+        iovec iov{&header, sizeof(header)};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        if (shmFd >= 0) {
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            auto cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            std::memcpy(CMSG_DATA(cmsg), &shmFd, sizeof(int));
+        }
+        ssize_t n;
+        do {
+            n = ::sendmsg(fd, &msg, sendFlags);
+        } while (n < 0 && errno == EINTR);
+        if (shmFd >= 0) {
+            ::close(shmFd);
+        }
+        if (n < 0) {
+            return socketError("send");
+        }
+        if (auto res = sendAll(fd, reinterpret_cast<const char *>(&header) + n,
+                               sizeof(header) - n);
+            !res) {
+            return res;
+        }
+
+        std::vector<uint64_t> sizes;
+        sizes.reserve(message.blobs.size());
+        for (const auto &blob : message.blobs) {
+            sizes.push_back(blob.size);
+        }
+        if (auto res = sendAll(fd, sizes.data(), sizes.size() * sizeof(uint64_t)); !res) {
+            return res;
+        }
+        return sendAll(fd, message.body.data(), message.body.size());
+    }
+
+    srt::Expected<bool> receiveStageMessage(int fd, StageMessage &message,
+                                            const std::atomic<bool> *cancelled) {
+        FrameHeader header;
+        int shmFd = -1;
+        auto exp = receiveAll(fd, &header, sizeof(header), cancelled, &shmFd);
+        if (!exp || !exp.value()) {
+            closeStageSocket(shmFd);
+            return exp;
+        }
+        // The segment descriptor is closed on return, the mapping stays valid
+        struct FdGuard {
+            int fd;
+            ~FdGuard() {
+                closeStageSocket(fd);
+            }
+        } shmGuard{shmFd};
+
+        if (header.magic != frameMagic || header.kind < StageMessage::Request ||
+            header.kind > StageMessage::Failure || header.stage >= StageCount ||
+            header.blobCount > maxBlobCount || header.bodySize > maxBodySize ||
+            (header.blobCount > 0) != (shmFd >= 0)) {
+            return srt::Error(srt::Error::InvalidFormat, "invalid stage message frame");
+        }
+
+        message = {};
+        message.kind = static_cast<StageMessage::Kind>(header.kind);
+        message.stage = static_cast<Stage>(header.stage);
+
+        std::vector<uint64_t> sizes(header.blobCount);
+        if (auto res = receiveAll(fd, sizes.data(), sizes.size() * sizeof(uint64_t), cancelled);
+            !res) {
+            return res.takeError();
+        } else if (!res.value() && !sizes.empty()) {
+            return closedError();
+        }
+        message.body.resize(header.bodySize);
+        if (auto res = receiveAll(fd, message.body.data(), message.body.size(), cancelled); !res) {
+            return res.takeError();
+        } else if (!res.value() && !message.body.empty()) {
+            return closedError();
+        }
+
+        if (shmFd < 0) {
+            return true;
+        }
+
+        // Map the segment, the blobs keep the mapping alive
+        struct stat st;
+        if (::fstat(shmFd, &st) != 0) {
+            return socketError("shared memory status");
+        }
+        const auto segmentSize = static_cast<uint64_t>(st.st_size);
+        uint64_t total = 0;
+        for (const auto size : sizes) {
+            // The blobs are never empty, so neither is the mapping
+            if (size == 0 || size > segmentSize || (total += alignBlob(size)) > segmentSize) {
+                return srt::Error(srt::Error::InvalidFormat, "invalid stage message segment");
+            }
+        }
+        void *addr = ::mmap(nullptr, total, PROT_READ, MAP_SHARED, shmFd, 0);
+        if (addr == MAP_FAILED) {
+            return socketError("shared memory mapping");
+        }
+        std::shared_ptr<const void> mapping(
+            addr, [total](const void *p) { ::munmap(const_cast<void *>(p), total); });
+        auto p = static_cast<const std::byte *>(addr);
+        for (const auto size : sizes) {
+            message.blobs.push_back({p, static_cast<size_t>(size), mapping});
+            p += alignBlob(size);
+        }
+        return true;
+    }
+#endif
+
+}
@@ -0,0 +1,37 @@
+#ifndef DSINFER_PIPELINE_STAGESOCKET_P_H
+#define DSINFER_PIPELINE_STAGESOCKET_P_H
+
+#include <atomic>
+#include <string>
+
+#include <synthrt/Support/Expected.h>
+
+#include <pipeline/StageCodec.h>
+
+namespace ds::pipeline {
+
+    // Stage messages over Unix sockets. A frame is a fixed header, the blob sizes and the body;
+    // the blobs are copied into one shared memory segment whose descriptor is passed along with
+    // the header, so that the tensors are not pushed through the socket.
+    //
+    // The blocking calls poll every few milliseconds and give up as soon as \a cancelled becomes
+    // true. Not supported on Windows.
+
+    srt::Expected<int> listenStageSocket(const std::string &path);
+
+    // Returns -1 if cancelled
+    srt::Expected<int> acceptStageSocket(int listenFd, const std::atomic<bool> *cancelled);
+
+    srt::Expected<int> connectStageSocket(const std::string &path);
+
+    void closeStageSocket(int fd);
+
+    srt::Expected<void> sendStageMessage(int fd, const StageMessage &message);
+
+    // Returns false if the peer closed the connection before a new frame
+    srt::Expected<bool> receiveStageMessage(int fd, StageMessage &message,
+                                            const std::atomic<bool> *cancelled);
+
+}
+
+#endif // DSINFER_PIPELINE_STAGESOCKET_P_H
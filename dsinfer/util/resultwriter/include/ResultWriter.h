@@ -0,0 +1,48 @@
+#ifndef DSINFER_RESULTWRITER_H
+#define DSINFER_RESULTWRITER_H
+
+#include <string>
+
+#include <dsinfer/Api/Inferences/Acoustic/1/AcousticApiL1.h>
+#include <dsinfer/Api/Inferences/Duration/1/DurationApiL1.h>
+#include <dsinfer/Api/Inferences/Pitch/1/PitchApiL1.h>
+#include <dsinfer/Api/Inferences/Variance/1/VarianceApiL1.h>
+
+namespace ds {
+
+    enum class CurveFormat {
+        /// Arrays of numbers in the shortest round-trip form.
+        Text,
+
+        /// float32 arrays encoded in base64 JSON strings, marked with "encoding": "f32le". Still
+        /// a text document, see \c Float32CurveEncoding.
+        Float32,
+    };
+
+    struct ResultWriterOptions {
+        CurveFormat curveFormat = CurveFormat::Text;
+    };
+
+    // The writers append JSON documents using the same schema as the input parsers, so that the
+    // outputs of a stage can be fed back as inputs of the next one.
+
+    /// {"durations": [...]}, or {"encoding": "f32le", "durations": "..."} in float32 format
+    void writeDurationResult(std::string &out, const Api::Duration::L1::DurationResult &result,
+                             const ResultWriterOptions &options = {});
+
+    /// {"parameters": [{"tag": "pitch", ...}]}
+    void writePitchResult(std::string &out, const Api::Pitch::L1::PitchResult &result,
+                          const ResultWriterOptions &options = {});
+
+    /// {"parameters": [...]}
+    void writeVarianceResult(std::string &out, const Api::Variance::L1::VarianceResult &result,
+                             const ResultWriterOptions &options = {});
+
+    /// The whole acoustic input, e.g. completed with the predicted durations and parameters.
+    void writeAcousticStartInput(std::string &out,
+                                 const Api::Acoustic::L1::AcousticStartInput &input,
+                                 const ResultWriterOptions &options = {});
+
+}
+
+#endif // DSINFER_RESULTWRITER_H
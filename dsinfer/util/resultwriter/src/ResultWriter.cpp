@@ -0,0 +1,276 @@
+#include "ResultWriter.h"
+
+#include <cstdio>
+
+#include <dsinfer/Support/CurveEncoding.h>
+#include <dsinfer/Support/FloatFormat.h>
+
+namespace ds {
+
+    namespace Co = Api::Common::L1;
+    namespace Ac = Api::Acoustic::L1;
+    namespace Dur = Api::Duration::L1;
+    namespace Pit = Api::Pitch::L1;
+    namespace Var = Api::Variance::L1;
+
+    static void appendJsonString(std::string &out, std::string_view str) {
+        out.push_back('"');
+        for (const auto ch : str) {
+            switch (ch) {
+                case '"':
+                    out.append("\\\"");
+                    break;
+                case '\\':
+                    out.append("\\\\");
+                    break;
+                case '\n':
+                    out.append("\\n");
+                    break;
+                case '\r':
+                    out.append("\\r");
+                    break;
+                case '\t':
+                    out.append("\\t");
+                    break;
+                default:
+                    if (static_cast<unsigned char>(ch) < 0x20) {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+                        out.append(buf);
+                    } else {
+                        out.push_back(ch);
+                    }
+                    break;
+            }
+        }
+        out.push_back('"');
+    }
+
+    static inline void appendKey(std::string &out, std::string_view key) {
+        appendJsonString(out, key);
+        out.push_back(':');
+    }
+
+    // Writes the "values" field, preceded by the "encoding" field in float32 format
+    static void appendCurveValues(std::string &out, std::string_view key,
+                                  const std::vector<double> &values,
+                                  const ResultWriterOptions &options) {
+        if (options.curveFormat == CurveFormat::Float32) {
+            appendKey(out, "encoding");
+            appendJsonString(out, Float32CurveEncoding);
+            out.push_back(',');
+            appendKey(out, key);
+            out.push_back('"');
+            appendFloat32Base64(out, values);
+            out.push_back('"');
+        } else {
+            appendKey(out, key);
+            appendJsonArray(out, values);
+        }
+    }
+
+    // Writes the curve fields parsed by parseValueCurve()
+    static void appendValueCurve(std::string &out, const std::vector<double> &values,
+                                 double interval, const ResultWriterOptions &options) {
+        if (interval == 0 && values.size() == 1) {
+            appendKey(out, "dynamic");
+            out.append("false,");
+            appendKey(out, "value");
+            appendJsonNumber(out, values.front());
+            return;
+        }
+        appendKey(out, "dynamic");
+        out.append("true,");
+        appendKey(out, "interval");
+        appendJsonNumber(out, interval);
+        out.push_back(',');
+        appendCurveValues(out, "values", values, options);
+    }
+
+    static void appendParameter(std::string &out, const Co::InputParameterInfo &param,
+                                const ResultWriterOptions &options) {
+        out.push_back('{');
+        appendKey(out, "tag");
+        appendJsonString(out, param.tag.name());
+        out.push_back(',');
+        appendValueCurve(out, param.values, param.interval, options);
+        if (param.retake) {
+            out.push_back(',');
+            appendKey(out, "retake");
+            out.push_back('{');
+            appendKey(out, "start");
+            appendJsonNumber(out, param.retake->start);
+            out.push_back(',');
+            appendKey(out, "end");
+            appendJsonNumber(out, param.retake->end);
+            out.push_back('}');
+        }
+        out.push_back('}');
+    }
+
+    static void appendParameters(std::string &out,
+                                 const std::vector<Co::InputParameterInfo> &params,
+                                 const ResultWriterOptions &options) {
+        appendKey(out, "parameters");
+        out.push_back('[');
+        for (size_t i = 0; i < params.size(); ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            appendParameter(out, params[i], options);
+        }
+        out.push_back(']');
+    }
+
+    static const char *glideName(Co::GlideType glide) {
+        switch (glide) {
+            case Co::GT_Up:
+                return "up";
+            case Co::GT_Down:
+                return "down";
+            default:
+                break;
+        }
+        return "none";
+    }
+
+    static void appendWord(std::string &out, const Co::InputWordInfo &word) {
+        out.push_back('{');
+        appendKey(out, "phones");
+        out.push_back('[');
+        for (size_t i = 0; i < word.phones.size(); ++i) {
+            const auto &phone = word.phones[i];
+            if (i > 0) {
+                out.push_back(',');
+            }
+            out.push_back('{');
+            appendKey(out, "token");
+            appendJsonString(out, phone.token);
+            out.push_back(',');
+            appendKey(out, "language");
+            appendJsonString(out, phone.language);
+            out.push_back(',');
+            appendKey(out, "tone");
+            out.append(std::to_string(phone.tone));
+            out.push_back(',');
+            appendKey(out, "start");
+            appendJsonNumber(out, phone.start);
+            if (!phone.speakers.empty()) {
+                out.push_back(',');
+                appendKey(out, "speakers");
+                out.push_back('[');
+                for (size_t j = 0; j < phone.speakers.size(); ++j) {
+                    if (j > 0) {
+                        out.push_back(',');
+                    }
+                    out.push_back('{');
+                    appendKey(out, "name");
+                    appendJsonString(out, phone.speakers[j].name);
+                    out.push_back(',');
+                    appendKey(out, "proportion");
+                    appendJsonNumber(out, phone.speakers[j].proportion);
+                    out.push_back('}');
+                }
+                out.push_back(']');
+            }
+            out.push_back('}');
+        }
+        out.append("],");
+        appendKey(out, "notes");
+        out.push_back('[');
+        for (size_t i = 0; i < word.notes.size(); ++i) {
+            const auto &note = word.notes[i];
+            if (i > 0) {
+                out.push_back(',');
+            }
+            out.push_back('{');
+            appendKey(out, "key");
+            out.append(std::to_string(note.key));
+            out.push_back(',');
+            appendKey(out, "cents");
+            out.append(std::to_string(note.cents));
+            out.push_back(',');
+            appendKey(out, "duration");
+            appendJsonNumber(out, note.duration);
+            out.push_back(',');
+            appendKey(out, "glide");
+            appendJsonString(out, glideName(note.glide));
+            out.push_back(',');
+            appendKey(out, "is_rest");
+            out.append(note.is_rest ? "true" : "false");
+            out.push_back('}');
+        }
+        out.append("]}");
+    }
+
+    void writeDurationResult(std::string &out, const Dur::DurationResult &result,
+                             const ResultWriterOptions &options) {
+        out.push_back('{');
+        appendCurveValues(out, "durations", result.durations, options);
+        out.push_back('}');
+    }
+
+    void writePitchResult(std::string &out, const Pit::PitchResult &result,
+                          const ResultWriterOptions &options) {
+        out.push_back('{');
+        appendKey(out, "parameters");
+        out.push_back('[');
+        out.push_back('{');
+        appendKey(out, "tag");
+        appendJsonString(out, Co::Tags::Pitch.name());
+        out.push_back(',');
+        appendValueCurve(out, result.pitch, result.interval, options);
+        out.append("}]}");
+    }
+
+    void writeVarianceResult(std::string &out, const Var::VarianceResult &result,
+                             const ResultWriterOptions &options) {
+        out.push_back('{');
+        appendParameters(out, result.predictions, options);
+        out.push_back('}');
+    }
+
+    void writeAcousticStartInput(std::string &out, const Ac::AcousticStartInput &input,
+                                 const ResultWriterOptions &options) {
+        out.push_back('{');
+        appendKey(out, "duration");
+        appendJsonNumber(out, input.duration);
+        out.push_back(',');
+        appendKey(out, "steps");
+        out.append(std::to_string(input.steps));
+        out.push_back(',');
+        appendKey(out, "depth");
+        appendJsonNumber(out, input.depth);
+        out.push_back(',');
+
+        appendKey(out, "words");
+        out.push_back('[');
+        for (size_t i = 0; i < input.words.size(); ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            appendWord(out, input.words[i]);
+        }
+        out.append("],");
+
+        appendParameters(out, input.parameters, options);
+        out.push_back(',');
+
+        appendKey(out, "speakers");
+        out.push_back('[');
+        for (size_t i = 0; i < input.speakers.size(); ++i) {
+            const auto &speaker = input.speakers[i];
+            if (i > 0) {
+                out.push_back(',');
+            }
+            out.push_back('{');
+            appendKey(out, "name");
+            appendJsonString(out, speaker.name);
+            out.push_back(',');
+            appendValueCurve(out, speaker.proportions, speaker.interval, options);
+            out.push_back('}');
+        }
+        out.append("]}");
+    }
+
+}
@@ -0,0 +1,60 @@
+#ifndef SYNTHRT_PACKAGEMANIFEST_H
+#define SYNTHRT_PACKAGEMANIFEST_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <synthrt/Support/Expected.h>
+
+namespace srt {
+
+    /// PackageManifest - The checksums of the files of a package, stored in
+    /// \c package-info/manifest.json when the package is packed.
+    ///
+    /// A package is verified once when it is installed. A stamp recording the size and the
+    /// modification time of each file is then left next to the manifest, so that later opens
+    /// only compare the file attributes instead of reading the files again.
+    class SYNTHRT_EXPORT PackageManifest {
+    public:
+        struct File {
+            /// Path relative to the package directory, separated by '/'.
+            std::string path;
+            uint32_t crc32 = 0;
+            uint64_t size = 0;
+        };
+
+        std::vector<File> files;
+
+    public:
+        /// Returns whether the package directory has a manifest.
+        static bool exists(const std::filesystem::path &dir);
+
+        /// Computes the manifest of all files in the package directory, except the ones in
+        /// \c package-info. Files are checksummed in parallel on \a threads threads (0 means the
+        /// number of CPU cores).
+        static Expected<PackageManifest> create(const std::filesystem::path &dir,
+                                                int threads = 0);
+
+        static Expected<PackageManifest> load(const std::filesystem::path &dir);
+        Expected<void> save(const std::filesystem::path &dir) const;
+
+        /// Checks the size and the checksum of every file.
+        Expected<void> verify(const std::filesystem::path &dir, int threads = 0) const;
+
+        /// Verifies the package directory against its manifest, unless the verified stamp shows
+        /// that no file changed since the last successful verification. The stamp is updated on
+        /// success.
+        static Expected<void> verifyInstalled(const std::filesystem::path &dir,
+                                              int threads = 0);
+
+        /// Records that the files of the package directory match its manifest. If the package
+        /// directory is not writable, the stamp is stored in the user cache directory instead,
+        /// keyed by the canonical path of the package.
+        static Expected<void> writeVerifiedStamp(const std::filesystem::path &dir);
+    };
+
+}
+
+#endif // SYNTHRT_PACKAGEMANIFEST_H
@@ -0,0 +1,24 @@
+#ifndef SYNTHRT_CRC32_H
+#define SYNTHRT_CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <synthrt/synthrt_global.h>
+
+namespace srt {
+
+    /// Computes the CRC-32 used by ZIP and zlib (reflected polynomial 0xEDB88320).
+    ///
+    /// Pass the result of the previous call as \a crc to continue a checksum over several
+    /// buffers. Uses carry-less multiplication on x86 and the CRC32 instructions on ARMv8 when
+    /// the CPU has them, and a slicing-by-8 table otherwise.
+    SYNTHRT_EXPORT uint32_t crc32(const void *data, size_t size, uint32_t crc = 0);
+
+    /// Returns the CRC-32 of the concatenation of two buffers, given their checksums and the
+    /// size of the second one. Lets large files be checksummed in parallel chunks.
+    SYNTHRT_EXPORT uint32_t crc32Combine(uint32_t crc1, uint32_t crc2, uint64_t size2);
+
+}
+
+#endif // SYNTHRT_CRC32_H
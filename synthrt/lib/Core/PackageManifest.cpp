@@ -0,0 +1,600 @@
+#include "PackageManifest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <stdcorelib/path.h>
+#include <stdcorelib/str.h>
+#include <stdcorelib/support/versionnumber.h>
+
+#include <synthrt/Support/Crc32.h>
+#include <synthrt/Support/JSON.h>
+
+namespace fs = std::filesystem;
+
+namespace srt {
+
+    static constexpr const char ManifestVersion[] = "1.0";
+
+    // Large files are split so that a package made of a few big models still uses all threads
+    static constexpr uint64_t ChunkSize = uint64_t(32) << 20;
+    static constexpr size_t ReadBufferSize = size_t(1) << 20;
+
+    static constexpr uint64_t UnknownSize = UINT64_MAX;
+
+    static inline fs::path infoDir(const fs::path &dir) {
+        return dir / _TSTR("package-info");
+    }
+
+    static inline fs::path manifestPath(const fs::path &dir) {
+        return infoDir(dir) / _TSTR("manifest.json");
+    }
+
+    static inline fs::path stampPath(const fs::path &dir) {
+        return infoDir(dir) / _TSTR("verified.json");
+    }
+
+    static std::string toHex(uint32_t value) {
+        char buf[9];
+        std::snprintf(buf, sizeof(buf), "%08x", value);
+        return buf;
+    }
+
+    static fs::path userCacheDir() {
+#ifdef _WIN32
+        if (const auto dir = _wgetenv(L"LOCALAPPDATA"); dir && *dir) {
+            return dir;
+        }
+#else
+        if (const auto dir = std::getenv("XDG_CACHE_HOME"); dir && *dir) {
+            return dir;
+        }
+        if (const auto home = std::getenv("HOME"); home && *home) {
+            return fs::path(home) / ".cache";
+        }
+#endif
+        return {};
+    }
+
+    // Stamp of a package whose own directory is not writable, keyed by its canonical path
+    static fs::path userStampPath(const std::string &canonicalPath) {
+        const auto cacheDir = userCacheDir();
+        if (cacheDir.empty()) {
+            return {};
+        }
+        return cacheDir / _TSTR("synthrt") / _TSTR("verified") /
+               stdc::path::from_utf8(toHex(crc32(canonicalPath.data(), canonicalPath.size())) +
+                                     ".json");
+    }
+
+    static std::string canonicalPackagePath(const fs::path &dir) {
+        std::error_code ec;
+        auto path = fs::weakly_canonical(dir, ec);
+        return stdc::path::to_utf8(ec ? fs::absolute(dir, ec) : path);
+    }
+
+    static bool fromHex(std::string_view str, uint32_t *value) {
+        if (str.empty() || str.size() > 8) {
+            return false;
+        }
+        uint32_t res = 0;
+        for (const char c : str) {
+            res <<= 4;
+            if (c >= '0' && c <= '9') {
+                res |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                res |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                res |= c - 'A' + 10;
+            } else {
+                return false;
+            }
+        }
+        *value = res;
+        return true;
+    }
+
+    // Only plain relative paths inside the package are accepted
+    static bool isValidFilePath(std::string_view path) {
+        if (path.empty() || path.front() == '/' || path.find('\\') != std::string_view::npos ||
+            path.find(':') != std::string_view::npos) {
+            return false;
+        }
+        size_t start = 0;
+        while (start <= path.size()) {
+            auto end = path.find('/', start);
+            if (end == std::string_view::npos) {
+                end = path.size();
+            }
+            const auto part = path.substr(start, end - start);
+            if (part.empty() || part == "." || part == "..") {
+                return false;
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+
+    static int64_t modificationTime(const fs::path &path, std::error_code &ec) {
+        return static_cast<int64_t>(fs::last_write_time(path, ec).time_since_epoch().count());
+    }
+
+    static Expected<std::string> readText(const fs::path &path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return Error{
+                Error::FileNotOpen,
+                stdc::formatN(R"("%1": failed to open file)", path),
+            };
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
+    static Expected<void> writeText(const fs::path &path, const std::string &text) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return Error{
+                Error::FileNotOpen,
+                stdc::formatN(R"("%1": failed to create file)", path),
+            };
+        }
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!file) {
+            return Error{
+                Error::FileNotOpen,
+                stdc::formatN(R"("%1": failed to write file)", path),
+            };
+        }
+        return Expected<void>();
+    }
+
+    // Checksums the files chunk by chunk on a pool of threads, then combines the chunks of each
+    // file in order.
+    static Expected<std::vector<uint32_t>> checksumFiles(const std::vector<fs::path> &paths,
+                                                         const std::vector<uint64_t> &sizes,
+                                                         int threads) {
+        struct Chunk {
+            size_t file;
+            uint64_t offset;
+            uint64_t size;
+            uint32_t crc;
+        };
+
+        std::vector<Chunk> chunks;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            uint64_t offset = 0;
+            do {
+                const auto size = (std::min) (ChunkSize, sizes[i] - offset);
+                chunks.push_back({i, offset, size, 0});
+                offset += size;
+            } while (offset < sizes[i]);
+        }
+
+        if (threads <= 0) {
+            threads = static_cast<int>((std::max) (1u, std::thread::hardware_concurrency()));
+        }
+        const auto workerCount = (std::min) (chunks.size(), static_cast<size_t>(threads));
+
+        std::atomic<size_t> nextChunk = 0;
+        std::atomic<bool> failed = false;
+        std::mutex errorMutex;
+        Error firstError;
+
+        const auto worker = [&]() {
+            std::vector<char> buffer(ReadBufferSize);
+            std::ifstream file;
+            size_t openFile = SIZE_MAX;
+            while (!failed) {
+                const size_t i = nextChunk++;
+                if (i >= chunks.size()) {
+                    break;
+                }
+                auto &chunk = chunks[i];
+                Error error;
+                if (chunk.file != openFile) {
+                    file.close();
+                    file.clear();
+                    file.open(paths[chunk.file], std::ios::binary);
+                    openFile = chunk.file;
+                }
+                if (!file.is_open()) {
+                    error = Error{
+                        Error::FileNotOpen,
+                        stdc::formatN(R"("%1": failed to open file)", paths[chunk.file]),
+                    };
+                } else {
+                    file.clear();
+                    file.seekg(static_cast<std::streamoff>(chunk.offset));
+                    uint64_t remaining = chunk.size;
+                    uint32_t crc = 0;
+                    while (remaining > 0) {
+                        const auto count = (std::min) (remaining, uint64_t(buffer.size()));
+                        file.read(buffer.data(), static_cast<std::streamsize>(count));
+                        if (static_cast<uint64_t>(file.gcount()) != count) {
+                            error = Error{
+                                Error::FileNotOpen,
+                                stdc::formatN(R"("%1": failed to read file)", paths[chunk.file]),
+                            };
+                            break;
+                        }
+                        crc = crc32(buffer.data(), count, crc);
+                        remaining -= count;
+                    }
+                    chunk.crc = crc;
+                }
+                if (!error.ok()) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!failed.exchange(true)) {
+                        firstError = std::move(error);
+                    }
+                    break;
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        if (workerCount > 1) {
+            workers.reserve(workerCount - 1);
+            for (size_t i = 1; i < workerCount; ++i) {
+                workers.emplace_back(worker);
+            }
+        }
+        worker();
+        for (auto &thread : workers) {
+            thread.join();
+        }
+        if (failed) {
+            return firstError;
+        }
+
+        std::vector<uint32_t> res(paths.size(), 0);
+        for (const auto &chunk : chunks) {
+            res[chunk.file] = crc32Combine(res[chunk.file], chunk.crc, chunk.size);
+        }
+        return res;
+    }
+
+    static Expected<PackageManifest> parseManifest(const std::string &text,
+                                                   const fs::path &path) {
+        std::string error;
+        auto root = JsonValue::fromJson(text, false, &error);
+        if (!error.empty()) {
+            return Error{
+                Error::InvalidFormat,
+                stdc::formatN(R"("%1": invalid manifest format: %2)", path, error),
+            };
+        }
+        if (!root.isObject()) {
+            return Error{
+                Error::InvalidFormat,
+                stdc::formatN(R"("%1": invalid manifest format: not an object)", path),
+            };
+        }
+        const auto &obj = root.toObject();
+
+        // $version
+        {
+            auto it = obj.find("$version");
+            if (it != obj.end() && stdc::VersionNumber::fromString(it->second.toString()) >
+                                       stdc::VersionNumber(1)) {
+                return Error{
+                    Error::FeatureNotSupported,
+                    stdc::formatN(R"("%1": manifest version "%2" is not supported)", path,
+                                  it->second.toString()),
+                };
+            }
+        }
+
+        PackageManifest manifest;
+        auto it = obj.find("files");
+        if (it == obj.end() || !it->second.isArray()) {
+            return Error{
+                Error::InvalidFormat,
+                stdc::formatN(R"(%1: missing "files" field)", path),
+            };
+        }
+        const auto &arr = it->second.toArray();
+        manifest.files.reserve(arr.size());
+        for (const auto &item : arr) {
+            PackageManifest::File file;
+            file.path = item["path"].toString();
+            if (!isValidFilePath(file.path) || !fromHex(item["crc32"].toStringView(), &file.crc32)) {
+                return Error{
+                    Error::InvalidFormat,
+                    stdc::formatN(R"(%1: invalid file entry "%2")", path, file.path),
+                };
+            }
+            // The size is not required by the specification
+            const auto &size = item["size"];
+            file.size = size.isInt() ? size.toUInt() : UnknownSize;
+            manifest.files.push_back(std::move(file));
+        }
+        return manifest;
+    }
+
+    bool PackageManifest::exists(const fs::path &dir) {
+        std::error_code ec;
+        return fs::is_regular_file(manifestPath(dir), ec);
+    }
+
+    Expected<PackageManifest> PackageManifest::create(const fs::path &dir, int threads) {
+        std::error_code ec;
+        if (!fs::is_directory(dir, ec)) {
+            return Error{
+                Error::FileNotFound,
+                stdc::formatN(R"(invalid package path "%1")", dir),
+            };
+        }
+
+        struct Entry {
+            std::string path;
+            fs::path fullPath;
+            uint64_t size;
+        };
+        std::vector<Entry> entries;
+        const auto info = infoDir(dir);
+        for (auto it = fs::recursive_directory_iterator(dir, ec);
+             !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            const auto &entry = *it;
+            if (entry.is_directory() && it.depth() == 0 && entry.path() == info) {
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (!entry.is_regular_file()) {
+                continue;
+            }
+            auto path = stdc::path::to_utf8(entry.path().lexically_relative(dir));
+            std::replace(path.begin(), path.end(), '\\', '/');
+            entries.push_back({std::move(path), entry.path(), entry.file_size()});
+        }
+        if (ec) {
+            return Error{
+                Error::FileNotOpen,
+                stdc::formatN(R"("%1": failed to list files: %2)", dir, ec.message()),
+            };
+        }
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry &a, const Entry &b) { return a.path < b.path; });
+
+        std::vector<fs::path> paths;
+        std::vector<uint64_t> sizes;
+        paths.reserve(entries.size());
+        sizes.reserve(entries.size());
+        for (const auto &entry : entries) {
+            paths.push_back(entry.fullPath);
+            sizes.push_back(entry.size);
+        }
+        auto exp = checksumFiles(paths, sizes, threads);
+        if (!exp) {
+            return exp.takeError();
+        }
+        const auto &crcs = exp.value();
+
+        PackageManifest manifest;
+        manifest.files.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            manifest.files.push_back({std::move(entries[i].path), crcs[i], entries[i].size});
+        }
+        return manifest;
+    }
+
+    Expected<PackageManifest> PackageManifest::load(const fs::path &dir) {
+        const auto path = manifestPath(dir);
+        auto exp = readText(path);
+        if (!exp) {
+            return exp.takeError();
+        }
+        return parseManifest(exp.value(), path);
+    }
+
+    Expected<void> PackageManifest::save(const fs::path &dir) const {
+        std::error_code ec;
+        fs::create_directories(infoDir(dir), ec);
+
+        JsonArray arr;
+        arr.reserve(files.size());
+        for (const auto &file : files) {
+            JsonObject item{
+                {"path",  file.path           },
+                {"crc32", toHex(file.crc32)   },
+            };
+            if (file.size != UnknownSize) {
+                item["size"] = file.size;
+            }
+            arr.emplace_back(std::move(item));
+        }
+        JsonObject obj{
+            {"$version", ManifestVersion},
+            {"files",    std::move(arr) },
+        };
+        return writeText(manifestPath(dir), JsonValue(std::move(obj)).toJson(4));
+    }
+
+    Expected<void> PackageManifest::verify(const fs::path &dir, int threads) const {
+        std::vector<fs::path> paths;
+        std::vector<uint64_t> sizes;
+        paths.reserve(files.size());
+        sizes.reserve(files.size());
+
+        // Check the sizes first, which does not need to read anything
+        for (const auto &file : files) {
+            auto path = dir / stdc::path::from_utf8(file.path);
+            std::error_code ec;
+            const auto size = fs::file_size(path, ec);
+            if (ec) {
+                return Error{
+                    Error::FileNotFound,
+                    stdc::formatN(R"("%1": missing package file "%2")", dir, file.path),
+                };
+            }
+            if (file.size != UnknownSize && file.size != size) {
+                return Error{
+                    Error::InvalidFormat,
+                    stdc::formatN(R"("%1": size mismatch of package file "%2")", dir,
+                                  file.path),
+                };
+            }
+            paths.push_back(std::move(path));
+            sizes.push_back(size);
+        }
+
+        auto exp = checksumFiles(paths, sizes, threads);
+        if (!exp) {
+            return exp.takeError();
+        }
+        const auto &crcs = exp.value();
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (crcs[i] != files[i].crc32) {
+                return Error{
+                    Error::InvalidFormat,
+                    stdc::formatN(R"("%1": checksum mismatch of package file "%2")", dir,
+                                  files[i].path),
+                };
+            }
+        }
+        return Expected<void>();
+    }
+
+    // A stamp in the user cache names its package, as different paths may share a file name
+    static bool stampMatches(const fs::path &dir, const fs::path &stamp,
+                             const std::string &package, const PackageManifest &manifest,
+                             uint32_t manifestCrc) {
+        auto exp = readText(stamp);
+        if (!exp) {
+            return false;
+        }
+        std::string error;
+        const auto root = JsonValue::fromJson(exp.value(), false, &error);
+        if (!error.empty() || !root.isObject()) {
+            return false;
+        }
+        if (!package.empty() && root["package"].toStringView() != package) {
+            return false;
+        }
+        uint32_t stampManifestCrc;
+        if (!fromHex(root["manifest"].toStringView(), &stampManifestCrc) ||
+            stampManifestCrc != manifestCrc) {
+            return false;
+        }
+
+        std::map<std::string_view, const JsonValue *> stampFiles;
+        for (const auto &item : root["files"].toArray()) {
+            stampFiles[item["path"].toStringView()] = &item;
+        }
+        for (const auto &file : manifest.files) {
+            auto it = stampFiles.find(file.path);
+            if (it == stampFiles.end()) {
+                return false;
+            }
+            const auto &item = *it->second;
+            const auto path = dir / stdc::path::from_utf8(file.path);
+            std::error_code ec;
+            const auto size = fs::file_size(path, ec);
+            if (ec || size != item["size"].toUInt(UnknownSize)) {
+                return false;
+            }
+            const auto mtime = modificationTime(path, ec);
+            if (ec || mtime != item["mtime"].toInt()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Expected<void> PackageManifest::verifyInstalled(const fs::path &dir, int threads) {
+        const auto path = manifestPath(dir);
+        auto expText = readText(path);
+        if (!expText) {
+            return expText.takeError();
+        }
+        const auto &text = expText.value();
+        auto expManifest = parseManifest(text, path);
+        if (!expManifest) {
+            return expManifest.takeError();
+        }
+        const auto &manifest = expManifest.value();
+
+        const auto manifestCrc = crc32(text.data(), text.size());
+        if (stampMatches(dir, stampPath(dir), {}, manifest, manifestCrc)) {
+            return Expected<void>();
+        }
+        const auto package = canonicalPackagePath(dir);
+        if (const auto userStamp = userStampPath(package);
+            !userStamp.empty() && stampMatches(dir, userStamp, package, manifest, manifestCrc)) {
+            return Expected<void>();
+        }
+        if (auto res = manifest.verify(dir, threads); !res) {
+            return res;
+        }
+        // If the stamp cannot be written either in the package or in the user cache, the files
+        // are simply verified again next time
+        (void) writeVerifiedStamp(dir);
+        return Expected<void>();
+    }
+
+    Expected<void> PackageManifest::writeVerifiedStamp(const fs::path &dir) {
+        const auto path = manifestPath(dir);
+        auto expText = readText(path);
+        if (!expText) {
+            return expText.takeError();
+        }
+        const auto &text = expText.value();
+        auto expManifest = parseManifest(text, path);
+        if (!expManifest) {
+            return expManifest.takeError();
+        }
+
+        JsonArray arr;
+        arr.reserve(expManifest.value().files.size());
+        for (const auto &file : expManifest.value().files) {
+            const auto filePath = dir / stdc::path::from_utf8(file.path);
+            std::error_code ec;
+            const auto size = fs::file_size(filePath, ec);
+            const auto mtime = ec ? 0 : modificationTime(filePath, ec);
+            if (ec) {
+                return Error{
+                    Error::FileNotFound,
+                    stdc::formatN(R"("%1": missing package file "%2")", dir, file.path),
+                };
+            }
+            arr.emplace_back(JsonObject{
+                {"path",  file.path},
+                {"size",  size     },
+                {"mtime", mtime    },
+            });
+        }
+        JsonObject obj{
+            {"$version", ManifestVersion                     },
+            {"manifest", toHex(crc32(text.data(), text.size()))},
+            {"files",    std::move(arr)                      },
+        };
+        auto res = writeText(stampPath(dir), JsonValue(obj).toJson(4));
+        if (res) {
+            return res;
+        }
+
+        // The package may be installed in a read-only location
+        const auto package = canonicalPackagePath(dir);
+        const auto userStamp = userStampPath(package);
+        if (userStamp.empty()) {
+            return res;
+        }
+        std::error_code ec;
+        fs::create_directories(userStamp.parent_path(), ec);
+        obj["package"] = package;
+        if (!writeText(userStamp, JsonValue(std::move(obj)).toJson(4))) {
+            return res;
+        }
+        return Expected<void>();
+    }
+
+}
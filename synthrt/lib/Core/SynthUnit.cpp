@@ -10,6 +10,7 @@
 #include "JSON.h"
 #include "Contribute_p.h"
 #include "PackageRef_p.h"
+#include "PackageManifest.h"
 
 namespace fs = std::filesystem;
 
@@ -53,6 +54,13 @@ namespace srt {
             }
         }
 
+        // Verify the files of packed packages, only compares the stamp once installed
+        if (!noLoad && PackageManifest::exists(canonicalPath)) {
+            if (auto exp = PackageManifest::verifyInstalled(canonicalPath); !exp) {
+                return exp.error();
+            }
+        }
+
         // Parse spec
         auto pd = new PackageData(&decl);
         llvm::SmallVector<ContribSpec *> contributes;
@@ -0,0 +1,261 @@
+#include "Crc32.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define SYNTHRT_CRC32_X86
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#  include <emmintrin.h>
+#  include <smmintrin.h>
+#  include <wmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#  define SYNTHRT_CRC32_ARM
+#  include <arm_acle.h>
+#endif
+
+namespace srt {
+
+    static constexpr uint32_t Polynomial = 0xEDB88320;
+
+    using Crc32Table = std::array<std::array<uint32_t, 256>, 8>;
+
+    static Crc32Table makeTable() {
+        Crc32Table table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int j = 0; j < 8; ++j) {
+                crc = (crc & 1) ? (crc >> 1) ^ Polynomial : crc >> 1;
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+            }
+        }
+        return table;
+    }
+
+    static const Crc32Table &table() {
+        static const Crc32Table table = makeTable();
+        return table;
+    }
+
+    // The functions below work on the inverted CRC register
+    static uint32_t crc32Table(const uint8_t *p, size_t size, uint32_t crc) {
+        const auto &t = table();
+        while (size >= 8) {
+            uint32_t lo, hi;
+            std::memcpy(&lo, p, 4);
+            std::memcpy(&hi, p + 4, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            lo = __builtin_bswap32(lo);
+            hi = __builtin_bswap32(hi);
+#endif
+            lo ^= crc;
+            crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^
+                  t[4][lo >> 24] ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+                  t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+            p += 8;
+            size -= 8;
+        }
+        while (size--) {
+            crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+        }
+        return crc;
+    }
+
+#ifdef SYNTHRT_CRC32_X86
+#  ifdef _MSC_VER
+#    define SYNTHRT_CRC32_TARGET
+#  else
+#    define SYNTHRT_CRC32_TARGET __attribute__((target("pclmul,sse4.1")))
+#  endif
+
+    static bool hasClmul() {
+#  ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        const unsigned ecx = info[2];
+#  else
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+#  endif
+        // PCLMULQDQ and SSE4.1
+        return (ecx & (1u << 1)) && (ecx & (1u << 19));
+    }
+
+    // Folds 64-byte blocks with carry-less multiplication and reduces the remainder with a
+    // Barrett reduction, see "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+    // Instruction" (Intel, 2009). Requires size >= 64 and a multiple of 16.
+    SYNTHRT_CRC32_TARGET
+    static uint32_t crc32Clmul(const uint8_t *p, size_t size, uint32_t crc) {
+        alignas(16) static const uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+        alignas(16) static const uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+        alignas(16) static const uint64_t k5k0[] = {0x0163cd6124, 0x0000000000};
+        alignas(16) static const uint64_t poly[] = {0x01db710641, 0x01f7011641};
+
+        __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+        x1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 0x00));
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 0x10));
+        x3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 0x20));
+        x4 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 0x30));
+        x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(k1k2));
+        p += 64;
+        size -= 64;
+
+        // Fold 4 lanes in parallel
+        while (size >= 64) {
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+            x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+            x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+            x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+            x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 0x00)));
+            x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 0x10)));
+            x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 0x20)));
+            x4 = _mm_xor_si128(_mm_xor_si128(x4, x8),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 0x30)));
+            p += 64;
+            size -= 64;
+        }
+
+        // Fold the lanes into one
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(k3k4));
+        for (const auto next : {x2, x3, x4}) {
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, next), x5);
+        }
+
+        // Fold the remaining 16-byte blocks
+        while (size >= 16) {
+            x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+            p += 16;
+            size -= 16;
+        }
+
+        // 128 bits to 64 bits
+        x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+        x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+        x1 = _mm_srli_si128(x1, 8);
+        x1 = _mm_xor_si128(x1, x2);
+
+        x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(k5k0));
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_and_si128(x1, x3);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        // Barrett reduction to 32 bits
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(poly));
+        x2 = _mm_and_si128(x1, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+        x2 = _mm_and_si128(x2, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+        return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+    }
+#endif
+
+#ifdef SYNTHRT_CRC32_ARM
+    static uint32_t crc32Arm(const uint8_t *p, size_t size, uint32_t crc) {
+        while (size >= 8) {
+            uint64_t v;
+            std::memcpy(&v, p, 8);
+            crc = __crc32d(crc, v);
+            p += 8;
+            size -= 8;
+        }
+        while (size--) {
+            crc = __crc32b(crc, *p++);
+        }
+        return crc;
+    }
+#endif
+
+    uint32_t crc32(const void *data, size_t size, uint32_t crc) {
+        auto p = static_cast<const uint8_t *>(data);
+        crc = ~crc;
+#if defined(SYNTHRT_CRC32_X86)
+        static const bool clmul = hasClmul();
+        if (clmul && size >= 64) {
+            const size_t blocks = size & ~size_t(15);
+            crc = crc32Clmul(p, blocks, crc);
+            p += blocks;
+            size -= blocks;
+        }
+        crc = crc32Table(p, size, crc);
+#elif defined(SYNTHRT_CRC32_ARM)
+        crc = crc32Arm(p, size, crc);
+#else
+        crc = crc32Table(p, size, crc);
+#endif
+        return ~crc;
+    }
+
+    // Polynomial arithmetic modulo the CRC polynomial, in the reflected bit order
+    static uint32_t multModP(uint32_t a, uint32_t b) {
+        uint32_t m = uint32_t(1) << 31;
+        uint32_t p = 0;
+        for (;;) {
+            if (a & m) {
+                p ^= b;
+                if ((a & (m - 1)) == 0) {
+                    break;
+                }
+            }
+            m >>= 1;
+            b = (b & 1) ? (b >> 1) ^ Polynomial : b >> 1;
+        }
+        return p;
+    }
+
+    // Returns x^(n * 2^k) modulo the CRC polynomial
+    static uint32_t x2nModP(uint64_t n, unsigned k) {
+        static const auto powers = [] {
+            // powers[i] = x^(2^i)
+            std::array<uint32_t, 32> res{};
+            uint32_t p = uint32_t(1) << 30; // x^1
+            res[0] = p;
+            for (size_t i = 1; i < res.size(); ++i) {
+                res[i] = p = multModP(p, p);
+            }
+            return res;
+        }();
+
+        uint32_t p = uint32_t(1) << 31; // x^0
+        while (n) {
+            if (n & 1) {
+                p = multModP(powers[k & 31], p);
+            }
+            n >>= 1;
+            ++k;
+        }
+        return p;
+    }
+
+    uint32_t crc32Combine(uint32_t crc1, uint32_t crc2, uint64_t size2) {
+        // Shift crc1 over the size2 bytes (8 * size2 = size2 * 2^3 bits)
+        return multModP(x2nModP(size2, 3), crc1) ^ crc2;
+    }
+
+}
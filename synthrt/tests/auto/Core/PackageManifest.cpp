@@ -0,0 +1,168 @@
+#include <synthrt/Core/PackageManifest.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+namespace fs = std::filesystem;
+
+using srt::PackageManifest;
+
+// A package directory removed at the end of the test
+class TempPackage {
+public:
+    explicit TempPackage(const std::string &name)
+        : dir(fs::temp_directory_path() / ("synthrt_test_" + name)) {
+        fs::remove_all(dir);
+        fs::create_directories(dir / "sub");
+        write("model.onnx", std::string(100000, 'm'));
+        write("sub/dict.txt", "a\tb\n");
+        write("desc.json", "{}");
+    }
+
+    ~TempPackage() {
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+    }
+
+    void write(const std::string &path, const std::string &content) const {
+        std::ofstream file(dir / path, std::ios::binary | std::ios::trunc);
+        file << content;
+    }
+
+    // Changes a byte without changing the size or the modification time
+    void corrupt(const std::string &path) const {
+        const auto mtime = fs::last_write_time(dir / path);
+        std::fstream file(dir / path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(10);
+        file.put('x');
+        file.close();
+        fs::last_write_time(dir / path, mtime);
+    }
+
+    fs::path dir;
+};
+
+static void createManifest(const TempPackage &package) {
+    auto exp = PackageManifest::create(package.dir, 2);
+    BOOST_REQUIRE(exp.hasValue());
+    BOOST_REQUIRE(exp.value().save(package.dir).hasValue());
+}
+
+BOOST_AUTO_TEST_SUITE(test_PackageManifest)
+
+BOOST_AUTO_TEST_CASE(test_RoundTrip) {
+    TempPackage package("roundtrip");
+    BOOST_CHECK(!PackageManifest::exists(package.dir));
+
+    auto exp = PackageManifest::create(package.dir, 2);
+    BOOST_REQUIRE(exp.hasValue());
+    const auto &created = exp.value();
+    BOOST_REQUIRE(created.save(package.dir).hasValue());
+    BOOST_CHECK(PackageManifest::exists(package.dir));
+
+    // Sorted by path, without the manifest itself
+    BOOST_REQUIRE_EQUAL(created.files.size(), 3);
+    BOOST_CHECK_EQUAL(created.files[0].path, "desc.json");
+    BOOST_CHECK_EQUAL(created.files[1].path, "model.onnx");
+    BOOST_CHECK_EQUAL(created.files[1].size, 100000);
+    BOOST_CHECK_EQUAL(created.files[2].path, "sub/dict.txt");
+
+    auto loaded = PackageManifest::load(package.dir);
+    BOOST_REQUIRE(loaded.hasValue());
+    BOOST_REQUIRE_EQUAL(loaded.value().files.size(), created.files.size());
+    for (size_t i = 0; i < created.files.size(); ++i) {
+        BOOST_CHECK_EQUAL(loaded.value().files[i].path, created.files[i].path);
+        BOOST_CHECK_EQUAL(loaded.value().files[i].crc32, created.files[i].crc32);
+        BOOST_CHECK_EQUAL(loaded.value().files[i].size, created.files[i].size);
+    }
+    BOOST_CHECK(loaded.value().verify(package.dir, 2).hasValue());
+}
+
+BOOST_AUTO_TEST_CASE(test_ChangedByteFailsVerify) {
+    TempPackage package("changed");
+    createManifest(package);
+
+    package.corrupt("model.onnx");
+    auto loaded = PackageManifest::load(package.dir);
+    BOOST_REQUIRE(loaded.hasValue());
+    BOOST_CHECK(!loaded.value().verify(package.dir, 2).hasValue());
+
+    // A missing file fails too
+    fs::remove(package.dir / "sub/dict.txt");
+    BOOST_CHECK(!loaded.value().verify(package.dir, 2).hasValue());
+}
+
+BOOST_AUTO_TEST_CASE(test_StampSkipsVerify) {
+    TempPackage package("stamp");
+    createManifest(package);
+    BOOST_REQUIRE(PackageManifest::writeVerifiedStamp(package.dir).hasValue());
+
+    // The stamp still matches, so the changed content is not read
+    package.corrupt("model.onnx");
+    BOOST_CHECK(PackageManifest::verifyInstalled(package.dir, 2).hasValue());
+
+    // A new modification time forces a verification
+    fs::last_write_time(package.dir / "model.onnx",
+                        fs::last_write_time(package.dir / "model.onnx") + std::chrono::hours(1));
+    BOOST_CHECK(!PackageManifest::verifyInstalled(package.dir, 2).hasValue());
+}
+
+BOOST_AUTO_TEST_CASE(test_SizeChangeForcesVerify) {
+    TempPackage package("size");
+    createManifest(package);
+    BOOST_REQUIRE(PackageManifest::verifyInstalled(package.dir, 2).hasValue());
+
+    // The size is compared even if the modification time is kept
+    const auto mtime = fs::last_write_time(package.dir / "sub/dict.txt");
+    package.write("sub/dict.txt", "a\tb\nc\td\n");
+    fs::last_write_time(package.dir / "sub/dict.txt", mtime);
+    BOOST_CHECK(!PackageManifest::verifyInstalled(package.dir, 2).hasValue());
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(test_UserCacheStamp) {
+    TempPackage package("readonly");
+    createManifest(package);
+
+    // The stamp cannot be written into the package
+    fs::create_directories(package.dir / "package-info/verified.json");
+    const auto cacheDir = package.dir.parent_path() / "synthrt_test_cache";
+    fs::remove_all(cacheDir);
+    const char *oldCache = std::getenv("XDG_CACHE_HOME");
+    const std::string oldCacheValue = oldCache ? oldCache : "";
+    ::setenv("XDG_CACHE_HOME", cacheDir.c_str(), 1);
+
+    BOOST_CHECK(PackageManifest::verifyInstalled(package.dir, 2).hasValue());
+    BOOST_CHECK(fs::is_directory(cacheDir / "synthrt/verified"));
+    package.corrupt("model.onnx");
+    BOOST_CHECK(PackageManifest::verifyInstalled(package.dir, 2).hasValue());
+
+    if (oldCache) {
+        ::setenv("XDG_CACHE_HOME", oldCacheValue.c_str(), 1);
+    } else {
+        ::unsetenv("XDG_CACHE_HOME");
+    }
+    fs::remove_all(cacheDir);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(test_InvalidFilePath) {
+    TempPackage package("paths");
+    fs::create_directories(package.dir / "package-info");
+    for (const auto path : {"../model.onnx", "/etc/passwd", "sub/../../x", "sub//dict.txt",
+                            "C:/model.onnx", "sub\\\\dict.txt", ""}) {
+        package.write("package-info/manifest.json",
+                      std::string(R"({"$version": "1.0", "files": [{"path": ")") + path +
+                          R"(", "crc32": "00000000"}]})");
+        BOOST_CHECK_MESSAGE(!PackageManifest::load(package.dir).hasValue(), path);
+    }
+    package.write("package-info/manifest.json",
+                  R"({"$version": "1.0", "files": [{"path": "sub/dict.txt", "crc32": "0"}]})");
+    BOOST_CHECK(PackageManifest::load(package.dir).hasValue());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
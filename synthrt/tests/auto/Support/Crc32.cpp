@@ -0,0 +1,38 @@
+#include <synthrt/Support/Crc32.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_Crc32)
+
+BOOST_AUTO_TEST_CASE(test_crc32) {
+    BOOST_CHECK(srt::crc32("", 0) == 0);
+    BOOST_CHECK(srt::crc32("123456789", 9) == 0xCBF43926);
+    BOOST_CHECK(srt::crc32("The quick brown fox jumps over the lazy dog", 43) == 0x414FA339);
+
+    // Incremental updates and unaligned lengths
+    std::vector<unsigned char> data(100003);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(i * 2654435761u >> 13);
+    }
+    const auto whole = srt::crc32(data.data(), data.size());
+    uint32_t crc = 0;
+    for (size_t i = 0; i < data.size(); i += 777) {
+        crc = srt::crc32(data.data() + i, (std::min)(size_t(777), data.size() - i), crc);
+    }
+    BOOST_CHECK(crc == whole);
+}
+
+BOOST_AUTO_TEST_CASE(test_crc32Combine) {
+    std::string data = "The quick brown fox jumps over the lazy dog";
+    for (size_t split = 0; split <= data.size(); ++split) {
+        const auto crc1 = srt::crc32(data.data(), split);
+        const auto crc2 = srt::crc32(data.data() + split, data.size() - split);
+        BOOST_CHECK(srt::crc32Combine(crc1, crc2, data.size() - split) == 0x414FA339);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()